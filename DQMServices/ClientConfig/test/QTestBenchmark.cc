@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DQMServices/ClientConfig/interface/QTestHandle.h"
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "DQMServices/Core/interface/MonitorElement.h"
+#include "DQMServices/Core/interface/QReport.h"
+#include "DQMServices/Core/interface/QTest.h"
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+/*
+ * Benchmark of the quality tests configured by QT_Benchmark.xml, as a
+ * subsystem configures them: 1D distributions compared to their reference
+ * (Chi2, Kolmogorov, dead channels), 2D occupancies (dead channels,
+ * uniformity and range of the contents) and profiles. The tests are run
+ * reading the bins through GetBinContent and GetBinError, then directly
+ * from the arrays of the histograms; the time per pass is printed, and
+ * the results of the two passes are checked to be identical.
+ *
+ * Usage: QTestBenchmark [number of MEs of each kind] [passes] [QTest xml file]
+ */
+
+namespace {
+  struct Result
+  {
+    int status;
+    float value;
+    std::string message;
+    std::vector<float> badChannels;
+
+    bool operator==(const Result &o) const
+    {
+      return status == o.status && value == o.value
+        && message == o.message && badChannels == o.badChannels;
+    }
+  };
+
+  void book(DQMStore &store, unsigned int nMEs)
+  {
+    store.bookTransaction([&](DQMStore::IBooker &b) {
+        // the references first, so that the MEs are linked to them
+        b.setCurrentFolder("Reference/Benchmark/Distributions");
+        for (unsigned int i = 0; i < nMEs; ++i)
+        {
+          MonitorElement *me = b.book1D("h" + std::to_string(i), "reference", 100, 0., 100.);
+          for (unsigned int j = 0; j < 5000; ++j)
+            me->Fill((j * 37 + i) % 1000 / 10. + 0.05);
+        }
+        b.setCurrentFolder("Benchmark/Distributions");
+        for (unsigned int i = 0; i < nMEs; ++i)
+        {
+          MonitorElement *me = b.book1D("h" + std::to_string(i), "distribution", 100, 0., 100.);
+          for (unsigned int j = 0; j < 5000; ++j)
+            if ((j * 37 + i) % 1000 / 10 != i % 100)
+              me->Fill((j * 41 + i * 3) % 1000 / 10. + 0.05, i % 4 ? 1. : 1.25);
+        }
+        b.setCurrentFolder("Benchmark/Occupancies");
+        for (unsigned int i = 0; i < nMEs; ++i)
+        {
+          MonitorElement *me = b.book2D("h" + std::to_string(i), "occupancy", 60, 0., 60., 40, 0., 40.);
+          for (int x = 1; x <= 60; ++x)
+            for (int y = 1; y <= 40; ++y)
+              if ((x * 7 + y * 3 + i) % 97)
+                me->setBinContent(x, y, 10 + (x * y + i) % 11 + ((x + i) % 50 == 0 ? 30 : 0));
+          me->setEntries(60 * 40 * 15);
+        }
+        b.setCurrentFolder("Benchmark/Profiles");
+        for (unsigned int i = 0; i < nMEs; ++i)
+        {
+          MonitorElement *me = b.bookProfile("h" + std::to_string(i), "profile", 50, 0., 50., 0., 100.);
+          for (unsigned int j = 0; j < 10000; ++j)
+            me->Fill((j * 13 + i) % 500 / 10. + 0.05, 10. + (j * 7 + i) % 9 - 4 + ((j + i) % 250 ? 0. : 20.));
+        }
+      }, 0, 0);
+  }
+
+  // time of the quality tests, in seconds per pass, and their results
+  double run(DQMStore &store, unsigned int nPasses, std::vector<Result> &results)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int pass = 0; pass < nPasses; ++pass)
+      store.runQTests();
+    auto stop = std::chrono::steady_clock::now();
+
+    for (MonitorElement *me : store.getAllContents("Benchmark"))
+      for (QReport *qr : me->getQReports())
+      {
+        Result r = { qr->getStatus(), qr->getQTresult(), qr->getMessage(), {} };
+        for (DQMChannel chan : qr->getBadChannels())
+        {
+          r.badChannels.push_back(chan.getBinX());
+          r.badChannels.push_back(chan.getBinY());
+          r.badChannels.push_back(chan.getContents());
+          r.badChannels.push_back(chan.getRMS());
+        }
+        results.push_back(r);
+      }
+    return std::chrono::duration<double>(stop - start).count() / nPasses;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int nMEs = argc > 1 ? std::atoi(argv[1]) : 1000;
+  unsigned int nPasses = argc > 2 ? std::atoi(argv[2]) : 10;
+  std::string config = argc > 3 ? argv[3]
+    : edm::FileInPath("DQMServices/ClientConfig/test/QT_Benchmark.xml").fullPath();
+
+  std::cout << "QTestBenchmark: " << nMEs << " MEs of each kind, " << nPasses << " passes, "
+            << config << std::endl;
+
+  const char *modes[] = { "bin accessors", "bin arrays" };
+  std::vector<Result> results[2];
+  for (unsigned int mode = 0; mode < 2; ++mode)
+  {
+    DQMStore store{edm::ParameterSet()};
+    book(store, nMEs);
+    QTestHandle handle;
+    if (handle.configureTests(config, &store))
+    {
+      std::cout << "Error: cannot configure the quality tests of " << config << std::endl;
+      return 1;
+    }
+    handle.attachTests(&store, false);
+
+    QCriterion::setDirectBinAccess(mode == 1);
+    double time = run(store, nPasses, results[mode]);
+    std::cout << " " << std::left << std::setw(16) << modes[mode] << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << time * 1e3 << " ms/pass"
+              << std::setw(10) << time * 1e9 / results[mode].size() << " ns/test" << std::endl;
+  }
+  QCriterion::setDirectBinAccess(true);
+
+  if (results[0].empty() || results[0] != results[1])
+  {
+    std::cout << "Error: the quality tests give different results with bin arrays" << std::endl;
+    return 1;
+  }
+  return 0;
+}
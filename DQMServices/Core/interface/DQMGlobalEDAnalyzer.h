@@ -20,7 +20,7 @@ private:
   virtual void
   dqmBeginRun(edm::Run const&, edm::EventSetup const&, H &) const { }
 
-  // this will run while holding the DQMStore lock
+  // this will run in a DQMStore booking transaction
   virtual void
   bookHistograms(DQMStore::ConcurrentBooker &, edm::Run const&, edm::EventSetup const&, H &) const = 0;
 
@@ -38,7 +38,7 @@ DQMGlobalEDAnalyzer<H>::globalBeginRun(edm::Run const& run, edm::EventSetup cons
   auto h = std::make_shared<H>();
   dqmBeginRun(run, setup, *h);
   edm::Service<DQMStore>()->bookConcurrentTransaction([&, this](DQMStore::ConcurrentBooker &b) {
-      // this runs while holding the DQMStore lock
+      // this runs in a DQMStore booking transaction
       b.cd();
       bookHistograms(b, run, setup, *h);
     },
@@ -62,6 +62,8 @@ public:
   static const uint32_t DQM_PROP_DEAD		 = 0x00080000;
   static const uint32_t DQM_PROP_STALE		 = 0x00100000;
   static const uint32_t DQM_PROP_EFFICIENCY_PLOT = 0x00200000;
+  static const uint32_t DQM_PROP_DELTA		 = 0x00400000; // only in messages
+  static const uint32_t DQM_PROP_SNAPSHOT	 = 0x00800000; // only in messages
   static const uint32_t DQM_PROP_MARKTODELETE    = 0x01000000;
 
   static const uint32_t DQM_MSG_HELLO		 = 0;
@@ -115,6 +117,9 @@ public:
     DataBlob		rawdata;
     std::string		scalar;
     std::string		qdata;
+    DataBlob		basedata;        // last snapshot sent or received
+    uint64_t		baseversion = 0; // version of basedata
+    uint32_t		ndeltas = 0;     // deltas sent since basedata
   };
 
   struct Bucket
@@ -163,6 +168,7 @@ public:
 
   void			debug(bool doit);
   void			delay(int delay);
+  void			deltaUpdates(unsigned snapshotInterval);
   void			startLocalServer(int port);
   void			startLocalServer(const char *path);
   void			staleObjectWaitLimit(lat::TimeSpan time);
@@ -287,11 +293,14 @@ public:
 
   static void		packQualityData(std::string &into, const QReports &qr);
   static void		unpackQualityData(QReports &qr, uint32_t &flags, const char *from);
+  static bool		encodeDelta(DataBlob &into, const DataBlob &base, const DataBlob &data);
+  static bool		applyDelta(DataBlob &into, const DataBlob &base, const unsigned char *delta, size_t len);
 
 protected:
   std::ostream &	logme();
   static void		copydata(Bucket *b, const void *data, size_t len);
-  virtual void		sendObjectToPeer(Bucket *msg, Object &o, bool data);
+  virtual void		sendObjectToPeer(Bucket *msg, Object &o, bool data, bool delta = false);
+  bool			sendsDeltas(const Peer *p) const;
 
   virtual bool		shouldStop();
   void			waitForData(Peer *p, const std::string &name, const std::string &info, Peer *owner);
@@ -308,7 +317,7 @@ protected:
   virtual Peer *	getPeer(lat::Socket *s) = 0;
   virtual Peer *	createPeer(lat::Socket *s) = 0;
   virtual void		removePeer(Peer *p, lat::Socket *s) = 0;
-  virtual void		sendObjectListToPeer(Bucket *msg, bool all, bool clear) = 0;
+  virtual void		sendObjectListToPeer(Bucket *msg, bool all, bool clear, bool delta = false) = 0;
   virtual void		sendObjectListToPeers(bool all) = 0;
 
   void			updateMask(Peer *p);
@@ -347,6 +356,7 @@ private:
   sig_atomic_t		shutdown_;
 
   int			delay_;
+  unsigned		deltaUpdates_;
   lat::TimeSpan		waitStale_;
   lat::TimeSpan		waitMax_;
   bool			flush_;
@@ -525,7 +535,7 @@ protected:
 
   /// Send all objects to a peer and optionally mark sent objects old.
   void
-  sendObjectListToPeer(Bucket *msg, bool all, bool clear) override
+  sendObjectListToPeer(Bucket *msg, bool all, bool clear, bool delta = false) override
     {
       typename PeerMap::iterator pi, pe;
       typename ObjectMap::iterator oi, oe;
@@ -552,7 +562,7 @@ protected:
 	for (oi = pi->second.objs.begin(), oe = pi->second.objs.end(); oi != oe; ++oi)
 	  if (all || (oi->flags & DQM_PROP_NEW))
 	  {
-	    sendObjectToPeer(msg, const_cast<ObjType &>(*oi), oi->lastreq > 0);
+	    sendObjectToPeer(msg, const_cast<ObjType &>(*oi), oi->lastreq > 0, delta);
 	    if (clear)
 	      const_cast<ObjType &>(*oi).flags &= ~DQM_PROP_NEW;
 	    ++nupdates;
@@ -580,7 +590,7 @@ protected:
 
 	Bucket msg;
         msg.next = nullptr;
-	sendObjectListToPeer(&msg, !p.updated || all, true);
+	sendObjectListToPeer(&msg, !p.updated || all, true, sendsDeltas(&p));
 
 	if (! msg.data.empty())
 	{
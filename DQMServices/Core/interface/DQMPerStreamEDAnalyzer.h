@@ -0,0 +1,192 @@
+#ifndef DQMServices_Core_DQMPerStreamEDAnalyzer_h
+#define DQMServices_Core_DQMPerStreamEDAnalyzer_h
+
+#include <memory>
+
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/global/EDProducer.h"
+#include "FWCore/ServiceRegistry/interface/ModuleCallingContext.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "DataFormats/Histograms/interface/DQMToken.h"
+
+namespace dqm {
+  namespace impl {
+    // the histograms booked for a run, and the private copies of their
+    // MonitorElements filled by the streams
+    template <typename H>
+    struct PerStreamRunCache {
+      H histograms;
+      DQMStore::PerStreamBooker::Copies copies;
+    };
+
+    // nothing is summarised, the summary transitions are only used to
+    // merge the copies of each stream at the end of a luminosity block
+    struct PerStreamLumiSummary {};
+  }
+}
+
+// DQM module whose histograms are filled by all the streams concurrently
+// and without locking, each stream filling private copies of them (see
+// PerStreamMonitorElement). The copies of a stream are added to the
+// MonitorElements in the DQMStore when the stream ends a luminosity
+// block; the per-lumi and per-run MonitorElements are then handled as
+// those of a DQMEDAnalyzer.
+template <typename H>
+class DQMPerStreamEDAnalyzer : public edm::global::EDProducer<edm::RunCache<dqm::impl::PerStreamRunCache<H>>,
+                                                              edm::LuminosityBlockSummaryCache<dqm::impl::PerStreamLumiSummary>,
+                                                              edm::EndLuminosityBlockProducer,
+                                                              edm::EndRunProducer,
+                                                              edm::Accumulator>
+{
+public:
+  DQMPerStreamEDAnalyzer();
+
+private:
+  using RunCache = dqm::impl::PerStreamRunCache<H>;
+  using LumiSummary = dqm::impl::PerStreamLumiSummary;
+
+  void
+  preallocStreams(unsigned int) final;
+
+  std::shared_ptr<RunCache>
+  globalBeginRun(edm::Run const&, edm::EventSetup const&) const final;
+
+  void
+  globalEndRun(edm::Run const&, edm::EventSetup const&) const final;
+
+  void
+  globalEndRunProduce(edm::Run&, edm::EventSetup const&) const final;
+
+  std::shared_ptr<LumiSummary>
+  globalBeginLuminosityBlockSummary(edm::LuminosityBlock const&, edm::EventSetup const&) const final;
+
+  void
+  streamEndLuminosityBlockSummary(edm::StreamID, edm::LuminosityBlock const&, edm::EventSetup const&, LumiSummary*) const final;
+
+  void
+  globalEndLuminosityBlockSummary(edm::LuminosityBlock const&, edm::EventSetup const&, LumiSummary*) const final;
+
+  void
+  globalEndLuminosityBlockProduce(edm::LuminosityBlock&, edm::EventSetup const&, LumiSummary const*) const final;
+
+  void
+  accumulate(edm::StreamID, edm::Event const&, edm::EventSetup const&) const final;
+
+  virtual void
+  dqmBeginRun(edm::Run const&, edm::EventSetup const&, H &) const { }
+
+  virtual void
+  bookHistograms(DQMStore::PerStreamBooker &, edm::Run const&, edm::EventSetup const&, H &) const = 0;
+
+  // the PerStreamMonitorElements must be filled with the index of the stream
+  virtual void
+  dqmAnalyze(edm::StreamID, edm::Event const&, edm::EventSetup const&, H const&) const = 0;
+
+  // called once the copies of all the streams have been merged
+  virtual void
+  dqmEndRun(edm::Run const&, edm::EventSetup const&, H const&) const { }
+
+  unsigned int nStreams_;
+  edm::EDPutTokenT<DQMToken> lumiToken_;
+  edm::EDPutTokenT<DQMToken> runToken_;
+};
+
+template <typename H>
+DQMPerStreamEDAnalyzer<H>::DQMPerStreamEDAnalyzer() :
+  nStreams_(1)
+{
+  lumiToken_ = this->template produces<DQMToken,edm::Transition::EndLuminosityBlock>("endLumi");
+  runToken_ = this->template produces<DQMToken,edm::Transition::EndRun>("endRun");
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::preallocStreams(unsigned int nStreams)
+{
+  nStreams_ = nStreams;
+}
+
+template <typename H>
+std::shared_ptr<typename DQMPerStreamEDAnalyzer<H>::RunCache>
+DQMPerStreamEDAnalyzer<H>::globalBeginRun(edm::Run const& run, edm::EventSetup const& setup) const
+{
+  auto cache = std::make_shared<RunCache>();
+  dqmBeginRun(run, setup, cache->histograms);
+  edm::Service<DQMStore>()->bookPerStreamTransaction([&, this](DQMStore::PerStreamBooker &b) {
+      b.cd();
+      bookHistograms(b, run, setup, cache->histograms);
+    },
+    run.run(),
+    run.moduleCallingContext()->moduleDescription()->id(),
+    nStreams_,
+    cache->copies);
+  return cache;
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::globalEndRun(edm::Run const& run, edm::EventSetup const& setup) const
+{
+  dqmEndRun(run, setup, this->runCache(run.index())->histograms);
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::globalEndRunProduce(edm::Run& run, edm::EventSetup const&) const
+{
+  edm::Service<DQMStore>()->cloneRunHistograms(
+      run.run(),
+      run.moduleCallingContext()->moduleDescription()->id());
+
+  run.put(runToken_, std::make_unique<DQMToken>());
+}
+
+template <typename H>
+std::shared_ptr<typename DQMPerStreamEDAnalyzer<H>::LumiSummary>
+DQMPerStreamEDAnalyzer<H>::globalBeginLuminosityBlockSummary(edm::LuminosityBlock const&, edm::EventSetup const&) const
+{
+  return std::make_shared<LumiSummary>();
+}
+
+// the framework does not run these concurrently, so the streams add their
+// copies to the MonitorElements one at a time
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::streamEndLuminosityBlockSummary(edm::StreamID stream, edm::LuminosityBlock const& lumi,
+                                                           edm::EventSetup const&, LumiSummary*) const
+{
+  for (auto const& copies : this->runCache(lumi.getRun().index())->copies)
+    copies->merge(stream.value());
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::globalEndLuminosityBlockSummary(edm::LuminosityBlock const&, edm::EventSetup const&,
+                                                           LumiSummary*) const
+{
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::globalEndLuminosityBlockProduce(edm::LuminosityBlock& lumi, edm::EventSetup const&,
+                                                           LumiSummary const*) const
+{
+  edm::Service<DQMStore>()->cloneLumiHistograms(
+      lumi.run(),
+      lumi.luminosityBlock(),
+      lumi.moduleCallingContext()->moduleDescription()->id());
+
+  lumi.put(lumiToken_, std::make_unique<DQMToken>());
+}
+
+template <typename H>
+void
+DQMPerStreamEDAnalyzer<H>::accumulate(edm::StreamID stream, edm::Event const& event, edm::EventSetup const& setup) const
+{
+  dqmAnalyze(stream, event, setup, this->runCache(event.getRun().index())->histograms);
+}
+
+#endif // DQMServices_Core_DQMPerStreamEDAnalyzer_h
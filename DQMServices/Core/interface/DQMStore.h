@@ -5,12 +5,15 @@
 #define DQM_DEPRECATED __attribute__((deprecated))
 #endif
 
+#include <array>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <functional>
 #include <iosfwd>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
@@ -23,6 +26,7 @@
 
 #include "DQMServices/Core/interface/DQMDefinitions.h"
 #include "DQMServices/Core/interface/ConcurrentMonitorElement.h"
+#include "DQMServices/Core/interface/PerStreamMonitorElement.h"
 
 namespace edm { class DQMHttpSource; class ParameterSet; class ActivityRegistry; class GlobalContext; }
 namespace lat { class Regexp; }
@@ -295,6 +299,101 @@ class DQMStore
     ~ConcurrentBooker() = default;
   };
 
+  // Booker of histograms filled per stream, see PerStreamMonitorElement.
+  // The private copies of the booked MonitorElements are added to copies,
+  // which is owned by the booking module.
+  class PerStreamBooker : public IBooker
+  {
+  public:
+    friend class DQMStore;
+    using Copies = std::vector<std::unique_ptr<PerStreamMonitorElement::Copies>>;
+
+    // for the supported syntaxes, see the declarations of DQMStore::book1D
+    template <typename... Args>
+    PerStreamMonitorElement book1D(Args && ... args) {
+      return add(IBooker::book1D(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book1S
+    template <typename... Args>
+    PerStreamMonitorElement book1S(Args && ... args) {
+      return add(IBooker::book1S(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book1DD
+    template <typename... Args>
+    PerStreamMonitorElement book1DD(Args && ... args) {
+      return add(IBooker::book1DD(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book2D
+    template <typename... Args>
+    PerStreamMonitorElement book2D(Args && ... args) {
+      return add(IBooker::book2D(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book2S
+    template <typename... Args>
+    PerStreamMonitorElement book2S(Args && ... args) {
+      return add(IBooker::book2S(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book2DD
+    template <typename... Args>
+    PerStreamMonitorElement book2DD(Args && ... args) {
+      return add(IBooker::book2DD(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::book3D
+    template <typename... Args>
+    PerStreamMonitorElement book3D(Args && ... args) {
+      return add(IBooker::book3D(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::bookProfile
+    template <typename... Args>
+    PerStreamMonitorElement bookProfile(Args && ... args) {
+      return add(IBooker::bookProfile(std::forward<Args>(args)...));
+    }
+
+    // for the supported syntaxes, see the declarations of DQMStore::bookProfile2D
+    template <typename... Args>
+    PerStreamMonitorElement bookProfile2D(Args && ... args) {
+      return add(IBooker::bookProfile2D(std::forward<Args>(args)...));
+    }
+
+    // scalar MonitorElements cannot be filled per stream
+    template <typename... Args>
+    void bookString(Args && ... args) = delete;
+    template <typename... Args>
+    void bookInt(Args && ... args) = delete;
+    template <typename... Args>
+    void bookFloat(Args && ... args) = delete;
+
+  private:
+    PerStreamBooker(DQMStore * store, unsigned int nStreams, Copies & copies) :
+      IBooker(store),
+      nStreams_(nStreams),
+      copies_(copies)
+    { }
+
+    PerStreamBooker() = delete;
+    PerStreamBooker(PerStreamBooker const&) = delete;
+    PerStreamBooker(PerStreamBooker &&) = delete;
+    PerStreamBooker& operator= (PerStreamBooker const&) = delete;
+    PerStreamBooker& operator= (PerStreamBooker &&) = delete;
+
+    ~PerStreamBooker() = default;
+
+    PerStreamMonitorElement add(MonitorElement * me) {
+      copies_.push_back(std::make_unique<PerStreamMonitorElement::Copies>(me, nStreams_));
+      return PerStreamMonitorElement(copies_.back().get());
+    }
+
+    unsigned int nStreams_;
+    Copies & copies_;
+  };
+
   class IGetter
   {
    public:
@@ -349,41 +448,46 @@ class DQMStore
   // calls whatever user-supplied code via the function f. The latter
   // is passed the instance of the IBooker class (owned by the *only*
   // DQMStore instance), that is capable of booking MonitorElements
-  // into the DQMStore via a public API. The central mutex is acquired
-  // *before* invoking and automatically released upon returns.
+  // into the DQMStore via a public API. The run number, module id and
+  // current folder of the booking are kept per thread for the duration
+  // of the transaction, so that transactions of different modules run
+  // concurrently; those of the same module (one per stream) are
+  // serialised.
   template <typename iFunc>
   void bookTransaction(iFunc f, uint32_t run, uint32_t moduleId) {
-    std::lock_guard<std::mutex> guard(book_mutex_);
-    /* Set the run number and module id only if multithreading is enabled */
-    if (enableMultiThread_) {
-      run_ = run;
-      moduleId_ = moduleId;
-    }
+    /* Use the run number and module id only if multithreading is enabled */
+    BookingTransaction transaction(this,
+                                   enableMultiThread_ ? run : 0,
+                                   enableMultiThread_ ? moduleId : 0);
     f(*ibooker_);
-
-    /* Reset the run number and module id only if multithreading is enabled */
-    if (enableMultiThread_) {
-      run_ = 0;
-      moduleId_ = 0;
-    }
   }
 
   // Similar function used to book "global" histograms via the
   // ConcurrentMonitorElement interface.
   template <typename iFunc>
   void bookConcurrentTransaction(iFunc f, uint32_t run) {
-    std::lock_guard<std::mutex> guard(book_mutex_);
-    /* Set the run_ member only if enableMultiThread is enabled */
-    if (enableMultiThread_) {
-      run_ = run;
-    }
+    /* Use the run number only if multithreading is enabled */
+    BookingTransaction transaction(this, enableMultiThread_ ? run : 0, 0);
     ConcurrentBooker booker(this);
     f(booker);
+  }
 
-    /* Reset the run_ member only if enableMultiThread is enabled */
-    if (enableMultiThread_) {
-      run_ = 0;
-    }
+  // Similar function used to book histograms filled per stream via the
+  // PerStreamMonitorElement interface. The private copies of the booked
+  // MonitorElements are prepared once f has returned, so that they get
+  // the final binning, titles and labels.
+  template <typename iFunc>
+  void bookPerStreamTransaction(iFunc f, uint32_t run, uint32_t moduleId,
+                                unsigned int nStreams, PerStreamBooker::Copies & copies) {
+    /* Use the run number and module id only if multithreading is enabled */
+    BookingTransaction transaction(this,
+                                   enableMultiThread_ ? run : 0,
+                                   enableMultiThread_ ? moduleId : 0);
+    size_t first = copies.size();
+    PerStreamBooker booker(this, nStreams, copies);
+    f(booker);
+    for (size_t i = first; i < copies.size(); ++i)
+      copies[i]->prepare();
   }
 
   // Signature needed in the harvesting where the booking is done
@@ -396,6 +500,18 @@ class DQMStore
     f(*ibooker_, *igetter_);
   }
 
+  // Functions used by the DQMEDHarvesters in place of meBookerGetter.
+  // With concurrent harvesting enabled, the directories read and booked
+  // by each harvester are tracked, and the dqmEndJob of the harvesters
+  // is queued and run by runHarvestingQueue(), where harvesters which
+  // do not touch the same directories run concurrently. Otherwise f is
+  // run at once, as with meBookerGetter.
+  using HarvestingFunction = std::function<void(IBooker &, IGetter &)>;
+  void registerHarvester();
+  void runHarvesting(uint32_t moduleId, const HarvestingFunction &f);
+  void queueHarvesting(uint32_t moduleId, HarvestingFunction f);
+  void runHarvestingQueue();
+
   //-------------------------------------------------------------------------
   // ---------------------- Constructors ------------------------------------
   DQMStore(const edm::ParameterSet &pset, edm::ActivityRegistry&);
@@ -746,11 +862,42 @@ class DQMStore
   void        forceReset();
   void        postGlobalBeginLumi(const edm::GlobalContext&);
 
+  // ---------------------- Booking transactions -----------------------
+  // Booking state of the transaction running in the current thread.
+  struct RunningHarvester;
+  class BookingTransaction {
+   public:
+    BookingTransaction(DQMStore *store, uint32_t run, uint32_t moduleId, bool serialise = true);
+    ~BookingTransaction();
+    BookingTransaction(const BookingTransaction&) = delete;
+    BookingTransaction& operator=(const BookingTransaction&) = delete;
+
+   private:
+    friend class DQMStore;
+    std::unique_lock<std::mutex> guard_;
+    DQMStore *                   store_;
+    uint32_t                     run_;
+    uint32_t                     moduleId_;
+    std::string                  pwd_;
+    BookingTransaction *         previous_;
+    std::set<std::string> *      accessed_;  // directories used, if tracked
+    RunningHarvester *           harvester_; // concurrent harvester, if any
+  };
+
+  BookingTransaction *          transaction_() const;
+  std::string &                 currentFolder_();
+  const std::string &           currentFolder_() const;
+  uint32_t                      currentRun_() const;
+  uint32_t                      currentModuleId_() const;
+  void                          trackAccess_(const std::string &dir) const;
+
   bool        extract(TObject *obj, const std::string &dir, bool overwrite, bool collateHistograms);
   TObject *   extractNextObject(TBufferFile&) const;
 
   // ---------------------- Booking ------------------------------------
   MonitorElement *              initialise(MonitorElement *me, const std::string &path);
+  MonitorElement *              insert_(const std::string &dir,
+                                        const std::string &name);
   MonitorElement *              book_(const std::string &dir,
                                       const std::string &name,
                                       const char *context);
@@ -801,6 +948,7 @@ class DQMStore
   using MEMap                 = std::set<MonitorElement>;
   using QCMap                 = std::map<std::string, QCriterion *>;
   using QAMap                 = std::map<std::string, QCriterion *(*)(const std::string &)>;
+  using QCloneMap             = std::map<std::string, QCriterion *(*)(const QCriterion *)>;
 
 
   // ------------------------ private I/O helpers ------------------------------
@@ -836,20 +984,34 @@ class DQMStore
   bool                          enableMultiThread_;
   bool                          LSbasedMode_;
   bool                          forceResetOnBeginLumi_;
+  bool                          nativeHistograms_;
+  bool                          nativeFloatPrecision_;
+  bool                          concurrentHarvesting_;
   std::string                   readSelectedDirectory_;
-  uint32_t                      run_;
-  uint32_t                      moduleId_;
   std::ofstream *               stream_;
 
   std::string                   pwd_;
   MEMap                         data_;
   std::set<std::string>         dirs_;
 
+  // Hash index of data_ for the lookups of a single ME, sharded so that
+  // concurrent lookups and insertions rarely contend.
+  class MEIndex;
+  std::unique_ptr<MEIndex>      index_;
+
+  // Harvesters, their tracked directories and the queue of their
+  // dqmEndJob, for the concurrent harvesting.
+  class HarvestingScheduler;
+  std::unique_ptr<HarvestingScheduler> harvesting_;
+
   QCMap                         qtests_;
   QAMap                         qalgos_;
+  QCloneMap                     qclones_;
   QTestSpecs                    qtestspecs_;
 
-  std::mutex book_mutex_;
+  mutable std::mutex book_mutex_;
+  std::array<std::mutex, 16> transaction_mutexes_;
+  static thread_local BookingTransaction * currentTransaction_;
   IBooker * ibooker_;
   IGetter * igetter_;
 
@@ -16,6 +16,8 @@
 # include "TObjString.h"
 # include "TAxis.h"
 # include <sys/time.h>
+# include <functional>
+# include <memory>
 # include <string>
 # include <set>
 # include <map>
@@ -29,6 +31,7 @@
 # endif
 
 class QCriterion;
+namespace dqm { class NativeHistogram; }
 
 // tag for a special constructor, see below
 struct MonitorElementNoCloneTag {};
@@ -64,9 +67,18 @@ public:
   };
 
 private:
+  enum NativeMode
+  {
+    DQM_NATIVE_OFF,                  //< Always a ROOT object.
+    DQM_NATIVE_ON,                   //< Native storage at the first fill, if possible.
+    DQM_NATIVE_FLOAT                 //< Idem, with the contents in single precision.
+  };
+
   DQMNet::CoreObject    data_;       //< Core object information.
   Scalar                scalar_;     //< Current scalar value.
-  TH1                   *object_;    //< Current ROOT object value.
+  mutable TH1           *object_;    //< Current ROOT object value.
+  mutable dqm::NativeHistogram *native_; //< Compact histogram replacing object_, if any.
+  mutable NativeMode    nativeMode_; //< Whether object_ may be replaced by native_.
   TH1                   *reference_; //< Current ROOT reference object.
   TH1                   *refvalue_;  //< Soft reference if any.
   std::vector<QReport>  qreports_;   //< QReports associated to this object.
@@ -183,6 +195,7 @@ public:
   void Fill(double x, double y, double z, double w);
   void ShiftFillLast(double y, double ye = 0., int32_t xscale = 1);
   void Reset();
+  void merge(const MonitorElement &other);
 
   std::string valueString() const;
   std::string tagString() const;
@@ -229,9 +242,17 @@ public:
   void runQTests();
 
 private:
+  /// run the quality tests with the criteria given by copyOf(criterion),
+  /// copies private to the calling thread when the quality tests of
+  /// several MEs run concurrently
+  void runQTests(const std::function<QCriterion *(QCriterion *)> &copyOf);
   void doFill(int64_t x);
   void incompatible(const char *func) const;
   TH1 *accessRootObject(const char *func, int reqdim) const;
+  TH1 *exposeRootObject(const char *func, int reqdim) const;
+  dqm::NativeHistogram *nativeHistogram(int reqdim);
+  void materialize(bool handOut) const;
+  void enableNativeStorage(bool floatPrecision);
 
 public:
 #if DQM_ROOT_METHODS
@@ -332,6 +353,9 @@ private:
 
 public:
   TObject *getRootObject() const;
+  /// the ROOT object to be written or sent, a temporary one owned by tmp
+  /// if the histogram is stored natively, which it remains
+  TH1 *rootObjectForIO(std::unique_ptr<TH1> &tmp) const;
   TH1 *getTH1() const;
   TH1F *getTH1F() const;
   TH1S *getTH1S() const;
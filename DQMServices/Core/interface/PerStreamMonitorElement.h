@@ -0,0 +1,169 @@
+#ifndef DQMServices_Core_PerStreamMonitorElement_h
+#define DQMServices_Core_PerStreamMonitorElement_h
+
+/* Encapsulate a MonitorElement to fill it from several streams without
+ * locking: every stream fills its own private copy of the histogram, and
+ * the copies are added to the MonitorElement held by the DQMStore when
+ * the stream ends a luminosity block (see DQMPerStreamEDAnalyzer).
+ *
+ * Only histograms and profiles can be filled per stream.
+ */
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "DQMServices/Core/interface/MonitorElement.h"
+
+class PerStreamMonitorElement
+{
+public:
+  // The private copies of one MonitorElement, owned by the module that
+  // booked it. The copies are made from a reset clone of the booked
+  // MonitorElement, taken once its booking is complete, so that they
+  // have the same binning and labels and the MonitorElement itself is
+  // only read or written when a stream merges its copy.
+  class Copies
+  {
+  public:
+    Copies(MonitorElement* me, unsigned int nStreams) :
+      me_(me),
+      streams_(nStreams),
+      filled_(nStreams, 0)
+    { }
+
+    Copies(Copies const&) = delete;
+    Copies& operator=(Copies const&) = delete;
+
+    // to be called at the end of the booking, before any fill
+    void prepare()
+    {
+      proto_ = std::make_unique<MonitorElement>(*me_);
+      proto_->Reset();
+    }
+
+    // the copy filled by a stream, made at the first fill
+    MonitorElement& stream(unsigned int stream)
+    {
+      auto& copy = streams_[stream];
+      if (not copy)
+        copy = std::make_unique<MonitorElement>(*proto_);
+      filled_[stream] = 1;
+      return *copy;
+    }
+
+    // add the copy of a stream to the MonitorElement and reset it; the
+    // merges of different streams must not run concurrently
+    void merge(unsigned int stream)
+    {
+      if (not filled_[stream])
+        return;
+      me_->merge(*streams_[stream]);
+      streams_[stream]->Reset();
+      filled_[stream] = 0;
+    }
+
+    MonitorElement* me() const
+    {
+      return me_;
+    }
+
+  private:
+    MonitorElement* me_;
+    std::unique_ptr<MonitorElement> proto_;
+    std::vector<std::unique_ptr<MonitorElement>> streams_;
+    // one flag per stream, each one is only written by its own stream
+    std::vector<char> filled_;
+  };
+
+  PerStreamMonitorElement() :
+    copies_(nullptr)
+  { }
+
+  explicit PerStreamMonitorElement(Copies* copies) :
+    copies_(copies)
+  { }
+
+  // expose as a const method to mean that it is concurrent-safe, as long
+  // as each stream passes its own index
+  template <typename... Args>
+  void fill(unsigned int stream, Args && ... args) const
+  {
+    copies_->stream(stream).Fill(std::forward<Args>(args)...);
+  }
+
+  void reset()
+  {
+    copies_ = nullptr;
+  }
+
+  operator bool() const
+  {
+    return (copies_ != nullptr);
+  }
+
+  // the MonitorElement in the DQMStore; its contents are only complete
+  // once all the streams have merged their copies
+  MonitorElement const* monitorElement() const
+  {
+    return copies_->me();
+  }
+
+  // non-const methods to manipulate axes and titles.
+  // these must be used only while the MonitorElement is being booked,
+  // the private copies are made afterwards.
+  void setTitle(std::string const& title)
+  {
+    copies_->me()->setTitle(title);
+  }
+
+  void setXTitle(std::string const& title)
+  {
+    copies_->me()->getTH1()->SetXTitle(title.c_str());
+  }
+
+  void setXTitle(const char* title)
+  {
+    copies_->me()->getTH1()->SetXTitle(title);
+  }
+
+  void setYTitle(std::string const& title)
+  {
+    copies_->me()->getTH1()->SetYTitle(title.c_str());
+  }
+
+  void setYTitle(const char* title)
+  {
+    copies_->me()->getTH1()->SetYTitle(title);
+  }
+
+  void setAxisRange(double xmin, double xmax, int axis = 1)
+  {
+    copies_->me()->setAxisRange(xmin, xmax, axis);
+  }
+
+  void setAxisTitle(std::string const& title, int axis = 1)
+  {
+    copies_->me()->setAxisTitle(title, axis);
+  }
+
+  void setBinLabel(int bin, std::string const& label, int axis = 1)
+  {
+    copies_->me()->setBinLabel(bin, label, axis);
+  }
+
+  void enableSumw2()
+  {
+    copies_->me()->getTH1()->Sumw2();
+  }
+
+  void setLumiFlag()
+  {
+    copies_->me()->setLumiFlag();
+  }
+
+private:
+  Copies* copies_;
+};
+
+#endif // DQMServices_Core_PerStreamMonitorElement_h
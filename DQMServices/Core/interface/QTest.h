@@ -67,6 +67,11 @@ public:
   /// (not relevant for all quality tests!)
   virtual std::vector<DQMChannel> getBadChannels() const
                                         { return std::vector<DQMChannel>(); }
+  /// read the bins of the plain 1D and 2D histograms directly from their
+  /// arrays (default), or through GetBinContent and GetBinError as for
+  /// the other kinds; the results are the same, for comparisons
+  static void setDirectBinAccess(bool direct) { directBinAccess_ = direct; }
+  static bool directBinAccess()         { return directBinAccess_; }
 
 protected:
   QCriterion(std::string qtname)        { qtname_ = std::move(qtname); init(); }
@@ -80,7 +85,7 @@ protected:
   void setAlgoName(std::string name)    { algoName_ = std::move(name); }
 
   float runTest(const MonitorElement *me, QReport &qr, DQMNet::QValue &qv)   {
-      assert(qr.qcriterion_ == this);
+      assert(qr.qcriterion_->getName() == qtname_); // this or a copy of it
       assert(qv.qtname == qtname_);
 
       prob_ = runTest(me); // this runTest goes to SimpleTest derivates
@@ -123,6 +128,7 @@ private:
   /// default "probability" values for setting warnings & errors when running tests
   static const float WARNING_PROB_THRESHOLD;
   static const float ERROR_PROB_THRESHOLD;
+  static bool directBinAccess_;
 
   /// for creating and deleting class instances
   friend class DQMStore;
@@ -112,6 +112,15 @@ namespace edm
     template <typename F>
     void watchPostModuleGlobalEndRun(F) {}
 
+    template <typename F>
+    void watchPreModuleConstruction(F) {}
+
+    template <typename F>
+    void watchPreModuleEndJob(F) {}
+
+    template <typename F>
+    void watchPostEndJob(F) {}
+
     PreallocationSignal preallocateSignal_;
   };
 
@@ -132,6 +141,7 @@ namespace edm
   {
   public:
     unsigned int id() const {return 0;}
+    std::string const& moduleLabel() const { static std::string label; return label; }
   };
 
   class ModuleCallingContext
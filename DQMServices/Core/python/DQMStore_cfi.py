@@ -10,5 +10,21 @@ DQMStore = cms.Service("DQMStore",
     #MEs are flagged to be LS based.
     LSbasedMode = cms.untracked.bool(False),
     #this is bound to the enableMultiThread flag.
-    forceResetOnBeginLumi = cms.untracked.bool(False)
+    forceResetOnBeginLumi = cms.untracked.bool(False),
+    #keep the plain 1D and 2D histograms in a compact native storage
+    #once filled, instead of their ROOT objects; modules must not keep
+    #pointers to the ROOT objects across runs.
+    nativeHistograms = cms.untracked.bool(False),
+    nativeHistogramsFloatPrecision = cms.untracked.bool(False),
+    #run the dqmEndJob of the harvesters which use different folders
+    #concurrently. The folders used by each harvester are read from
+    #the harvestingProfile file, and written back to it at the end of
+    #the job. Only the harvesters listed in concurrentHarvesters, which
+    #must not fit with ROOT or use any other global ROOT state, run
+    #concurrently; the others, and those not in the profile, run one
+    #after the other. A harvester using a folder outside of its profile
+    #runs alone from then on.
+    concurrentHarvesting = cms.untracked.bool(False),
+    harvestingProfile = cms.untracked.string(''),
+    concurrentHarvesters = cms.untracked.vstring()
 )
@@ -9,5 +9,7 @@ from DQMServices.Core.DQMStore_cfi import *
 #    publishFrequency = cms.untracked.double(5.0),
 #    collectorPort = cms.untracked.int32(9090),
 #    collectorHost = cms.untracked.string('localhost'),
-#    filter = cms.untracked.string('')
+#    filter = cms.untracked.string(''),
+#    # send histograms as changes to a full snapshot, sent every N updates
+#    deltaUpdates = cms.untracked.int32(0)
 #)
@@ -0,0 +1,74 @@
+# Event throughput of DQM-heavy jobs for the three ways of filling histograms
+# in multithreaded jobs, e.g.
+#   cmsRun dqm_testFillThroughput_cfg.py mode=one
+#   cmsRun dqm_testFillThroughput_cfg.py mode=concurrent
+#   cmsRun dqm_testFillThroughput_cfg.py mode=perstream
+# and compare the event throughput printed in the TimeReport. In the
+# perstream mode the modules check at the end of the run that the merged
+# histograms have all their entries.
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+
+options = VarParsing.VarParsing()
+options.register('mode',
+                 'perstream',
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.string,
+                 "one, concurrent or perstream")
+options.register('numberOfThreads',
+                 16,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of threads and streams")
+options.register('numberOfModules',
+                 20,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of DQM modules")
+options.register('numberOfHistograms',
+                 100,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of histograms per module")
+options.register('fillsPerEvent',
+                 10,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of fills per histogram and event")
+options.register('numberOfEvents',
+                 20000,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of events")
+options.parseArguments()
+
+modules = {'one': (cms.EDProducer, 'DQMTestOneFill'),
+           'concurrent': (cms.EDAnalyzer, 'DQMTestConcurrentFill'),
+           'perstream': (cms.EDProducer, 'DQMTestPerStreamFill')}
+
+process = cms.Process("DQMFILLTHROUGHPUT")
+process.load("DQMServices.Core.DQM_cfg")
+process.DQMStore.enableMultiThread = cms.untracked.bool(True)
+
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(options.numberOfEvents)
+)
+
+process.source = cms.Source("EmptySource",
+                            numberEventsInLuminosityBlock = cms.untracked.uint32(100))
+
+process.options = cms.untracked.PSet(
+    numberOfStreams = cms.untracked.uint32(options.numberOfThreads),
+    numberOfThreads = cms.untracked.uint32(options.numberOfThreads),
+    wantSummary = cms.untracked.bool(True)
+)
+
+process.p = cms.Path()
+for i in range(options.numberOfModules):
+    moduleType, plugin = modules[options.mode]
+    module = moduleType(plugin,
+                        folder = cms.untracked.string("Throughput/Module%d" % i),
+                        numberOfHistograms = cms.untracked.uint32(options.numberOfHistograms),
+                        fillsPerEvent = cms.untracked.uint32(options.fillsPerEvent))
+    setattr(process, "dqmFill%d" % i, module)
+    process.p += module
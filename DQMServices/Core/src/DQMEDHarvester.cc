@@ -10,11 +10,17 @@ DQMEDHarvester::DQMEDHarvester() {
   usesResource("DQMStore");
   lumiToken_ = produces<DQMToken,edm::Transition::EndLuminosityBlock>("endLumi");
   runToken_ = produces<DQMToken,edm::Transition::EndRun>("endRun");
+  edm::Service<DQMStore> store;
+  if (store.isAvailable())
+    store->registerHarvester();
 }
 
+// With concurrent harvesting, the dqmEndJob is queued in the DQMStore and
+// runs, possibly concurrently with that of other harvesters, before the
+// endJob of the next module that is not a harvester.
 void DQMEDHarvester::endJob() {
   DQMStore * store = edm::Service<DQMStore>().operator->();
-  store->meBookerGetter([this](DQMStore::IBooker &b, DQMStore::IGetter &g) {
+  store->queueHarvesting(moduleDescription().id(), [this](DQMStore::IBooker &b, DQMStore::IGetter &g) {
     this->dqmEndJob(b, g);
   });
 }
@@ -22,7 +28,7 @@ void DQMEDHarvester::endJob() {
 void DQMEDHarvester::endLuminosityBlock(edm::LuminosityBlock const& iLumi,
 					edm::EventSetup const& iSetup) {
   DQMStore * store = edm::Service<DQMStore>().operator->();
-  store->meBookerGetter([this, &iLumi, &iSetup](DQMStore::IBooker &b, DQMStore::IGetter &g){
+  store->runHarvesting(moduleDescription().id(), [this, &iLumi, &iSetup](DQMStore::IBooker &b, DQMStore::IGetter &g){
     this->dqmEndLuminosityBlock(b, g, iLumi, iSetup);
   });
 }
@@ -11,6 +11,7 @@
 #include "classlib/utils/StringOps.h"
 #include "classlib/utils/SystemError.h"
 #include "classlib/utils/Regexp.h"
+#include <zlib.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
@@ -257,6 +258,49 @@ DQMNet::unpackQualityData(QReports &qr, uint32_t &flags, const char *from)
   }
 }
 
+/// Encode @a data as a delta to @a base, appended to @a into: the
+/// compressed XOR of the two, which is mostly zeroes when only a few
+/// bins of a histogram have changed.  Fails if the two differ in size
+/// or if the delta would not be much smaller than the data itself.
+bool
+DQMNet::encodeDelta(DataBlob &into, const DataBlob &base, const DataBlob &data)
+{
+  if (data.empty() || base.size() != data.size())
+    return false;
+
+  DataBlob diff(data.size());
+  for (size_t i = 0, e = data.size(); i != e; ++i)
+    diff[i] = data[i] ^ base[i];
+
+  size_t offset = into.size();
+  uLongf len = compressBound(diff.size());
+  into.resize(offset + len);
+  if (compress2(&into[offset], &len, &diff[0], diff.size(), 1) != Z_OK
+      || len > data.size() / 2)
+  {
+    into.resize(offset);
+    return false;
+  }
+
+  into.resize(offset + len);
+  return true;
+}
+
+/// Rebuild into @a into the data encoded by encodeDelta() as the @a
+/// len bytes at @a delta relative to @a base.
+bool
+DQMNet::applyDelta(DataBlob &into, const DataBlob &base, const unsigned char *delta, size_t len)
+{
+  uLongf size = base.size();
+  into.resize(size);
+  if (uncompress(&into[0], &size, delta, len) != Z_OK || size != base.size())
+    return false;
+
+  for (size_t i = 0, e = into.size(); i != e; ++i)
+    into[i] ^= base[i];
+  return true;
+}
+
 #if 0
 // Deserialise a ROOT object from a buffer at the current position.
 static TObject *
@@ -415,7 +459,7 @@ DQMNet::releaseFromWait(Bucket *msg, WaitObject &w, Object *o)
 // without the object data, except the data is always sent for scalar
 // objects.
 void
-DQMNet::sendObjectToPeer(Bucket *msg, Object &o, bool data)
+DQMNet::sendObjectToPeer(Bucket *msg, Object &o, bool data, bool delta)
 {
   uint32_t flags = o.flags & ~DQM_PROP_DEAD;
   DataBlob objdata;
@@ -424,6 +468,37 @@ DQMNet::sendObjectToPeer(Bucket *msg, Object &o, bool data)
     objdata.insert(objdata.end(),
 		   &o.scalar[0],
 		   &o.scalar[0] + o.scalar.size());
+  else if (data && delta && deltaUpdates_ && ! o.rawdata.empty())
+  {
+    // Send only the changes since the last snapshot.  Send a new
+    // snapshot instead every deltaUpdates_ updates, or when the
+    // changes are too large.  Both are preceded by the version of
+    // the snapshot.
+    DataBlob changes;
+    if (! o.basedata.empty()
+	&& o.ndeltas < deltaUpdates_
+	&& encodeDelta(changes, o.basedata, o.rawdata))
+    {
+      flags |= DQM_PROP_DELTA;
+      ++o.ndeltas;
+    }
+    else
+    {
+      o.basedata = o.rawdata;
+      o.baseversion = o.version;
+      o.ndeltas = 0;
+      flags |= DQM_PROP_SNAPSHOT;
+    }
+
+    const DataBlob &payload = (flags & DQM_PROP_DELTA) ? changes : o.rawdata;
+    uint32_t base[2] = { uint32_t(o.baseversion & 0xffffffff),
+			 uint32_t(o.baseversion >> 32) };
+    objdata.reserve(sizeof(base) + payload.size());
+    objdata.insert(objdata.end(),
+		   (unsigned char *) &base[0],
+		   (unsigned char *) &base[0] + sizeof(base));
+    objdata.insert(objdata.end(), payload.begin(), payload.end());
+  }
   else if (data)
     objdata.insert(objdata.end(),
 		   &o.rawdata[0],
@@ -462,6 +537,14 @@ DQMNet::sendObjectToPeer(Bucket *msg, Object &o, bool data)
     copydata(msg, &o.qdata[0], qlen);
 }
 
+/// Check whether objects are sent to @a p as deltas: only to the
+/// collector this node updates, see deltaUpdates().
+bool
+DQMNet::sendsDeltas(const Peer *p) const
+{
+  return deltaUpdates_ && p->automatic == &downstream_;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Handle peer messages.
 bool
@@ -499,7 +582,7 @@ DQMNet::onMessage(Bucket *msg, Peer *p, unsigned char *data, size_t len)
 	  << p->peeraddr << ", size " << len << std::endl;
 
       // Send over current status: list of known objects.
-      sendObjectListToPeer(msg, true, false);
+      sendObjectListToPeer(msg, true, false, sendsDeltas(p));
     }
     return true;
 
@@ -540,7 +623,13 @@ DQMNet::onMessage(Bucket *msg, Peer *p, unsigned char *data, size_t len)
 	    && (o->flags & DQM_PROP_TYPE_MASK) > DQM_PROP_TYPE_SCALAR)
 	  waitForData(p, name, "", owner);
 	else
-	  sendObjectToPeer(msg, *o, true);
+	{
+	  // A peer receiving deltas asks for the full data when it does
+	  // not have the snapshot they refer to: send it a new one.
+	  if (sendsDeltas(p))
+	    o->basedata.clear();
+	  sendObjectToPeer(msg, *o, true, sendsDeltas(p));
+	}
       }
       else
       {
@@ -673,7 +762,8 @@ DQMNet::onMessage(Bucket *msg, Peer *p, unsigned char *data, size_t len)
       if (! o)
 	o = makeObject(p, name);
 
-      o->flags = words[2] | DQM_PROP_NEW | DQM_PROP_RECEIVED;
+      o->flags = ((words[2] & ~(DQM_PROP_DELTA | DQM_PROP_SNAPSHOT))
+		  | DQM_PROP_NEW | DQM_PROP_RECEIVED);
       o->tag = words[5];
       o->version = ((uint64_t) words[4] << 32 | words[3]);
       o->scalar.clear();
@@ -683,6 +773,41 @@ DQMNet::onMessage(Bucket *msg, Peer *p, unsigned char *data, size_t len)
 	o->rawdata.clear();
         o->scalar.insert(o->scalar.end(), objdata, qdata);
       }
+      else if (datalen && (words[2] & (DQM_PROP_DELTA | DQM_PROP_SNAPSHOT)))
+      {
+	// Delta encoded data, see sendObjectToPeer(): a snapshot is kept
+	// to rebuild the data from the following deltas.  If we do not
+	// have the snapshot a delta refers to, continue as if no data was
+	// sent, which asks for the full data.
+	uint32_t base[2] = { 0, 0 };
+	if (datalen >= sizeof(base))
+	  memcpy(&base[0], objdata, sizeof(base));
+	uint64_t baseversion = ((uint64_t) base[1] << 32 | base[0]);
+	unsigned char *payload = objdata + sizeof(base);
+	DataBlob rawdata;
+	if (datalen < sizeof(base))
+	  datalen = 0;
+	else if (words[2] & DQM_PROP_SNAPSHOT)
+	{
+	  o->rawdata.assign(payload, qdata);
+	  o->basedata = o->rawdata;
+	  o->baseversion = o->version;
+	}
+	else if (! o->basedata.empty()
+		 && o->baseversion == baseversion
+		 && applyDelta(rawdata, o->basedata, payload, qdata - payload))
+	  o->rawdata.swap(rawdata);
+	else
+	{
+	  if (debug_)
+	    logme()
+	      << "DEBUG: cannot apply delta to '" << name << "' from "
+	      << p->peeraddr << ", requesting full data" << std::endl;
+	  datalen = 0;
+	  if (! o->rawdata.empty())
+	    o->flags |= DQM_PROP_STALE;
+	}
+      }
       else if (datalen)
       {
 	o->rawdata.clear();
@@ -1075,6 +1200,7 @@ DQMNet::DQMNet (const std::string &appname /* = "" */)
     communicate_ ((pthread_t) -1),
     shutdown_ (0),
     delay_ (1000),
+    deltaUpdates_ (0),
     waitStale_ (0, 0, 0, 0, 500000000 /* 500 ms */),
     waitMax_ (0, 0, 0, 5 /* seconds */, 0),
     flush_ (false)
@@ -1113,6 +1239,17 @@ DQMNet::delay(int delay)
   delay_ = delay;
 }
 
+/// Send the object data to the collector given to updateToCollector()
+/// as deltas to the last full snapshot sent, with a new snapshot at
+/// least every @a snapshotInterval updates; zero, the default, always
+/// sends the full data.  The collector must understand delta updates.
+/// Must be called before calling run() or start().
+void
+DQMNet::deltaUpdates(unsigned snapshotInterval)
+{
+  deltaUpdates_ = snapshotInterval;
+}
+
 /// Set the time limit for waiting updates to stale objects.
 /// Once limit has been exhausted whatever data exists is returned.
 /// Applies only when data has been received, another time limit is
@@ -41,12 +41,15 @@ DQMService::DQMService(const edm::ParameterSet &pset, edm::ActivityRegistry &ar)
   bool verbose = pset.getUntrackedParameter<bool>("verbose", false);
   publishFrequency_ = pset.getUntrackedParameter<double>("publishFrequency", publishFrequency_);
   std::string filter = pset.getUntrackedParameter<std::string>("filter", "");
+  int deltaUpdates = pset.getUntrackedParameter<int>("deltaUpdates", 0);
 
   if (host != "" && port > 0)
   {
     net_ = new DQMBasicNet;
     net_->debug(verbose);
     net_->updateToCollector(host, port);
+    if (deltaUpdates > 0)
+      net_->deltaUpdates(deltaUpdates);
     net_->start();
   }
 
@@ -140,7 +143,8 @@ void DQMService::flushStandalone()
       default:
 	{
           TBufferFile buffer(TBufferFile::kWrite);
-          buffer.WriteObject(me.object_);
+          std::unique_ptr<TH1> tmp;
+          buffer.WriteObject(me.rootObjectForIO(tmp));
           if (me.reference_)
 	    buffer.WriteObject(me.reference_);
           else
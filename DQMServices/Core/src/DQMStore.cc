@@ -16,6 +16,13 @@
 #include "TClass.h"
 #include "TSystem.h"
 #include "TBufferFile.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+#include "tbb/task_group.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iterator>
 #include <cerrno>
 #include <boost/algorithm/string.hpp>
@@ -24,6 +31,8 @@
 #include <fstream>
 #include <sstream>
 #include <exception>
+#include <functional>
+#include <unordered_map>
 #include <utility>
 
 /** @var DQMStore::verbose_
@@ -52,6 +61,10 @@ DQMOldReceiver::runQualityTests.  */
 /** @var DQMStore::qalgos_
     Set of all the available quality test algorithms. */
 
+/** @var DQMStore::qclones_
+    Copy functions of the quality test algorithms, for running the
+    tests of several monitor elements concurrently. */
+
 //////////////////////////////////////////////////////////////////////
 /// name of global monitoring folder (containing all sources subdirectories)
 static const std::string s_monitorDirName = "DQMData";
@@ -125,9 +138,518 @@ makeQCriterion(const std::string &qtname)
 { return new T(qtname); }
 
 template <class T>
+QCriterion *
+cloneQCriterion(const QCriterion *qc)
+{ return new T(static_cast<const T &>(*qc)); }
+
+template <class T>
+void
+initQCriterion(std::map<std::string, QCriterion *(*)(const std::string &)> &m,
+               std::map<std::string, QCriterion *(*)(const QCriterion *)> &clones)
+{
+  m[T::getAlgoName()] = &makeQCriterion<T>;
+  clones[T::getAlgoName()] = &cloneQCriterion<T>;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// Hash index of the monitor elements, keyed like data_ on (run, lumi,
+/// module id, directory, name). The index is split in shards, each with
+/// its own lock, so that threads booking or looking up different monitor
+/// elements do not serialise on a single mutex. Only the elements are
+/// indexed: the range scans (directory contents, per-run clones, saving)
+/// still use the ordered data_.
+class DQMStore::MEIndex
+{
+public:
+  static size_t
+  hash(const std::string &dir, const std::string &name,
+       uint32_t run, uint32_t lumi, uint32_t moduleId)
+  {
+    size_t seed = std::hash<std::string>()(dir);
+    combine(seed, std::hash<std::string>()(name));
+    combine(seed, (size_t(run) << 32) | lumi);
+    combine(seed, moduleId);
+    return seed;
+  }
+
+  MonitorElement *
+  find(const std::string &dir, const std::string &name,
+       uint32_t run, uint32_t lumi, uint32_t moduleId) const
+  {
+    size_t h = hash(dir, name, run, lumi, moduleId);
+    Shard &shard = shards_[shardOf(h)];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto range = shard.elements.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i)
+    {
+      MonitorElement *me = i->second;
+      if (me->run() == run && me->lumi() == lumi && me->moduleId() == moduleId
+          && me->getName() == name && me->getPathname() == dir)
+        return me;
+    }
+    return nullptr;
+  }
+
+  void
+  insert(MonitorElement *me)
+  {
+    size_t h = hash(me);
+    Shard &shard = shards_[shardOf(h)];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.elements.emplace(h, me);
+  }
+
+  void
+  erase(const MonitorElement *me)
+  {
+    size_t h = hash(me);
+    Shard &shard = shards_[shardOf(h)];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto range = shard.elements.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i)
+      if (i->second == me)
+      {
+        shard.elements.erase(i);
+        return;
+      }
+  }
+
+private:
+  static constexpr unsigned int nShards = 64;
+
+  // One cache line per shard, the mutexes of two shards must not share one.
+  struct alignas(64) Shard
+  {
+    std::mutex mutex;
+    std::unordered_multimap<size_t, MonitorElement *> elements;
+  };
+
+  static void
+  combine(size_t &seed, size_t value)
+  { seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2); }
+
+  static size_t
+  hash(const MonitorElement *me)
+  { return hash(me->getPathname(), me->getName(), me->run(), me->lumi(), me->moduleId()); }
+
+  // use the high bits, the low ones select the bucket within the shard
+  static unsigned int
+  shardOf(size_t h)
+  { return (h >> 40) % nShards; }
+
+  mutable std::array<Shard, nShards> shards_;
+};
+
+//////////////////////////////////////////////////////////////////////
+thread_local DQMStore::BookingTransaction *DQMStore::currentTransaction_ = nullptr;
+
+/// Start a booking transaction in the current thread. The transactions
+/// of one module are serialised, as the stream instances of the module
+/// book the same monitor elements.
+/// A transaction which is not serialised is one of a harvester, run
+/// only by the harvesting scheduler.
+DQMStore::BookingTransaction::BookingTransaction(DQMStore *store, uint32_t run, uint32_t moduleId,
+                                                 bool serialise /* = true */)
+  : guard_(serialise
+           ? std::unique_lock<std::mutex>(store->transaction_mutexes_[moduleId % store->transaction_mutexes_.size()])
+           : std::unique_lock<std::mutex>()),
+    store_(store),
+    run_(run),
+    moduleId_(moduleId),
+    pwd_(store->pwd_),
+    previous_(currentTransaction_),
+    accessed_(nullptr),
+    harvester_(nullptr)
+{
+  currentTransaction_ = this;
+}
+
+DQMStore::BookingTransaction::~BookingTransaction()
+{
+  currentTransaction_ = previous_;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+/// Harvesters of the job, with the directories each of them reads or
+/// books, and the queue of the dqmEndJob deferred to runHarvestingQueue.
+/// The directories used by each harvester in earlier jobs are read from,
+/// and written back to, a profile file: two queued harvesters run
+/// concurrently only if both are declared safe to run concurrently, that
+/// is they do not use ROOT fitting or other global ROOT state, and their
+/// profiles show they use disjoint directory trees. Any other harvester
+/// runs alone, after those queued before it and before those queued after
+/// it, as it would without the scheduler; the queue is in the order of
+/// the configuration.
+/// As the profile may be out of date, a concurrent harvester which uses a
+/// directory outside of its profile first waits for the other harvesters
+/// running to finish, and then runs alone.
+class DQMStore::HarvestingScheduler
+{
+public:
+  HarvestingScheduler(std::string profileFile, const std::vector<std::string> &concurrentHarvesters)
+    : profileFile_(std::move(profileFile)),
+      concurrentHarvesters_(concurrentHarvesters.begin(), concurrentHarvesters.end()),
+      constructing_(0),
+      running_(0),
+      alone_(false)
+  {
+    // one line per harvester label, then one per directory it used,
+    // as the label and the directory separated by a tab
+    std::ifstream in(profileFile_);
+    std::string line;
+    while (std::getline(in, line))
+    {
+      size_t tab = line.find('\t');
+      if (tab == std::string::npos)
+        profiles_[line];
+      else
+        profiles_[line.substr(0, tab)].insert(line.substr(tab+1));
+    }
+  }
+
+  /// module being constructed, that is a harvester if it registers
+  void
+  constructing(uint32_t moduleId, const std::string &label)
+  {
+    constructing_ = moduleId;
+    constructingLabel_ = label;
+  }
+
+  void
+  addConstructing()
+  { harvesters_[constructing_].label = constructingLabel_; }
+
+  bool
+  isHarvester(uint32_t moduleId) const
+  { return harvesters_.count(moduleId) > 0; }
+
+  /// directories used by the harvester in this job
+  std::set<std::string> &
+  used(uint32_t moduleId)
+  {
+    Harvester &h = harvesters_[moduleId];
+    if (h.label.empty())
+      h.label = "module" + std::to_string(moduleId);
+    return h.used;
+  }
+
+  void
+  queue(uint32_t moduleId, HarvestingFunction f)
+  {
+    used(moduleId);
+    queue_.emplace_back(moduleId, std::move(f));
+  }
+
+  bool
+  empty() const
+  { return queue_.empty(); }
+
+  void run(DQMStore &store, unsigned verbose);
+
+  /// the concurrent harvesters share the gate, unless one runs alone
+  void
+  enter()
+  {
+    std::unique_lock<std::mutex> lock(gateMutex_);
+    gateCondition_.wait(lock, [this]() { return ! alone_; });
+    ++running_;
+  }
+
+  void
+  leave(bool alone)
+  {
+    std::lock_guard<std::mutex> lock(gateMutex_);
+    if (alone)
+      alone_ = false;
+    else
+      --running_;
+    gateCondition_.notify_all();
+  }
+
+  /// called by a concurrent harvester which entered the gate, to wait
+  /// until no other is running; none starts until it leaves
+  void
+  runAlone()
+  {
+    std::unique_lock<std::mutex> lock(gateMutex_);
+    --running_;
+    gateCondition_.notify_all();
+    gateCondition_.wait(lock, [this]() { return ! alone_; });
+    alone_ = true;
+    gateCondition_.wait(lock, [this]() { return running_ == 0; });
+  }
+
+private:
+  struct Harvester
+  {
+    std::string label;
+    std::set<std::string> used;
+  };
+
+  static bool
+  overlap(const std::set<std::string> &a, const std::set<std::string> &b)
+  {
+    for (auto const &da : a)
+      for (auto const &db : b)
+        if (isSubdirectory(da, db) || isSubdirectory(db, da))
+          return true;
+    return false;
+  }
+
+  void writeProfile() const;
+
+  std::string                                           profileFile_;
+  std::set<std::string>                                 concurrentHarvesters_;
+  std::map<std::string, std::set<std::string>>          profiles_;
+  std::map<uint32_t, Harvester>                         harvesters_;
+  std::vector<std::pair<uint32_t, HarvestingFunction>>  queue_;
+  uint32_t                                              constructing_;
+  std::string                                           constructingLabel_;
+
+  std::mutex                                            gateMutex_;
+  std::condition_variable                               gateCondition_;
+  size_t                                                running_;
+  bool                                                  alone_;
+};
+
+/// A queued harvester while it runs concurrently with others, with the
+/// directories it may use without running alone.
+struct DQMStore::RunningHarvester
+{
+  RunningHarvester(HarvestingScheduler &scheduler, const std::set<std::string> &dirs)
+    : scheduler_(scheduler),
+      dirs_(dirs),
+      alone_(false)
+  { scheduler_.enter(); }
+
+  ~RunningHarvester()
+  { scheduler_.leave(alone_); }
+
+  RunningHarvester(const RunningHarvester &) = delete;
+  RunningHarvester &operator=(const RunningHarvester &) = delete;
+
+  void
+  access(const std::string &dir)
+  {
+    if (alone_)
+      return;
+    for (auto const &d : dirs_)
+      if (isSubdirectory(d, dir))
+        return;
+    scheduler_.runAlone();
+    alone_ = true;
+  }
+
+  HarvestingScheduler &          scheduler_;
+  const std::set<std::string> &  dirs_;
+  bool                           alone_;
+};
+
+/// run the queued harvesters, those with independent directories
+/// concurrently, then extend the profiles with the directories used
+void
+DQMStore::HarvestingScheduler::run(DQMStore &store, unsigned verbose)
+{
+  std::vector<std::pair<uint32_t, HarvestingFunction>> queue;
+  queue.swap(queue_);
+  size_t n = queue.size();
+
+  // directories of each harvester: its profile and those it already
+  // used in this job, at the end of the luminosity blocks
+  std::vector<Harvester *> harvesters(n);
+  std::vector<std::set<std::string>> dirs(n);
+  std::vector<char> profiled(n);
+  std::vector<char> concurrent(n);
+  size_t nconcurrent = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    harvesters[i] = &harvesters_[queue[i].first];
+    auto p = profiles_.find(harvesters[i]->label);
+    profiled[i] = (p != profiles_.end());
+    if (profiled[i])
+      dirs[i] = p->second;
+    dirs[i].insert(harvesters[i]->used.begin(), harvesters[i]->used.end());
+    concurrent[i] = profiled[i] && concurrentHarvesters_.count(harvesters[i]->label);
+    nconcurrent += concurrent[i];
+  }
+
+  // a harvester waits for the ones before it with which it shares a
+  // directory tree
+  std::vector<std::vector<size_t>> next(n);
+  std::unique_ptr<std::atomic<size_t>[]> waiting(new std::atomic<size_t>[n]);
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t count = 0;
+    for (size_t j = 0; j < i; ++j)
+      if (! concurrent[i] || ! concurrent[j] || overlap(dirs[i], dirs[j]))
+      {
+        next[j].push_back(i);
+        ++count;
+      }
+    waiting[i] = count;
+    if (count == 0)
+      ready.push_back(i);
+  }
+
+  std::vector<double> times(n, 0.);
+  std::vector<char> ranAlone(n);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  tbb::task_group group;
+  std::function<void(size_t)> start = [&](size_t i)
+    {
+      group.run([&, i]()
+        {
+          if (! failed)
+          {
+            auto begin = std::chrono::steady_clock::now();
+            try
+            {
+              // a harvester using TBB must not pick up another harvester
+              // while it holds the gate
+              tbb::this_task_arena::isolate([&]()
+                {
+                  BookingTransaction transaction(&store, 0, 0, false);
+                  transaction.accessed_ = &harvesters[i]->used;
+                  std::unique_ptr<RunningHarvester> running;
+                  if (concurrent[i])
+                    running.reset(new RunningHarvester(*this, dirs[i]));
+                  transaction.harvester_ = running.get();
+                  queue[i].second(*store.ibooker_, *store.igetter_);
+                  ranAlone[i] = running && running->alone_;
+                });
+            }
+            catch (...)
+            {
+              std::lock_guard<std::mutex> guard(errorMutex);
+              if (! error)
+                error = std::current_exception();
+              failed = true;
+            }
+            times[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+          }
+          for (size_t k : next[i])
+            if (--waiting[k] == 0)
+              start(k);
+        });
+    };
+
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i : ready)
+    start(i);
+  group.wait();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  if (verbose > 0)
+  {
+    double total = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      total += times[i];
+      if (verbose > 1)
+        std::cout << "DQMStore: harvester '" << harvesters[i]->label << "' ran in "
+                  << times[i] << " s" << (concurrent[i] ? "\n" : " alone\n");
+    }
+    std::cout << "DQMStore: ran " << n << " harvesters (" << nconcurrent << " concurrently) in "
+              << elapsed << " s, " << total << " s of harvesting\n";
+  }
+
+  // the profiles are extended with the directories used
+  bool changed = false;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (ranAlone[i])
+      std::cout << "DQMStore: WARNING: harvester '" << harvesters[i]->label
+                << "' used directories which are not in its harvesting profile,"
+                << " and ran alone from then on\n";
+    std::set<std::string> &profile = profiles_[harvesters[i]->label];
+    for (auto const &dir : harvesters[i]->used)
+      changed |= profile.insert(dir).second;
+    changed |= ! profiled[i];
+  }
+  if (changed && ! profileFile_.empty())
+    writeProfile();
+}
+
+void
+DQMStore::HarvestingScheduler::writeProfile() const
+{
+  std::ofstream out(profileFile_);
+  for (auto const &profile : profiles_)
+  {
+    out << profile.first << '\n';
+    for (auto const &dir : profile.second)
+      out << profile.first << '\t' << dir << '\n';
+  }
+  if (! out)
+    raiseDQMError("DQMStore", "Failed to write the harvesting profile '%s'",
+                  profileFile_.c_str());
+}
+
+/// note a directory read or booked into by the harvester running in the
+/// current thread, if its directories are tracked
+void
+DQMStore::trackAccess_(const std::string &dir) const
+{
+  BookingTransaction *t = transaction_();
+  if (t && t->harvester_)
+    t->harvester_->access(dir);
+  if (t && t->accessed_)
+    t->accessed_->insert(dir);
+}
+
+/// called by the DQMEDHarvesters when constructed: the module being
+/// constructed is a harvester, so the queued harvesters need not run
+/// before its endJob
+void
+DQMStore::registerHarvester()
+{
+  if (concurrentHarvesting_)
+    harvesting_->addConstructing();
+}
+
+/// run the harvesting code f of a module now, tracking the directories
+/// it uses if concurrent harvesting is enabled
+void
+DQMStore::runHarvesting(uint32_t moduleId, const HarvestingFunction &f)
+{
+  if (! concurrentHarvesting_)
+  {
+    meBookerGetter(f);
+    return;
+  }
+
+  runHarvestingQueue();
+  BookingTransaction transaction(this, 0, 0, false);
+  transaction.accessed_ = &harvesting_->used(moduleId);
+  f(*ibooker_, *igetter_);
+}
+
+/// run the dqmEndJob f of a harvester, later in runHarvestingQueue() if
+/// concurrent harvesting is enabled
 void
-initQCriterion(std::map<std::string, QCriterion *(*)(const std::string &)> &m)
-{ m[T::getAlgoName()] = &makeQCriterion<T>; }
+DQMStore::queueHarvesting(uint32_t moduleId, HarvestingFunction f)
+{
+  if (! concurrentHarvesting_)
+    meBookerGetter(f);
+  else
+    harvesting_->queue(moduleId, std::move(f));
+}
+
+/// run the queued harvesters; called before the endJob of any module
+/// which is not a harvester, and at the end of the job
+void
+DQMStore::runHarvestingQueue()
+{
+  if (concurrentHarvesting_ && ! harvesting_->empty())
+    harvesting_->run(*this, verbose_);
+}
 
 
 /////////////////////////////////////////////////////////////
@@ -358,11 +880,13 @@ DQMStore::DQMStore(const edm::ParameterSet &pset, edm::ActivityRegistry& ar)
     collateHistograms_ (false),
     enableMultiThread_(false),
     forceResetOnBeginLumi_(false),
+    nativeHistograms_(false),
+    nativeFloatPrecision_(false),
+    concurrentHarvesting_(false),
     readSelectedDirectory_ (""),
-    run_(0),
-    moduleId_(0),
     stream_(nullptr),
     pwd_ (""),
+    index_(new MEIndex),
     ibooker_(nullptr),
     igetter_(nullptr)
 {
@@ -385,6 +909,18 @@ DQMStore::DQMStore(const edm::ParameterSet &pset, edm::ActivityRegistry& ar)
     ar.watchPostSourceLumi([this](edm::LuminosityBlockIndex){ forceReset(); });
   }
   ar.watchPostGlobalBeginLumi(this, &DQMStore::postGlobalBeginLumi);
+  if (concurrentHarvesting_) {
+    ar.watchPreModuleConstruction([this](edm::ModuleDescription const& md) {
+        harvesting_->constructing(md.id(), md.moduleLabel());
+      });
+    // the queued harvesters run before the endJob of any other module,
+    // e.g. the file saver, and at the latest at the end of the job
+    ar.watchPreModuleEndJob([this](edm::ModuleDescription const& md) {
+        if (! harvesting_->isHarvester(md.id()))
+          runHarvestingQueue();
+      });
+    ar.watchPostEndJob([this]() { runHarvestingQueue(); });
+  }
 }
 
 DQMStore::DQMStore(const edm::ParameterSet &pset)
@@ -393,11 +929,14 @@ DQMStore::DQMStore(const edm::ParameterSet &pset)
     reset_ (false),
     collateHistograms_ (false),
     enableMultiThread_(false),
+    forceResetOnBeginLumi_(false),
+    nativeHistograms_(false),
+    nativeFloatPrecision_(false),
+    concurrentHarvesting_(false),
     readSelectedDirectory_ (""),
-    run_(0),
-    moduleId_(0),
     stream_(nullptr),
     pwd_ (""),
+    index_(new MEIndex),
     ibooker_(nullptr),
     igetter_(nullptr)
 {
@@ -447,6 +986,24 @@ DQMStore::initializeFrom(const edm::ParameterSet& pset) {
    if (LSbasedMode_)
      std::cout << "DQMStore: LSbasedMode option is enabled\n";
 
+  nativeHistograms_ = pset.getUntrackedParameter<bool>("nativeHistograms", false);
+  nativeFloatPrecision_ = pset.getUntrackedParameter<bool>("nativeHistogramsFloatPrecision", false);
+  if (nativeHistograms_)
+    std::cout << "DQMStore: native histogram storage is enabled"
+              << (nativeFloatPrecision_ ? " (single precision)\n" : "\n");
+
+  concurrentHarvesting_ = pset.getUntrackedParameter<bool>("concurrentHarvesting", false);
+  if (concurrentHarvesting_)
+  {
+    std::string profile = pset.getUntrackedParameter<std::string>("harvestingProfile", "");
+    std::vector<std::string> harvesters
+      = pset.getUntrackedParameter<std::vector<std::string> >("concurrentHarvesters", std::vector<std::string>());
+    std::cout << "DQMStore: concurrent harvesting is enabled for " << harvesters.size() << " harvesters"
+              << (profile.empty() ? ", without harvesting profile\n"
+                  : ", with harvesting profile '" + profile + "'\n");
+    harvesting_.reset(new HarvestingScheduler(profile, harvesters));
+  }
+
   std::string ref = pset.getUntrackedParameter<std::string>("referenceFileName", "");
   if (! ref.empty())
   {
@@ -454,20 +1011,20 @@ DQMStore::initializeFrom(const edm::ParameterSet& pset) {
     readFile(ref, true, "", s_referenceDirName, StripRunDirs, false);
   }
 
-  initQCriterion<Comp2RefChi2>(qalgos_);
-  initQCriterion<Comp2Ref2DChi2>(qalgos_);
-  initQCriterion<Comp2RefKolmogorov>(qalgos_);
-  initQCriterion<ContentsXRange>(qalgos_);
-  initQCriterion<ContentsYRange>(qalgos_);
-  initQCriterion<MeanWithinExpected>(qalgos_);
-  initQCriterion<Comp2RefEqualH>(qalgos_);
-  initQCriterion<DeadChannel>(qalgos_);
-  initQCriterion<NoisyChannel>(qalgos_);
-  initQCriterion<ContentSigma>(qalgos_);
-  initQCriterion<ContentsWithinExpected>(qalgos_);
-  initQCriterion<CompareToMedian>(qalgos_);
-  initQCriterion<CompareLastFilledBin>(qalgos_);
-  initQCriterion<CheckVariance>(qalgos_);
+  initQCriterion<Comp2RefChi2>(qalgos_, qclones_);
+  initQCriterion<Comp2Ref2DChi2>(qalgos_, qclones_);
+  initQCriterion<Comp2RefKolmogorov>(qalgos_, qclones_);
+  initQCriterion<ContentsXRange>(qalgos_, qclones_);
+  initQCriterion<ContentsYRange>(qalgos_, qclones_);
+  initQCriterion<MeanWithinExpected>(qalgos_, qclones_);
+  initQCriterion<Comp2RefEqualH>(qalgos_, qclones_);
+  initQCriterion<DeadChannel>(qalgos_, qclones_);
+  initQCriterion<NoisyChannel>(qalgos_, qclones_);
+  initQCriterion<ContentSigma>(qalgos_, qclones_);
+  initQCriterion<ContentsWithinExpected>(qalgos_, qclones_);
+  initQCriterion<CompareToMedian>(qalgos_, qclones_);
+  initQCriterion<CompareLastFilledBin>(qalgos_, qclones_);
+  initQCriterion<CheckVariance>(qalgos_, qclones_);
 
   scaleFlag_ = pset.getUntrackedParameter<double>("ScalingFlag", 0.0);
   if (verbose_ > 0)
@@ -558,7 +1115,46 @@ DQMStore::setVerbose(unsigned /* level */)
 /// return pathname of current directory
 const std::string &
 DQMStore::pwd() const
-{ return pwd_; }
+{ return currentFolder_(); }
+
+/// booking transaction of this store running in the current thread, if any
+DQMStore::BookingTransaction *
+DQMStore::transaction_() const
+{
+  BookingTransaction *t = currentTransaction_;
+  return (t && t->store_ == this) ? t : nullptr;
+}
+
+/// current directory, that of the booking transaction if there is one
+std::string &
+DQMStore::currentFolder_()
+{
+  BookingTransaction *t = transaction_();
+  return t ? t->pwd_ : pwd_;
+}
+
+const std::string &
+DQMStore::currentFolder_() const
+{
+  BookingTransaction *t = transaction_();
+  return t ? t->pwd_ : pwd_;
+}
+
+/// run number used for booking, 0 outside a transaction
+uint32_t
+DQMStore::currentRun_() const
+{
+  BookingTransaction *t = transaction_();
+  return t ? t->run_ : 0;
+}
+
+/// module id used for booking, 0 outside a transaction
+uint32_t
+DQMStore::currentModuleId_() const
+{
+  BookingTransaction *t = transaction_();
+  return t ? t->moduleId_ : 0;
+}
 
 /// go to top directory (ie. root)
 void
@@ -590,19 +1186,21 @@ DQMStore::setCurrentFolder(const std::string &fullpath)
   std::string clean;
   const std::string *cleaned = nullptr;
   cleanTrailingSlashes(fullpath, clean, cleaned);
+  if (! cleaned->empty())
+    trackAccess_(*cleaned);
   makeDirectory(*cleaned);
-  pwd_ = *cleaned;
+  currentFolder_() = *cleaned;
 }
 
 /// equivalent to "cd .."
 void
 DQMStore::goUp()
 {
-  size_t pos = pwd_.rfind('/');
+  size_t pos = currentFolder_().rfind('/');
   if (pos == std::string::npos)
     setCurrentFolder("");
   else
-    setCurrentFolder(pwd_.substr(0, pos));
+    setCurrentFolder(currentFolder_().substr(0, pos));
 }
 
 // -------------------------------------------------------------------
@@ -632,8 +1230,10 @@ DQMStore::makeDirectory(const std::string &path)
                     " which already exists as a monitor element",
                     subdir.c_str());
 
-    if (! dirs_.count(subdir))
+    {
+      std::lock_guard<std::mutex> guard(book_mutex_);
       dirs_.insert(subdir);
+    }
 
     // Stop if we've reached the end (including possibly a trailing slash).
     if (slash+1 >= path.size())
@@ -651,7 +1251,11 @@ DQMStore::makeDirectory(const std::string &path)
 /// true if directory exists
 bool
 DQMStore::dirExists(const std::string &path) const
-{ return dirs_.count(path) > 0; }
+{
+  trackAccess_(path);
+  std::lock_guard<std::mutex> guard(book_mutex_);
+  return dirs_.count(path) > 0;
+}
 
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
@@ -665,6 +1269,7 @@ DQMStore::book_(const std::string &dir, const std::string &name,
   assert(name.find('/') == std::string::npos);
   if (verbose_ > 3)
     print_trace(dir, name);
+  trackAccess_(dir);
   std::string path;
   mergePath(path, dir, name);
 
@@ -672,13 +1277,15 @@ DQMStore::book_(const std::string &dir, const std::string &name,
   h->SetDirectory(nullptr);
 
   // Check if the request monitor element already exists.
-  MonitorElement *me = findObject(dir, name, run_, 0, moduleId_);
+  MonitorElement *me = findObject(dir, name, currentRun_(), 0, currentModuleId_());
   if (me)
   {
     if (collateHistograms_)
     {
       collate(me, h, verbose_);
       delete h;
+      if (nativeHistograms_)
+        me->enableNativeStorage(nativeFloatPrecision_);
       return me;
     }
     else
@@ -690,16 +1297,17 @@ DQMStore::book_(const std::string &dir, const std::string &name,
       me->Reset();
       collate(me, h, verbose_);
       delete h;
+      if (nativeHistograms_)
+        me->enableNativeStorage(nativeFloatPrecision_);
       return me;
     }
   }
   else
   {
     // Create and initialise core object.
-    assert(dirs_.count(dir));
-    MonitorElement proto(&*dirs_.find(dir), name, run_, moduleId_);
-    me = const_cast<MonitorElement &>(*data_.insert(std::move(proto)).first)
-      .initialise((MonitorElement::Kind)kind, h);
+    me = insert_(dir, name)->initialise((MonitorElement::Kind)kind, h);
+    if (nativeHistograms_)
+      me->enableNativeStorage(nativeFloatPrecision_);
 
     // Initialise quality test information.
     auto qi = qtestspecs_.begin();
@@ -725,6 +1333,7 @@ DQMStore::book_(const std::string &dir, const std::string &name,
       // dir we assign the object_ of the reference MonitorElement to the
       // reference_ property of our new MonitorElement.
       me->data_.flags |= DQMNet::DQM_PROP_HAS_REFERENCE;
+      referenceME->materialize(true);
       me->reference_ = referenceME->object_;
     }
 
@@ -741,9 +1350,10 @@ DQMStore::book_(const std::string &dir,
   assert(name.find('/') == std::string::npos);
   if (verbose_ > 3)
     print_trace(dir, name);
+  trackAccess_(dir);
 
   // Check if the request monitor element already exists.
-  if (MonitorElement *me = findObject(dir, name, run_, 0, moduleId_))
+  if (MonitorElement *me = findObject(dir, name, currentRun_(), 0, currentModuleId_()))
   {
     if (verbose_ > 1)
     {
@@ -760,12 +1370,24 @@ DQMStore::book_(const std::string &dir,
   else
   {
     // Create it and return for initialisation.
-    assert(dirs_.count(dir));
-    MonitorElement proto(&*dirs_.find(dir), name, run_, moduleId_);
-    return &const_cast<MonitorElement &>(*data_.insert(std::move(proto)).first);
+    return insert_(dir, name);
   }
 }
 
+/// add a new monitor element for the current run and module; only the
+/// insertion itself is done under the global lock
+MonitorElement *
+DQMStore::insert_(const std::string &dir, const std::string &name)
+{
+  std::lock_guard<std::mutex> guard(book_mutex_);
+  auto di = dirs_.find(dir);
+  assert(di != dirs_.end());
+  MonitorElement proto(&*di, name, currentRun_(), currentModuleId_());
+  auto me = &const_cast<MonitorElement &>(*data_.insert(std::move(proto)).first);
+  index_->insert(me);
+  return me;
+}
+
 // -------------------------------------------------------------------
 /// Book int.
 MonitorElement *
@@ -773,7 +1395,7 @@ DQMStore::bookInt_(const std::string &dir, const std::string &name)
 {
   if (collateHistograms_)
   {
-    if (MonitorElement *me = findObject(dir, name, run_, 0, moduleId_))
+    if (MonitorElement *me = findObject(dir, name, currentRun_(), 0, currentModuleId_()))
     {
       me->Fill(0);
       return me;
@@ -787,13 +1409,13 @@ DQMStore::bookInt_(const std::string &dir, const std::string &name)
 /// Book int.
 MonitorElement *
 DQMStore::bookInt(const char *name)
-{ return bookInt_(pwd_, name); }
+{ return bookInt_(currentFolder_(), name); }
 
 /// Book int.
 MonitorElement *
 DQMStore::bookInt(const std::string &name)
 {
-  return bookInt_(pwd_, name);
+  return bookInt_(currentFolder_(), name);
 }
 
 // -------------------------------------------------------------------
@@ -803,7 +1425,7 @@ DQMStore::bookFloat_(const std::string &dir, const std::string &name)
 {
   if (collateHistograms_)
   {
-    if (MonitorElement *me = findObject(dir, name, run_, 0, moduleId_))
+    if (MonitorElement *me = findObject(dir, name, currentRun_(), 0, currentModuleId_()))
     {
       me->Fill(0.);
       return me;
@@ -817,13 +1439,13 @@ DQMStore::bookFloat_(const std::string &dir, const std::string &name)
 /// Book float.
 MonitorElement *
 DQMStore::bookFloat(const char *name)
-{ return bookFloat_(pwd_, name); }
+{ return bookFloat_(currentFolder_(), name); }
 
 /// Book float.
 MonitorElement *
 DQMStore::bookFloat(const std::string &name)
 {
-  return bookFloat_(pwd_, name);
+  return bookFloat_(currentFolder_(), name);
 }
 
 // -------------------------------------------------------------------
@@ -835,7 +1457,7 @@ DQMStore::bookString_(const std::string &dir,
 {
   if (collateHistograms_)
   {
-    if (MonitorElement *me = findObject(dir, name, run_, 0, moduleId_))
+    if (MonitorElement *me = findObject(dir, name, currentRun_(), 0, currentModuleId_()))
       return me;
   }
 
@@ -846,13 +1468,13 @@ DQMStore::bookString_(const std::string &dir,
 /// Book string.
 MonitorElement *
 DQMStore::bookString(const char *name, const char *value)
-{ return bookString_(pwd_, name, value); }
+{ return bookString_(currentFolder_(), name, value); }
 
 /// Book string.
 MonitorElement *
 DQMStore::bookString(const std::string &name, const std::string &value)
 {
-  return bookString_(pwd_, name, value);
+  return bookString_(currentFolder_(), name, value);
 }
 
 // -------------------------------------------------------------------
@@ -882,7 +1504,7 @@ MonitorElement *
 DQMStore::book1D(const char *name, const char *title,
                  int nchX, double lowX, double highX)
 {
-  return book1D_(pwd_, name, new TH1F(name, title, nchX, lowX, highX));
+  return book1D_(currentFolder_(), name, new TH1F(name, title, nchX, lowX, highX));
 }
 
 /// Book 1D histogram.
@@ -890,7 +1512,7 @@ MonitorElement *
 DQMStore::book1D(const std::string &name, const std::string &title,
                  int nchX, double lowX, double highX)
 {
-  return book1D_(pwd_, name, new TH1F(name.c_str(), title.c_str(), nchX, lowX, highX));
+  return book1D_(currentFolder_(), name, new TH1F(name.c_str(), title.c_str(), nchX, lowX, highX));
 }
 
 /// Book 1S histogram.
@@ -898,7 +1520,7 @@ MonitorElement *
 DQMStore::book1S(const char *name, const char *title,
                  int nchX, double lowX, double highX)
 {
-  return book1S_(pwd_, name, new TH1S(name, title, nchX, lowX, highX));
+  return book1S_(currentFolder_(), name, new TH1S(name, title, nchX, lowX, highX));
 }
 
 /// Book 1S histogram.
@@ -906,7 +1528,7 @@ MonitorElement *
 DQMStore::book1S(const std::string &name, const std::string &title,
                  int nchX, double lowX, double highX)
 {
-  return book1S_(pwd_, name, new TH1S(name.c_str(), title.c_str(), nchX, lowX, highX));
+  return book1S_(currentFolder_(), name, new TH1S(name.c_str(), title.c_str(), nchX, lowX, highX));
 }
 
 /// Book 1S histogram.
@@ -914,7 +1536,7 @@ MonitorElement *
 DQMStore::book1DD(const char *name, const char *title,
                   int nchX, double lowX, double highX)
 {
-  return book1DD_(pwd_, name, new TH1D(name, title, nchX, lowX, highX));
+  return book1DD_(currentFolder_(), name, new TH1D(name, title, nchX, lowX, highX));
 }
 
 /// Book 1S histogram.
@@ -922,7 +1544,7 @@ MonitorElement *
 DQMStore::book1DD(const std::string &name, const std::string &title,
                   int nchX, double lowX, double highX)
 {
-  return book1DD_(pwd_, name, new TH1D(name.c_str(), title.c_str(), nchX, lowX, highX));
+  return book1DD_(currentFolder_(), name, new TH1D(name.c_str(), title.c_str(), nchX, lowX, highX));
 }
 
 /// Book 1D variable bin histogram.
@@ -930,7 +1552,7 @@ MonitorElement *
 DQMStore::book1D(const char *name, const char *title,
                  int nchX, const float *xbinsize)
 {
-  return book1D_(pwd_, name, new TH1F(name, title, nchX, xbinsize));
+  return book1D_(currentFolder_(), name, new TH1F(name, title, nchX, xbinsize));
 }
 
 /// Book 1D variable bin histogram.
@@ -938,49 +1560,49 @@ MonitorElement *
 DQMStore::book1D(const std::string &name, const std::string &title,
                  int nchX, const float *xbinsize)
 {
-  return book1D_(pwd_, name, new TH1F(name.c_str(), title.c_str(), nchX, xbinsize));
+  return book1D_(currentFolder_(), name, new TH1F(name.c_str(), title.c_str(), nchX, xbinsize));
 }
 
 /// Book 1D histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1D(const char *name, TH1F *source)
 {
-  return book1D_(pwd_, name, static_cast<TH1F *>(source->Clone(name)));
+  return book1D_(currentFolder_(), name, static_cast<TH1F *>(source->Clone(name)));
 }
 
 /// Book 1D histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1D(const std::string &name, TH1F *source)
 {
-  return book1D_(pwd_, name, static_cast<TH1F *>(source->Clone(name.c_str())));
+  return book1D_(currentFolder_(), name, static_cast<TH1F *>(source->Clone(name.c_str())));
 }
 
 /// Book 1S histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1S(const char *name, TH1S *source)
 {
-  return book1S_(pwd_, name, static_cast<TH1S *>(source->Clone(name)));
+  return book1S_(currentFolder_(), name, static_cast<TH1S *>(source->Clone(name)));
 }
 
 /// Book 1S histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1S(const std::string &name, TH1S *source)
 {
-  return book1S_(pwd_, name, static_cast<TH1S *>(source->Clone(name.c_str())));
+  return book1S_(currentFolder_(), name, static_cast<TH1S *>(source->Clone(name.c_str())));
 }
 
 /// Book 1D double histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1DD(const char *name, TH1D *source)
 {
-  return book1DD_(pwd_, name, static_cast<TH1D *>(source->Clone(name)));
+  return book1DD_(currentFolder_(), name, static_cast<TH1D *>(source->Clone(name)));
 }
 
 /// Book 1D double histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book1DD(const std::string &name, TH1D *source)
 {
-  return book1DD_(pwd_, name, static_cast<TH1D *>(source->Clone(name.c_str())));
+  return book1DD_(currentFolder_(), name, static_cast<TH1D *>(source->Clone(name.c_str())));
 }
 
 // -------------------------------------------------------------------
@@ -1011,7 +1633,7 @@ DQMStore::book2D(const char *name, const char *title,
                  int nchX, double lowX, double highX,
                  int nchY, double lowY, double highY)
 {
-  return book2D_(pwd_, name, new TH2F(name, title,
+  return book2D_(currentFolder_(), name, new TH2F(name, title,
                                      nchX, lowX, highX,
                                      nchY, lowY, highY));
 }
@@ -1022,7 +1644,7 @@ DQMStore::book2D(const std::string &name, const std::string &title,
                  int nchX, double lowX, double highX,
                  int nchY, double lowY, double highY)
 {
-  return book2D_(pwd_, name, new TH2F(name.c_str(), title.c_str(),
+  return book2D_(currentFolder_(), name, new TH2F(name.c_str(), title.c_str(),
                                      nchX, lowX, highX,
                                      nchY, lowY, highY));
 }
@@ -1033,7 +1655,7 @@ DQMStore::book2S(const char *name, const char *title,
                  int nchX, double lowX, double highX,
                  int nchY, double lowY, double highY)
 {
-  return book2S_(pwd_, name, new TH2S(name, title,
+  return book2S_(currentFolder_(), name, new TH2S(name, title,
                                      nchX, lowX, highX,
                                      nchY, lowY, highY));
 }
@@ -1044,7 +1666,7 @@ DQMStore::book2S(const std::string &name, const std::string &title,
                  int nchX, double lowX, double highX,
                  int nchY, double lowY, double highY)
 {
-  return book2S_(pwd_, name, new TH2S(name.c_str(), title.c_str(),
+  return book2S_(currentFolder_(), name, new TH2S(name.c_str(), title.c_str(),
                                      nchX, lowX, highX,
                                      nchY, lowY, highY));
 }
@@ -1055,7 +1677,7 @@ DQMStore::book2DD(const char *name, const char *title,
                   int nchX, double lowX, double highX,
                   int nchY, double lowY, double highY)
 {
-  return book2DD_(pwd_, name, new TH2D(name, title,
+  return book2DD_(currentFolder_(), name, new TH2D(name, title,
                                       nchX, lowX, highX,
                                       nchY, lowY, highY));
 }
@@ -1066,7 +1688,7 @@ DQMStore::book2DD(const std::string &name, const std::string &title,
                   int nchX, double lowX, double highX,
                   int nchY, double lowY, double highY)
 {
-  return book2DD_(pwd_, name, new TH2D(name.c_str(), title.c_str(),
+  return book2DD_(currentFolder_(), name, new TH2D(name.c_str(), title.c_str(),
                                       nchX, lowX, highX,
                                       nchY, lowY, highY));
 }
@@ -1076,7 +1698,7 @@ MonitorElement *
 DQMStore::book2D(const char *name, const char *title,
                  int nchX, const float *xbinsize, int nchY, const float *ybinsize)
 {
-  return book2D_(pwd_, name, new TH2F(name, title,
+  return book2D_(currentFolder_(), name, new TH2F(name, title,
                                      nchX, xbinsize, nchY, ybinsize));
 }
 
@@ -1085,7 +1707,7 @@ MonitorElement *
 DQMStore::book2D(const std::string &name, const std::string &title,
                  int nchX, const float *xbinsize, int nchY, const float *ybinsize)
 {
-  return book2D_(pwd_, name, new TH2F(name.c_str(), title.c_str(),
+  return book2D_(currentFolder_(), name, new TH2F(name.c_str(), title.c_str(),
                                      nchX, xbinsize, nchY, ybinsize));
 }
 
@@ -1095,7 +1717,7 @@ DQMStore::book2S(const char *name, const char *title,
                  int nchX, const float *xbinsize, int nchY, const float *ybinsize)
 {
 
-  return book2S_(pwd_, name, new TH2S(name, title,
+  return book2S_(currentFolder_(), name, new TH2S(name, title,
                                      nchX, xbinsize, nchY, ybinsize));
 }
 
@@ -1104,7 +1726,7 @@ MonitorElement *
 DQMStore::book2S(const std::string &name, const std::string &title,
                  int nchX, const float *xbinsize, int nchY, const float *ybinsize)
 {
-  return book2S_(pwd_, name, new TH2S(name.c_str(), title.c_str(),
+  return book2S_(currentFolder_(), name, new TH2S(name.c_str(), title.c_str(),
                                      nchX, xbinsize, nchY, ybinsize));
 }
 
@@ -1112,42 +1734,42 @@ DQMStore::book2S(const std::string &name, const std::string &title,
 MonitorElement *
 DQMStore::book2D(const char *name, TH2F *source)
 {
-  return book2D_(pwd_, name, static_cast<TH2F *>(source->Clone(name)));
+  return book2D_(currentFolder_(), name, static_cast<TH2F *>(source->Clone(name)));
 }
 
 /// Book 2D histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book2D(const std::string &name, TH2F *source)
 {
-  return book2D_(pwd_, name, static_cast<TH2F *>(source->Clone(name.c_str())));
+  return book2D_(currentFolder_(), name, static_cast<TH2F *>(source->Clone(name.c_str())));
 }
 
 /// Book 2DS histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book2S(const char *name, TH2S *source)
 {
-  return book2S_(pwd_, name, static_cast<TH2S *>(source->Clone(name)));
+  return book2S_(currentFolder_(), name, static_cast<TH2S *>(source->Clone(name)));
 }
 
 /// Book 2DS histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book2S(const std::string &name, TH2S *source)
 {
-  return book2S_(pwd_, name, static_cast<TH2S *>(source->Clone(name.c_str())));
+  return book2S_(currentFolder_(), name, static_cast<TH2S *>(source->Clone(name.c_str())));
 }
 
 /// Book 2DS histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book2DD(const char *name, TH2D *source)
 {
-  return book2DD_(pwd_, name, static_cast<TH2D *>(source->Clone(name)));
+  return book2DD_(currentFolder_(), name, static_cast<TH2D *>(source->Clone(name)));
 }
 
 /// Book 2DS histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book2DD(const std::string &name, TH2D *source)
 {
-  return book2DD_(pwd_, name, static_cast<TH2D *>(source->Clone(name.c_str())));
+  return book2DD_(currentFolder_(), name, static_cast<TH2D *>(source->Clone(name.c_str())));
 }
 
 // -------------------------------------------------------------------
@@ -1165,7 +1787,7 @@ DQMStore::book3D(const char *name, const char *title,
                  int nchY, double lowY, double highY,
                  int nchZ, double lowZ, double highZ)
 {
-  return book3D_(pwd_, name, new TH3F(name, title,
+  return book3D_(currentFolder_(), name, new TH3F(name, title,
                                      nchX, lowX, highX,
                                      nchY, lowY, highY,
                                      nchZ, lowZ, highZ));
@@ -1178,7 +1800,7 @@ DQMStore::book3D(const std::string &name, const std::string &title,
                  int nchY, double lowY, double highY,
                  int nchZ, double lowZ, double highZ)
 {
-  return book3D_(pwd_, name, new TH3F(name.c_str(), title.c_str(),
+  return book3D_(currentFolder_(), name, new TH3F(name.c_str(), title.c_str(),
                                      nchX, lowX, highX,
                                      nchY, lowY, highY,
                                      nchZ, lowZ, highZ));
@@ -1188,14 +1810,14 @@ DQMStore::book3D(const std::string &name, const std::string &title,
 MonitorElement *
 DQMStore::book3D(const char *name, TH3F *source)
 {
-  return book3D_(pwd_, name, static_cast<TH3F *>(source->Clone(name)));
+  return book3D_(currentFolder_(), name, static_cast<TH3F *>(source->Clone(name)));
 }
 
 /// Book 3D histogram by cloning an existing histogram.
 MonitorElement *
 DQMStore::book3D(const std::string &name, TH3F *source)
 {
-  return book3D_(pwd_, name, static_cast<TH3F *>(source->Clone(name.c_str())));
+  return book3D_(currentFolder_(), name, static_cast<TH3F *>(source->Clone(name.c_str())));
 }
 
 // -------------------------------------------------------------------
@@ -1217,7 +1839,7 @@ DQMStore::bookProfile(const char *name, const char *title,
                       int /* nchY */, double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name, title,
+  return bookProfile_(currentFolder_(), name, new TProfile(name, title,
                                               nchX, lowX, highX,
                                               lowY, highY,
                                               option));
@@ -1232,7 +1854,7 @@ DQMStore::bookProfile(const std::string &name, const std::string &title,
                       int /* nchY */, double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name.c_str(), title.c_str(),
+  return bookProfile_(currentFolder_(), name, new TProfile(name.c_str(), title.c_str(),
                                               nchX, lowX, highX,
                                               lowY, highY,
                                               option));
@@ -1247,7 +1869,7 @@ DQMStore::bookProfile(const char *name, const char *title,
                       double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name, title,
+  return bookProfile_(currentFolder_(), name, new TProfile(name, title,
                                               nchX, lowX, highX,
                                               lowY, highY,
                                               option));
@@ -1262,7 +1884,7 @@ DQMStore::bookProfile(const std::string &name, const std::string &title,
                       double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name.c_str(), title.c_str(),
+  return bookProfile_(currentFolder_(), name, new TProfile(name.c_str(), title.c_str(),
                                               nchX, lowX, highX,
                                               lowY, highY,
                                               option));
@@ -1277,7 +1899,7 @@ DQMStore::bookProfile(const char *name, const char *title,
                       int /* nchY */, double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name, title,
+  return bookProfile_(currentFolder_(), name, new TProfile(name, title,
                                               nchX, xbinsize,
                                               lowY, highY,
                                               option));
@@ -1292,7 +1914,7 @@ DQMStore::bookProfile(const std::string &name, const std::string &title,
                       int /* nchY */, double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name.c_str(), title.c_str(),
+  return bookProfile_(currentFolder_(), name, new TProfile(name.c_str(), title.c_str(),
                                               nchX, xbinsize,
                                               lowY, highY,
                                               option));
@@ -1307,7 +1929,7 @@ DQMStore::bookProfile(const char *name, const char *title,
                       double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name, title,
+  return bookProfile_(currentFolder_(), name, new TProfile(name, title,
                                               nchX, xbinsize,
                                               lowY, highY,
                                               option));
@@ -1322,7 +1944,7 @@ DQMStore::bookProfile(const std::string &name, const std::string &title,
                       double lowY, double highY,
                       const char *option /* = "s" */)
 {
-  return bookProfile_(pwd_, name, new TProfile(name.c_str(), title.c_str(),
+  return bookProfile_(currentFolder_(), name, new TProfile(name.c_str(), title.c_str(),
                                               nchX, xbinsize,
                                               lowY, highY,
                                               option));
@@ -1332,14 +1954,14 @@ DQMStore::bookProfile(const std::string &name, const std::string &title,
 MonitorElement *
 DQMStore::bookProfile(const char *name, TProfile *source)
 {
-  return bookProfile_(pwd_, name, static_cast<TProfile *>(source->Clone(name)));
+  return bookProfile_(currentFolder_(), name, static_cast<TProfile *>(source->Clone(name)));
 }
 
 /// Book TProfile by cloning an existing profile.
 MonitorElement *
 DQMStore::bookProfile(const std::string &name, TProfile *source)
 {
-  return bookProfile_(pwd_, name, static_cast<TProfile *>(source->Clone(name.c_str())));
+  return bookProfile_(currentFolder_(), name, static_cast<TProfile *>(source->Clone(name.c_str())));
 }
 
 // -------------------------------------------------------------------
@@ -1362,7 +1984,7 @@ DQMStore::bookProfile2D(const char *name, const char *title,
                         int /* nchZ */, double lowZ, double highZ,
                         const char *option /* = "s" */)
 {
-  return bookProfile2D_(pwd_, name, new TProfile2D(name, title,
+  return bookProfile2D_(currentFolder_(), name, new TProfile2D(name, title,
                                                   nchX, lowX, highX,
                                                   nchY, lowY, highY,
                                                   lowZ, highZ,
@@ -1379,7 +2001,7 @@ DQMStore::bookProfile2D(const std::string &name, const std::string &title,
                         int /* nchZ */, double lowZ, double highZ,
                         const char *option /* = "s" */)
 {
-  return bookProfile2D_(pwd_, name, new TProfile2D(name.c_str(), title.c_str(),
+  return bookProfile2D_(currentFolder_(), name, new TProfile2D(name.c_str(), title.c_str(),
                                                   nchX, lowX, highX,
                                                   nchY, lowY, highY,
                                                   lowZ, highZ,
@@ -1396,7 +2018,7 @@ DQMStore::bookProfile2D(const char *name, const char *title,
                         double lowZ, double highZ,
                         const char *option /* = "s" */)
 {
-  return bookProfile2D_(pwd_, name, new TProfile2D(name, title,
+  return bookProfile2D_(currentFolder_(), name, new TProfile2D(name, title,
                                                   nchX, lowX, highX,
                                                   nchY, lowY, highY,
                                                   lowZ, highZ,
@@ -1413,7 +2035,7 @@ DQMStore::bookProfile2D(const std::string &name, const std::string &title,
                         double lowZ, double highZ,
                         const char *option /* = "s" */)
 {
-  return bookProfile2D_(pwd_, name, new TProfile2D(name.c_str(), title.c_str(),
+  return bookProfile2D_(currentFolder_(), name, new TProfile2D(name.c_str(), title.c_str(),
                                                   nchX, lowX, highX,
                                                   nchY, lowY, highY,
                                                   lowZ, highZ,
@@ -1424,14 +2046,14 @@ DQMStore::bookProfile2D(const std::string &name, const std::string &title,
 MonitorElement *
 DQMStore::bookProfile2D(const char *name, TProfile2D *source)
 {
-  return bookProfile2D_(pwd_, name, static_cast<TProfile2D *>(source->Clone(name)));
+  return bookProfile2D_(currentFolder_(), name, static_cast<TProfile2D *>(source->Clone(name)));
 }
 
 /// Book TProfile2D by cloning an existing profile.
 MonitorElement *
 DQMStore::bookProfile2D(const std::string &name, TProfile2D *source)
 {
-  return bookProfile2D_(pwd_, name, static_cast<TProfile2D *>(source->Clone(name.c_str())));
+  return bookProfile2D_(currentFolder_(), name, static_cast<TProfile2D *>(source->Clone(name.c_str())));
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -1605,9 +2227,11 @@ DQMStore::tagAllContents(const std::string &path, unsigned int myTag)
 std::vector<std::string>
 DQMStore::getSubdirs() const
 {
+  trackAccess_(currentFolder_());
+  std::lock_guard<std::mutex> guard(book_mutex_);
   std::vector<std::string> result;
   auto e = dirs_.end();
-  auto i = dirs_.find(pwd_);
+  auto i = dirs_.find(currentFolder_());
 
   // If we didn't find current directory, the tree is empty, so quit.
   if (i == e)
@@ -1615,10 +2239,10 @@ DQMStore::getSubdirs() const
 
   // Skip the current directory and then start looking for immediate
   // subdirectories in the dirs_ list.  Stop when we are no longer in
-  // (direct or indirect) subdirectories of pwd_.  Note that we don't
+  // (direct or indirect) subdirectories of currentFolder_().  Note that we don't
   // "know" which order the set will sort A/B, A/B/C and A/D.
-  while (++i != e && isSubdirectory(pwd_, *i))
-    if (i->find('/', pwd_.size()+1) == std::string::npos)
+  while (++i != e && isSubdirectory(currentFolder_(), *i))
+    if (i->find('/', currentFolder_().size()+1) == std::string::npos)
       result.push_back(*i);
 
   return result;
@@ -1628,12 +2252,14 @@ DQMStore::getSubdirs() const
 std::vector<std::string>
 DQMStore::getMEs() const
 {
-  MonitorElement proto(&pwd_, std::string());
+  trackAccess_(currentFolder_());
+  std::lock_guard<std::mutex> guard(book_mutex_);
+  MonitorElement proto(&currentFolder_(), std::string());
   std::vector<std::string> result;
   auto e = data_.end();
   auto i = data_.lower_bound(proto);
-  for ( ; i != e && isSubdirectory(pwd_, *i->data_.dirname); ++i)
-    if (pwd_ == *i->data_.dirname)
+  for ( ; i != e && isSubdirectory(currentFolder_(), *i->data_.dirname); ++i)
+    if (currentFolder_() == *i->data_.dirname)
       result.push_back(i->getName());
 
   return result;
@@ -1644,6 +2270,8 @@ DQMStore::getMEs() const
 bool
 DQMStore::containsAnyMonitorable(const std::string &path) const
 {
+  trackAccess_(path);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(&path, std::string());
   auto e = data_.end();
   auto i = data_.lower_bound(proto);
@@ -1657,10 +2285,8 @@ DQMStore::get(const std::string &path) const
   std::string dir;
   std::string name;
   splitPath(dir, name, path);
-  MonitorElement proto(&dir, name);
-  auto mepos = data_.find(proto);
-  return (mepos == data_.end() ? nullptr
-          : const_cast<MonitorElement *>(&*mepos));
+  trackAccess_(dir);
+  return index_->find(dir, name, 0, 0, 0);
 }
 
 /// get all MonitorElements tagged as <tag>
@@ -1668,6 +2294,8 @@ std::vector<MonitorElement *>
 DQMStore::get(unsigned int tag) const
 {
   // FIXME: Use reverse map [tag -> path] / [tag -> dir]?
+  trackAccess_("");
+  std::lock_guard<std::mutex> guard(book_mutex_);
   std::vector<MonitorElement *> result;
   for (auto const & me : data_)
   {
@@ -1685,6 +2313,8 @@ DQMStore::getContents(const std::string &path) const
   std::string clean;
   const std::string *cleaned = nullptr;
   cleanTrailingSlashes(path, clean, cleaned);
+  trackAccess_(*cleaned);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(cleaned, std::string());
 
   std::vector<MonitorElement *> result;
@@ -1704,6 +2334,8 @@ DQMStore::getContents(const std::string &path, unsigned int tag) const
   std::string clean;
   const std::string *cleaned = nullptr;
   cleanTrailingSlashes(path, clean, cleaned);
+  trackAccess_(*cleaned);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(cleaned, std::string());
 
   std::vector<MonitorElement *> result;
@@ -1725,6 +2357,8 @@ DQMStore::getContents(const std::string &path, unsigned int tag) const
 void
 DQMStore::getContents(std::vector<std::string> &into, bool showContents /* = true */) const
 {
+  trackAccess_("");
+  std::lock_guard<std::mutex> guard(book_mutex_);
   into.clear();
   into.reserve(dirs_.size());
 
@@ -1794,16 +2428,7 @@ DQMStore::findObject(const std::string &dir,
     raiseDQMError("DQMStore", "Monitor element path name '%s' uses"
                   " unacceptable characters", name.c_str());
 
-  MonitorElement proto;
-  proto.data_.dirname  = &dir;
-  proto.data_.objname  = name;
-  proto.data_.run      = run;
-  proto.data_.lumi     = lumi;
-  proto.data_.moduleId = moduleId;
-
-  auto mepos = data_.find(proto);
-  return (mepos == data_.end() ? nullptr
-          : const_cast<MonitorElement *>(&*mepos));
+  return index_->find(dir, name, run, lumi, moduleId);
 }
 
 /// get vector with children of folder, including all subfolders + their children;
@@ -1816,6 +2441,8 @@ DQMStore::getAllContents(const std::string &path,
   std::string clean;
   const std::string *cleaned = nullptr;
   cleanTrailingSlashes(path, clean, cleaned);
+  trackAccess_(*cleaned);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(cleaned, std::string(), run, 0);
   proto.setLumi(lumi);
 
@@ -1870,6 +2497,8 @@ DQMStore::getMatchingContents(const std::string &pattern, lat::Regexp::Syntax sy
                   pattern.c_str(), e.explain().c_str());
   }
 
+  trackAccess_("");
+  std::lock_guard<std::mutex> guard(book_mutex_);
   std::string path;
   std::vector<MonitorElement *> result;
   auto i = data_.begin();
@@ -2001,7 +2630,9 @@ DQMStore::cloneLumiHistograms(uint32_t run, uint32_t lumi, uint32_t moduleId)
     clone.globalize();
     clone.setLumi(lumi);
     clone.markToDelete();
-    data_.insert(std::move(clone));
+    auto inserted = data_.insert(std::move(clone));
+    if (inserted.second)
+      index_->insert(const_cast<MonitorElement*>(&*inserted.first));
 
     // reset the ME for the next lumisection
     const_cast<MonitorElement*>(&*i)->Reset();
@@ -2037,7 +2668,9 @@ DQMStore::cloneRunHistograms(uint32_t run, uint32_t moduleId)
     MonitorElement clone{*i};
     clone.globalize();
     clone.markToDelete();
-    data_.insert(std::move(clone));
+    auto inserted = data_.insert(std::move(clone));
+    if (inserted.second)
+      index_->insert(const_cast<MonitorElement*>(&*inserted.first));
 
     // reset the ME for the next lumisection
     const_cast<MonitorElement*>(&*i)->Reset();
@@ -2082,6 +2715,7 @@ DQMStore::deleteUnusedLumiHistograms(uint32_t run, uint32_t lumi)
                 << "flags " << i->data_.flags << "\n";
     }
 
+    index_->erase(&*i);
     i = data_.erase(i);
   }
 }
@@ -2382,6 +3016,7 @@ DQMStore::extract(TObject *obj, const std::string &dir,
       // MonitorElement to the reference_ property of the corresponding
       // non-reference MonitorElement.
       master->data_.flags |= DQMNet::DQM_PROP_HAS_REFERENCE;
+      refcheck->materialize(true);
       master->reference_ = refcheck->object_;
     }
   }
@@ -2444,7 +3079,8 @@ DQMStore::saveMonitorElementToROOT(
   if (me.kind() < MonitorElement::DQM_KIND_TH1F) {
     TObjString(me.tagString().c_str()).Write();
   } else {
-    me.object_->Write();
+    std::unique_ptr<TH1> tmp;
+    me.rootObjectForIO(tmp)->Write();
   }
 
   // Save quality reports if this is not in reference section.
@@ -2676,7 +3312,8 @@ DQMStore::saveMonitorElementToPB(
     TObjString object(me.tagString().c_str());
     buffer.WriteObject(&object);
   } else {
-    buffer.WriteObject(me.object_);
+    std::unique_ptr<TH1> tmp;
+    buffer.WriteObject(me.rootObjectForIO(tmp));
   }
   dqmstorepb::ROOTFilePB::Histo & histo = * file.add_histo();
   histo.set_full_pathname(*me.data_.dirname + '/' + me.data_.objname);
@@ -3198,12 +3835,17 @@ DQMStore::rmdir(const std::string &path)
   std::string clean;
   const std::string *cleaned = nullptr;
   cleanTrailingSlashes(path, clean, cleaned);
+  trackAccess_(*cleaned);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(cleaned, std::string());
 
   auto e = data_.end();
   auto i = data_.lower_bound(proto);
   while (i != e && isSubdirectory(*cleaned, *i->data_.dirname))
+  {
+    index_->erase(&*i);
     data_.erase(i++);
+  }
 
   auto de = dirs_.end();
   auto di = dirs_.lower_bound(*cleaned);
@@ -3215,12 +3857,17 @@ DQMStore::rmdir(const std::string &path)
 void
 DQMStore::removeContents(const std::string &dir)
 {
+  trackAccess_(dir);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(&dir, std::string());
   auto e = data_.end();
   auto i = data_.lower_bound(proto);
   while (i != e && isSubdirectory(dir, *i->data_.dirname))
     if (dir == *i->data_.dirname)
+    {
+      index_->erase(&*i);
       data_.erase(i++);
+    }
     else
       ++i;
 }
@@ -3229,7 +3876,7 @@ DQMStore::removeContents(const std::string &dir)
 void
 DQMStore::removeContents()
 {
-  removeContents(pwd_);
+  removeContents(currentFolder_());
 }
 
 /// erase monitoring element in current directory
@@ -3237,7 +3884,7 @@ DQMStore::removeContents()
 void
 DQMStore::removeElement(const std::string &name)
 {
-  removeElement(pwd_, name);
+  removeElement(currentFolder_(), name);
 }
 
 /// remove monitoring element from directory;
@@ -3245,11 +3892,14 @@ DQMStore::removeElement(const std::string &name)
 void
 DQMStore::removeElement(const std::string &dir, const std::string &name, bool warning /* = true */)
 {
+  trackAccess_(dir);
+  std::lock_guard<std::mutex> guard(book_mutex_);
   MonitorElement proto(&dir, name);
   auto pos = data_.find(proto);
-  if (pos != data_.end())
+  if (pos != data_.end()) {
+    index_->erase(&*pos);
     data_.erase(pos);
-  else if (warning) {
+  } else if (warning) {
     std::cout << "DQMStore: WARNING: attempt to remove non-existent"
               << " monitor element '" << name << "' in '" << dir << "'\n";
   }
@@ -3344,7 +3994,9 @@ DQMStore::useQTestByMatch(const std::string &pattern, const std::string &qtname)
   return cases;
 }
 /// run quality tests (also finds updated contents in last monitoring cycle,
-/// including newly added content)
+/// including newly added content); the monitor elements are tested in
+/// parallel, each range of them with its own copies of the criteria, as
+/// a criterion keeps the state of the test it runs
 void
 DQMStore::runQTests()
 {
@@ -3354,11 +4006,68 @@ DQMStore::runQTests()
               << ( reset_ ? "true" : "false" ) << std::endl;
 
   // Apply quality tests to each monitor element, skipping references.
-  auto mi = data_.begin();
-  auto me = data_.end();
-  for ( ; mi != me; ++mi)
-    if (! isSubdirectory(s_referenceDirName, *mi->data_.dirname))
-      const_cast<MonitorElement &>(*mi).runQTests();
+  if (! concurrentHarvesting_)
+  {
+    for (auto const &me : data_)
+      if (! isSubdirectory(s_referenceDirName, *me.data_.dirname))
+        const_cast<MonitorElement &>(me).runQTests();
+    reset_ = false;
+    return;
+  }
+
+  // With concurrent harvesting, test the elements in parallel, isolated
+  // so that a thread waiting in the loop runs no unrelated task.
+  std::vector<MonitorElement *> mes;
+  std::vector<MonitorElement *> tested;
+  mes.reserve(data_.size());
+  for (auto const &me : data_)
+    if (! isSubdirectory(s_referenceDirName, *me.data_.dirname))
+    {
+      auto *mi = const_cast<MonitorElement *>(&me);
+      mes.push_back(mi);
+      if (! mi->qreports_.empty() && mi->wasUpdated())
+        tested.push_back(mi);
+    }
+
+  tbb::this_task_arena::isolate([&]()
+    {
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, mes.size(), 64),
+                        [&](const tbb::blocked_range<size_t> &range)
+        {
+          std::map<QCriterion *, QCriterion *> copies;
+          std::function<QCriterion *(QCriterion *)> copyOf = [&](QCriterion *qc)
+            {
+              QCriterion *&copy = copies[qc];
+              if (! copy)
+                copy = qclones_.find(qc->algoName())->second(qc);
+              return copy;
+            };
+          try
+          {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+              mes[i]->runQTests(copyOf);
+          }
+          catch (...)
+          {
+            for (auto &copy : copies)
+              delete copy.second;
+            throw;
+          }
+          for (auto &copy : copies)
+            delete copy.second;
+        });
+    });
+
+  // Leave in the criteria the result of the last element they tested,
+  // as when the elements were tested one after the other.
+  for (auto mi : tested)
+    for (auto const &qr : mi->qreports_)
+      if (QCriterion *qc = qr.qcriterion_)
+      {
+        qc->prob_ = qr.qvalue_->qtresult;
+        qc->status_ = qr.qvalue_->code;
+        qc->message_ = qr.qvalue_->message;
+      }
 
   reset_ = false;
 }
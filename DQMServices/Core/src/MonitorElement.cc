@@ -3,6 +3,7 @@
 #include "DQMServices/Core/interface/MonitorElement.h"
 #include "DQMServices/Core/interface/QTest.h"
 #include "DQMServices/Core/src/DQMError.h"
+#include "DQMServices/Core/src/NativeHistogram.h"
 #include "TClass.h"
 #include "TMath.h"
 #include "TList.h"
@@ -150,6 +151,8 @@ MonitorElement::initialise(Kind kind, const std::string &value)
 
 MonitorElement::MonitorElement()
   : object_(nullptr),
+    native_(nullptr),
+    nativeMode_(DQM_NATIVE_OFF),
     reference_(nullptr),
     refvalue_(nullptr)
 {
@@ -168,6 +171,8 @@ MonitorElement::MonitorElement()
 MonitorElement::MonitorElement(const std::string *path,
                                const std::string &name)
   : object_(nullptr),
+    native_(nullptr),
+    nativeMode_(DQM_NATIVE_OFF),
     reference_(nullptr),
     refvalue_(nullptr)
 {
@@ -189,6 +194,8 @@ MonitorElement::MonitorElement(const std::string *path,
                                uint32_t run,
                                uint32_t moduleId)
   : object_(nullptr),
+    native_(nullptr),
+    nativeMode_(DQM_NATIVE_OFF),
     reference_(nullptr),
     refvalue_(nullptr)
 {
@@ -209,6 +216,8 @@ MonitorElement::MonitorElement(const MonitorElement &x, MonitorElementNoCloneTag
   : data_(x.data_),
     scalar_(x.scalar_),
     object_(nullptr),
+    native_(nullptr),
+    nativeMode_(x.nativeMode_),
     reference_(x.reference_),
     refvalue_(nullptr),
     qreports_(x.qreports_)
@@ -221,6 +230,9 @@ MonitorElement::MonitorElement(const MonitorElement &x)
   if (x.object_)
     object_ = static_cast<TH1 *>(x.object_->Clone());
 
+  if (x.native_)
+    native_ = new dqm::NativeHistogram(*x.native_);
+
   if (x.refvalue_)
     refvalue_ = static_cast<TH1 *>(x.refvalue_->Clone());
 }
@@ -229,15 +241,18 @@ MonitorElement::MonitorElement(MonitorElement &&o)
   : MonitorElement::MonitorElement(o, MonitorElementNoCloneTag())
 {
   object_ = o.object_;
+  native_ = o.native_;
   refvalue_ = o.refvalue_;
 
   o.object_ = nullptr;
+  o.native_ = nullptr;
   o.refvalue_ = nullptr;
 }
 
 MonitorElement::~MonitorElement()
 {
   delete object_;
+  delete native_;
   delete refvalue_;
 }
 
@@ -289,6 +304,8 @@ MonitorElement::Fill(double x)
     scalar_.num = static_cast<int64_t>(x);
   else if (kind() == DQM_KIND_REAL)
     scalar_.real = x;
+  else if (dqm::NativeHistogram *h = nativeHistogram(1))
+    h->fill(x, 1);
   else if (kind() == DQM_KIND_TH1F)
     accessRootObject(__PRETTY_FUNCTION__, 1)
       ->Fill(x, 1);
@@ -311,6 +328,8 @@ MonitorElement::doFill(int64_t x)
     scalar_.num = static_cast<int64_t>(x);
   else if (kind() == DQM_KIND_REAL)
     scalar_.real = static_cast<double>(x);
+  else if (dqm::NativeHistogram *h = nativeHistogram(1))
+    h->fill(static_cast<double>(x), 1);
   else if (kind() == DQM_KIND_TH1F)
     accessRootObject(__PRETTY_FUNCTION__, 1)
       ->Fill(static_cast<double>(x), 1);
@@ -329,7 +348,11 @@ void
 MonitorElement::Fill(double x, double yw)
 {
   update();
-  if (kind() == DQM_KIND_TH1F)
+  if (dqm::NativeHistogram *h = nativeHistogram(1))
+    h->fill(x, yw);
+  else if (dqm::NativeHistogram *h = nativeHistogram(2))
+    h->fill(x, yw, 1);
+  else if (kind() == DQM_KIND_TH1F)
     accessRootObject(__PRETTY_FUNCTION__, 1)
       ->Fill(x, yw);
   else if (kind() == DQM_KIND_TH1S)
@@ -433,7 +456,9 @@ void
 MonitorElement::Fill(double x, double y, double zw)
 {
   update();
-  if (kind() == DQM_KIND_TH2F)
+  if (dqm::NativeHistogram *h = nativeHistogram(2))
+    h->fill(x, y, zw);
+  else if (kind() == DQM_KIND_TH2F)
     static_cast<TH2F *>(accessRootObject(__PRETTY_FUNCTION__, 2))
       ->Fill(x, y, zw);
   else if (kind() == DQM_KIND_TH2S)
@@ -481,11 +506,34 @@ MonitorElement::Reset()
     scalar_.real = 0;
   else if (kind() == DQM_KIND_STRING)
     scalar_.str.clear();
+  else if (native_)
+    native_->reset();
   else
-    return accessRootObject(__PRETTY_FUNCTION__, 1)
+    // not through accessRootObject, which would disable the native storage
+    return checkRootObject(data_.objname, object_, __PRETTY_FUNCTION__, 1)
       ->Reset();
 }
 
+/// add the contents of other, a histogram of the same type and binning
+void
+MonitorElement::merge(const MonitorElement &other)
+{
+  update();
+  if (dqm::NativeHistogram *h = nativeHistogram(0))
+  {
+    std::unique_ptr<dqm::NativeHistogram> tmp;
+    const dqm::NativeHistogram *o = other.native_;
+    if (! o && other.object_)
+      o = (tmp = dqm::NativeHistogram::fromROOT(*other.object_, false)).get();
+    if (o && h->add(*o))
+      return;
+  }
+
+  std::unique_ptr<TH1> tmp;
+  accessRootObject(__PRETTY_FUNCTION__, 1)
+    ->Add(other.rootObjectForIO(tmp));
+}
+
 /// convert scalar data into a string.
 void
 MonitorElement::packScalarData(std::string &into, const char *prefix) const
@@ -667,6 +715,12 @@ MonitorElement::getQOthers() const
 /// run all quality tests
 void
 MonitorElement::runQTests()
+{
+  runQTests([](QCriterion *qc) { return qc; });
+}
+
+void
+MonitorElement::runQTests(const std::function<QCriterion *(QCriterion *)> &copyOf)
 {
   assert(qreports_.size() == data_.qreports.size());
 
@@ -686,7 +740,7 @@ MonitorElement::runQTests()
       std::string oldMessage = qv.message;
       int oldStatus = qv.code;
 
-      qc->runTest(this, qr, qv);
+      copyOf(qc)->runTest(this, qr, qv);
 
       if (oldStatus != qv.code || oldMessage != qv.message)
         update();
@@ -712,9 +766,90 @@ MonitorElement::accessRootObject(const char *func, int reqdim) const
                   " element '%s' because it is not a root object",
                   func, data_.objname.c_str());
 
+  materialize(false);
   return checkRootObject(data_.objname, object_, func, reqdim);
 }
 
+/// Like accessRootObject, for the accessors which hand out the ROOT
+/// object: the caller may keep the pointer, so the histogram stays a
+/// ROOT object even if it was not filled yet.
+TH1 *
+MonitorElement::exposeRootObject(const char *func, int reqdim) const
+{
+  TH1 *h = accessRootObject(func, reqdim);
+  materialize(true);
+  return h;
+}
+
+/// The native storage of the histogram if it has reqdim dimensions (any
+/// if reqdim is 0), made from the ROOT object at the first call once
+/// enabled; null if the histogram is, or has to be, a ROOT object.
+dqm::NativeHistogram *
+MonitorElement::nativeHistogram(int reqdim)
+{
+  if (! native_)
+  {
+    if (nativeMode_ == DQM_NATIVE_OFF)
+      return nullptr;
+
+    if (object_ && ! refvalue_)
+      native_ = dqm::NativeHistogram::fromROOT(*object_, nativeMode_ == DQM_NATIVE_FLOAT).release();
+    if (! native_)
+    {
+      nativeMode_ = DQM_NATIVE_OFF;
+      return nullptr;
+    }
+    delete object_;
+    object_ = nullptr;
+  }
+
+  if (reqdim && native_->dimension() != reqdim)
+    return nullptr;
+  return native_;
+}
+
+/// Make the ROOT object back from the native storage, if any, and keep
+/// it until the DQMStore enables the native storage again when the
+/// histogram is booked anew. Before the first fill the ROOT object is
+/// only the prototype of the native one: setters and getters work on it
+/// and the native storage stays enabled, unless the object is handed out
+/// (handOut), since the caller may then keep a pointer to it.
+void
+MonitorElement::materialize(bool handOut) const
+{
+  if (native_)
+  {
+    object_ = native_->toROOT(kind() == DQM_KIND_TH1D || kind() == DQM_KIND_TH2D);
+    delete native_;
+    native_ = nullptr;
+    nativeMode_ = DQM_NATIVE_OFF;
+  }
+  else if (handOut)
+    nativeMode_ = DQM_NATIVE_OFF;
+}
+
+/// Let the next fill replace the ROOT object by a native one, see
+/// dqm::NativeHistogram for the histograms that can be stored natively.
+void
+MonitorElement::enableNativeStorage(bool floatPrecision)
+{
+  if (kind() >= DQM_KIND_TH1F && ! refvalue_)
+    nativeMode_ = floatPrecision ? DQM_NATIVE_FLOAT : DQM_NATIVE_ON;
+}
+
+/// The ROOT object to be written or sent: for natively stored histograms
+/// a temporary one owned by tmp, so that the histogram stays native.
+TH1 *
+MonitorElement::rootObjectForIO(std::unique_ptr<TH1> &tmp) const
+{
+  if (native_)
+  {
+    tmp.reset(native_->toROOT(kind() == DQM_KIND_TH1D || kind() == DQM_KIND_TH2D));
+    return tmp.get();
+  }
+  return object_;
+}
+
 /*** getter methods (wrapper around ROOT methods) ****/
 //
 /// get mean value of histogram along x, y or z axis (axis=1, 2, 3 respectively)
@@ -1041,6 +1176,7 @@ void
 MonitorElement::softReset()
 {
   update();
+  materialize(false);
 
   // Create the reference object the first time this is called.
   // On subsequent calls accumulate the current value to the
@@ -1182,6 +1318,7 @@ MonitorElement::disableSoftReset()
 {
   if (refvalue_)
   {
+    materialize(false);
     if (kind() == DQM_KIND_TH1F
         || kind() == DQM_KIND_TH1S
         || kind() == DQM_KIND_TH1D
@@ -1469,6 +1606,7 @@ TObject *
 MonitorElement::getRootObject() const
 {
   const_cast<MonitorElement *>(this)->update();
+  materialize(true);
   return object_;
 }
 
@@ -1476,7 +1614,7 @@ TH1 *
 MonitorElement::getTH1() const
 {
   const_cast<MonitorElement *>(this)->update();
-  return accessRootObject(__PRETTY_FUNCTION__, 0);
+  return exposeRootObject(__PRETTY_FUNCTION__, 0);
 }
 
 TH1F *
@@ -1484,7 +1622,7 @@ MonitorElement::getTH1F() const
 {
   assert(kind() == DQM_KIND_TH1F);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH1F *>(accessRootObject(__PRETTY_FUNCTION__, 1));
+  return static_cast<TH1F *>(exposeRootObject(__PRETTY_FUNCTION__, 1));
 }
 
 TH1S *
@@ -1492,7 +1630,7 @@ MonitorElement::getTH1S() const
 {
   assert(kind() == DQM_KIND_TH1S);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH1S *>(accessRootObject(__PRETTY_FUNCTION__, 1));
+  return static_cast<TH1S *>(exposeRootObject(__PRETTY_FUNCTION__, 1));
 }
 
 TH1D *
@@ -1500,7 +1638,7 @@ MonitorElement::getTH1D() const
 {
   assert(kind() == DQM_KIND_TH1D);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH1D *>(accessRootObject(__PRETTY_FUNCTION__, 1));
+  return static_cast<TH1D *>(exposeRootObject(__PRETTY_FUNCTION__, 1));
 }
 
 TH2F *
@@ -1508,7 +1646,7 @@ MonitorElement::getTH2F() const
 {
   assert(kind() == DQM_KIND_TH2F);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH2F *>(accessRootObject(__PRETTY_FUNCTION__, 2));
+  return static_cast<TH2F *>(exposeRootObject(__PRETTY_FUNCTION__, 2));
 }
 
 TH2S *
@@ -1516,7 +1654,7 @@ MonitorElement::getTH2S() const
 {
   assert(kind() == DQM_KIND_TH2S);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH2S *>(accessRootObject(__PRETTY_FUNCTION__, 2));
+  return static_cast<TH2S *>(exposeRootObject(__PRETTY_FUNCTION__, 2));
 }
 
 TH2D *
@@ -1524,7 +1662,7 @@ MonitorElement::getTH2D() const
 {
   assert(kind() == DQM_KIND_TH2D);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH2D *>(accessRootObject(__PRETTY_FUNCTION__, 2));
+  return static_cast<TH2D *>(exposeRootObject(__PRETTY_FUNCTION__, 2));
 }
 
 TH3F *
@@ -1532,7 +1670,7 @@ MonitorElement::getTH3F() const
 {
   assert(kind() == DQM_KIND_TH3F);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TH3F *>(accessRootObject(__PRETTY_FUNCTION__, 3));
+  return static_cast<TH3F *>(exposeRootObject(__PRETTY_FUNCTION__, 3));
 }
 
 TProfile *
@@ -1540,7 +1678,7 @@ MonitorElement::getTProfile() const
 {
   assert(kind() == DQM_KIND_TPROFILE);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TProfile *>(accessRootObject(__PRETTY_FUNCTION__, 1));
+  return static_cast<TProfile *>(exposeRootObject(__PRETTY_FUNCTION__, 1));
 }
 
 TProfile2D *
@@ -1548,7 +1686,7 @@ MonitorElement::getTProfile2D() const
 {
   assert(kind() == DQM_KIND_TPROFILE2D);
   const_cast<MonitorElement *>(this)->update();
-  return static_cast<TProfile2D *>(accessRootObject(__PRETTY_FUNCTION__, 2));
+  return static_cast<TProfile2D *>(exposeRootObject(__PRETTY_FUNCTION__, 2));
 }
 
 // -------------------------------------------------------------------
@@ -0,0 +1,294 @@
+#include "DQMServices/Core/src/NativeHistogram.h"
+#include "TH1F.h"
+#include "TH1D.h"
+#include "TH2F.h"
+#include "TH2D.h"
+#include "TList.h"
+#include <algorithm>
+#include <cmath>
+
+using dqm::NativeHistogram;
+
+/// true if the axis has fixed-width bins and nothing else set that the
+/// native storage would lose
+static bool
+isPlainAxis(const TAxis &axis)
+{
+  return (! axis.IsVariableBinSize()
+          && ! axis.GetLabels()
+          && ! axis.GetTimeDisplay()
+          && ! axis.TestBit(TAxis::kAxisRange)
+          && ! axis.CanExtend()
+          && axis.GetNbins() > 0
+          && axis.GetXmax() > axis.GetXmin());
+}
+
+std::unique_ptr<NativeHistogram>
+NativeHistogram::fromROOT(const TH1 &h, bool floatPrecision)
+{
+  const TClass *type = h.IsA();
+  bool isFloat = (type == TH1F::Class() || type == TH2F::Class());
+  bool isDouble = (type == TH1D::Class() || type == TH2D::Class());
+  if (! isFloat && ! isDouble)
+    return nullptr;
+
+  int dimension = h.GetDimension();
+  if (! isPlainAxis(*h.GetXaxis())
+      || (dimension == 2 && ! isPlainAxis(*h.GetYaxis()))
+      || h.GetBuffer()
+      || h.TestBit(TH1::kIsNotW)
+      || h.TestBit(TH1::kIsAverage)
+      || h.GetStatOverflowsBehaviour()
+      || h.GetBinErrorOption() != TH1::kNormal
+      || h.GetNormFactor() != 0
+      || h.GetMaximumStored() != -1111
+      || h.GetMinimumStored() != -1111
+      || (h.GetListOfFunctions() && h.GetListOfFunctions()->GetSize()))
+    return nullptr;
+
+  std::unique_ptr<NativeHistogram> n(new NativeHistogram);
+  n->name_ = h.GetName();
+  n->title_ = h.GetTitle();
+  n->option_ = h.GetOption();
+  n->noStats_ = h.TestBit(TH1::kNoStats);
+
+  auto setAxis = [](Axis &a, const TAxis &axis)
+    {
+      a.nbins = axis.GetNbins();
+      a.min = axis.GetXmin();
+      a.max = axis.GetXmax();
+      a.title = axis.GetTitle();
+    };
+  setAxis(n->x_, *h.GetXaxis());
+  if (dimension == 2)
+  {
+    setAxis(n->y_, *h.GetYaxis());
+    n->ny_ = n->y_.nbins;
+  }
+  else
+    n->y_.title = h.GetYaxis()->GetTitle();
+  n->zTitle_ = h.GetZaxis()->GetTitle();
+
+  n->lineColor_ = h.GetLineColor();
+  n->lineStyle_ = h.GetLineStyle();
+  n->lineWidth_ = h.GetLineWidth();
+  n->fillColor_ = h.GetFillColor();
+  n->fillStyle_ = h.GetFillStyle();
+  n->markerColor_ = h.GetMarkerColor();
+  n->markerStyle_ = h.GetMarkerStyle();
+  n->markerSize_ = h.GetMarkerSize();
+
+  size_t ncells = h.GetNcells();
+  if (isFloat)
+  {
+    const Float_t *contents = dynamic_cast<const TArrayF &>(h).GetArray();
+    n->floatContents_.assign(contents, contents + ncells);
+  }
+  else if (floatPrecision)
+  {
+    const Double_t *contents = dynamic_cast<const TArrayD &>(h).GetArray();
+    n->floatContents_.assign(contents, contents + ncells);
+  }
+  else
+  {
+    const Double_t *contents = dynamic_cast<const TArrayD &>(h).GetArray();
+    n->doubleContents_.assign(contents, contents + ncells);
+  }
+  if (h.GetSumw2N())
+  {
+    const Double_t *sumw2 = h.GetSumw2()->GetArray();
+    n->sumw2_.assign(sumw2, sumw2 + ncells);
+  }
+
+  Double_t stats[TH1::kNstat] = { 0 };
+  h.GetStats(stats);
+  n->tsumw_ = stats[0];
+  n->tsumw2_ = stats[1];
+  n->tsumwx_ = stats[2];
+  n->tsumwx2_ = stats[3];
+  if (dimension == 2)
+  {
+    n->tsumwy_ = stats[4];
+    n->tsumwy2_ = stats[5];
+    n->tsumwxy_ = stats[6];
+  }
+  n->entries_ = h.GetEntries();
+
+  return n;
+}
+
+TH1 *
+NativeHistogram::toROOT(bool doublePrecision) const
+{
+  TH1 *h;
+  if (ny_ == 0)
+    h = doublePrecision
+      ? static_cast<TH1 *>(new TH1D(name_.c_str(), title_.c_str(), x_.nbins, x_.min, x_.max))
+      : static_cast<TH1 *>(new TH1F(name_.c_str(), title_.c_str(), x_.nbins, x_.min, x_.max));
+  else
+    h = doublePrecision
+      ? static_cast<TH1 *>(new TH2D(name_.c_str(), title_.c_str(), x_.nbins, x_.min, x_.max,
+                                    y_.nbins, y_.min, y_.max))
+      : static_cast<TH1 *>(new TH2F(name_.c_str(), title_.c_str(), x_.nbins, x_.min, x_.max,
+                                    y_.nbins, y_.min, y_.max));
+  h->SetDirectory(nullptr);
+
+  h->SetOption(option_.c_str());
+  if (noStats_)
+    h->SetStats(false);
+  h->GetXaxis()->SetTitle(x_.title.c_str());
+  h->GetYaxis()->SetTitle(y_.title.c_str());
+  h->GetZaxis()->SetTitle(zTitle_.c_str());
+  h->SetLineColor(lineColor_);
+  h->SetLineStyle(lineStyle_);
+  h->SetLineWidth(lineWidth_);
+  h->SetFillColor(fillColor_);
+  h->SetFillStyle(fillStyle_);
+  h->SetMarkerColor(markerColor_);
+  h->SetMarkerStyle(markerStyle_);
+  h->SetMarkerSize(markerSize_);
+
+  // the contents, under- and overflows included, are written directly to
+  // the arrays of the histogram, SetBinContent would count entries
+  if (doublePrecision)
+  {
+    Double_t *contents = dynamic_cast<TArrayD &>(*h).GetArray();
+    if (doubleContents_.empty())
+      std::copy(floatContents_.begin(), floatContents_.end(), contents);
+    else
+      std::copy(doubleContents_.begin(), doubleContents_.end(), contents);
+  }
+  else
+  {
+    Float_t *contents = dynamic_cast<TArrayF &>(*h).GetArray();
+    std::copy(floatContents_.begin(), floatContents_.end(), contents);
+  }
+  if (! sumw2_.empty())
+  {
+    h->Sumw2();
+    std::copy(sumw2_.begin(), sumw2_.end(), h->GetSumw2()->GetArray());
+  }
+
+  Double_t stats[TH1::kNstat] = { tsumw_, tsumw2_, tsumwx_, tsumwx2_, tsumwy_, tsumwy2_, tsumwxy_ };
+  h->PutStats(stats);
+  h->SetEntries(entries_);
+
+  return h;
+}
+
+/// as TH1::AddBinContent, after TH1::Sumw2 if this is the first weighted fill
+inline void
+NativeHistogram::addToBin(size_t bin, double w)
+{
+  if (sumw2_.empty() && w != 1.0)
+    sumw2();
+  if (! sumw2_.empty())
+    sumw2_[bin] += w*w;
+  if (doubleContents_.empty())
+    floatContents_[bin] += float(w);
+  else
+    doubleContents_[bin] += w;
+}
+
+/// as TH1::Sumw2: the errors of the existing entries are their contents
+void
+NativeHistogram::sumw2()
+{
+  size_t ncells = std::max(floatContents_.size(), doubleContents_.size());
+  sumw2_.assign(ncells, 0.);
+  if (entries_ > 0)
+    for (size_t i = 0; i < ncells; ++i)
+      sumw2_[i] = std::abs(doubleContents_.empty() ? floatContents_[i] : doubleContents_[i]);
+}
+
+/// as TH1::Fill(x, w)
+void
+NativeHistogram::fill(double x, double w)
+{
+  entries_ += 1;
+  int bin = x_.findBin(x);
+  addToBin(bin, w);
+  if (bin == 0 || bin > x_.nbins)
+    return;
+  tsumw_ += w;
+  tsumw2_ += w*w;
+  tsumwx_ += w*x;
+  tsumwx2_ += w*x*x;
+}
+
+/// as TH2::Fill(x, y, w)
+void
+NativeHistogram::fill(double x, double y, double w)
+{
+  entries_ += 1;
+  int binx = x_.findBin(x);
+  int biny = y_.findBin(y);
+  addToBin(size_t(biny) * (x_.nbins + 2) + binx, w);
+  if (binx == 0 || binx > x_.nbins || biny == 0 || biny > y_.nbins)
+    return;
+  tsumw_ += w;
+  tsumw2_ += w*w;
+  tsumwx_ += w*x;
+  tsumwx2_ += w*x*x;
+  tsumwy_ += w*y;
+  tsumwy2_ += w*y*y;
+  tsumwxy_ += w*x*y;
+}
+
+/// as TH1::Reset: the errors stay enabled if they were
+void
+NativeHistogram::reset()
+{
+  std::fill(floatContents_.begin(), floatContents_.end(), 0.f);
+  std::fill(doubleContents_.begin(), doubleContents_.end(), 0.);
+  std::fill(sumw2_.begin(), sumw2_.end(), 0.);
+  entries_ = tsumw_ = tsumw2_ = tsumwx_ = tsumwx2_ = tsumwy_ = tsumwy2_ = tsumwxy_ = 0.;
+}
+
+/// as TH1::Add(other, 1)
+bool
+NativeHistogram::add(const NativeHistogram &other)
+{
+  if (ny_ != other.ny_
+      || x_.nbins != other.x_.nbins || x_.min != other.x_.min || x_.max != other.x_.max
+      || (ny_ && (y_.min != other.y_.min || y_.max != other.y_.max)))
+    return false;
+
+  size_t ncells = std::max(floatContents_.size(), doubleContents_.size());
+  auto content = [](const NativeHistogram &h, size_t i) -> double
+    { return h.doubleContents_.empty() ? h.floatContents_[i] : h.doubleContents_[i]; };
+
+  if (sumw2_.empty() && ! other.sumw2_.empty())
+    sumw2();
+  if (! sumw2_.empty())
+    for (size_t i = 0; i < ncells; ++i)
+      sumw2_[i] += other.sumw2_.empty() ? std::abs(content(other, i)) : other.sumw2_[i];
+
+  if (doubleContents_.empty())
+    for (size_t i = 0; i < ncells; ++i)
+      floatContents_[i] = float(floatContents_[i] + content(other, i));
+  else
+    for (size_t i = 0; i < ncells; ++i)
+      doubleContents_[i] += content(other, i);
+
+  entries_ += other.entries_;
+  tsumw_ += other.tsumw_;
+  tsumw2_ += other.tsumw2_;
+  tsumwx_ += other.tsumwx_;
+  tsumwx2_ += other.tsumwx2_;
+  tsumwy_ += other.tsumwy_;
+  tsumwy2_ += other.tsumwy2_;
+  tsumwxy_ += other.tsumwxy_;
+  return true;
+}
+
+size_t
+NativeHistogram::memory() const
+{
+  return sizeof(*this)
+    + name_.capacity() + title_.capacity() + option_.capacity()
+    + x_.title.capacity() + y_.title.capacity() + zTitle_.capacity()
+    + floatContents_.capacity() * sizeof(float)
+    + doubleContents_.capacity() * sizeof(double)
+    + sumw2_.capacity() * sizeof(double);
+}
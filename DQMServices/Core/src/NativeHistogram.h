@@ -0,0 +1,106 @@
+#ifndef DQMSERVICES_CORE_NATIVEHISTOGRAM_H
+# define DQMSERVICES_CORE_NATIVEHISTOGRAM_H
+
+# include <cstddef>
+# include <memory>
+# include <string>
+# include <vector>
+
+class TH1;
+
+namespace dqm
+{
+  /** Compact storage of a 1D or 2D histogram with fixed-width bins: the
+      bin contents (including under- and overflows) in one contiguous
+      array, the axes as (bins, min, max) and the few strings needed to
+      rebuild the ROOT object. Filling follows TH1::Fill and TH2::Fill,
+      including the statistics, so that the ROOT object made back from it
+      is the one that would have been filled directly.
+
+      Histograms with anything else (variable bins, labels, axis ranges,
+      functions...) cannot be stored natively, see fromROOT(). */
+  class NativeHistogram
+  {
+  public:
+    /// Native copy of h, or null if h cannot be stored natively. The
+    /// contents are kept in float if h is a TH1F or TH2F or if
+    /// floatPrecision is set, in double otherwise.
+    static std::unique_ptr<NativeHistogram> fromROOT(const TH1 &h, bool floatPrecision);
+
+    /// New ROOT object, a TH1D or TH2D if doublePrecision is set and a
+    /// TH1F or TH2F otherwise, not attached to any directory.
+    TH1 *toROOT(bool doublePrecision) const;
+
+    void fill(double x, double w);
+    void fill(double x, double y, double w);
+    void reset();
+
+    /// Add the contents of other; false if the binnings differ.
+    bool add(const NativeHistogram &other);
+
+    int dimension() const
+    { return ny_ ? 2 : 1; }
+
+    /// Approximate number of bytes used.
+    size_t memory() const;
+
+  private:
+    struct Axis
+    {
+      int nbins;
+      double min;
+      double max;
+      std::string title;
+
+      // as TAxis::FindFixBin, with the same rounding at the bin edges
+      int findBin(double x) const
+      {
+        if (x < min)
+          return 0;
+        if (! (x < max))
+          return nbins + 1;
+        return 1 + int(nbins * (x - min) / (max - min));
+      }
+    };
+
+    NativeHistogram() = default;
+    void addToBin(size_t bin, double w);
+    void sumw2();
+
+    std::string name_;
+    std::string title_;
+    std::string option_;
+    bool noStats_ = false;
+    Axis x_;
+    Axis y_;
+    std::string zTitle_;
+    int ny_ = 0;
+
+    // drawing attributes
+    short lineColor_ = 0;
+    short lineStyle_ = 0;
+    short lineWidth_ = 0;
+    short fillColor_ = 0;
+    short fillStyle_ = 0;
+    short markerColor_ = 0;
+    short markerStyle_ = 0;
+    float markerSize_ = 0.f;
+
+    // one of the two is used
+    std::vector<float> floatContents_;
+    std::vector<double> doubleContents_;
+    // sum of the squares of the weights, only once a weight != 1 is used
+    std::vector<double> sumw2_;
+
+    double entries_ = 0.;
+    double tsumw_ = 0.;
+    double tsumw2_ = 0.;
+    double tsumwx_ = 0.;
+    double tsumwx2_ = 0.;
+    double tsumwy_ = 0.;
+    double tsumwy2_ = 0.;
+    double tsumwxy_ = 0.;
+  };
+}
+
+#endif // DQMSERVICES_CORE_NATIVEHISTOGRAM_H
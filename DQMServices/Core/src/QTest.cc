@@ -3,8 +3,11 @@
 #include "DQMServices/Core/src/QStatisticalTests.h"
 #include "DQMServices/Core/src/DQMError.h"
 #include "TMath.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <math.h>
 #include "Math/ProbFuncMathCore.h"
 
@@ -12,6 +15,72 @@ using namespace std;
 
 const float QCriterion::ERROR_PROB_THRESHOLD = 0.50;
 const float QCriterion::WARNING_PROB_THRESHOLD = 0.90;
+bool QCriterion::directBinAccess_ = true;
+
+namespace {
+  /// The bin contents, and the bin errors if asked, of all the cells of a
+  /// histogram (under- and overflows included, indexed as TH1::GetBin) as
+  /// GetBinContent and GetBinError give them. For the plain 1D and 2D
+  /// histograms they are read directly from the arrays, for the others
+  /// (profiles, buffered histograms, non-gaussian errors) through the
+  /// accessors. The loops of the tests then run over plain arrays, without
+  /// a virtual call per bin, and the compiler can vectorise them.
+  struct BinArrays
+  {
+    std::vector<double> content;
+    std::vector<double> error;
+
+    BinArrays(const TH1 *h, bool errors)
+    {
+      int ncells = h->GetNcells();
+      const TClass *type = h->IsA();
+      bool direct = (QCriterion::directBinAccess()
+                     && ! h->GetBuffer()
+                     && h->GetBinErrorOption() == TH1::kNormal);
+      if (direct && (type == TH1F::Class() || type == TH2F::Class()))
+        copy(dynamic_cast<const TArrayF &>(*h).GetArray(), ncells);
+      else if (direct && (type == TH1S::Class() || type == TH2S::Class()))
+        copy(dynamic_cast<const TArrayS &>(*h).GetArray(), ncells);
+      else if (direct && (type == TH1D::Class() || type == TH2D::Class()))
+        copy(dynamic_cast<const TArrayD &>(*h).GetArray(), ncells);
+      else
+      {
+        content.resize(ncells);
+        for (int bin = 0; bin < ncells; ++bin)
+          content[bin] = h->GetBinContent(bin);
+        if (errors)
+        {
+          error.resize(ncells);
+          for (int bin = 0; bin < ncells; ++bin)
+            error[bin] = h->GetBinError(bin);
+        }
+        return;
+      }
+
+      // as TH1::GetBinError
+      if (errors)
+      {
+        error.resize(ncells);
+        if (h->GetSumw2N())
+        {
+          const double *sumw2 = h->GetSumw2()->GetArray();
+          for (int bin = 0; bin < ncells; ++bin)
+            error[bin] = std::sqrt(sumw2[bin]);
+        }
+        else
+          for (int bin = 0; bin < ncells; ++bin)
+            error[bin] = std::sqrt(std::abs(content[bin]));
+      }
+    }
+
+  private:
+    template <class T>
+    void copy(const T *array, int ncells)
+    {
+      content.assign(array, array + ncells);
+    }
+  };
+}
 
 // initialize values
 void
@@ -242,12 +311,15 @@ float Comp2RefChi2::runTest(const MonitorElement *me)
   //  }
   ndof = i_end-i_start+1-constraint;
 
+  BinArrays b1(h, true);
+  BinArrays b2(ref_, true);
+
   //Compute the normalisation factor
   double sum1=0, sum2=0;
   for (i=i_start; i<=i_end; i++)
   {
-    sum1 += h->GetBinContent(i);
-    sum2 += ref_->GetBinContent(i);
+    sum1 += b1.content[i];
+    sum2 += b2.content[i];
   }
 
   //check that the histograms are not empty
@@ -268,29 +340,41 @@ float Comp2RefChi2::runTest(const MonitorElement *me)
     return -1;
   }
 
-  double bin1, bin2, err1, err2, temp;
-  for (i=i_start; i<=i_end; i++)
+  // the terms of all the bins are computed first, in a loop without
+  // branches which vectorises, then summed in the order of the bins
+  int nbins = std::max(i_end-i_start+1, 0);
+  const double *c1 = &b1.content[i_start], *c2 = &b2.content[i_start];
+  const double *e1 = &b1.error[i_start], *e2 = &b2.error[i_start];
+  std::vector<double> terms(nbins);
+  std::vector<char> empty(nbins), noError(nbins);
+  for (i=0; i<nbins; i++)
   {
-    bin1 = h->GetBinContent(i)/sum1;
-    bin2 = ref_->GetBinContent(i)/sum2;
-    if (bin1 ==0 && bin2==0)
+    double bin1 = c1[i]/sum1;
+    double bin2 = c2[i]/sum2;
+    double temp = bin1-bin2;
+    double err1 = e1[i]*e1[i]/(sum1*sum1);
+    double err2 = e2[i]*e2[i]/(sum2*sum2);
+    empty[i] = (bin1 == 0 && bin2 == 0);
+    noError[i] = (e1[i] == 0 && e2[i] == 0);
+    terms[i] = temp*temp/(noError[i] ? 1. : err1+err2);
+  }
+
+  for (i=0; i<nbins; i++)
+  {
+    if (empty[i])
     {
       --ndof; //no data means one less degree of freedom
     } 
     else 
     {
-      temp  = bin1-bin2;
-      err1=h->GetBinError(i); err2=ref_->GetBinError(i);
-      if (err1 == 0 && err2 == 0)
+      if (noError[i])
       {
 	if (verbose_>0) 
 	  std::cout << "QTest:Comp2RefChi2"
 	            << " bins with non-zero content and zero error, exiting\n";
 	return -1;
       }
-      err1*=err1      ; err2*=err2;
-      err1/=sum1*sum1 ; err2/=sum2*sum2;
-      chi2 +=temp*temp/(err1+err2);
+      chi2 += terms[i];
     }
   }
   chi2_ = chi2;  Ndof_ = ndof;
@@ -475,12 +559,14 @@ float Comp2RefKolmogorov::runTest(const MonitorElement *me)
   double sum1 = 0, sum2 = 0;
   double ew1, ew2, w1 = 0, w2 = 0;
   int bin;
+  BinArrays b1(h, true);
+  BinArrays b2(ref_, true);
   for (bin=1;bin<=ncx1;bin++)
   {
-    sum1 += h->GetBinContent(bin);
-    sum2 += ref_->GetBinContent(bin);
-    ew1   = h->GetBinError(bin);
-    ew2   = ref_->GetBinError(bin);
+    sum1 += b1.content[bin];
+    sum2 += b2.content[bin];
+    ew1   = b1.error[bin];
+    ew2   = b2.error[bin];
     w1   += ew1*ew1;
     w2   += ew2*ew2;
   }
@@ -503,10 +589,10 @@ float Comp2RefKolmogorov::runTest(const MonitorElement *me)
   }
 
   double tsum1 = sum1; double tsum2 = sum2;
-  tsum1 += h->GetBinContent(0);
-  tsum2 += ref_->GetBinContent(0);
-  tsum1 += h->GetBinContent(ncx1+1);
-  tsum2 += ref_->GetBinContent(ncx1+1);
+  tsum1 += b1.content[0];
+  tsum2 += b2.content[0];
+  tsum1 += b1.content[ncx1+1];
+  tsum2 += b2.content[ncx1+1];
 
   // Check if histograms are weighted.
   // If number of entries = number of channels, probably histograms were
@@ -557,8 +643,8 @@ float Comp2RefKolmogorov::runTest(const MonitorElement *me)
   int last  = ncx1+1; // ncx1
   for ( bin=first; bin<=last; bin++)
   {
-    rsum1 += s1*h->GetBinContent(bin);
-    rsum2 += s2*ref_->GetBinContent(bin);
+    rsum1 += s1*b1.content[bin];
+    rsum2 += s2*b2.content[bin];
     dfmax = TMath::Max(dfmax,std::abs(rsum1-rsum2));
   }
 
@@ -798,20 +884,21 @@ float DeadChannel::runTest(const MonitorElement*me)
     int first = 1;
     int last  = ncx;
     int bin;
+    BinArrays b(h1, false);
+    const double *contents = &b.content[0];
 
-    /// loop over all channels
+    /// count the dead channels (equal to or less than ymin_), in a loop
+    /// which vectorises, and list them only if there are some
     for (bin = first; bin <= last; ++bin)
-    {
-      double contents = h1->GetBinContent(bin);
-      bool failure = false;
-      failure = contents <= ymin_; // dead channel: equal to or less than ymin_
-      if (failure)
-      { 
-        DQMChannel chan(bin, 0, 0, contents, h1->GetBinError(bin));
-        badChannels_.push_back(chan);
-        ++fail;
-      }
-    }
+      fail += (contents[bin] <= ymin_);
+
+    if (fail)
+      for (bin = first; bin <= last; ++bin)
+        if (contents[bin] <= ymin_)
+        { 
+          DQMChannel chan(bin, 0, 0, contents[bin], h1->GetBinError(bin));
+          badChannels_.push_back(chan);
+        }
     //return fraction of alive channels
     return 1.*(ncx - fail)/ncx;
   }
@@ -822,23 +909,31 @@ float DeadChannel::runTest(const MonitorElement*me)
   {
     int ncx = h2->GetXaxis()->GetNbins(); // get X bins
     int ncy = h2->GetYaxis()->GetNbins(); // get Y bins
+    BinArrays b(h2, false);
+    const double *contents = &b.content[0];
 
-    /// loop over all bins 
-    for (int cx = 1; cx <= ncx; ++cx)
+    /// count the dead channels row by row, along the array, and list them
+    /// in the order of the columns only if there are some
+    for (int cy = 1; cy <= ncy; ++cy)
     {
-      for (int cy = 1; cy <= ncy; ++cy)
+      const double *row = contents + cy*(ncx+2);
+      for (int cx = 1; cx <= ncx; ++cx)
+        fail += (row[cx] <= ymin_);
+    }
+
+    if (fail)
+      for (int cx = 1; cx <= ncx; ++cx)
       {
-	double contents = h2->GetBinContent(h2->GetBin(cx, cy));
-	bool failure = false;
-	failure = contents <= ymin_; // dead channel: equal to or less than ymin_
-	if (failure)
-	{ 
-          DQMChannel chan(cx, cy, 0, contents, h2->GetBinError(h2->GetBin(cx, cy)));
-          badChannels_.push_back(chan);
-          ++fail;
-	}
+        for (int cy = 1; cy <= ncy; ++cy)
+        {
+          int bin = h2->GetBin(cx, cy);
+          if (contents[bin] <= ymin_)
+          { 
+            DQMChannel chan(cx, cy, 0, contents[bin], h2->GetBinError(bin));
+            badChannels_.push_back(chan);
+          }
+        }
       }
-    }
     //return fraction of alive channels
     return 1.*(ncx*ncy - fail) / (ncx*ncy);
   }
@@ -1522,6 +1617,14 @@ float ContentsWithinExpected::runTest(const MonitorElement*me)
     double sum = 0.0;
     double average = 0.0;
 
+    // the bins are read from arrays; a profile has no y stride, as
+    // TProfile::GetBin(cx, cy) is cx
+    BinArrays b(h, checkRMS_);
+    const double *contents = &b.content[0];
+    int stride = (h->GetDimension() == 1 ? 0 : ncx+2);
+    TProfile *p1 = (me->kind() == MonitorElement::DQM_KIND_TPROFILE ? me->getTProfile() : nullptr);
+    TProfile2D *p2 = (me->kind() == MonitorElement::DQM_KIND_TPROFILE2D ? me->getTProfile2D() : nullptr);
+
     if (checkMeanTolerance_)
     { // calculate average value of all bin contents
 
@@ -1529,37 +1632,13 @@ float ContentsWithinExpected::runTest(const MonitorElement*me)
       {
 	for (int cy = 1; cy <= ncy; ++cy)
 	{
-	  if (me->kind() == MonitorElement::DQM_KIND_TH2F)
-	  {
-	    sum += h->GetBinContent(h->GetBin(cx, cy));
-	    ++nsum;
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TH2S)
-	  {
-	    sum += h->GetBinContent(h->GetBin(cx, cy));
-	    ++nsum;
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TH2D)
-	  {
-	    sum += h->GetBinContent(h->GetBin(cx, cy));
-	    ++nsum;
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TPROFILE)
-	  {
-	    if (me->getTProfile()->GetBinEntries(h->GetBin(cx)) >= minEntries_/(ncx))
-	    {
-	      sum += h->GetBinContent(h->GetBin(cx));
-	      ++nsum;
-	    }
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TPROFILE2D)
-	  {
-	    if (me->getTProfile2D()->GetBinEntries(h->GetBin(cx, cy)) >= minEntries_/(ncx*ncy))
-	    {
-	      sum += h->GetBinContent(h->GetBin(cx, cy));
-	      ++nsum;
-	    }
-	  }
+	  int bin = cx + stride*cy;
+	  if (p1 && p1->GetBinEntries(bin) < minEntries_/(ncx))
+	    continue;
+	  if (p2 && p2->GetBinEntries(bin) < minEntries_/(ncx*ncy))
+	    continue;
+	  sum += contents[bin];
+	  ++nsum;
 	}
       }
 
@@ -1574,72 +1653,56 @@ float ContentsWithinExpected::runTest(const MonitorElement*me)
     {
       for (int cy = 1; cy <= ncy; ++cy)
       {
+	int bin = cx + stride*cy;
 	bool failMean = false;
 	bool failRMS = false;
 	bool failMeanTolerance = false;
 
-	if (me->kind() == MonitorElement::DQM_KIND_TPROFILE && 
-            me->getTProfile()->GetBinEntries(h->GetBin(cx)) < minEntries_/(ncx))
+	if (p1 && p1->GetBinEntries(bin) < minEntries_/(ncx))
           continue;
 
-	if (me->kind() == MonitorElement::DQM_KIND_TPROFILE2D && 
-            me->getTProfile2D()->GetBinEntries(h->GetBin(cx, cy)) < minEntries_/(ncx*ncy)) 
+	if (p2 && p2->GetBinEntries(bin) < minEntries_/(ncx*ncy)) 
 	  continue;
 
 	if (checkMean_)
 	{
-	  double mean = h->GetBinContent(h->GetBin(cx, cy));
+	  double mean = contents[bin];
           failMean = (mean < minMean_ || mean > maxMean_);
 	}
 
 	if (checkRMS_)
 	{
-	  double rms = h->GetBinError(h->GetBin(cx, cy));
+	  double rms = b.error[bin];
           failRMS = (rms < minRMS_ || rms > maxRMS_);
 	}
 
 	if (checkMeanTolerance_)
 	{
-	  double mean = h->GetBinContent(h->GetBin(cx, cy));
+	  double mean = contents[bin];
           failMeanTolerance = (std::abs(mean - average) > toleranceMean_*std::abs(average));
 	}
 
 	if (failMean || failRMS || failMeanTolerance)
 	{
-
-	  if (me->kind() == MonitorElement::DQM_KIND_TH2F) 
+	  if (p1) 
 	  {
-            DQMChannel chan(cx, cy, 0,
-			    h->GetBinContent(h->GetBin(cx, cy)),
-			    h->GetBinError(h->GetBin(cx, cy)));
+	    DQMChannel chan(cx, cy, int(p1->GetBinEntries(bin)),
+			    0,
+			    h->GetBinError(bin));
             badChannels_.push_back(chan);
 	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TH2S) 
+	  else if (p2) 
 	  {
-            DQMChannel chan(cx, cy, 0,
-			    h->GetBinContent(h->GetBin(cx, cy)),
-			    h->GetBinError(h->GetBin(cx, cy)));
+	    DQMChannel chan(cx, cy, int(p2->GetBinEntries(bin)),
+			    contents[bin],
+			    h->GetBinError(bin));
             badChannels_.push_back(chan);
 	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TH2D) 
+	  else
 	  {
             DQMChannel chan(cx, cy, 0,
-			    h->GetBinContent(h->GetBin(cx, cy)),
-			    h->GetBinError(h->GetBin(cx, cy)));
-            badChannels_.push_back(chan);
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TPROFILE) 
-	  {
-	    DQMChannel chan(cx, cy, int(me->getTProfile()->GetBinEntries(h->GetBin(cx))),
-			    0,
-			    h->GetBinError(h->GetBin(cx)));
-            badChannels_.push_back(chan);
-	  }
-	  else if (me->kind() == MonitorElement::DQM_KIND_TPROFILE2D) 
-	  {
-	    DQMChannel chan(cx, cy, int(me->getTProfile2D()->GetBinEntries(h->GetBin(cx, cy))),
-			    h->GetBinContent(h->GetBin(cx, cy)),
-			    h->GetBinError(h->GetBin(cx, cy)));
+			    contents[bin],
+			    h->GetBinError(bin));
             badChannels_.push_back(chan);
 	  }
           ++fail;
@@ -1679,17 +1742,13 @@ float ContentsWithinExpected::runTest(const MonitorElement*me)
 
     // if (!rangeInitialized_) return 0; // all accepted if no initialization
     int fail = 0;
-    for (int cx = 1; cx <= ncx; ++cx)
+    BinArrays b(h, false);
+    // count the failures row by row, along the array
+    for (int cy = 1; cy <= ncy; ++cy)
     {
-      for (int cy = 1; cy <= ncy; ++cy)
-      {
-	bool failure = false;
-	double Content = h->GetBinContent(h->GetBin(cx, cy));
-	if (Content) 
-	  failure = (Content <  minMean_ || Content >  maxMean_);
-	if (failure) 
-	  ++fail;
-      }
+      const double *row = &b.content[cy*(ncx+2)];
+      for (int cx = 1; cx <= ncx; ++cx)
+	fail += (row[cx] != 0 && (row[cx] <  minMean_ || row[cx] >  maxMean_));
     }
     return 1.*(ncx*ncy-fail)/(ncx*ncy);
   } /// end of AS quality test 
@@ -0,0 +1,211 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "DQMServices/Core/interface/MonitorElement.h"
+#include "DQMServices/Core/interface/QReport.h"
+#include "DQMServices/Core/interface/QTest.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "tbb/task_arena.h"
+
+/*
+ * Benchmark of the concurrent harvesting of the DQMStore. Each subsystem
+ * has a harvester which reads the MEs of its source folder and books its
+ * results in its own folder, and a last harvester summarises the results
+ * of all the others, as the DQM summary clients do. The harvesters run
+ * one after the other, then with concurrent harvesting twice: without
+ * profile, which runs them in order and records the profile, and with
+ * the profile. The time of each pass is printed, and the results are
+ * checked to be those of the first pass.
+ *
+ * The quality tests of the source MEs are then run sequentially, and in
+ * parallel with all the threads, and their results compared.
+ *
+ * Usage: DQMHarvestingBenchmark [number of subsystems] [MEs per subsystem]
+ */
+
+namespace {
+  const int nbins = 100;
+  const char *profileFile = "DQMHarvestingBenchmark.profile";
+
+  std::string subsystem(unsigned int i)
+  {
+    return "Subsystem" + std::to_string(i);
+  }
+
+  void bookSources(DQMStore & store, unsigned int nSubsystems, unsigned int nMEs)
+  {
+    store.bookTransaction([&](DQMStore::IBooker & b) {
+        for (unsigned int s = 0; s < nSubsystems; ++s)
+        {
+          b.setCurrentFolder("Source/" + subsystem(s));
+          for (unsigned int i = 0; i < nMEs; ++i)
+          {
+            MonitorElement * me = b.book1D("h" + std::to_string(i), "source", nbins, 0., nbins);
+            for (int bin = 1; bin <= nbins; ++bin)
+              me->setBinContent(bin, 100 + (bin * 7 + i * 13 + s) % 17 + (bin == int(i % nbins) + 1 ? 80 : 0));
+            me->setEntries(nbins * 100);
+          }
+        }
+      }, 0, 0);
+  }
+
+  // the cumulative distribution and the bin pulls of each source ME, as
+  // an efficiency client would do
+  void harvestSubsystem(DQMStore::IBooker & b, DQMStore::IGetter & g, unsigned int s)
+  {
+    std::vector<MonitorElement *> sources = g.getContents("Source/" + subsystem(s));
+    b.setCurrentFolder("Harvest/" + subsystem(s));
+    MonitorElement * quality = b.book1D("quality", "quality", sources.size(), 0., sources.size());
+    for (unsigned int i = 0; i < sources.size(); ++i)
+    {
+      TH1 * h = sources[i]->getTH1();
+      MonitorElement * cumulative = b.book1D(sources[i]->getName() + "_cumulative", "cumulative", nbins, 0., nbins);
+      MonitorElement * pulls = b.book1D(sources[i]->getName() + "_pulls", "pulls", nbins, 0., nbins);
+      double sum = 0;
+      double chi2 = 0;
+      for (int bin = 1; bin <= nbins; ++bin)
+      {
+        sum += h->GetBinContent(bin);
+        cumulative->setBinContent(bin, sum / h->Integral());
+        double mean = 0;
+        for (int other = 1; other <= nbins; ++other)
+          if (other != bin)
+            mean += h->GetBinContent(other) / (nbins - 1);
+        double pull = (h->GetBinContent(bin) - mean) / std::sqrt(mean);
+        pulls->setBinContent(bin, pull);
+        chi2 += pull * pull;
+      }
+      quality->setBinContent(i + 1, chi2 / nbins);
+    }
+  }
+
+  // the mean quality of each subsystem
+  void harvestSummary(DQMStore::IBooker & b, DQMStore::IGetter & g, unsigned int nSubsystems)
+  {
+    b.setCurrentFolder("Harvest/Summary");
+    MonitorElement * summary = b.book1D("summary", "summary", nSubsystems, 0., nSubsystems);
+    for (unsigned int s = 0; s < nSubsystems; ++s)
+    {
+      MonitorElement * quality = g.get("Harvest/" + subsystem(s) + "/quality");
+      summary->setBinContent(s + 1, quality ? quality->getTH1()->Integral() : -1.);
+    }
+  }
+
+  // time of the harvesting, in seconds
+  double harvest(DQMStore & store, unsigned int nSubsystems)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int s = 0; s < nSubsystems; ++s)
+      store.queueHarvesting(s + 1, [s](DQMStore::IBooker & b, DQMStore::IGetter & g) {
+          harvestSubsystem(b, g, s);
+        });
+    store.queueHarvesting(nSubsystems + 1, [nSubsystems](DQMStore::IBooker & b, DQMStore::IGetter & g) {
+        harvestSummary(b, g, nSubsystems);
+      });
+    store.runHarvestingQueue();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+  }
+
+  std::vector<double> results(DQMStore & store)
+  {
+    std::vector<double> values;
+    for (MonitorElement * me : store.getAllContents("Harvest"))
+      for (int bin = 1; bin <= me->getNbinsX(); ++bin)
+        values.push_back(me->getBinContent(bin));
+    return values;
+  }
+
+  // time of the quality tests of the source MEs, in seconds, and their
+  // status
+  double runQTests(DQMStore & store, tbb::task_arena & arena, std::vector<int> & status)
+  {
+    auto * xrange = dynamic_cast<ContentsXRange *>(store.createQTest(ContentsXRange::getAlgoName(), "xrange"));
+    xrange->setAllowedXRange(5., 95.);
+    auto * noisy = dynamic_cast<NoisyChannel *>(store.createQTest(NoisyChannel::getAlgoName(), "noisy"));
+    noisy->setNumNeighbors(3);
+    noisy->setTolerance(0.3);
+    store.useQTestByMatch("Source/*", "xrange");
+    store.useQTestByMatch("Source/*", "noisy");
+
+    auto start = std::chrono::steady_clock::now();
+    arena.execute([&]() { store.runQTests(); });
+    auto stop = std::chrono::steady_clock::now();
+
+    for (MonitorElement * me : store.getAllContents("Source"))
+      for (QReport * qr : me->getQReports())
+        status.push_back(qr->getStatus());
+    return std::chrono::duration<double>(stop - start).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int nSubsystems = argc > 1 ? std::atoi(argv[1]) : 64;
+  unsigned int nMEs = argc > 2 ? std::atoi(argv[2]) : 200;
+
+  std::cout << "DQMHarvestingBenchmark: " << nSubsystems << " subsystems, "
+            << nMEs << " MEs each" << std::endl;
+  std::remove(profileFile);
+
+  // the harvesters do not fit with ROOT, so all of them may run concurrently
+  std::vector<std::string> harvesters;
+  for (unsigned int s = 0; s <= nSubsystems; ++s)
+    harvesters.push_back("module" + std::to_string(s + 1));
+
+  const char * passes[] = { "sequential", "concurrent, no profile", "concurrent, profile" };
+  std::vector<double> reference;
+  bool ok = true;
+  for (unsigned int pass = 0; pass < 3; ++pass)
+  {
+    edm::ParameterSet pset;
+    pset.addUntrackedParameter<bool>("concurrentHarvesting", pass > 0);
+    pset.addUntrackedParameter<std::string>("harvestingProfile", profileFile);
+    pset.addUntrackedParameter<std::vector<std::string> >("concurrentHarvesters", harvesters);
+    DQMStore store(pset);
+    bookSources(store, nSubsystems, nMEs);
+    double time = harvest(store, nSubsystems);
+    std::cout << " " << std::left << std::setw(24) << passes[pass] << std::right
+              << std::fixed << std::setprecision(3) << std::setw(9) << time << " s" << std::endl;
+
+    std::vector<double> values = results(store);
+    if (pass == 0)
+      reference = values;
+    else if (values != reference)
+    {
+      std::cout << "Error: the results of the " << passes[pass]
+                << " harvesting differ from the sequential ones" << std::endl;
+      ok = false;
+    }
+  }
+  std::remove(profileFile);
+
+  std::vector<int> status[2];
+  tbb::task_arena arenas[2] = { tbb::task_arena(1), tbb::task_arena() };
+  const char * threads[] = { "one thread", "all threads" };
+  for (unsigned int pass = 0; pass < 2; ++pass)
+  {
+    // the quality tests run in parallel only with concurrent harvesting
+    edm::ParameterSet pset;
+    pset.addUntrackedParameter<bool>("concurrentHarvesting", pass > 0);
+    DQMStore store(pset);
+    bookSources(store, nSubsystems, nMEs);
+    double time = runQTests(store, arenas[pass], status[pass]);
+    std::cout << " quality tests, " << std::left << std::setw(12) << threads[pass] << std::right
+              << std::setw(8) << time << " s" << std::endl;
+  }
+  if (status[0] != status[1])
+  {
+    std::cout << "Error: the quality tests give different results with one and all threads" << std::endl;
+    ok = false;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include <malloc.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "DQMServices/Core/interface/MonitorElement.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+/*
+ * Benchmark of the native histogram storage of the DQMStore: the same 1D
+ * (100 bins) and 2D (50x50 bins) MEs are booked and filled with the ROOT
+ * objects, with the native storage and with the native storage in single
+ * precision. For each mode the heap used per ME, the time per fill and
+ * the time per merge (as done at the end of each luminosity block for the
+ * per-stream copies) are printed, and the histograms are checked to be
+ * the same as the ROOT ones.
+ *
+ * Usage: DQMNativeHistogramBenchmark [number of 1D MEs] [number of 2D MEs]
+ */
+
+namespace {
+  const unsigned int fillsPerME = 1000;
+
+  struct Result
+  {
+    double bytesPerME;
+    double fillTime;
+    double mergeTime;
+  };
+
+  size_t heapUsed()
+  {
+    return mallinfo().uordblks;
+  }
+
+  Result run(DQMStore & store, unsigned int n1D, unsigned int n2D,
+             std::vector<MonitorElement *> & mes)
+  {
+    Result result;
+    size_t before = heapUsed();
+    store.bookTransaction([&](DQMStore::IBooker & b) {
+        b.setCurrentFolder("Benchmark/1D");
+        for (unsigned int i = 0; i < n1D; ++i)
+          mes.push_back(b.book1D("h" + std::to_string(i), "1D", 100, 0., 100.));
+        b.setCurrentFolder("Benchmark/2D");
+        for (unsigned int i = 0; i < n2D; ++i)
+          mes.push_back(b.book2D("h" + std::to_string(i), "2D", 50, 0., 50., 50, 0., 50.));
+        // setting titles before the first fill keeps the native storage
+        for (auto me : mes)
+          me->setAxisTitle("x", 1);
+      }, 1, 1);
+
+    // the first fill of an ME replaces its ROOT object by the native one
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < mes.size(); ++i)
+      for (unsigned int j = 0; j < fillsPerME; ++j)
+      {
+        double x = (i * 7 + j * 13) % 110 - 5 + 0.25;
+        if (i < n1D)
+          mes[i]->Fill(x, j % 3 ? 1. : 0.5);
+        else
+          mes[i]->Fill(x / 2, (j * 17) % 55 - 2 + 0.5);
+      }
+    auto stop = std::chrono::steady_clock::now();
+    result.bytesPerME = double(heapUsed() - before) / mes.size();
+    result.fillTime = std::chrono::duration<double>(stop - start).count() / (mes.size() * fillsPerME);
+
+    std::vector<std::unique_ptr<MonitorElement>> copies;
+    for (auto me : mes)
+      copies.emplace_back(new MonitorElement(*me));
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < mes.size(); ++i)
+      mes[i]->merge(*copies[i]);
+    stop = std::chrono::steady_clock::now();
+    result.mergeTime = std::chrono::duration<double>(stop - start).count() / mes.size();
+
+    return result;
+  }
+
+  bool same(double a, double b, double precision)
+  {
+    return std::abs(a - b) <= precision * std::max(std::abs(a), std::abs(b));
+  }
+
+  // compares the contents, errors and statistics of an ME with those of
+  // the ROOT reference
+  bool compare(MonitorElement * me, MonitorElement * ref, double precision)
+  {
+    TH1 * h = me->getTH1();
+    TH1 * r = ref->getTH1();
+    if (h->GetNcells() != r->GetNcells() || ! same(h->GetEntries(), r->GetEntries(), precision))
+      return false;
+    if (std::string(h->GetXaxis()->GetTitle()) != r->GetXaxis()->GetTitle())
+      return false;
+    for (int bin = 0; bin < h->GetNcells(); ++bin)
+      if (! same(h->GetBinContent(bin), r->GetBinContent(bin), precision)
+          || ! same(h->GetBinError(bin), r->GetBinError(bin), precision))
+        return false;
+    for (int axis = 1; axis <= h->GetDimension(); ++axis)
+      if (! same(h->GetMean(axis), r->GetMean(axis), precision)
+          || ! same(h->GetRMS(axis), r->GetRMS(axis), precision))
+        return false;
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int n1D = argc > 1 ? std::atoi(argv[1]) : 20000;
+  unsigned int n2D = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  std::cout << "DQMNativeHistogramBenchmark: " << n1D << " 1D and " << n2D << " 2D MEs" << std::endl;
+  std::cout << " storage        heap (bytes/ME)   fill (ns)   merge (ns/ME)" << std::endl;
+
+  const char * names[] = { "ROOT", "native", "native float" };
+  std::vector<MonitorElement *> reference;
+  std::unique_ptr<DQMStore> referenceStore;
+  double referenceBytesPerME = 0;
+  bool ok = true;
+  for (unsigned int mode = 0; mode < 3; ++mode)
+  {
+    edm::ParameterSet pset;
+    pset.addUntrackedParameter<bool>("nativeHistograms", mode > 0);
+    pset.addUntrackedParameter<bool>("nativeHistogramsFloatPrecision", mode == 2);
+    std::unique_ptr<DQMStore> store(new DQMStore(pset));
+    std::vector<MonitorElement *> mes;
+    Result result = run(*store, n1D, n2D, mes);
+    std::cout << " " << std::left << std::setw(14) << names[mode] << std::right
+              << std::setw(16) << std::fixed << std::setprecision(0) << result.bytesPerME
+              << std::setw(12) << std::setprecision(1) << result.fillTime * 1e9
+              << std::setw(16) << result.mergeTime * 1e9 << std::endl;
+
+    if (mode == 0)
+    {
+      referenceBytesPerME = result.bytesPerME;
+      reference = mes;
+      referenceStore = std::move(store);
+      continue;
+    }
+    if (result.bytesPerME >= referenceBytesPerME)
+    {
+      std::cout << "Error: the MEs were not stored natively with " << names[mode] << " storage" << std::endl;
+      ok = false;
+    }
+    // all the 1D and 2D histograms are TH1F and TH2F, kept in float in
+    // both modes, so only the order of the additions may differ
+    for (unsigned int i = 0; i < mes.size(); ++i)
+      if (! compare(mes[i], reference[i], 1e-6))
+      {
+        std::cout << "Error: " << mes[i]->getFullname() << " differs from the ROOT histogram with "
+                  << names[mode] << " storage" << std::endl;
+        ok = false;
+        break;
+      }
+  }
+
+  return ok ? 0 : 1;
+}
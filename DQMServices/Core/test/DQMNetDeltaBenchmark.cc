@@ -0,0 +1,169 @@
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DQMServices/Core/interface/DQMNet.h"
+#include "TBufferFile.h"
+#include "TH1F.h"
+#include "TH2F.h"
+
+/*
+ * Loopback benchmark of the delta updates of DQMNet: a source node
+ * publishes histograms of which only a few bins change between two
+ * updates, as online, and the update messages are passed directly to a
+ * receiving node, without sockets. For full and delta updates, the
+ * bytes sent and the CPU time spent by both nodes are printed per
+ * update cycle, and the data rebuilt by the receiver is checked to be
+ * the data published.
+ *
+ * Usage: DQMNetDeltaBenchmark [number of histograms] [number of cycles] [snapshot interval]
+ */
+
+namespace {
+  // gives access to the message handling of the network layer
+  class LoopbackNet : public DQMBasicNet
+  {
+  public:
+    using DQMBasicNet::createPeer;
+    using DQMBasicNet::findObject;
+    using DQMBasicNet::onMessage;
+    using DQMBasicNet::sendObjectListToPeer;
+  };
+
+  const unsigned int fillsPerCycle = 5;
+
+  std::string objectName(unsigned int i)
+  {
+    return "Benchmark/h" + std::to_string(i);
+  }
+
+  // serialises the histogram as DQMService does: object and no reference
+  void serialise(TH1 *h, DQMNet::DataBlob &into)
+  {
+    TBufferFile buffer(TBufferFile::kWrite);
+    buffer.WriteObject(h);
+    buffer.WriteObjectAny(nullptr, nullptr);
+    into.assign(buffer.Buffer(), buffer.Buffer() + buffer.Length());
+  }
+
+  struct Result
+  {
+    double bytes = 0;
+    double sendTime = 0;
+    double receiveTime = 0;
+    bool ok = true;
+  };
+
+  Result run(unsigned int nHistograms, unsigned int nCycles, unsigned int snapshotInterval)
+  {
+    std::vector<std::unique_ptr<TH1>> histograms;
+    for (unsigned int i = 0; i < nHistograms; ++i)
+      if (i % 10)
+        histograms.emplace_back(new TH1F(("h" + std::to_string(i)).c_str(), "1D", 100, 0., 100.));
+      else
+        histograms.emplace_back(new TH2F(("h" + std::to_string(i)).c_str(), "2D", 50, 0., 50., 50, 0., 50.));
+
+    LoopbackNet source;
+    LoopbackNet receiver;
+    source.deltaUpdates(snapshotInterval);
+    DQMNet::Peer *peer = receiver.createPeer((lat::Socket *) 1);
+    std::string dirname("Benchmark");
+
+    Result result;
+    for (unsigned int cycle = 0; cycle < nCycles; ++cycle)
+    {
+      // fill a few bins of every histogram and publish them; the data is
+      // sent as it would be for objects being looked at
+      for (unsigned int i = 0; i < nHistograms; ++i)
+      {
+        for (unsigned int j = 0; j < fillsPerCycle; ++j)
+          histograms[i]->Fill((cycle * 31 + i * 7 + j * 3) % 50 + 0.5, (i + j) % 50 + 0.5);
+
+        DQMNet::Object o;
+        std::string name(objectName(i));
+        o.flags = (histograms[i]->GetDimension() == 1 ? DQMNet::DQM_PROP_TYPE_TH1F : DQMNet::DQM_PROP_TYPE_TH2F)
+                  | DQMNet::DQM_PROP_NEW;
+        o.tag = 0;
+        o.version = cycle + 1;
+        o.lastreq = 1;
+        o.hash = DQMNet::dqmhash(name.c_str(), name.size());
+        o.dirname = &dirname;
+        o.objname = histograms[i]->GetName();
+        serialise(histograms[i].get(), o.rawdata);
+        source.updateLocalObject(o);
+      }
+
+      DQMNet::Bucket msg;
+      msg.next = nullptr;
+      std::clock_t start = std::clock();
+      source.sendObjectListToPeer(&msg, false, true, snapshotInterval > 0);
+      std::clock_t sent = std::clock();
+
+      DQMNet::Bucket reply;
+      reply.next = nullptr;
+      for (size_t pos = 0; pos < msg.data.size(); )
+      {
+        uint32_t len;
+        memcpy(&len, &msg.data[pos], sizeof(len));
+        if (! receiver.onMessage(&reply, peer, &msg.data[pos], len))
+          result.ok = false;
+        pos += len;
+      }
+      std::clock_t received = std::clock();
+
+      result.bytes += msg.data.size();
+      result.sendTime += double(sent - start) / CLOCKS_PER_SEC;
+      result.receiveTime += double(received - sent) / CLOCKS_PER_SEC;
+
+      for (unsigned int i = 0; i < nHistograms; ++i)
+      {
+        DQMNet::Object *published = source.findObject(nullptr, objectName(i));
+        DQMNet::Object *rebuilt = receiver.findObject(peer, objectName(i));
+        if (! published || ! rebuilt || published->rawdata != rebuilt->rawdata)
+          result.ok = false;
+      }
+    }
+
+    result.bytes /= nCycles;
+    result.sendTime /= nCycles;
+    result.receiveTime /= nCycles;
+    return result;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int nHistograms = argc > 1 ? std::atoi(argv[1]) : 10000;
+  unsigned int nCycles = argc > 2 ? std::atoi(argv[2]) : 50;
+  unsigned int snapshotInterval = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  TH1::AddDirectory(false);
+
+  std::cout << "DQMNetDeltaBenchmark: " << nHistograms << " histograms, " << nCycles << " update cycles, "
+            << "a snapshot every " << snapshotInterval << " updates" << std::endl;
+  std::cout << " updates   kB/cycle   source (ms/cycle)   receiver (ms/cycle)" << std::endl;
+
+  bool ok = true;
+  for (unsigned int interval : { 0u, snapshotInterval })
+  {
+    Result result = run(nHistograms, nCycles, interval);
+    std::cout << " " << std::left << std::setw(8) << (interval ? "delta" : "full") << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(11) << result.bytes / 1024
+              << std::setw(20) << result.sendTime * 1e3
+              << std::setw(22) << result.receiveTime * 1e3 << std::endl;
+    if (! result.ok)
+    {
+      std::cout << "Error: the data received differs from the data sent with "
+                << (interval ? "delta" : "full") << " updates" << std::endl;
+      ok = false;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
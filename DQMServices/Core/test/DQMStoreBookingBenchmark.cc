@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "DQMServices/Core/interface/MonitorElement.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+/*
+ * Benchmark of concurrent booking in the DQMStore: the MEs are booked by
+ * several threads, each one in the booking transaction of its own module
+ * (as the DQMEDAnalyzers do in multithreaded jobs), then booked again,
+ * which only looks them up and resets them. The time of both passes is
+ * printed for 1, 2, 4 ... threads.
+ *
+ * Usage: DQMStoreBookingBenchmark [number of MEs] [max number of threads]
+ */
+
+namespace {
+  const unsigned int mesPerFolder = 100;
+
+  // books the MEs [begin, end) of a module; returns false if an ME is
+  // not the one booked in the first pass
+  bool bookModule(DQMStore & store, unsigned int moduleId,
+                  unsigned int begin, unsigned int end,
+                  std::vector<MonitorElement *> & mes)
+  {
+    bool ok = true;
+    store.bookTransaction([&](DQMStore::IBooker & b) {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+          if ((i - begin) % mesPerFolder == 0)
+            b.setCurrentFolder("Benchmark/Module" + std::to_string(moduleId)
+                               + "/Folder" + std::to_string(i / mesPerFolder));
+          MonitorElement * me = b.bookFloat("ME" + std::to_string(i));
+          if (mes[i] == nullptr)
+            mes[i] = me;
+          else if (mes[i] != me)
+            ok = false;
+        }
+      }, 1, moduleId);
+    return ok;
+  }
+
+  // time of one pass over all the MEs with nThreads threads, in seconds
+  double run(DQMStore & store, unsigned int nThreads, unsigned int nMEs,
+             std::vector<MonitorElement *> & mes, bool & ok)
+  {
+    std::vector<std::thread> threads;
+    std::vector<char> results(nThreads, 1);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < nThreads; ++t)
+      threads.emplace_back([&, t]() {
+          // one module per thread, each with a contiguous slice of whole folders
+          unsigned int nFolders = (nMEs + mesPerFolder - 1) / mesPerFolder;
+          unsigned int begin = std::min(nMEs, nFolders * t / nThreads * mesPerFolder);
+          unsigned int end = std::min(nMEs, nFolders * (t + 1) / nThreads * mesPerFolder);
+          results[t] = bookModule(store, t + 1, begin, end, mes);
+        });
+    for (auto & thread : threads)
+      thread.join();
+    auto stop = std::chrono::steady_clock::now();
+    for (char result : results)
+      ok = ok && result;
+    return std::chrono::duration<double>(stop - start).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int nMEs = argc > 1 ? std::atoi(argv[1]) : 500000;
+  unsigned int maxThreads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+  edm::ParameterSet pset;
+  pset.addUntrackedParameter<bool>("enableMultiThread", true);
+
+  std::cout << "DQMStoreBookingBenchmark: " << nMEs << " MEs" << std::endl;
+  std::cout << " threads   book (ns/ME)   lookup (ns/ME)" << std::endl;
+  bool ok = true;
+  for (unsigned int n = 1; n <= maxThreads; n *= 2)
+  {
+    DQMStore store(pset);
+    std::vector<MonitorElement *> mes(nMEs, nullptr);
+    double book = run(store, n, nMEs, mes, ok);
+    double lookup = run(store, n, nMEs, mes, ok);
+    std::cout << std::setw(8) << n
+              << std::setw(15) << book * 1e9 / nMEs
+              << std::setw(17) << lookup * 1e9 / nMEs << std::endl;
+    if (! ok)
+    {
+      std::cout << "Error: booking an existing ME returned a different ME" << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include "DQMServices/Core/interface/DQMEDAnalyzer.h"
+#include "DQMServices/Core/interface/DQMGlobalEDAnalyzer.h"
+#include "DQMServices/Core/interface/DQMPerStreamEDAnalyzer.h"
+#include "DQMServices/Core/interface/DQMStore.h"
+#include "DQMServices/Core/interface/MonitorElement.h"
+
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*
+ * Modules filling many histograms for every event, to compare the event
+ * throughput of the three ways of filling DQM histograms in multithreaded
+ * jobs (see dqm_testFillThroughput_cfg.py):
+ *  - DQMTestOneFill: DQMEDAnalyzer, the events of all streams are
+ *    processed one at a time;
+ *  - DQMTestConcurrentFill: DQMGlobalEDAnalyzer, every fill takes the
+ *    lock of the ConcurrentMonitorElement;
+ *  - DQMTestPerStreamFill: DQMPerStreamEDAnalyzer, every stream fills its
+ *    own copies, merged at the end of each luminosity block. The module
+ *    checks at the end of the run that no entry was lost in the merges.
+ */
+
+namespace {
+  // value of the i-th fill of an event, spread over the 100 bins
+  double fillValue(edm::Event const& event, unsigned int i)
+  {
+    return (event.id().event() * 7 + i * 13) % 100 + 0.5;
+  }
+
+  std::string histogramName(unsigned int i)
+  {
+    return "h" + std::to_string(i);
+  }
+}
+
+class DQMTestOneFill : public DQMEDAnalyzer
+{
+public:
+  explicit DQMTestOneFill(edm::ParameterSet const& pset) :
+    folder_(pset.getUntrackedParameter<std::string>("folder")),
+    nHistograms_(pset.getUntrackedParameter<unsigned int>("numberOfHistograms")),
+    nFills_(pset.getUntrackedParameter<unsigned int>("fillsPerEvent"))
+  { }
+
+  void bookHistograms(DQMStore::IBooker& booker, edm::Run const&, edm::EventSetup const&) override
+  {
+    booker.setCurrentFolder(folder_);
+    histograms_.clear();
+    for (unsigned int i = 0; i < nHistograms_; ++i)
+      histograms_.push_back(booker.book1D(histogramName(i), histogramName(i), 100, 0., 100.));
+  }
+
+  void analyze(edm::Event const& event, edm::EventSetup const&) override
+  {
+    for (auto me : histograms_)
+      for (unsigned int i = 0; i < nFills_; ++i)
+        me->Fill(fillValue(event, i));
+  }
+
+private:
+  const std::string folder_;
+  const unsigned int nHistograms_;
+  const unsigned int nFills_;
+  std::vector<MonitorElement*> histograms_;
+};
+
+struct DQMTestConcurrentHistograms
+{
+  std::vector<ConcurrentMonitorElement> histograms;
+};
+
+class DQMTestConcurrentFill : public DQMGlobalEDAnalyzer<DQMTestConcurrentHistograms>
+{
+public:
+  explicit DQMTestConcurrentFill(edm::ParameterSet const& pset) :
+    folder_(pset.getUntrackedParameter<std::string>("folder")),
+    nHistograms_(pset.getUntrackedParameter<unsigned int>("numberOfHistograms")),
+    nFills_(pset.getUntrackedParameter<unsigned int>("fillsPerEvent"))
+  { }
+
+private:
+  void bookHistograms(DQMStore::ConcurrentBooker& booker, edm::Run const&, edm::EventSetup const&,
+                      DQMTestConcurrentHistograms& h) const override
+  {
+    booker.setCurrentFolder(folder_);
+    for (unsigned int i = 0; i < nHistograms_; ++i)
+      h.histograms.push_back(booker.book1D(histogramName(i), histogramName(i), 100, 0., 100.));
+  }
+
+  void dqmAnalyze(edm::Event const& event, edm::EventSetup const&, DQMTestConcurrentHistograms const& h) const override
+  {
+    for (auto const& me : h.histograms)
+      for (unsigned int i = 0; i < nFills_; ++i)
+        me.fill(fillValue(event, i));
+  }
+
+  const std::string folder_;
+  const unsigned int nHistograms_;
+  const unsigned int nFills_;
+};
+
+struct DQMTestPerStreamHistograms
+{
+  std::vector<PerStreamMonitorElement> histograms;
+  mutable std::atomic<unsigned long> events{0};
+};
+
+class DQMTestPerStreamFill : public DQMPerStreamEDAnalyzer<DQMTestPerStreamHistograms>
+{
+public:
+  explicit DQMTestPerStreamFill(edm::ParameterSet const& pset) :
+    folder_(pset.getUntrackedParameter<std::string>("folder")),
+    nHistograms_(pset.getUntrackedParameter<unsigned int>("numberOfHistograms")),
+    nFills_(pset.getUntrackedParameter<unsigned int>("fillsPerEvent"))
+  { }
+
+private:
+  void bookHistograms(DQMStore::PerStreamBooker& booker, edm::Run const&, edm::EventSetup const&,
+                      DQMTestPerStreamHistograms& h) const override
+  {
+    booker.setCurrentFolder(folder_);
+    for (unsigned int i = 0; i < nHistograms_; ++i)
+      h.histograms.push_back(booker.book1D(histogramName(i), histogramName(i), 100, 0., 100.));
+  }
+
+  void dqmAnalyze(edm::StreamID stream, edm::Event const& event, edm::EventSetup const&,
+                  DQMTestPerStreamHistograms const& h) const override
+  {
+    ++h.events;
+    for (auto const& me : h.histograms)
+      for (unsigned int i = 0; i < nFills_; ++i)
+        me.fill(stream, fillValue(event, i));
+  }
+
+  void dqmEndRun(edm::Run const& run, edm::EventSetup const&, DQMTestPerStreamHistograms const& h) const override
+  {
+    double expected = double(h.events) * nFills_;
+    for (auto const& me : h.histograms)
+      if (me.monitorElement()->getEntries() != expected)
+        throw cms::Exception("DQMTestPerStreamFill")
+          << "run " << run.run() << ": " << me.monitorElement()->getFullname() << " has "
+          << me.monitorElement()->getEntries() << " entries, " << expected << " expected";
+  }
+
+  const std::string folder_;
+  const unsigned int nHistograms_;
+  const unsigned int nFills_;
+};
+
+DEFINE_FWK_MODULE(DQMTestOneFill);
+DEFINE_FWK_MODULE(DQMTestConcurrentFill);
+DEFINE_FWK_MODULE(DQMTestPerStreamFill);
@@ -78,10 +78,14 @@ namespace {
      void doFill(MonitorElement* iElement) override {
        *m_fullNameBufferPtr = iElement->getFullname();
        m_flagBuffer = iElement->getTag();
-       m_bufferPtr = dynamic_cast<T*>(iElement->getRootObject());
+       // a natively stored histogram is written from a temporary ROOT
+       // object and stays native
+       std::unique_ptr<TH1> tmp;
+       m_bufferPtr = dynamic_cast<T*>(iElement->rootObjectForIO(tmp));
        assert(nullptr!=m_bufferPtr);
        //std::cout <<"#entries: "<<m_bufferPtr->GetEntries()<<std::endl;
        m_tree->Fill();
+       m_bufferPtr = nullptr;
      }
 
 
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <cstdio>
+#include <deque>
+#include <exception>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -61,6 +63,10 @@ private:
   evf::EvFDaqDirector::FileStatus nextEvent();
   evf::EvFDaqDirector::FileStatus getNextEvent();
   edm::Timestamp fillFEDRawDataCollection(FEDRawDataCollection&);
+  static void copyFEDs(FRDEventMsgView const&, FEDRawDataCollection&);
+  edm::Timestamp decodeTriggerFEDs(FEDRawDataCollection const&);
+  void verifyEventChecksum(FRDEventMsgView const&) const;
+  void unpackAhead();
   void deleteFile(std::string const&);
   int grabNextJsonFile(boost::filesystem::path const&);
 
@@ -119,7 +125,7 @@ private:
   uint32_t eventRunNumber_=0;
   uint32_t GTPEventID_ = 0;
   uint32_t L1EventID_ = 0;
-  unsigned char *tcds_pointer_;
+  const unsigned char *tcds_pointer_;
   unsigned int eventsThisLumi_;
   unsigned long eventsThisRun_ = 0;
 
@@ -178,6 +184,20 @@ private:
 
   std::map<unsigned int,unsigned int> sourceEventsReport_;
   std::mutex monlock_;
+
+  /*
+   * Parallel unpacking: the events following the current one in the same chunk
+   * are checksummed and copied into their FEDRawDataCollection by TBB tasks
+   **/
+  struct UnpackedEvent {
+    unsigned char* start_ = nullptr; //identifies the event in the chunk
+    std::unique_ptr<FEDRawDataCollection> rawData_;
+    std::exception_ptr checksumError_;
+    std::exception_ptr unpackError_;
+  };
+  const unsigned int parallelUnpackEvents_;
+  std::deque<UnpackedEvent> unpacked_;
+  UnpackedEvent currentUnpacked_;
 };
 
 
@@ -6,5 +6,14 @@
 
 uint32_t crc32c(uint32_t crc, const unsigned char *buf, size_t len);
 bool crc32c_hw_test();
+bool crc32c_clmul_test();
+
+/* Individual implementations, for validation and benchmarks. The hardware ones
+   require crc32c_hw_test() (crc32c_clmul_test() for crc32c_hw_clmul) */
+uint32_t crc32c_sw(uint32_t crc, const unsigned char *buf, size_t len);
+#if defined(__x86_64__)
+uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len);
+uint32_t crc32c_hw_clmul(uint32_t crc, const unsigned char *buf, size_t len);
+#endif
 
 #endif
@@ -8,12 +8,15 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <vector>
+#include <algorithm>
 #include <fstream>
 #include <zlib.h>
 #include <cstdio>
 #include <chrono>
 
 #include <boost/algorithm/string.hpp>
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 #include <boost/filesystem/fstream.hpp>
 
 
@@ -76,7 +79,8 @@ FedRawDataInputSource::FedRawDataInputSource(edm::ParameterSet const& pset,
   currentLumiSection_(0),
   tcds_pointer_(nullptr),
   eventsThisLumi_(0),
-  dpd_(nullptr)
+  dpd_(nullptr),
+  parallelUnpackEvents_(pset.getUntrackedParameter<unsigned int> ("parallelUnpackEvents",0))
 {
   char thishost[256];
   gethostname(thishost, 255);
@@ -226,6 +230,7 @@ void FedRawDataInputSource::fillDescriptions(edm::ConfigurationDescriptions& des
   desc.addUntracked<unsigned int> ("maxBufferedFiles",2)->setComment("Maximum number of simultaneously buffered raw files");
   desc.addUntracked<bool> ("verifyAdler32", true)->setComment("Verify event Adler32 checksum with FRDv3 or v4");
   desc.addUntracked<bool> ("verifyChecksum", true)->setComment("Verify event CRC-32C checksum of FRDv5 or higher");
+  desc.addUntracked<unsigned int> ("parallelUnpackEvents",0)->setComment("Maximum number of events of a chunk checksummed and unpacked in parallel ahead of the framework (0 or 1: disabled, multibuffer mode only)");
   desc.addUntracked<bool> ("useL1EventID", false)->setComment("Use L1 event ID from FED header if true or from TCDS FED if false");
   desc.addUntracked<bool> ("fileListMode", false)->setComment("Use fileNames parameter to directly specify raw files to open");
   desc.addUntracked<std::vector<std::string>> ("fileNames", std::vector<std::string>())->setComment("file list used when fileListMode is enabled");
@@ -602,37 +607,106 @@ inline evf::EvFDaqDirector::FileStatus FedRawDataInputSource::getNextEvent()
 	chunkIsFree_=false;
       }
     }
+    if (parallelUnpackEvents_>1) unpackAhead();
   }//end multibuffer mode
   if (fms_) fms_->setInState(evf::FastMonitoringThread::inChecksumEvent);
 
-  if (verifyChecksum_ && event_->version() >= 5)
+  try {
+    if (currentUnpacked_.start_) {
+      //checksum was already verified by the unpacking task
+      if (currentUnpacked_.checksumError_) std::rethrow_exception(currentUnpacked_.checksumError_);
+    }
+    else verifyEventChecksum(*event_);
+  }
+  catch (cms::Exception&) {
+    if (fms_) fms_->setExceptionDetected(currentLumiSection_);
+    throw;
+  }
+  if (fms_) fms_->setInState(evf::FastMonitoringThread::inCachedEvent);
+
+  currentFile_->nProcessed_++;
+
+  return evf::EvFDaqDirector::sameFile;
+}
+
+void FedRawDataInputSource::verifyEventChecksum(FRDEventMsgView const& event) const
+{
+  if (verifyChecksum_ && event.version() >= 5)
   {
     uint32_t crc=0;
-    crc = crc32c(crc,(const unsigned char*)event_->payload(),event_->eventSize());
-    if ( crc != event_->crc32c() ) {
-      if (fms_) fms_->setExceptionDetected(currentLumiSection_);
+    crc = crc32c(crc,(const unsigned char*)event.payload(),event.eventSize());
+    if ( crc != event.crc32c() ) {
       throw cms::Exception("FedRawDataInputSource::getNextEvent") <<
-        "Found a wrong crc32c checksum: expected 0x" << std::hex << event_->crc32c() <<
+        "Found a wrong crc32c checksum: expected 0x" << std::hex << event.crc32c() <<
         " but calculated 0x" << crc;
     }
   }
-  else if ( verifyAdler32_ && event_->version() >= 3)
+  else if ( verifyAdler32_ && event.version() >= 3)
   {
     uint32_t adler = adler32(0L,Z_NULL,0);
-    adler = adler32(adler,(Bytef*)event_->payload(),event_->eventSize());
+    adler = adler32(adler,(Bytef*)event.payload(),event.eventSize());
 
-    if ( adler != event_->adler32() ) {
-      if (fms_) fms_->setExceptionDetected(currentLumiSection_);
+    if ( adler != event.adler32() ) {
       throw cms::Exception("FedRawDataInputSource::getNextEvent") <<
-        "Found a wrong Adler32 checksum: expected 0x" << std::hex << event_->adler32() <<
+        "Found a wrong Adler32 checksum: expected 0x" << std::hex << event.adler32() <<
         " but calculated 0x" << adler;
     }
   }
-  if (fms_) fms_->setInState(evf::FastMonitoringThread::inCachedEvent);
+}
 
-  currentFile_->nProcessed_++;
+//multibuffer mode: checksum and unpack in parallel the current event and the
+//following ones which are entirely contained in the current chunk. Chunk data is
+//not modified until the reader thread gets the chunk back, which happens only after
+//the main thread has moved past all of these events
+void FedRawDataInputSource::unpackAhead()
+{
+  unsigned char* eventStart = (unsigned char*)event_->startAddress();
+
+  //anything else than the next event in line means the cache is stale
+  if (!unpacked_.empty() && unpacked_.front().start_ != eventStart) unpacked_.clear();
+
+  if (unpacked_.empty()) {
+    std::vector<unsigned char*> starts(1,eventStart);
+    InputChunk* chunk = currentFile_->chunks_[currentFile_->currentChunk_];
+    const uint32_t headerSize = FRDHeaderVersionSize[detectedFRDversion_];
+    uint32_t position = currentFile_->chunkPosition_;
+    uint32_t left = std::min(chunk->size_ - position, currentFile_->fileSize_ - currentFile_->bufferPosition_);
+    while (starts.size() < parallelUnpackEvents_ && left >= headerSize) {
+      const FRDEventMsgView view(chunk->buf_ + position);
+      if (view.version() != detectedFRDversion_ || view.size() < headerSize || view.size() > left) break;
+      starts.push_back(chunk->buf_ + position);
+      position += view.size();
+      left -= view.size();
+    }
 
-  return evf::EvFDaqDirector::sameFile;
+    unpacked_.resize(starts.size());
+    //isolate, so that this thread does not pick up unrelated framework tasks
+    //while waiting for the unpacking to finish
+    tbb::this_task_arena::isolate([&] {
+      tbb::parallel_for(size_t(0), starts.size(), [&](size_t i) {
+        UnpackedEvent& unpacked = unpacked_[i];
+        const FRDEventMsgView view(starts[i]);
+        unpacked.start_ = starts[i];
+        try {
+          verifyEventChecksum(view);
+        }
+        catch (...) {
+          unpacked.checksumError_ = std::current_exception();
+          return;
+        }
+        unpacked.rawData_.reset(new FEDRawDataCollection);
+        try {
+          copyFEDs(view, *unpacked.rawData_);
+        }
+        catch (...) {
+          unpacked.unpackError_ = std::current_exception();
+        }
+      });
+    });
+  }
+
+  currentUnpacked_ = std::move(unpacked_.front());
+  unpacked_.pop_front();
 }
 
 void FedRawDataInputSource::deleteFile(std::string const& fileName)
@@ -671,8 +745,19 @@ void FedRawDataInputSource::deleteFile(std::string const& fileName)
 void FedRawDataInputSource::read(edm::EventPrincipal& eventPrincipal)
 {
   if (fms_) fms_->setInState(evf::FastMonitoringThread::inReadEvent);
-  std::unique_ptr<FEDRawDataCollection> rawData(new FEDRawDataCollection);
-  edm::Timestamp tstamp = fillFEDRawDataCollection(*rawData);
+  std::unique_ptr<FEDRawDataCollection> rawData;
+  edm::Timestamp tstamp;
+  if (currentUnpacked_.start_) {
+    UnpackedEvent unpacked = std::move(currentUnpacked_);
+    currentUnpacked_ = UnpackedEvent();
+    if (unpacked.unpackError_) std::rethrow_exception(unpacked.unpackError_);
+    rawData = std::move(unpacked.rawData_);
+    tstamp = decodeTriggerFEDs(*rawData);
+  }
+  else {
+    rawData.reset(new FEDRawDataCollection);
+    tstamp = fillFEDRawDataCollection(*rawData);
+  }
 
   if (useL1EventID_){
     eventID_ = edm::EventID(eventRunNumber_, currentLumiSection_, L1EventID_);
@@ -746,17 +831,15 @@ void FedRawDataInputSource::read(edm::EventPrincipal& eventPrincipal)
 
 edm::Timestamp FedRawDataInputSource::fillFEDRawDataCollection(FEDRawDataCollection& rawData)
 {
-  edm::TimeValue_t time;
-  timeval stv;
-  gettimeofday(&stv,nullptr);
-  time = stv.tv_sec;
-  time = (time << 32) + stv.tv_usec;
-  edm::Timestamp tstamp(time);
+  copyFEDs(*event_, rawData);
+  return decodeTriggerFEDs(rawData);
+}
 
-  uint32_t eventSize = event_->eventSize();
-  unsigned char* event = (unsigned char*)event_->payload();
-  GTPEventID_=0;
-  tcds_pointer_ = nullptr;
+//copy FED fragments of the event into the collection (called concurrently by the unpacking tasks)
+void FedRawDataInputSource::copyFEDs(FRDEventMsgView const& eventView, FEDRawDataCollection& rawData)
+{
+  uint32_t eventSize = eventView.eventSize();
+  unsigned char* event = (unsigned char*)eventView.payload();
   while (eventSize > 0) {
     assert(eventSize>=FEDTrailer::length);
     eventSize -= FEDTrailer::length;
@@ -770,30 +853,49 @@ edm::Timestamp FedRawDataInputSource::fillFEDRawDataCollection(FEDRawDataCollect
     {
       throw cms::Exception("FedRawDataInputSource::fillFEDRawDataCollection") << "Out of range FED ID : " << fedId;
     }
-    if (fedId == FEDNumbering::MINTCDSuTCAFEDID) {
-      tcds_pointer_ = event + eventSize;
-    }
-    if (fedId == FEDNumbering::MINTriggerGTPFEDID) {
-      if (evf::evtn::evm_board_sense(event + eventSize,fedSize))
-          GTPEventID_ = evf::evtn::get(event + eventSize,true);
-      else
-          GTPEventID_ = evf::evtn::get(event + eventSize,false);
-      //evf::evtn::evm_board_setformat(fedSize);
-      const uint64_t gpsl = evf::evtn::getgpslow(event + eventSize);
-      const uint64_t gpsh = evf::evtn::getgpshigh(event + eventSize);
-      tstamp = edm::Timestamp(static_cast<edm::TimeValue_t> ((gpsh << 32) + gpsl));
-    }
-    //take event ID from GTPE FED
-    if (fedId == FEDNumbering::MINTriggerEGTPFEDID && GTPEventID_==0) {
-      if (evf::evtn::gtpe_board_sense(event + eventSize)) {
-        GTPEventID_ = evf::evtn::gtpe_get(event + eventSize);
-      }
-    }
     FEDRawData& fedData = rawData.FEDData(fedId);
     fedData.resize(fedSize);
     memcpy(fedData.data(), event + eventSize, fedSize);
   }
   assert(eventSize == 0);
+}
+
+//event ID and time stamp from the trigger FEDs. Not thread safe (GlobalEventNumber keeps
+//the detected board format in static variables), runs in the main thread
+edm::Timestamp FedRawDataInputSource::decodeTriggerFEDs(FEDRawDataCollection const& rawData)
+{
+  edm::TimeValue_t time;
+  timeval stv;
+  gettimeofday(&stv,nullptr);
+  time = stv.tv_sec;
+  time = (time << 32) + stv.tv_usec;
+  edm::Timestamp tstamp(time);
+
+  GTPEventID_=0;
+  tcds_pointer_ = nullptr;
+
+  FEDRawData const& tcdsData = rawData.FEDData(FEDNumbering::MINTCDSuTCAFEDID);
+  if (tcdsData.size()) tcds_pointer_ = tcdsData.data();
+
+  FEDRawData const& gtpData = rawData.FEDData(FEDNumbering::MINTriggerGTPFEDID);
+  if (gtpData.size()) {
+    const unsigned char* gtp = gtpData.data();
+    if (evf::evtn::evm_board_sense(gtp,gtpData.size()))
+        GTPEventID_ = evf::evtn::get(gtp,true);
+    else
+        GTPEventID_ = evf::evtn::get(gtp,false);
+    //evf::evtn::evm_board_setformat(fedSize);
+    const uint64_t gpsl = evf::evtn::getgpslow(gtp);
+    const uint64_t gpsh = evf::evtn::getgpshigh(gtp);
+    tstamp = edm::Timestamp(static_cast<edm::TimeValue_t> ((gpsh << 32) + gpsl));
+  }
+  //take event ID from GTPE FED
+  FEDRawData const& gtpeData = rawData.FEDData(FEDNumbering::MINTriggerEGTPFEDID);
+  if (gtpeData.size() && GTPEventID_==0) {
+    if (evf::evtn::gtpe_board_sense(gtpeData.data())) {
+      GTPEventID_ = evf::evtn::gtpe_get(gtpeData.data());
+    }
+  }
 
   return tstamp;
 }
@@ -37,6 +37,12 @@
  * and ifdefs to compile and call hw version only with X86_64
  */
 
+/* Implementation selected once at first use instead of running cpuid on
+ * every call, and variant of the hardware version combining the three
+ * parallel crcs with carry-less multiplication (PCLMULQDQ) instead of the
+ * shift tables
+ */
+
 
 
 #include <cstdio>
@@ -44,6 +50,12 @@
 #include <cstdint>
 #include <unistd.h>
 #include <pthread.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#include "EventFilter/Utilities/interface/crc32c.h"
 
 /* CRC-32C (iSCSI) polynomial in reversed bit order. */
 #define POLY 0x82f63b78
@@ -81,7 +93,7 @@ static void crc32c_init_sw(void)
 /* Table-driven software version as a fall-back.  This is about 15 times slower
    than using the hardware instructions.  This assumes little-endian integers,
    as is the case on Intel processors that the assembler code here is for. */
-static uint32_t crc32c_sw(uint32_t crci, const unsigned char *buf, size_t len)
+uint32_t crc32c_sw(uint32_t crci, const unsigned char *buf, size_t len)
 {
     const unsigned char *next = buf;
     uint64_t crc;
@@ -229,7 +241,7 @@ static void crc32c_init_hw(void)
 }
 
 /* Compute CRC-32C using the Intel hardware instruction. */
-static uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len)
+uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len)
 {
     const unsigned char *next = buf;
     const unsigned char *end;
@@ -317,6 +329,105 @@ static uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len)
     return (uint32_t)crc0 ^ 0xffffffff;
 }
 
+/* Constants for shifting a crc by LONG and SHORT zero bytes with a carry-less
+   multiply: for a crc a(x), the reflected 64-bit product a(x)k(x) is a(x)k(x)x
+   and the crc32 instruction on it gives a(x)k(x)x^33 mod P, so shifting by n
+   bytes takes k(x) = x^(8n-33) mod P. */
+static pthread_once_t crc32c_once_clmul = PTHREAD_ONCE_INIT;
+static uint64_t crc32c_clmul_long;
+static uint64_t crc32c_clmul_short;
+
+/* x^n mod P in reflected bit order */
+static uint32_t crc32c_xpow(size_t n)
+{
+    uint32_t p = 0x80000000;    /* x^0 */
+    while (n--)
+        p = p & 1 ? (p >> 1) ^ POLY : p >> 1;
+    return p;
+}
+
+static void crc32c_init_clmul(void)
+{
+    crc32c_clmul_long = crc32c_xpow(8*LONG - 33);
+    crc32c_clmul_short = crc32c_xpow(8*SHORT - 33);
+}
+
+/* Apply the zeros operator for the length k was built for. */
+__attribute__((target("sse4.2,pclmul")))
+static inline uint32_t crc32c_shift_clmul(uint64_t k, uint32_t crc)
+{
+    const __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc), _mm_cvtsi64_si128(k), 0);
+    return _mm_crc32_u64(0, _mm_cvtsi128_si64(product));
+}
+
+/* Same as crc32c_hw, with the three crcs of each block combined by carry-less
+   multiplication: two multiplies instead of eight table lookups per shift,
+   which also keeps the 8 kB of shift tables out of the cache. */
+__attribute__((target("sse4.2,pclmul")))
+uint32_t crc32c_hw_clmul(uint32_t crc, const unsigned char *buf, size_t len)
+{
+    const unsigned char *next = buf;
+    const unsigned char *end;
+    uint64_t crc0, crc1, crc2;
+
+    pthread_once(&crc32c_once_clmul, crc32c_init_clmul);
+
+    crc0 = crc ^ 0xffffffff;
+
+    while (len && ((uintptr_t)next & 7) != 0) {
+        crc0 = _mm_crc32_u8(crc0, *next);
+        next++;
+        len--;
+    }
+
+    while (len >= LONG*3) {
+        crc1 = 0;
+        crc2 = 0;
+        end = next + LONG;
+        do {
+            crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
+            crc1 = _mm_crc32_u64(crc1, *(const uint64_t *)(next + LONG));
+            crc2 = _mm_crc32_u64(crc2, *(const uint64_t *)(next + 2*LONG));
+            next += 8;
+        } while (next < end);
+        crc0 = crc32c_shift_clmul(crc32c_clmul_long, crc0) ^ crc1;
+        crc0 = crc32c_shift_clmul(crc32c_clmul_long, crc0) ^ crc2;
+        next += LONG*2;
+        len -= LONG*3;
+    }
+
+    while (len >= SHORT*3) {
+        crc1 = 0;
+        crc2 = 0;
+        end = next + SHORT;
+        do {
+            crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
+            crc1 = _mm_crc32_u64(crc1, *(const uint64_t *)(next + SHORT));
+            crc2 = _mm_crc32_u64(crc2, *(const uint64_t *)(next + 2*SHORT));
+            next += 8;
+        } while (next < end);
+        crc0 = crc32c_shift_clmul(crc32c_clmul_short, crc0) ^ crc1;
+        crc0 = crc32c_shift_clmul(crc32c_clmul_short, crc0) ^ crc2;
+        next += SHORT*2;
+        len -= SHORT*3;
+    }
+
+    end = next + (len - (len & 7));
+    while (next < end) {
+        crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
+        next += 8;
+    }
+    len &= 7;
+
+    while (len) {
+        crc0 = _mm_crc32_u8(crc0, *next);
+        next++;
+        len--;
+    }
+
+    return (uint32_t)crc0 ^ 0xffffffff;
+}
+
 /* Check for SSE 4.2.  SSE 4.2 was first supported in Nehalem processors
    introduced in November, 2008.  This does not check for the existence of the
    cpuid instruction itself, which was introduced on the 486SL in 1992, so this
@@ -333,20 +444,40 @@ static uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len)
         (have) = (ecx >> 20) & 1; \
     } while (0)
 
+/* Check for PCLMULQDQ, first supported in Westmere processors. */
+#define PCLMUL(have) \
+    do { \
+        uint32_t eax, ecx; \
+        eax = 1; \
+        __asm__("cpuid" \
+                : "=c"(ecx) \
+                : "a"(eax) \
+                : "%ebx", "%edx"); \
+        (have) = (ecx >> 1) & 1; \
+    } while (0)
+
 #endif //defined(__x86_64__)
 
-/* Compute a CRC-32C.  If the crc32 instruction is available, use the hardware
-   version.  Otherwise, use the software version. */
-uint32_t crc32c(uint32_t crc, const unsigned char *buf, size_t len)
+typedef uint32_t (*crc32c_func)(uint32_t, const unsigned char *, size_t);
+
+static crc32c_func crc32c_select()
 {
 #if defined(__x86_64__)
-    int sse42;
-
-    SSE42(sse42);
-    return sse42 ? crc32c_hw(crc, buf, len) : crc32c_sw(crc, buf, len);
-#else
-    return crc32c_sw(crc, buf, len);
+    if (crc32c_clmul_test())
+        return crc32c_hw_clmul;
+    if (crc32c_hw_test())
+        return crc32c_hw;
 #endif
+    return crc32c_sw;
+}
+
+/* Compute a CRC-32C.  If the crc32 instruction is available, use the hardware
+   version, with the carry-less multiply if available.  Otherwise, use the
+   software version. */
+uint32_t crc32c(uint32_t crc, const unsigned char *buf, size_t len)
+{
+    static const crc32c_func impl = crc32c_select();
+    return impl(crc, buf, len);
 }
 
 
@@ -364,3 +495,15 @@ bool crc32c_hw_test()
 #endif
 }
 
+bool crc32c_clmul_test()
+{
+#if defined(__x86_64__)
+  int sse42, pclmul;
+
+  SSE42(sse42);
+  PCLMUL(pclmul);
+  return sse42 && pclmul;
+#else
+  return 0;
+#endif
+}
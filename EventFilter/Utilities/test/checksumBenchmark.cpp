@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "EventFilter/Utilities/interface/crc32c.h"
+#include "FWCore/Utilities/interface/Adler32Calculator.h"
+
+// throughput of the crc32c and Adler32 implementations
+// usage: checksumBenchmark [buffer size in kB] [total MB per implementation]
+namespace {
+  template <typename F>
+  void measure(std::string const& name, std::vector<unsigned char> const& buffer, size_t totalBytes, F f) {
+    const size_t iterations = std::max<size_t>(1, totalBytes / buffer.size());
+    uint32_t result = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) result += f(buffer.data(), buffer.size());
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::setw(16) << name << std::setw(10) << std::fixed << std::setprecision(2)
+              << iterations * buffer.size() / elapsed.count() / 1e9 << " GB/s  (0x" << std::hex << result << std::dec << ")"
+              << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  const size_t bufferSize = (argc > 1 ? std::atoi(argv[1]) : 1024) * 1024;
+  const size_t totalBytes = size_t(argc > 2 ? std::atoi(argv[2]) : 256) * 1024 * 1024;
+
+  std::vector<unsigned char> buffer(bufferSize);
+  std::mt19937 engine(1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (auto& c : buffer) c = byte(engine);
+
+  std::cout << "buffer of " << bufferSize / 1024 << " kB" << std::endl;
+  measure("crc32c sw", buffer, totalBytes, [](const unsigned char* p, size_t n) { return crc32c_sw(0, p, n); });
+#if defined(__x86_64__)
+  if (crc32c_hw_test())
+    measure("crc32c sse4.2", buffer, totalBytes, [](const unsigned char* p, size_t n) { return crc32c_hw(0, p, n); });
+  if (crc32c_clmul_test())
+    measure("crc32c pclmul", buffer, totalBytes, [](const unsigned char* p, size_t n) { return crc32c_hw_clmul(0, p, n); });
+#endif
+  measure("adler32 scalar", buffer, totalBytes, [](const unsigned char* p, size_t n) {
+    uint32_t a = 1, b = 0;
+    cms::Adler32Scalar((char const*)p, n, a, b);
+    return (b << 16) | a;
+  });
+  if (cms::Adler32AVX2Available())
+    measure("adler32 avx2", buffer, totalBytes, [](const unsigned char* p, size_t n) {
+      uint32_t a = 1, b = 0;
+      cms::Adler32AVX2((char const*)p, n, a, b);
+      return (b << 16) | a;
+    });
+  return 0;
+}
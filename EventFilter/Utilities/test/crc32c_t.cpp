@@ -0,0 +1,45 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "EventFilter/Utilities/interface/crc32c.h"
+
+// cross-check of the crc32c implementations over random buffers
+int main() {
+  // standard check value of CRC-32C
+  const char* check = "123456789";
+  assert(crc32c_sw(0, (const unsigned char*)check, strlen(check)) == 0xe3069283);
+  assert(crc32c(0, (const unsigned char*)check, strlen(check)) == 0xe3069283);
+
+  std::cout << "crc32c hardware: " << crc32c_hw_test() << " with carry-less multiply: " << crc32c_clmul_test() << std::endl;
+
+  std::mt19937 engine(4321);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<unsigned char> buffer(1 << 20);
+  for (auto& c : buffer) c = byte(engine);
+
+  // around the SHORT*3 and LONG*3 block sizes of the hardware versions
+  std::vector<size_t> lengths = {0, 1, 7, 8, 9, 767, 768, 769, 1536, 24575, 24576, 24577, 49152 + 768 + 13, buffer.size() - 16};
+  std::uniform_int_distribution<size_t> randomLength(0, buffer.size() - 16);
+  for (int i = 0; i < 50; ++i) lengths.push_back(randomLength(engine));
+
+  for (auto len : lengths) {
+    for (size_t offset = 0; offset < 16; offset += 5) {
+      const unsigned char* data = &buffer[offset];
+      const uint32_t expected = crc32c_sw(0, data, len);
+      assert(crc32c(0, data, len) == expected);
+      // continuing a crc over a second piece
+      assert(crc32c(crc32c(0, data, len / 2), data + len / 2, len - len / 2) == expected);
+#if defined(__x86_64__)
+      if (crc32c_hw_test()) assert(crc32c_hw(0, data, len) == expected);
+      if (crc32c_clmul_test()) {
+        assert(crc32c_hw_clmul(0, data, len) == expected);
+        assert(crc32c_hw_clmul(crc32c_hw_clmul(0, data, len / 3), data + len / 3, len - len / 3) == expected);
+      }
+#endif
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+#replay raw files written by startBU.py (DaqFakeReader) through FedRawDataInputSource in file list mode
+#e.g. cmsRun replayFU.py inputFiles=file:/fff/BU0/ramdisk/run000100/run100_ls0001_index000000.raw numThreads=8 unpackEvents=16
+#and compare the event throughput in the TimeReport with unpackEvents=0. No module is
+#scheduled: the time measured is the one of the source alone
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+import os
+
+options = VarParsing.VarParsing ('analysis')
+
+options.register ('fuBaseDir',
+                  '/tmp/fff/data', # default value
+                  VarParsing.VarParsing.multiplicity.singleton,
+                  VarParsing.VarParsing.varType.string,          # string, int, or float
+                  "FU base directory")
+
+options.register ('numThreads',
+                  1, # default value
+                  VarParsing.VarParsing.multiplicity.singleton,
+                  VarParsing.VarParsing.varType.int,          # string, int, or float
+                  "Number of CMSSW threads")
+
+options.register ('unpackEvents',
+                  0, # default value
+                  VarParsing.VarParsing.multiplicity.singleton,
+                  VarParsing.VarParsing.varType.int,          # string, int, or float
+                  "Number of events unpacked in parallel by the source (0: serial)")
+
+options.register ('loop',
+                  False, # default value
+                  VarParsing.VarParsing.multiplicity.singleton,
+                  VarParsing.VarParsing.varType.bool,          # string, int, or float
+                  "Loop over the input files until maxEvents is reached")
+
+options.parseArguments()
+
+process = cms.Process("REPLAYFU")
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(options.maxEvents)
+)
+
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.numThreads),
+    numberOfStreams = cms.untracked.uint32(options.numThreads),
+    wantSummary = cms.untracked.bool(True)
+)
+process.MessageLogger = cms.Service("MessageLogger",
+    cout = cms.untracked.PSet(threshold = cms.untracked.string( "INFO" )),
+    destinations = cms.untracked.vstring( 'cout' ))
+
+process.EvFDaqDirector = cms.Service("EvFDaqDirector",
+    runNumber = cms.untracked.uint32(0),
+    baseDir = cms.untracked.string(options.fuBaseDir),
+    buBaseDir = cms.untracked.string(options.fuBaseDir),
+    directorIsBu = cms.untracked.bool(False),
+    testModeNoBuilderUnit = cms.untracked.bool(False))
+
+try:
+  os.makedirs(options.fuBaseDir)
+except Exception as ex:
+  print str(ex)
+  pass
+
+process.source = cms.Source("FedRawDataInputSource",
+    fileListMode = cms.untracked.bool(True),
+    fileListLoopMode = cms.untracked.bool(options.loop),
+    fileNames = cms.untracked.vstring([f.replace('file:','') for f in options.inputFiles]),
+    verifyAdler32 = cms.untracked.bool(True),
+    verifyChecksum = cms.untracked.bool(True),
+    useL1EventID = cms.untracked.bool(True),
+    eventChunkSize = cms.untracked.uint32(64),
+    eventChunkBlock = cms.untracked.uint32(64),
+    numBuffers = cms.untracked.uint32(4),
+    maxBufferedFiles = cms.untracked.uint32(4),
+    parallelUnpackEvents = cms.untracked.uint32(options.unpackEvents)
+    )
@@ -91,7 +91,7 @@ namespace edm {
          DataProxy const& operator=(DataProxy const&) = delete; // stop default
 
          // ---------- member data --------------------------------
-         CMS_THREAD_SAFE mutable void const* cache_; //protected by a global mutex
+         CMS_THREAD_SAFE mutable void const* cache_; //protected by ESProductionLocks
          mutable std::atomic<bool> cacheIsValid_;
          mutable std::atomic<bool> nonTransientAccessRequested_;
          ComponentDescription const* description_;
@@ -271,6 +271,10 @@ namespace edm {
     
     void processEventWithLooper(EventPrincipal&);
 
+    //The EventSetup of the concurrent IOV iIOVIndex, 0 is the one of espController_
+    eventsetup::EventSetupsController& esControllerForIOV(unsigned int iIOVIndex);
+    EventSetup const& eventSetupForIOV(unsigned int iIOVIndex) const;
+
     std::shared_ptr<ProductRegistry const> preg() const {return get_underlying_safe(preg_);}
     std::shared_ptr<ProductRegistry>& preg() {return get_underlying_safe(preg_);}
     std::shared_ptr<BranchIDListHelper const> branchIDListHelper() const {return get_underlying_safe(branchIDListHelper_);}
@@ -295,7 +299,11 @@ namespace edm {
     InputSource::ItemType lastSourceTransition_;
     edm::propagate_const<std::unique_ptr<eventsetup::EventSetupsController>> espController_;
     edm::propagate_const<std::shared_ptr<eventsetup::EventSetupProvider>> esp_;
-    edm::SerialTaskQueue iovQueue_;
+    //Additional EventSetups, one per concurrent IOV beyond the first
+    std::vector<edm::propagate_const<std::unique_ptr<eventsetup::EventSetupsController>>> extraESControllers_;
+    std::vector<edm::propagate_const<std::shared_ptr<eventsetup::EventSetupProvider>>> extraESProviders_;
+    std::vector<edm::SerialTaskQueue> iovQueues_;
+    unsigned int currentIOVIndex_ = 0;
     std::unique_ptr<ExceptionToActionTable const>          act_table_;
     std::shared_ptr<ProcessConfiguration const>       processConfiguration_;
     ProcessContext                                processContext_;
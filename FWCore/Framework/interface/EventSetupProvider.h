@@ -105,6 +105,12 @@ class EventSetupProvider {
 
       unsigned subProcessIndex() const { return subProcessIndex_; }
 
+      ///When the job runs several concurrent IOVs, each has its own EventSetupProvider
+      void setIOVIndex(unsigned int iIndex, unsigned int iNumberOfIOVs) {
+         iovIndex_ = iIndex;
+         numberOfIOVs_ = iNumberOfIOVs;
+      }
+
       static void logInfoWhenSharing(ParameterSet const& iConfiguration);
 
    protected:
@@ -132,6 +138,8 @@ class EventSetupProvider {
       std::unique_ptr<EventSetupKnownRecordsSupplier> knownRecordsSupplier_;
       bool mustFinishConfiguration_;
       unsigned subProcessIndex_;
+      unsigned int iovIndex_;
+      unsigned int numberOfIOVs_;
 
       // The following are all used only during initialization and then cleared.
 
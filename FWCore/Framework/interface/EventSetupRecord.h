@@ -170,9 +170,11 @@ namespace edm {
           Record.
           The value of '0' will never be returned so you can use that to
           denote that you have not yet checked the value.
+          When the job runs several concurrent IOVs, the values handed out
+          by the Records of the different IOVs never overlap.
           */
          unsigned long long cacheIdentifier() const {
-            return cacheIdentifier_;
+            return (cacheIdentifier_-1)*numberOfIOVs_ + 1 + iovIndex_;
          }
 
          ///clears the oToFill vector and then fills it with the keys for all registered data keys
@@ -191,6 +193,10 @@ namespace edm {
 
          void set(ValidityInterval const&);
          void setEventSetup(EventSetup const* iEventSetup) {eventSetup_ = iEventSetup; }
+         void setIOVIndex(unsigned int iIndex, unsigned int iNumberOfIOVs) {
+            iovIndex_ = iIndex;
+            numberOfIOVs_ = iNumberOfIOVs;
+         }
 
          void getESProducers(std::vector<ComponentDescription const*>& esproducers);
          void fillReferencedDataKeys(std::map<DataKey, ComponentDescription const*>& referencedDataKeys);
@@ -244,6 +250,8 @@ namespace edm {
          std::map<DataKey, DataProxy const*> proxies_ ;
          EventSetup const* eventSetup_;
          unsigned long long cacheIdentifier_;
+         unsigned int iovIndex_;
+         unsigned int numberOfIOVs_;
          mutable std::atomic<bool> transientAccessRequested_;
       };
    }
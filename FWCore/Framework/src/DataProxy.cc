@@ -11,10 +11,10 @@
 //
 
 // system include files
-#include <mutex>
 
 // user include files
 #include "FWCore/Framework/interface/DataProxy.h"
+#include "FWCore/Framework/src/ESProductionLocks.h"
 #include "FWCore/Framework/interface/ComponentDescription.h"
 #include "FWCore/Framework/interface/MakeDataException.h"
 #include "FWCore/Framework/interface/EventSetupRecord.h"
@@ -25,7 +25,6 @@
 //
 namespace edm {
    namespace eventsetup {
-     static std::recursive_mutex s_esGlobalMutex;
 //
 // static data member definitions
 //
@@ -136,7 +135,7 @@ DataProxy::get(const EventSetupRecord& iRecord, const DataKey& iKey, bool iTrans
 {
    if(!cacheIsValid()) {
       ESSignalSentry signalSentry(iRecord, iKey, providerDescription(), activityRegistry);
-      std::lock_guard<std::recursive_mutex> guard(s_esGlobalMutex);
+      ESProductionLocks::Sentry guard(providerDescription());
       signalSentry.sendPostLockSignal();
       if(!cacheIsValid()) {
          cache_ = const_cast<DataProxy*>(this)->getImpl(iRecord, iKey);
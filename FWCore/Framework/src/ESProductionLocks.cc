@@ -0,0 +1,181 @@
+// -*- C++ -*-
+//
+// Package:     Framework
+// Class  :     ESProductionLocks
+//
+
+// system include files
+#include <algorithm>
+
+// user include files
+#include "FWCore/Framework/src/ESProductionLocks.h"
+
+namespace edm {
+   namespace eventsetup {
+
+      ESProductionLocks::Sentry::Sentry(void const* iProvider) :
+         Sentry(instance(), iProvider) {
+      }
+
+      ESProductionLocks::Sentry::Sentry(ESProductionLocks& iLocks, void const* iProvider) :
+         mutex_(iLocks.mutexFor(iProvider)) {
+         mutex_.lock();
+      }
+
+      ESProductionLocks::Sentry::~Sentry() {
+         mutex_.unlock();
+      }
+
+      ESProductionLocks::ESProductionLocks() :
+         concurrent_(false) {
+      }
+
+      ESProductionLocks&
+      ESProductionLocks::instance() {
+         static ESProductionLocks s_locks;
+         return s_locks;
+      }
+
+      void
+      ESProductionLocks::setConcurrent(bool iConcurrent) {
+         concurrent_ = iConcurrent;
+      }
+
+      void
+      ESProductionLocks::addProviders(ProviderRecords const& iProviderRecords,
+                                      RecordDependencies const& iRecordDependencies) {
+         std::lock_guard<std::mutex> guard(mutex_);
+         for(auto const& provider : iProviderRecords) {
+            providerRecords_[provider.first].insert(provider.second.begin(), provider.second.end());
+         }
+         for(auto const& record : iRecordDependencies) {
+            recordDependencies_[record.first].insert(record.second.begin(), record.second.end());
+         }
+         makeGroups();
+      }
+
+      std::recursive_mutex&
+      ESProductionLocks::mutexFor(void const* iProvider) {
+         if(not concurrent()) {
+            return allProviders_;
+         }
+         std::lock_guard<std::mutex> guard(mutex_);
+         auto itFound = providerMutexes_.find(iProvider);
+         if(itFound != providerMutexes_.end()) {
+            return *itFound->second;
+         }
+         auto& own = ownMutexes_[iProvider];
+         if(not own) {
+            own = std::make_unique<std::recursive_mutex>();
+         }
+         return *own;
+      }
+
+      void
+      ESProductionLocks::makeGroups() {
+         //number the records
+         std::map<EventSetupRecordKey, unsigned int> index;
+         for(auto const& provider : providerRecords_) {
+            for(auto const& record : provider.second) {
+               index.emplace(record, 0);
+            }
+         }
+         for(auto const& record : recordDependencies_) {
+            index.emplace(record.first, 0);
+            for(auto const& dependent : record.second) {
+               index.emplace(dependent, 0);
+            }
+         }
+         std::vector<EventSetupRecordKey> keys;
+         keys.reserve(index.size());
+         for(auto& record : index) {
+            record.second = keys.size();
+            keys.push_back(record.first);
+         }
+         unsigned int const nRecords = keys.size();
+
+         std::vector<unsigned int> parent(nRecords);
+         for(unsigned int i = 0; i < nRecords; ++i) {
+            parent[i] = i;
+         }
+         auto find = [&parent](unsigned int i) {
+            while(parent[i] != i) {
+               parent[i] = parent[parent[i]];
+               i = parent[i];
+            }
+            return i;
+         };
+         //the root is the smallest record of the group, which names its lock
+         auto merge = [&parent, &find](unsigned int i, unsigned int j) {
+            i = find(i);
+            j = find(j);
+            if(i < j) {
+               parent[j] = i;
+            } else if(j < i) {
+               parent[i] = j;
+            }
+         };
+
+         //all the records of a provider are in its group
+         for(auto const& provider : providerRecords_) {
+            auto const& records = provider.second;
+            for(auto const& record : records) {
+               merge(index[*records.begin()], index[record]);
+            }
+         }
+
+         //merge the groups which depend on each other
+         std::vector<std::set<unsigned int> > dependsOn(nRecords);
+         for(auto const& record : recordDependencies_) {
+            for(auto const& dependent : record.second) {
+               unsigned int from = find(index[record.first]);
+               unsigned int to = find(index[dependent]);
+               if(from != to) {
+                  dependsOn[from].insert(to);
+               }
+            }
+         }
+         std::vector<std::vector<bool> > reaches(nRecords);
+         for(unsigned int group = 0; group < nRecords; ++group) {
+            if(find(group) != group) {
+               continue;
+            }
+            auto& reached = reaches[group];
+            reached.assign(nRecords, false);
+            std::vector<unsigned int> toVisit(1, group);
+            while(not toVisit.empty()) {
+               unsigned int visiting = toVisit.back();
+               toVisit.pop_back();
+               for(unsigned int next : dependsOn[visiting]) {
+                  if(not reached[next]) {
+                     reached[next] = true;
+                     toVisit.push_back(next);
+                  }
+               }
+            }
+         }
+         for(unsigned int group = 0; group < nRecords; ++group) {
+            if(reaches[group].empty()) {
+               continue;
+            }
+            for(unsigned int other = group+1; other < nRecords; ++other) {
+               if(not reaches[other].empty() and reaches[group][other] and reaches[other][group]) {
+                  merge(group, other);
+               }
+            }
+         }
+
+         providerMutexes_.clear();
+         for(auto const& provider : providerRecords_) {
+            if(provider.second.empty()) {
+               continue;
+            }
+            auto& groupMutex = groupMutexes_[keys[find(index[*provider.second.begin()])]];
+            if(not groupMutex) {
+               groupMutex = std::make_unique<std::recursive_mutex>();
+            }
+            providerMutexes_[provider.first] = groupMutex.get();
+         }
+      }
+   }
+}
@@ -0,0 +1,99 @@
+#ifndef FWCore_Framework_ESProductionLocks_h
+#define FWCore_Framework_ESProductionLocks_h
+// -*- C++ -*-
+//
+// Package:     Framework
+// Class  :     ESProductionLocks
+//
+/** \class edm::eventsetup::ESProductionLocks
+
+ Description: Synchronizes the creation of EventSetup data by DataProxy::get
+
+ Usage:
+    Instead of one process wide lock, DataProxy::get locks the DataProxyProvider
+ (ESProducer or ESSource) of the proxy while the data is being made, since the
+ providers are not required to be thread safe or reentrant. Only one thread
+ at a time is inside a given provider, and the data of a proxy is made only
+ once.
+
+    Providers can ask for data of their own record or of the records it depends
+ on while making their data, so the locks are recursive and a thread holding
+ one may take others. To rule out deadlocks the providers are grouped, and
+ all providers of a group share one lock:
+    - all the providers of a record are in the same group, as are all the
+      records of a provider;
+    - groups which depend on each other through the record dependencies, even
+      indirectly, are merged.
+ The dependencies between the groups then form a DAG, and a thread holding the
+ lock of a group only ever waits for the lock of a group below it, so the
+ locks are always taken in the same order. Data of providers of unrelated
+ groups are made concurrently.
+
+    The groups are defined by addProviders(), called by each EventSetupProvider
+ once its configuration is finished and before any data are made. A provider
+ which was not added has a lock of its own.
+
+    setConcurrent(false) makes all the providers share one lock, which gives
+ the same serialization as the former global mutex.
+*/
+
+#include "FWCore/Framework/interface/EventSetupRecordKey.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace edm {
+   namespace eventsetup {
+
+      class ESProductionLocks {
+      public:
+         typedef std::map<void const*, std::set<EventSetupRecordKey> > ProviderRecords;
+         typedef std::map<EventSetupRecordKey, std::set<EventSetupRecordKey> > RecordDependencies;
+
+         class Sentry {
+         public:
+            explicit Sentry(void const* iProvider);
+            Sentry(ESProductionLocks& iLocks, void const* iProvider);
+            ~Sentry();
+
+            Sentry(Sentry const&) = delete;
+            Sentry& operator=(Sentry const&) = delete;
+         private:
+            std::recursive_mutex& mutex_;
+         };
+
+         ESProductionLocks();
+
+         static ESProductionLocks& instance();
+
+         void setConcurrent(bool iConcurrent);
+         bool concurrent() const { return concurrent_.load(); }
+
+         // the records made by each provider (identified by the address of its
+         // ComponentDescription) and the records each record depends on
+         void addProviders(ProviderRecords const& iProviderRecords,
+                           RecordDependencies const& iRecordDependencies);
+
+         std::recursive_mutex& mutexFor(void const* iProvider);
+
+      private:
+         void makeGroups();
+
+         std::mutex mutex_;
+         std::atomic<bool> concurrent_;
+         std::recursive_mutex allProviders_;
+         ProviderRecords providerRecords_;
+         RecordDependencies recordDependencies_;
+         // the group locks, by smallest record of the group
+         std::map<EventSetupRecordKey, std::unique_ptr<std::recursive_mutex> > groupMutexes_;
+         std::map<void const*, std::recursive_mutex*> providerMutexes_;
+         // providers which were not added
+         std::map<void const*, std::unique_ptr<std::recursive_mutex> > ownMutexes_;
+      };
+   }
+}
+#endif
@@ -28,6 +28,7 @@
 #include "FWCore/Framework/interface/SubProcess.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/src/Breakpoints.h"
+#include "FWCore/Framework/src/ESProductionLocks.h"
 #include "FWCore/Framework/src/EventSetupsController.h"
 #include "FWCore/Framework/src/InputSourceFactory.h"
 #include "FWCore/Framework/src/SharedResourcesRegistry.h"
@@ -407,6 +408,7 @@ namespace edm {
       fileModeNoMerge_ = (fileMode == "NOMERGE");
     }
     forceESCacheClearOnNewRun_ = optionsPset.getUntrackedParameter<bool>("forceEventSetupCacheClearOnNewRun");
+    eventsetup::ESProductionLocks::instance().setConcurrent(optionsPset.getUntrackedParameter<bool>("concurrentEventSetupProduction"));
 
     //threading
     unsigned int nThreads = optionsPset.getUntrackedParameter<unsigned int>("numberOfThreads");
@@ -431,6 +433,10 @@ namespace edm {
     if (nConcurrentLumis == 0) {
       nConcurrentLumis = nConcurrentRuns;
     }
+    unsigned int nConcurrentIOVs = optionsPset.getUntrackedParameter<unsigned int>("numberOfConcurrentIOVs");
+    if (nConcurrentIOVs == 0) {
+      nConcurrentIOVs = 1;
+    }
 
     //Check that relationships between threading parameters makes sense
     /*
@@ -481,6 +487,27 @@ namespace edm {
       nConcurrentLumis=1;
       nConcurrentRuns=1;
     }
+    //A lumi only ever uses one IOV so more IOVs than lumis can not be used.
+    // SubProcesses share EventSetup components with this process through
+    // espController_ so they only work with one IOV.
+    if(nConcurrentIOVs > nConcurrentLumis) {
+      nConcurrentIOVs = nConcurrentLumis;
+    }
+    if(hasSubProcesses) {
+      nConcurrentIOVs = 1;
+    }
+    if(nConcurrentIOVs > 1) {
+      edm::LogInfo("ThreadStreamSetup") <<"setting # concurrent IOVs "<<nConcurrentIOVs;
+    }
+    // each additional IOV gets its own ESSources and ESProducers
+    esp_->setIOVIndex(0, nConcurrentIOVs);
+    for(unsigned int index = 1; index < nConcurrentIOVs; ++index) {
+      extraESControllers_.emplace_back(std::make_unique<eventsetup::EventSetupsController>());
+      auto esp = extraESControllers_.back()->makeProvider(*parameterSet, items.actReg_.get());
+      esp->setIOVIndex(index, nConcurrentIOVs);
+      extraESProviders_.emplace_back(std::move(esp));
+    }
+    iovQueues_.resize(nConcurrentIOVs);
 
     preallocations_ = PreallocationConfiguration{nThreads,nStreams,nConcurrentLumis,nConcurrentRuns};
 
@@ -552,6 +579,8 @@ namespace edm {
 
     // manually destroy all these thing that may need the services around
     // propagate_const<T> has no reset() function
+    extraESProviders_.clear();
+    extraESControllers_.clear();
     espController_ = nullptr;
     esp_ = nullptr;
     schedule_ = nullptr;
@@ -950,7 +979,12 @@ namespace edm {
                     runPrincipal.beginTime());
     if(forceESCacheClearOnNewRun_){
       espController_->forceCacheClear();
+      for(auto& controller: extraESControllers_) {
+        controller->forceCacheClear();
+      }
     }
+    //the lumis of the previous run are all done so start again from the IOV the run uses
+    currentIOVIndex_ = 0;
     {
       SendSourceTerminationSignalIfException sentry(actReg_.get());
       espController_->eventSetupForInstance(ts);
@@ -1153,7 +1187,7 @@ namespace edm {
             } else {
 
               status->globalBeginDidSucceed();
-              EventSetup const& es = esp_->eventSetup();
+              EventSetup const& es = eventSetupForIOV(status->eventSetupIndex());
               if(looper_) {
                 try {
                   //make the services available
@@ -1193,7 +1227,7 @@ namespace edm {
           
           //task to start the global begin lumi
           WaitingTaskHolder beginStreamsHolder{beginStreamsTask};
-          EventSetup const& es = esp_->eventSetup();
+          EventSetup const& es = eventSetupForIOV(status->eventSetupIndex());
           {
             typedef OccurrenceTraits<LuminosityBlockPrincipal, BranchActionGlobalBegin> Traits;
             beginGlobalTransitionAsync<Traits>(beginStreamsHolder,
@@ -1212,21 +1246,27 @@ namespace edm {
         
     //Safe to do check now since can not have multiple beginLumis at same time in this part of the code
     // because we do not attempt to read from the source again until we try to get the first event in a lumi
-    if(espController_->isWithinValidityInterval(iSync)) {
-      iovQueue_.pause();
+    if(esControllerForIOV(currentIOVIndex_).isWithinValidityInterval(iSync)) {
+      status->setEventSetupIndex(currentIOVIndex_);
+      iovQueues_[currentIOVIndex_].pause();
       lumiQueue_->pushAndPause(std::move(lumiWork));
     } else {
+      //Move to the next IOV. Its queue only runs once the lumis still using
+      // that IOV are done, while lumis of the other IOVs keep processing.
+      currentIOVIndex_ = (currentIOVIndex_+1) % iovQueues_.size();
+      unsigned int iovIndex = currentIOVIndex_;
+      status->setEventSetupIndex(iovIndex);
       //If EventSetup fails, need beginStreamsHolder in order to pass back exception
-      iovQueue_.push([this,iHolder,lumiWork,iSync]() mutable {
+      iovQueues_[iovIndex].push([this,iHolder,lumiWork,iSync,iovIndex]() mutable {
         try {
           SendSourceTerminationSignalIfException sentry(actReg_.get());
-          espController_->eventSetupForInstance(iSync);
+          esControllerForIOV(iovIndex).eventSetupForInstance(iSync);
           sentry.completedSuccessfully();
         } catch(...) {
           iHolder.doneWaiting(std::current_exception());
           return;
         }
-        iovQueue_.pause();
+        iovQueues_[iovIndex].pause();
         lumiQueue_->pushAndPause(std::move(lumiWork));
       });
     }
@@ -1268,7 +1308,7 @@ namespace edm {
           ServiceRegistry::Operate operate(serviceToken_);
           if(looper_) {
             auto& lp = *(status->lumiPrincipal());
-            EventSetup const& es = esp_->eventSetup();
+            EventSetup const& es = eventSetupForIOV(status->eventSetupIndex());
             looper_->doEndLuminosityBlock(lp, es, &processContext_);
           }
         }catch(...) {
@@ -1279,7 +1319,7 @@ namespace edm {
       }
       deleteLumiFromCache(*status);
       //release our hold on the IOV
-      iovQueue_.resume();
+      iovQueues_[status->eventSetupIndex()].resume();
       status->resumeGlobalLumiQueue();
       try {
         status.reset();
@@ -1309,7 +1349,7 @@ namespace edm {
 
 
     typedef OccurrenceTraits<LuminosityBlockPrincipal, BranchActionGlobalEnd> Traits;
-    EventSetup const& es = esp_->eventSetup();
+    EventSetup const& es = eventSetupForIOV(iLumiStatus->eventSetupIndex());
 
     endGlobalTransitionAsync<Traits>(WaitingTaskHolder(writeT),
                                      *schedule_,
@@ -1350,7 +1390,7 @@ namespace edm {
       auto & lumiPrincipal = *iLumiStatus->lumiPrincipal();
       IOVSyncValue ts(EventID(lumiPrincipal.run(), lumiPrincipal.luminosityBlock(), EventID::maxEventNumber()),
                       lumiPrincipal.endTime());
-      EventSetup const& es = esp_->eventSetup();
+      EventSetup const& es = eventSetupForIOV(iLumiStatus->eventSetupIndex());
 
       bool cleaningUpAfterException = iLumiStatus->cleaningUpAfterException();
       
@@ -1680,10 +1720,26 @@ namespace edm {
     }
     
     schedule_->processOneEventAsync(std::move(afterProcessTask),
-                                    iStreamIndex,*pep, esp_->eventSetup(), serviceToken_);
+                                    iStreamIndex,*pep,
+                                    eventSetupForIOV(streamLumiStatus_[iStreamIndex]->eventSetupIndex()),
+                                    serviceToken_);
 
   }
 
+  eventsetup::EventSetupsController& EventProcessor::esControllerForIOV(unsigned int iIOVIndex) {
+    if(iIOVIndex == 0) {
+      return *espController_;
+    }
+    return *extraESControllers_[iIOVIndex-1];
+  }
+
+  EventSetup const& EventProcessor::eventSetupForIOV(unsigned int iIOVIndex) const {
+    if(iIOVIndex == 0) {
+      return esp_->eventSetup();
+    }
+    return extraESProviders_[iIOVIndex-1]->eventSetup();
+  }
+
   void EventProcessor::processEventWithLooper(EventPrincipal& iPrincipal) {
     bool randomAccess = input_->randomAccess();
     ProcessingController::ForwardState forwardState = input_->forwardState();
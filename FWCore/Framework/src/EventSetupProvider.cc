@@ -25,6 +25,7 @@
 #include "FWCore/Framework/interface/EventSetupRecordIntervalFinder.h"
 #include "FWCore/Framework/interface/ModuleFactory.h"
 #include "FWCore/Framework/interface/ParameterSetIDHolder.h"
+#include "FWCore/Framework/src/ESProductionLocks.h"
 #include "FWCore/Framework/src/EventSetupsController.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
@@ -69,6 +70,8 @@ providers_(),
 knownRecordsSupplier_( std::make_unique<KnownRecordsSupplierImpl>(providers_)),
 mustFinishConfiguration_(true),
 subProcessIndex_(subProcessIndex),
+iovIndex_(0),
+numberOfIOVs_(1),
 preferredProviderInfo_((nullptr!=iInfo) ? (new PreferredProviderInfo(*iInfo)): nullptr),
 finders_(new std::vector<std::shared_ptr<EventSetupRecordIntervalFinder> >() ),
 dataProviders_(new std::vector<std::shared_ptr<DataProxyProvider> >() ),
@@ -311,6 +314,7 @@ EventSetupProvider::finishConfiguration()
    // their Records and therefore could delay setting up their Proxies
    psetIDToRecordKey_->clear();
    typedef std::set<EventSetupRecordKey> Keys;
+   ESProductionLocks::ProviderRecords providerRecords;
    for(std::vector<std::shared_ptr<DataProxyProvider> >::iterator itProvider=dataProviders_->begin(),
        itEnd = dataProviders_->end();
        itProvider != itEnd;
@@ -319,6 +323,7 @@ EventSetupProvider::finishConfiguration()
       ParameterSetIDHolder psetID((*itProvider)->description().pid_);
 
       const Keys recordsUsing = (*itProvider)->usingRecords();
+      providerRecords[&(*itProvider)->description()] = recordsUsing;
       
       for(Keys::const_iterator itKey = recordsUsing.begin(), itKeyEnd = recordsUsing.end();
           itKey != itKeyEnd;
@@ -348,6 +353,7 @@ EventSetupProvider::finishConfiguration()
    //For each Provider, find all the Providers it depends on.  If a dependent Provider
    // can not be found pass in an empty list
    //CHANGE: now allow for missing Providers
+   ESProductionLocks::RecordDependencies recordDependencies;
    for(Providers::iterator itProvider = providers_.begin(), itProviderEnd = providers_.end();
         itProvider != itProviderEnd;
         ++itProvider) {
@@ -360,6 +366,7 @@ EventSetupProvider::finishConfiguration()
       itProvider->second->usePreferred(*preferredInfo);
       
       std::set<EventSetupRecordKey> records = itProvider->second->dependentRecords();
+      recordDependencies[itProvider->first] = records;
       if(!records.empty()) {
          std::string missingRecords;
          std::vector<std::shared_ptr<EventSetupRecordProvider> > depProviders;
@@ -396,6 +403,8 @@ EventSetupProvider::finishConfiguration()
          itProvider->second->setDependentProviders(depProviders);
       }
    }
+   //the providers which make data concurrently follow from the records they share
+   ESProductionLocks::instance().addProviders(providerRecords, recordDependencies);
    mustFinishConfiguration_ = false;
 }
 
@@ -736,6 +745,7 @@ EventSetupProvider::clearInitializationData() {
 void
 EventSetupProvider::addRecordToEventSetup(EventSetupRecord& iRecord) {
    iRecord.setEventSetup(&eventSetup_);
+   iRecord.setIOVIndex(iovIndex_, numberOfIOVs_);
    eventSetup_.add(iRecord);
 }
       
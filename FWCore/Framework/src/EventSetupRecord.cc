@@ -43,6 +43,8 @@ validity_(),
 proxies_(),
 eventSetup_(nullptr),
 cacheIdentifier_(1), //start with 1 since 0 means we haven't checked yet
+iovIndex_(0),
+numberOfIOVs_(1),
 transientAccessRequested_(false)
 {
 }
@@ -91,6 +91,10 @@ class LuminosityBlockProcessingStatus
   const IOVSyncValue nextSyncValue() const { return nextSyncValue_;}
   
   std::shared_ptr<void> const& runResource() const {return run_;}
+
+  //Which of the concurrent EventSetup IOVs this lumi uses
+  unsigned int eventSetupIndex() const { return eventSetupIndex_;}
+  void setEventSetupIndex(unsigned int iIndex) { eventSetupIndex_ = iIndex;}
   
   //Called once all events in Lumi have been processed
   void setEndTime();
@@ -101,6 +105,7 @@ class LuminosityBlockProcessingStatus
   LimitedTaskQueue::Resumer globalLumiQueueResumer_;
   EventProcessor* eventProcessor_ = nullptr;
   IOVSyncValue nextSyncValue_;
+  unsigned int eventSetupIndex_{0}; //set before the lumi is pushed to the global lumi queue
   std::atomic<unsigned int> nStreamsStillProcessingLumi_{0}; //read/write as streams finish lumi so must be atomic
   edm::Timestamp endTime_{};
   std::atomic<char> endTimeSetStatus_{0};
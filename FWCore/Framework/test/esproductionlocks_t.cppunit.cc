@@ -0,0 +1,252 @@
+/*
+ *  esproductionlocks_t.cc
+ *
+ *  Tests of the locks used while making EventSetup data
+ */
+
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "FWCore/Framework/src/ESProductionLocks.h"
+#include "FWCore/Framework/test/DummyRecord.h"
+#include "FWCore/Framework/test/Dummy2Record.h"
+#include "FWCore/Framework/test/DepRecord.h"
+#include "FWCore/Framework/test/DepOn2Record.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using edm::eventsetup::ESProductionLocks;
+using edm::eventsetup::EventSetupRecordKey;
+
+namespace {
+  //providers are only used as addresses
+  int provider1, provider2, provider3;
+
+  EventSetupRecordKey const dummy = EventSetupRecordKey::makeKey<DummyRecord>();
+  EventSetupRecordKey const dummy2 = EventSetupRecordKey::makeKey<Dummy2Record>();
+  EventSetupRecordKey const dep = EventSetupRecordKey::makeKey<DepRecord>();
+  EventSetupRecordKey const depOn2 = EventSetupRecordKey::makeKey<DepOn2Record>();
+
+  //lets threads wait for each other; a wait which times out fails the test
+  // instead of hanging it
+  class Latch {
+  public:
+    explicit Latch(int iCount) : count_(iCount) {}
+    void countDown() {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if(--count_ <= 0) {
+        cv_.notify_all();
+      }
+    }
+    bool wait() {
+      std::unique_lock<std::mutex> guard(mutex_);
+      return cv_.wait_for(guard, std::chrono::seconds(30), [this]() { return count_ <= 0; });
+    }
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_;
+  };
+}
+
+class testESProductionLocks: public CppUnit::TestFixture
+{
+CPPUNIT_TEST_SUITE(testESProductionLocks);
+
+CPPUNIT_TEST(recursiveTest);
+CPPUNIT_TEST(unrelatedProvidersTest);
+CPPUNIT_TEST(sharedRecordTest);
+CPPUNIT_TEST(dependentProvidersTest);
+CPPUNIT_TEST(crossedDependenciesTest);
+CPPUNIT_TEST(unknownProviderTest);
+CPPUNIT_TEST(serialTest);
+
+CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp() {}
+  void tearDown() {}
+
+  void recursiveTest();
+  void unrelatedProvidersTest();
+  void sharedRecordTest();
+  void dependentProvidersTest();
+  void crossedDependenciesTest();
+  void unknownProviderTest();
+  void serialTest();
+};
+
+///registration of the test so that the runner can find it
+CPPUNIT_TEST_SUITE_REGISTRATION(testESProductionLocks);
+
+void testESProductionLocks::recursiveTest()
+{
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dummy}}}, {});
+
+  ESProductionLocks::Sentry outer(locks, &provider1);
+  {
+    //a provider asking for another of its products while making one
+    ESProductionLocks::Sentry inner(locks, &provider1);
+    ESProductionLocks::Sentry again(locks, &provider1);
+  }
+}
+
+void testESProductionLocks::unrelatedProvidersTest()
+{
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dummy}}, {&provider2, {dummy2}}}, {});
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) != &locks.mutexFor(&provider2));
+
+  //both threads must be inside their provider at the same time
+  Latch inside(2);
+  std::atomic<int> together{0};
+  auto make = [&](void const* iProvider) {
+    ESProductionLocks::Sentry sentry(locks, iProvider);
+    inside.countDown();
+    if(inside.wait()) {
+      ++together;
+    }
+  };
+  std::thread t1(make, &provider1);
+  std::thread t2(make, &provider2);
+  t1.join();
+  t2.join();
+  CPPUNIT_ASSERT(together == 2);
+}
+
+void testESProductionLocks::sharedRecordTest()
+{
+  //providers of the same record are never used concurrently
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dummy}}, {&provider2, {dummy, dummy2}}, {&provider3, {dummy2}}}, {});
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider2));
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider3));
+
+  std::atomic<int> inside{0};
+  std::atomic<int> maxInside{0};
+  auto make = [&](void const* iProvider) {
+    for(int i = 0; i < 100; ++i) {
+      ESProductionLocks::Sentry sentry(locks, iProvider);
+      int n = ++inside;
+      if(n > maxInside) maxInside = n;
+      std::this_thread::yield();
+      --inside;
+    }
+  };
+  std::thread t1(make, &provider1);
+  std::thread t2(make, &provider2);
+  std::thread t3(make, &provider3);
+  t1.join();
+  t2.join();
+  t3.join();
+  CPPUNIT_ASSERT(maxInside == 1);
+}
+
+void testESProductionLocks::dependentProvidersTest()
+{
+  //provider1 makes DepRecord data, which may need data of provider2 from
+  // DummyRecord, but not the other way around: the two have separate locks
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dep}}, {&provider2, {dummy}}}, {{dep, {dummy}}});
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) != &locks.mutexFor(&provider2));
+
+  Latch bothInside(2);
+  std::atomic<bool> together{false};
+  std::atomic<bool> nestedDone{false};
+  std::thread t1([&]() {
+    ESProductionLocks::Sentry sentry(locks, &provider1);
+    bothInside.countDown();
+    together = bothInside.wait();
+    //waits for thread 2 to leave provider2
+    ESProductionLocks::Sentry nested(locks, &provider2);
+    nestedDone = true;
+  });
+  std::thread t2([&]() {
+    ESProductionLocks::Sentry sentry(locks, &provider2);
+    bothInside.countDown();
+    bothInside.wait();
+  });
+  t1.join();
+  t2.join();
+  CPPUNIT_ASSERT(together);
+  CPPUNIT_ASSERT(nestedDone);
+}
+
+void testESProductionLocks::crossedDependenciesTest()
+{
+  //provider1 makes DummyRecord and DepOn2Record data, and the latter may need
+  // data of provider2 from Dummy2Record. provider2 also makes DepRecord data,
+  // which may need data of provider1 from DummyRecord. Taking the two locks in
+  // either order could deadlock, so the providers share one lock.
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dummy, depOn2}}, {&provider2, {dummy2, dep}}, {&provider3, {dummy2}}},
+                     {{depOn2, {dummy, dummy2}}, {dep, {dummy}}});
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider2));
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider3));
+
+  Latch thread1Inside(1);
+  std::atomic<bool> thread1Left{false};
+  std::atomic<bool> thread2AfterThread1{false};
+  std::thread t1([&]() {
+    ESProductionLocks::Sentry sentry(locks, &provider1);
+    thread1Inside.countDown();
+    {
+      ESProductionLocks::Sentry nested(locks, &provider2);
+    }
+    thread1Left = true;
+  });
+  std::thread t2([&]() {
+    thread1Inside.wait();
+    ESProductionLocks::Sentry sentry(locks, &provider2);
+    thread2AfterThread1 = thread1Left.load();
+    ESProductionLocks::Sentry nested(locks, &provider1);
+  });
+  t1.join();
+  t2.join();
+  CPPUNIT_ASSERT(thread2AfterThread1);
+}
+
+void testESProductionLocks::unknownProviderTest()
+{
+  ESProductionLocks locks;
+  locks.setConcurrent(true);
+  locks.addProviders({{&provider1, {dummy}}}, {});
+  std::recursive_mutex& own = locks.mutexFor(&provider2);
+  CPPUNIT_ASSERT(&own == &locks.mutexFor(&provider2));
+  CPPUNIT_ASSERT(&own != &locks.mutexFor(&provider1));
+  CPPUNIT_ASSERT(&own != &locks.mutexFor(&provider3));
+}
+
+void testESProductionLocks::serialTest()
+{
+  ESProductionLocks locks;
+  CPPUNIT_ASSERT(not locks.concurrent());
+  locks.addProviders({{&provider1, {dummy}}, {&provider2, {dummy2}}}, {});
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider2));
+  CPPUNIT_ASSERT(&locks.mutexFor(&provider1) == &locks.mutexFor(&provider3));
+
+  std::atomic<int> inside{0};
+  std::atomic<int> maxInside{0};
+  auto make = [&](void const* iProvider) {
+    for(int i = 0; i < 100; ++i) {
+      ESProductionLocks::Sentry sentry(locks, iProvider);
+      int n = ++inside;
+      if(n > maxInside) maxInside = n;
+      std::this_thread::yield();
+      --inside;
+    }
+  };
+  std::thread t1(make, &provider1);
+  std::thread t2(make, &provider2);
+  t1.join();
+  t2.join();
+  CPPUNIT_ASSERT(maxInside == 1);
+}
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Pass in name and status
+function die { echo $1: status $2 ;  exit $2; }
+
+#the last few lines of the output are the printout from the
+# ConcurrentModuleTimer service detailing how much time was
+# spent in 2,3 or 4 modules running simultaneously.
+# A luminosity block only has 2 events so more than 2 modules can only
+# run at the same time if 2 luminosity blocks, each with its own IOV, do.
+touch empty_file
+
+(cmsRun ${LOCAL_TEST_DIR}/test_concurrent_iovs_cfg.py 1 2>&1) | tail -n 2 | grep -v ' 0 ' | grep -v 'e-' | diff - empty_file || die "Failure using test_concurrent_iovs_cfg.py 1" $?
+
+(cmsRun ${LOCAL_TEST_DIR}/test_concurrent_iovs_cfg.py 2 2>&1) | tail -n 1 | grep -v ' 0 ' | grep -v 'e-' | diff - empty_file && die "Failure using test_concurrent_iovs_cfg.py 2" $?
+
+exit 0
@@ -0,0 +1,79 @@
+// -*- C++ -*-
+//
+// Package:     FWCore/Framework
+// Class  :     TestConcurrentIOVs
+//
+// Implementation:
+//     An ESSource whose DummyRecord IOV is one luminosity block and an
+//     analyzer checking that every event sees the data of its own
+//     luminosity block. Used to test running with several concurrent IOVs.
+//
+
+// system include files
+#include <chrono>
+#include <thread>
+
+// user include files
+#include "FWCore/Framework/interface/EventSetupRecordIntervalFinder.h"
+#include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/Framework/interface/SourceFactory.h"
+#include "FWCore/Framework/interface/global/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "FWCore/Framework/test/DummyData.h"
+#include "FWCore/Framework/test/DummyRecord.h"
+
+namespace edmtest {
+
+  class PerLumiDummyESSource : public edm::EventSetupRecordIntervalFinder, public edm::ESProducer {
+  public:
+    PerLumiDummyESSource(edm::ParameterSet const& iPSet):
+    waitTime_(iPSet.getUntrackedParameter<unsigned int>("millisecondsToProduce",0)) {
+      this->findingRecord<DummyRecord>();
+      setWhatProduced(this);
+    }
+
+    std::unique_ptr<edm::eventsetup::test::DummyData> produce(DummyRecord const& iRecord) {
+      //stands in for reading the conditions from a database
+      if(waitTime_ != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(waitTime_));
+      }
+      return std::make_unique<edm::eventsetup::test::DummyData>(iRecord.validityInterval().first().eventID().luminosityBlock());
+    }
+
+  protected:
+    void setIntervalFor(edm::eventsetup::EventSetupRecordKey const&,
+                        edm::IOVSyncValue const& iTime,
+                        edm::ValidityInterval& iInterval) override {
+      edm::EventID const& id = iTime.eventID();
+      iInterval = edm::ValidityInterval(edm::IOVSyncValue(edm::EventID(id.run(), id.luminosityBlock(), 0)),
+                                        edm::IOVSyncValue(edm::EventID(id.run(), id.luminosityBlock(), edm::EventID::maxEventNumber())));
+    }
+
+  private:
+    const unsigned int waitTime_;
+  };
+
+  class PerLumiDummyDataAnalyzer : public edm::global::EDAnalyzer<> {
+  public:
+    explicit PerLumiDummyDataAnalyzer(edm::ParameterSet const&) {}
+
+    void analyze(edm::StreamID, edm::Event const& iEvent, edm::EventSetup const& iSetup) const override {
+      edm::ESHandle<edm::eventsetup::test::DummyData> data;
+      iSetup.get<DummyRecord>().get(data);
+      if(data->value_ != static_cast<int>(iEvent.luminosityBlock())) {
+        throw cms::Exception("WrongIOV") << "event " << iEvent.id() << " got the DummyData of luminosity block "
+                                         << data->value_;
+      }
+    }
+  };
+}
+
+using namespace edmtest;
+DEFINE_FWK_EVENTSETUP_SOURCE(PerLumiDummyESSource);
+DEFINE_FWK_MODULE(PerLumiDummyDataAnalyzer);
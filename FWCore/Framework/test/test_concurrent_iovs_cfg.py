@@ -0,0 +1,33 @@
+import FWCore.ParameterSet.Config as cms
+import sys
+
+# the DummyRecord IOV changes every luminosity block, pass the number of
+# concurrent IOVs as argument: 1 serializes the luminosity blocks, 2 lets
+# the next one start while the previous is still processing events
+nIOVs = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+
+process = cms.Process("TEST")
+
+process.source = cms.Source("EmptySource", numberEventsInLuminosityBlock = cms.untracked.uint32(2))
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32( 20 ) )
+
+process.options = cms.untracked.PSet( numberOfThreads = cms.untracked.uint32(4),
+                                      numberOfStreams = cms.untracked.uint32(0),
+                                      numberOfConcurrentLuminosityBlocks = cms.untracked.uint32(2),
+                                      numberOfConcurrentIOVs = cms.untracked.uint32(nIOVs))
+
+process.perLumi = cms.ESSource("PerLumiDummyESSource",
+                               millisecondsToProduce = cms.untracked.uint32(10))
+
+process.prod = cms.EDProducer("BusyWaitIntProducer",
+                              ivalue = cms.int32(1),
+                              iterations = cms.uint32(50*1000) )
+
+process.check = cms.EDAnalyzer("PerLumiDummyDataAnalyzer")
+
+process.p = cms.Path(process.prod+process.check)
+
+process.add_(cms.Service("ConcurrentModuleTimer",
+                         modulesToExclude = cms.untracked.vstring("TriggerResults","p","check"),
+                         excludeSource = cms.untracked.bool(True)))
@@ -20,11 +20,15 @@ void fillOptionsDescription(ParameterSetDescription& description) {
   description.addUntracked<unsigned int>("numberOfConcurrentRuns", 1);
   description.addUntracked<unsigned int>("numberOfConcurrentLuminosityBlocks", 1)->
     setComment("If zero, then set the same as the number of runs");
+  description.addUntracked<unsigned int>("numberOfConcurrentIOVs", 1)->
+    setComment("If zero, then set to one. Each IOV has its own ESSources and ESProducers. Limited to the number of luminosity blocks, one with a looper or SubProcesses");
   description.addUntracked<bool>("wantSummary", false)->
     setComment("Set true to print a report on the trigger decisions and timing of modules");
   description.addUntracked<std::string>("fileMode", "FULLMERGE")->
     setComment("Legal values are 'NOMERGE' and 'FULLMERGE'");
   description.addUntracked<bool>("forceEventSetupCacheClearOnNewRun", false);
+  description.addUntracked<bool>("concurrentEventSetupProduction", false)->
+    setComment("Set true to make EventSetup data concurrently for unrelated ESProducers and ESSources instead of one product at a time");
   description.addUntracked<bool>("throwIfIllegalParameter", true)->
     setComment("Set false to disable exception throws when configuration validation detects illegal parameters");
   description.addUntracked<bool>("printDependencies", false)->
@@ -0,0 +1,650 @@
+// -*- C++ -*-
+//
+// Package: FWCore/Services
+// Class  : SamplingProfiler
+//
+// Implementation:
+//     The process CPU time is sampled with SIGPROF (setitimer ITIMER_PROF),
+//     which the kernel delivers to the thread using the CPU. The signal
+//     handler records the call stack of the interrupted thread together
+//     with the module and stream it is running, which the thread keeps
+//     up to date from the ModuleCallingContext of the module transitions.
+//     The samples are written to preallocated per-thread buffers and
+//     aggregated into identical stacks by the thread itself between two
+//     modules. The handler itself does not allocate; the stack is unwound
+//     from the interrupted context with the local unwinder of libunwind,
+//     which is async-signal-safe, unlike backtrace() of glibc. Its
+//     per-thread cache is primed at start, but a frame whose unwind
+//     information is not cached yet is looked up through dl_iterate_phdr,
+//     which takes the (recursive) lock of the dynamic loader. At the end
+//     of the job the addresses are symbolised and the stacks written in
+//     the "folded" format read by flamegraph.pl, one tree per module.
+//
+
+#include "DataFormats/Provenance/interface/ModuleDescription.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ConfigurationDescriptions.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ParameterSet/interface/ParameterSetDescription.h"
+#include "FWCore/ServiceRegistry/interface/ActivityRegistry.h"
+#include "FWCore/ServiceRegistry/interface/GlobalContext.h"
+#include "FWCore/ServiceRegistry/interface/ModuleCallingContext.h"
+#include "FWCore/ServiceRegistry/interface/ServiceMaker.h"
+#include "FWCore/ServiceRegistry/interface/StreamContext.h"
+#include "FWCore/Utilities/interface/EDMException.h"
+#include "FWCore/Utilities/interface/OStreamColumn.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+  // What a thread is running: the module id in the upper half, the
+  // stream in the lower half.
+  using Context = std::uint64_t;
+  constexpr std::uint32_t kNoModule = ~0u;
+  constexpr std::uint32_t kSource = ~0u - 1;
+  constexpr std::uint32_t kNoStream = ~0u;
+
+  inline Context makeContext(std::uint32_t module, std::uint32_t stream) {
+    return (Context(module) << 32) | stream;
+  }
+  inline std::uint32_t contextModule(Context c) { return c >> 32; }
+  inline std::uint32_t contextStream(Context c) { return c & 0xffffffff; }
+
+  constexpr unsigned int kMaxNesting = 32;
+  constexpr unsigned int kMaxThreads = 1024;
+
+  inline pid_t threadID() { return syscall(SYS_gettid); }
+
+  /// The return addresses of the stack of the context uc, the innermost
+  /// first, which is the interrupted instruction for the context of a
+  /// signal handler; async-signal-safe.
+  unsigned int unwind(unw_context_t* uc, int flags, std::uintptr_t* frames, unsigned int maxDepth) {
+    unw_cursor_t cursor;
+    if (unw_init_local2(&cursor, uc, flags) < 0) {
+      return 0;
+    }
+    unsigned int n = 0;
+    do {
+      unw_word_t ip;
+      if (unw_get_reg(&cursor, UNW_REG_IP, &ip) < 0 or ip == 0) {
+        break;
+      }
+      frames[n++] = ip;
+    } while (n < maxDepth and unw_step(&cursor) > 0);
+    return n;
+  }
+
+  /// A sampled stack: the context, then the frames from the outermost to
+  /// the interrupted one.
+  using Stack = std::vector<std::uintptr_t>;
+  struct StackHash {
+    std::size_t operator()(Stack const& s) const {
+      std::size_t h = 14695981039346656037ull;
+      for (auto v : s) {
+        h = (h ^ v) * 1099511628211ull;
+      }
+      return h;
+    }
+  };
+  using Stacks = std::unordered_map<Stack, unsigned long, StackHash>;
+
+  //===============================================================
+  // Samples of one thread. The context stack and the buffers are written
+  // by the thread itself, and by its signal handler which interrupts it;
+  // the buffers are read back by the thread too, or once the sampling
+  // has stopped. The samples go to the active half of the buffers, and
+  // the thread aggregates the other half after switching them.
+  class ThreadSamples {
+  public:
+    ThreadSamples(unsigned int samplesPerHalf, unsigned int maxDepth)
+      : capacity_{samplesPerHalf}, maxDepth_{maxDepth} {
+      for (auto& h : halves_) {
+        h.contexts.reset(new Context[capacity_]);
+        h.depths.reset(new unsigned int[capacity_]);
+        h.frames.reset(new std::uintptr_t[std::size_t(capacity_) * std::max(maxDepth_, 1u)]);
+      }
+    }
+
+    void push(Context c) {
+      auto n = nesting_.load(std::memory_order_relaxed);
+      if (n < kMaxNesting) {
+        contexts_[n].store(c, std::memory_order_relaxed);
+      }
+      std::atomic_signal_fence(std::memory_order_release);
+      nesting_.store(n + 1, std::memory_order_relaxed);
+    }
+
+    void pop() {
+      auto n = nesting_.load(std::memory_order_relaxed);
+      if (n > 0) {
+        nesting_.store(n - 1, std::memory_order_relaxed);
+      }
+      if (halves_[active_.load(std::memory_order_relaxed)].used.load(std::memory_order_relaxed) >= capacity_ / 2) {
+        switchHalves();
+      }
+    }
+
+    // called from the signal handler only, with its context
+    void sample(void* uc) {
+      auto& h = halves_[active_.load(std::memory_order_relaxed)];
+      auto i = h.used.load(std::memory_order_relaxed);
+      if (i == capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      auto n = nesting_.load(std::memory_order_relaxed);
+      h.contexts[i] = n ? contexts_[std::min(n, kMaxNesting) - 1].load(std::memory_order_relaxed)
+                        : makeContext(kNoModule, kNoStream);
+      h.depths[i] = maxDepth_ ? unwind(static_cast<unw_context_t*>(uc), UNW_INIT_SIGNAL_FRAME,
+                                       &h.frames[std::size_t(i) * maxDepth_], maxDepth_)
+                              : 0;
+      std::atomic_signal_fence(std::memory_order_release);
+      h.used.store(i + 1, std::memory_order_relaxed);
+    }
+
+    // once the sampling has stopped
+    void aggregateAll() {
+      aggregate(halves_[0]);
+      aggregate(halves_[1]);
+    }
+
+    Stacks const& stacks() const { return stacks_; }
+    unsigned long dropped() const { return dropped_.load(); }
+
+  private:
+    struct Half {
+      std::unique_ptr<Context[]> contexts;
+      std::unique_ptr<unsigned int[]> depths;
+      std::unique_ptr<std::uintptr_t[]> frames;
+      std::atomic<unsigned int> used{0};
+    };
+
+    // The handler only runs on this thread, between two of its
+    // instructions: once the active half is switched it does not touch
+    // the other one any more.
+    void switchHalves() {
+      auto old = active_.load(std::memory_order_relaxed);
+      active_.store(1 - old, std::memory_order_relaxed);
+      std::atomic_signal_fence(std::memory_order_acq_rel);
+      aggregate(halves_[old]);
+    }
+
+    void aggregate(Half& h) {
+      auto n = h.used.load(std::memory_order_relaxed);
+      Stack stack;
+      for (unsigned int i = 0; i < n; ++i) {
+        stack.clear();
+        stack.push_back(h.contexts[i]);
+        std::uintptr_t const* frames = &h.frames[std::size_t(i) * maxDepth_];
+        int depth = h.depths[i];
+        // the first frame is the interrupted instruction, the others are
+        // return addresses, moved back into the call
+        for (int f = depth - 1; f > 0; --f) {
+          stack.push_back(frames[f] - 1);
+        }
+        if (depth > 0) {
+          stack.push_back(frames[0]);
+        }
+        ++stacks_[stack];
+      }
+      std::atomic_signal_fence(std::memory_order_acq_rel);
+      h.used.store(0, std::memory_order_relaxed);
+    }
+
+    unsigned int const capacity_;
+    unsigned int const maxDepth_;
+    std::atomic<unsigned int> nesting_{0};
+    std::array<std::atomic<Context>, kMaxNesting> contexts_;
+    std::array<Half, 2> halves_;
+    std::atomic<unsigned int> active_{0};
+    std::atomic<unsigned long> dropped_{0};
+    Stacks stacks_;
+  };
+
+  //===============================================================
+  // The samples of the threads by thread id, for the signal handler: a
+  // fixed open-addressing table, filled once per thread and never freed
+  // while sampling, emptied when the service owning the samples goes.
+  std::array<std::atomic<pid_t>, kMaxThreads> s_threadIDs;
+  std::array<std::atomic<ThreadSamples*>, kMaxThreads> s_threadSamples;
+  std::atomic<bool> s_sampling{false};
+  std::atomic<unsigned long> s_otherSamples{0};
+  // numbers the instances of the service, for the samples cached per thread
+  std::atomic<unsigned long> s_instances{0};
+
+  void clearThreads() {
+    for (unsigned int i = 0; i < kMaxThreads; ++i) {
+      s_threadSamples[i].store(nullptr, std::memory_order_relaxed);
+      s_threadIDs[i].store(0, std::memory_order_release);
+    }
+  }
+
+  bool registerThread(pid_t tid, ThreadSamples* samples) {
+    for (unsigned int k = 0; k < kMaxThreads; ++k) {
+      auto i = (unsigned(tid) + k) % kMaxThreads;
+      pid_t expected = 0;
+      if (s_threadIDs[i].compare_exchange_strong(expected, tid) or expected == tid) {
+        s_threadSamples[i].store(samples, std::memory_order_release);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  ThreadSamples* findThread(pid_t tid) {
+    for (unsigned int k = 0; k < kMaxThreads; ++k) {
+      auto i = (unsigned(tid) + k) % kMaxThreads;
+      auto id = s_threadIDs[i].load(std::memory_order_acquire);
+      if (id == tid) {
+        return s_threadSamples[i].load(std::memory_order_acquire);
+      }
+      if (id == 0) {
+        break;
+      }
+    }
+    return nullptr;
+  }
+
+  extern "C" void samplingProfilerHandler(int, siginfo_t*, void* uc) {
+    if (not s_sampling.load(std::memory_order_relaxed)) {
+      return;
+    }
+    int savedErrno = errno;
+    if (auto samples = findThread(threadID())) {
+      samples->sample(uc);
+    } else {
+      s_otherSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+    errno = savedErrno;
+  }
+
+  std::string symbolName(std::uintptr_t address) {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(address), &info) == 0) {
+      std::ostringstream os;
+      os << "0x" << std::hex << address;
+      return os.str();
+    }
+    if (info.dli_sname) {
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      std::string name(status == 0 ? demangled : info.dli_sname);
+      std::free(demangled);
+      return name;
+    }
+    // without a symbol the frames of a library are merged, the offsets
+    // would give a different frame per instruction
+    std::string library(info.dli_fname ? info.dli_fname : "");
+    return "[" + library.substr(library.rfind('/') + 1) + "]";
+  }
+
+  std::string const space{"  "};
+}
+
+namespace edm {
+  namespace service {
+
+    class SamplingProfiler {
+    public:
+      SamplingProfiler(ParameterSet const&, ActivityRegistry&);
+      ~SamplingProfiler();
+      static void fillDescriptions(ConfigurationDescriptions& descriptions);
+
+    private:
+      ThreadSamples& threadSamples();
+      void enter(std::uint32_t module, std::uint32_t stream) { threadSamples().push(makeContext(module, stream)); }
+      void leave() { threadSamples().pop(); }
+
+      void preModuleConstruction(ModuleDescription const&);
+      void preModule(ModuleDescription const& md) { enter(md.id(), kNoStream); }
+      void postModule(ModuleDescription const&) { leave(); }
+      void preModuleStream(StreamContext const& sc, ModuleCallingContext const& mcc) {
+        enter(mcc.moduleDescription()->id(), sc.streamID().value());
+      }
+      void postModuleStream(StreamContext const&, ModuleCallingContext const&) { leave(); }
+      void preModuleGlobal(GlobalContext const&, ModuleCallingContext const& mcc) {
+        enter(mcc.moduleDescription()->id(), kNoStream);
+      }
+      void postModuleGlobal(GlobalContext const&, ModuleCallingContext const&) { leave(); }
+      void preSourceEvent(StreamID sid) { enter(kSource, sid.value()); }
+      void postSourceEvent(StreamID) { leave(); }
+
+      void start();
+      void stop();
+      void postEndJob();
+      std::string moduleName(std::uint32_t module) const;
+
+      double const samplingPeriod_;
+      unsigned int const maxStackDepth_;
+      unsigned int const samplesPerThread_;
+      std::string const fileName_;
+      bool const perStream_;
+      unsigned long const instance_;
+
+      struct sigaction oldAction_;
+      bool started_ = false;
+
+      // label and type of the modules, by id
+      std::vector<std::pair<std::string, std::string>> modules_;
+
+      std::mutex threadsMutex_;
+      std::vector<std::unique_ptr<ThreadSamples>> threads_;
+    };
+
+    inline bool isProcessWideService(SamplingProfiler const*) { return true; }
+
+  }
+}
+
+using edm::service::SamplingProfiler;
+
+SamplingProfiler::SamplingProfiler(ParameterSet const& iPS, ActivityRegistry& iRegistry)
+  : samplingPeriod_{iPS.getUntrackedParameter<double>("samplingPeriod")},
+    maxStackDepth_{iPS.getUntrackedParameter<unsigned int>("maxStackDepth")},
+    samplesPerThread_{std::max(iPS.getUntrackedParameter<unsigned int>("samplesPerThread"), 2u)},
+    fileName_{iPS.getUntrackedParameter<std::string>("fileName")},
+    perStream_{iPS.getUntrackedParameter<bool>("perStream")},
+    instance_{++s_instances} {
+  iRegistry.watchPreModuleConstruction(this, &SamplingProfiler::preModuleConstruction);
+  iRegistry.watchPostModuleConstruction(this, &SamplingProfiler::postModule);
+  iRegistry.watchPreModuleBeginJob(this, &SamplingProfiler::preModule);
+  iRegistry.watchPostModuleBeginJob(this, &SamplingProfiler::postModule);
+  iRegistry.watchPreModuleEndJob(this, &SamplingProfiler::preModule);
+  iRegistry.watchPostModuleEndJob(this, &SamplingProfiler::postModule);
+
+  iRegistry.watchPreSourceEvent(this, &SamplingProfiler::preSourceEvent);
+  iRegistry.watchPostSourceEvent(this, &SamplingProfiler::postSourceEvent);
+
+  iRegistry.watchPreModuleEventAcquire(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleEventAcquire(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleEvent(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleEvent(this, &SamplingProfiler::postModuleStream);
+
+  iRegistry.watchPreModuleBeginStream(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleBeginStream(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleEndStream(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleEndStream(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleStreamBeginRun(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleStreamBeginRun(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleStreamEndRun(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleStreamEndRun(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleStreamBeginLumi(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleStreamBeginLumi(this, &SamplingProfiler::postModuleStream);
+  iRegistry.watchPreModuleStreamEndLumi(this, &SamplingProfiler::preModuleStream);
+  iRegistry.watchPostModuleStreamEndLumi(this, &SamplingProfiler::postModuleStream);
+
+  iRegistry.watchPreModuleGlobalBeginRun(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleGlobalBeginRun(this, &SamplingProfiler::postModuleGlobal);
+  iRegistry.watchPreModuleGlobalEndRun(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleGlobalEndRun(this, &SamplingProfiler::postModuleGlobal);
+  iRegistry.watchPreModuleWriteRun(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleWriteRun(this, &SamplingProfiler::postModuleGlobal);
+  iRegistry.watchPreModuleGlobalBeginLumi(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleGlobalBeginLumi(this, &SamplingProfiler::postModuleGlobal);
+  iRegistry.watchPreModuleGlobalEndLumi(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleGlobalEndLumi(this, &SamplingProfiler::postModuleGlobal);
+  iRegistry.watchPreModuleWriteLumi(this, &SamplingProfiler::preModuleGlobal);
+  iRegistry.watchPostModuleWriteLumi(this, &SamplingProfiler::postModuleGlobal);
+
+  iRegistry.watchPostEndJob(this, &SamplingProfiler::postEndJob);
+
+  start();
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  stop();
+  // no handler runs any more, the samples of the threads can go
+  clearThreads();
+}
+
+void SamplingProfiler::fillDescriptions(ConfigurationDescriptions& descriptions) {
+  ParameterSetDescription desc;
+  desc.addUntracked<double>("samplingPeriod", 10.)
+      ->setComment("CPU time of the process between two samples, in milliseconds.");
+  desc.addUntracked<unsigned int>("maxStackDepth", 64)
+      ->setComment("Maximum number of frames recorded per sample. With 0, the samples are only\n"
+                   "attributed to the modules, without their stacks.");
+  desc.addUntracked<unsigned int>("samplesPerThread", 8192)
+      ->setComment("Number of samples a thread can hold before aggregating them, which it\n"
+                   "does between two modules. Samples beyond it are dropped and counted.");
+  desc.addUntracked<std::string>("fileName", "samplingProfile.folded")
+      ->setComment("File to which the stacks are written in the folded format of flamegraph.pl,\n"
+                   "with the module label as the root frame. An empty name writes only the\n"
+                   "per-module summary to the log.");
+  desc.addUntracked<bool>("perStream", false)
+      ->setComment("Put the stream above the module label in the stacks of the file.");
+  descriptions.add("SamplingProfiler", desc);
+  descriptions.setComment(
+      "This service samples the CPU time of the process and attributes the samples to the\n"
+      "module and stream running on the interrupted thread.");
+}
+
+ThreadSamples& SamplingProfiler::threadSamples() {
+  // the samples of this thread for this instance of the service, an
+  // instance made later in the process gets its own
+  static thread_local std::pair<unsigned long, ThreadSamples*> cache{0, nullptr};
+  auto& samples = cache.second;
+  if (cache.first != instance_) {
+    auto s = std::make_unique<ThreadSamples>(samplesPerThread_ / 2, maxStackDepth_);
+    cache.first = instance_;
+    samples = s.get();
+    {
+      std::lock_guard<std::mutex> guard(threadsMutex_);
+      threads_.push_back(std::move(s));
+    }
+    if (not registerThread(threadID(), samples)) {
+      edm::LogWarning("SamplingProfiler") << "Too many threads, the samples of thread " << threadID()
+                                          << " are not attributed";
+    }
+  }
+  return *samples;
+}
+
+void SamplingProfiler::preModuleConstruction(ModuleDescription const& md) {
+  auto const mid = md.id();
+  if (mid >= modules_.size()) {
+    modules_.resize(mid + 1);
+  }
+  modules_[mid] = std::make_pair(md.moduleLabel(), md.moduleName());
+  enter(mid, kNoStream);
+}
+
+void SamplingProfiler::start() {
+  // a per-thread cache of the unwind information needs no lock in the
+  // handler; libunwind initialises itself at the first unwinding, which
+  // must not happen in the handler
+  unw_set_caching_policy(unw_local_addr_space, UNW_CACHE_PER_THREAD);
+  if (maxStackDepth_ > 0) {
+    unw_context_t context;
+    unw_getcontext(&context);
+    std::uintptr_t frames[2];
+    unwind(&context, 0, frames, 2);
+  }
+
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_sigaction = samplingProfilerHandler;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &oldAction_) != 0) {
+    throw edm::Exception(edm::errors::Configuration) << "SamplingProfiler: cannot install the SIGPROF handler";
+  }
+  if ((oldAction_.sa_flags & SA_SIGINFO) or
+      (oldAction_.sa_handler != SIG_DFL and oldAction_.sa_handler != SIG_IGN)) {
+    sigaction(SIGPROF, &oldAction_, nullptr);
+    throw edm::Exception(edm::errors::Configuration)
+        << "SamplingProfiler: SIGPROF is already used by another profiler";
+  }
+
+  long period = std::max(1l, long(samplingPeriod_ * 1000));
+  struct itimerval timer;
+  timer.it_interval.tv_sec = period / 1000000;
+  timer.it_interval.tv_usec = period % 1000000;
+  timer.it_value = timer.it_interval;
+  s_otherSamples = 0;
+  s_sampling = true;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  started_ = true;
+}
+
+void SamplingProfiler::stop() {
+  if (not started_) {
+    return;
+  }
+  struct itimerval timer;
+  std::memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  s_sampling = false;
+  // a SIGPROF generated before the timer was disarmed may still be pending
+  // for the process: take it, with the signal blocked in this thread,
+  // before giving the signal back to its previous action, which may be to
+  // terminate the process
+  sigset_t prof, mask;
+  sigemptyset(&prof);
+  sigaddset(&prof, SIGPROF);
+  pthread_sigmask(SIG_BLOCK, &prof, &mask);
+  struct timespec const noWait = {0, 0};
+  while (sigtimedwait(&prof, nullptr, &noWait) == SIGPROF) {
+  }
+  sigaction(SIGPROF, &oldAction_, nullptr);
+  pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+  started_ = false;
+}
+
+std::string SamplingProfiler::moduleName(std::uint32_t module) const {
+  if (module == kNoModule) {
+    return "(framework)";
+  }
+  if (module == kSource) {
+    return "(source)";
+  }
+  if (module < modules_.size()) {
+    return modules_[module].first;
+  }
+  return "(unknown)";
+}
+
+void SamplingProfiler::postEndJob() {
+  stop();
+
+  // all the stacks, and the samples per module and per stream
+  Stacks stacks;
+  unsigned long total = 0, dropped = 0;
+  std::map<std::uint32_t, unsigned long> perModule;
+  std::map<std::uint32_t, unsigned long> perStream;
+  {
+    std::lock_guard<std::mutex> guard(threadsMutex_);
+    for (auto& t : threads_) {
+      t->aggregateAll();
+      dropped += t->dropped();
+      for (auto const& s : t->stacks()) {
+        stacks[s.first] += s.second;
+        total += s.second;
+        perModule[contextModule(s.first[0])] += s.second;
+        perStream[contextStream(s.first[0])] += s.second;
+      }
+    }
+  }
+  auto other = s_otherSamples.load();
+
+  if (not fileName_.empty()) {
+    std::ofstream file(fileName_);
+    std::unordered_map<std::uintptr_t, std::string> symbols;
+    for (auto const& s : stacks) {
+      auto context = s.first[0];
+      if (perStream_) {
+        auto stream = contextStream(context);
+        if (stream == kNoStream) {
+          file << "(global);";
+        } else {
+          file << "stream " << stream << ';';
+        }
+      }
+      file << moduleName(contextModule(context));
+      for (std::size_t f = 1; f < s.first.size(); ++f) {
+        auto i = symbols.find(s.first[f]);
+        if (i == symbols.end()) {
+          i = symbols.emplace(s.first[f], symbolName(s.first[f])).first;
+        }
+        file << ';' << i->second;
+      }
+      file << ' ' << s.second << '\n';
+    }
+    if (not file) {
+      edm::LogError("SamplingProfiler") << "Cannot write the profile to " << fileName_;
+    }
+  }
+
+  std::vector<std::pair<unsigned long, std::uint32_t>> modules;
+  std::size_t width = std::string("Module label").size();
+  for (auto const& m : perModule) {
+    modules.emplace_back(m.second, m.first);
+    width = std::max(width, moduleName(m.first).size());
+  }
+  std::sort(modules.rbegin(), modules.rend());
+
+  OStreamColumn tag{"SamplingProfiler>"};
+  OStreamColumn col1{"Module label", width};
+  OStreamColumn col2{"Module type", 24};
+  OStreamColumn col3{"Samples", 10};
+  OStreamColumn col4{"Fraction", 9};
+
+  LogAbsolute out{"SamplingProfiler"};
+  out << '\n';
+  out << tag << space << total << " samples, one per " << samplingPeriod_ << " ms of CPU time";
+  if (dropped or other) {
+    out << " (" << dropped << " dropped, " << other << " in threads outside the framework)";
+  }
+  out << '\n';
+  out << tag << space << col1 << space << col2 << space << col3 << space << col4 << '\n';
+  out << tag << space << std::setfill('-') << col1(std::string{}) << space << col2(std::string{}) << space
+      << col3(std::string{}) << space << col4(std::string{}) << '\n';
+  out << std::setfill(' ');
+  for (auto const& m : modules) {
+    std::string type = m.second < modules_.size() ? modules_[m.second].second : std::string{};
+    std::ostringstream fraction;
+    fraction << std::fixed << std::setprecision(1) << 100. * m.first / std::max(total, 1ul) << " %";
+    out << std::left << tag << space << col1(moduleName(m.second)) << space << col2(type) << space << std::right
+        << col3(m.first) << space << col4(fraction.str()) << '\n';
+  }
+  out << tag << space << "Samples per stream:";
+  for (auto const& s : perStream) {
+    if (s.first == kNoStream) {
+      out << space << "global " << s.second;
+    } else {
+      out << space << s.first << ' ' << s.second;
+    }
+  }
+  out << '\n';
+}
+
+DEFINE_FWK_SERVICE(SamplingProfiler);
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# Pass in name and status
+function die { echo $1: status $2 ;  exit $2; }
+
+F1=${LOCAL_TEST_DIR}/test_samplingprofiler_cfg.py
+
+(cmsRun $F1 ) || die "Failure using $F1" $?
+
+# the busy module must have most of the samples, its stacks rooted at its label
+[ -s samplingProfile.folded ] || die "No profile written" 1
+BUSY=$(awk -F'[; ]' '$1 == "busy" { n += $NF } END { print n+0 }' samplingProfile.folded)
+LIGHT=$(awk -F'[; ]' '$1 == "light" { n += $NF } END { print n+0 }' samplingProfile.folded)
+[ "$BUSY" -gt "$LIGHT" ] || die "Samples not attributed to the busy module ($BUSY, $LIGHT)" 1
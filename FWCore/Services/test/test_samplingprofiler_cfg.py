@@ -0,0 +1,19 @@
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process("TEST")
+
+process.source = cms.Source("EmptySource")
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(20))
+
+process.options = cms.untracked.PSet(numberOfThreads = cms.untracked.uint32(2),
+                                     numberOfStreams = cms.untracked.uint32(2))
+
+process.busy = cms.EDProducer("BusyWaitIntProducer", ivalue = cms.int32(1), iterations = cms.uint32(10*1000*1000))
+process.light = cms.EDProducer("BusyWaitIntProducer", ivalue = cms.int32(2), iterations = cms.uint32(1000))
+
+process.p = cms.Path(process.busy+process.light)
+
+process.add_(cms.Service("SamplingProfiler",
+                         samplingPeriod = cms.untracked.double(1.),
+                         fileName = cms.untracked.string("samplingProfile.folded")))
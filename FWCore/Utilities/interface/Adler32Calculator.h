@@ -13,5 +13,12 @@ namespace cms {
 
   void Adler32(char const* data, size_t len, uint32_t& a, uint32_t& b);
   uint32_t Adler32(char const* data, size_t len);
+
+  // The functions above use the AVX2 implementation when the CPU supports it.
+  // The individual implementations are exposed for validation and benchmarks;
+  // Adler32AVX2 falls back to the scalar code on non x86-64 builds.
+  void Adler32Scalar(char const* data, size_t len, uint32_t& a, uint32_t& b);
+  void Adler32AVX2(char const* data, size_t len, uint32_t& a, uint32_t& b);
+  bool Adler32AVX2Available();
 }
 #endif
@@ -1,32 +1,118 @@
 #include "FWCore/Utilities/interface/Adler32Calculator.h"
 
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 namespace cms {
 
+  namespace {
+    constexpr uint32_t kModAdler = 65521;
+    // largest n such that 255n(n+1)/2 + (n+1)(kModAdler-1) <= 2^32-1
+    constexpr size_t kNMax = 5552;
+
+    bool avx2Available() {
+#if defined(__x86_64__)
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    typedef void (*Adler32Function)(char const*, size_t, uint32_t&, uint32_t&);
+
+    Adler32Function selectAdler32() {
+      return avx2Available() ? &Adler32AVX2 : &Adler32Scalar;
+    }
+  }
+
   //-------------------------------------------------------
   // the following is adapted from 
   // http://en.wikipedia.org/wiki/Adler-32
   //-------------------------------------------------------
   
   void
-  Adler32(char const* data, size_t len, uint32_t& a, uint32_t& b) {
+  Adler32Scalar(char const* data, size_t len, uint32_t& a, uint32_t& b) {
    /* data: Pointer to the data to be summed; len is in bytes */
   
-    #define MOD_ADLER 65521
-   
     unsigned char const* ptr = static_cast<unsigned char const*>(static_cast<void const*>(data));
     while (len > 0) {
-      size_t tlen = (len > 5552 ? 5552 : len);
+      size_t tlen = (len > kNMax ? kNMax : len);
       len -= tlen;
       do {
         a += *ptr++;
         b += a;
       } while (--tlen);
       
-      a %= MOD_ADLER;
-      b %= MOD_ADLER;
+      a %= kModAdler;
+      b %= kModAdler;
     }
-  
-    #undef MOD_ADLER
+  }
+
+#if defined(__x86_64__)
+  namespace {
+    __attribute__((target("avx2")))
+    inline uint32_t horizontalSum(__m256i v) {
+      __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_cvtsi128_si32(s);
+    }
+  }
+
+  // 32 bytes per iteration: the byte sums go to a with _mm256_sad_epu8, the
+  // position weighted sums to b with _mm256_maddubs_epi16. The 32*a term of
+  // each iteration is accumulated separately and added once per block, blocks
+  // being short enough (kNMax) for the 32 bit lanes not to overflow.
+  __attribute__((target("avx2")))
+  void
+  Adler32AVX2(char const* data, size_t len, uint32_t& a, uint32_t& b) {
+    unsigned char const* ptr = static_cast<unsigned char const*>(static_cast<void const*>(data));
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                             16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    constexpr size_t blockVectors = kNMax / 32;
+
+    while (len >= 32) {
+      size_t n = std::min(len / 32, blockVectors);
+      len -= n * 32;
+      __m256i vs1 = _mm256_setr_epi32(a, 0, 0, 0, 0, 0, 0, 0);
+      __m256i vs2 = _mm256_setr_epi32(b, 0, 0, 0, 0, 0, 0, 0);
+      __m256i vs1Sum = zero;
+      do {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+        vs1Sum = _mm256_add_epi32(vs1Sum, vs1);
+        vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(bytes, zero));
+        vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+        ptr += 32;
+      } while (--n);
+      vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(vs1Sum, 5));
+      a = horizontalSum(vs1) % kModAdler;
+      b = horizontalSum(vs2) % kModAdler;
+    }
+    if (len > 0) {
+      Adler32Scalar(static_cast<char const*>(static_cast<void const*>(ptr)), len, a, b);
+    }
+  }
+#else
+  void
+  Adler32AVX2(char const* data, size_t len, uint32_t& a, uint32_t& b) {
+    Adler32Scalar(data, len, a, b);
+  }
+#endif
+
+  bool
+  Adler32AVX2Available() {
+    return avx2Available();
+  }
+
+  void
+  Adler32(char const* data, size_t len, uint32_t& a, uint32_t& b) {
+    static const Adler32Function adler32 = selectAdler32();
+    adler32(data, len, a, b);
   }
   
   uint32_t
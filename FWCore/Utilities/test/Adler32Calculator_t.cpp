@@ -0,0 +1,63 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "FWCore/Utilities/interface/Adler32Calculator.h"
+
+namespace {
+  // straightforward definition, one modulo per byte
+  uint32_t reference(unsigned char const* data, size_t len) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < len; ++i) {
+      a = (a + data[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+  }
+
+  uint32_t combine(uint32_t a, uint32_t b) { return (b << 16) | a; }
+}
+
+int main() {
+  std::mt19937 engine(12345);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<unsigned char> buffer(1 << 20);
+  for (auto& c : buffer) c = byte(engine);
+  // all 0xff bytes maximize the sums within a block
+  std::vector<unsigned char> ones(3 * 5552 + 77, 0xff);
+
+  std::cout << "AVX2 implementation " << (cms::Adler32AVX2Available() ? "" : "not ") << "available" << std::endl;
+
+  std::vector<size_t> lengths = {0, 1, 2, 31, 32, 33, 63, 64, 65, 5551, 5552, 5553, 5536, 5568, 65536, 100000, buffer.size() - 64};
+  std::uniform_int_distribution<size_t> randomLength(0, buffer.size() - 64);
+  for (int i = 0; i < 50; ++i) lengths.push_back(randomLength(engine));
+
+  for (auto len : lengths) {
+    for (size_t offset = 0; offset < 33; offset += 7) {
+      char const* data = reinterpret_cast<char const*>(&buffer[offset]);
+      const uint32_t expected = reference(&buffer[offset], len);
+      assert(cms::Adler32(data, len) == expected);
+
+      uint32_t a = 1, b = 0;
+      cms::Adler32Scalar(data, len, a, b);
+      assert(combine(a, b) == expected);
+
+      if (cms::Adler32AVX2Available()) {
+        a = 1, b = 0;
+        cms::Adler32AVX2(data, len, a, b);
+        assert(combine(a, b) == expected);
+
+        // incremental update in two pieces, as done by the streamer file writer
+        a = 1, b = 0;
+        cms::Adler32AVX2(data, len / 3, a, b);
+        cms::Adler32AVX2(data + len / 3, len - len / 3, a, b);
+        assert(combine(a, b) == expected);
+      }
+    }
+  }
+
+  char const* data = reinterpret_cast<char const*>(ones.data());
+  assert(cms::Adler32(data, ones.size()) == reference(ones.data(), ones.size()));
+  return 0;
+}
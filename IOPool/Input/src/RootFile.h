@@ -171,6 +171,7 @@ namespace edm {
     // RunNumber_t const& runNumber() const {return indexIntoFileIter().run();}
     EventID const& eventID() const {return eventAux().id();}
     RootTree const& eventTree() const {return eventTree_;}
+    void enableEventPrefetching(unsigned int nEntries) {eventTree_.enablePrefetchAhead(file_, nEntries);}
     RootTree const& lumiTree() const {return lumiTree_;}
     RootTree const& runTree() const {return runTree_;}
     FileFormatVersion fileFormatVersion() const {return fileFormatVersion_;}
@@ -0,0 +1,162 @@
+#include "RootPrefetcher.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "Utilities/StorageFactory/interface/IOFlags.h"
+#include "Utilities/StorageFactory/interface/IOPosBuffer.h"
+#include "Utilities/StorageFactory/interface/Storage.h"
+#include "Utilities/StorageFactory/interface/StorageAccount.h"
+#include "Utilities/StorageFactory/interface/StorageFactory.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace edm {
+  namespace {
+    // Ranges closer than this are merged into one request.
+    int64_t const maxGap = 64 * 1024;
+    // Upper bound on the bytes in flight for one vectored read.
+    size_t const bufferSize = 16 * 1024 * 1024;
+
+    StorageAccount::Counter* s_statsPrefetch = nullptr;
+    StorageAccount::Counter* s_statsReadv = nullptr;
+
+    inline StorageAccount::Counter&
+    storageCounter(StorageAccount::Counter*& c, StorageAccount::Operation operation) {
+      static auto const token = StorageAccount::tokenForStorageClassName("rootprefetcher");
+      if (!c) c = &StorageAccount::counter(token, operation);
+      return *c;
+    }
+  }
+
+  RootPrefetcher::RootPrefetcher(std::string const& fileName) :
+    fileName_(fileName),
+    storage_(),
+    buffer_(),
+    mutex_(),
+    cond_(),
+    pending_(),
+    hasPending_(false),
+    stop_(false),
+    useHint_(true),
+    enabled_(true),
+    thread_([this]() { run(); }) {
+  }
+
+  RootPrefetcher::~RootPrefetcher() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+  }
+
+  void
+  RootPrefetcher::request(std::vector<Range>&& ranges) {
+    if (!enabled_ || ranges.empty()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      pending_.swap(ranges);
+      hasPending_ = true;
+    }
+    cond_.notify_one();
+  }
+
+  bool
+  RootPrefetcher::hasPendingRequest() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return hasPending_ || stop_;
+  }
+
+  void
+  RootPrefetcher::run() {
+    std::vector<Range> ranges;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return stop_ || hasPending_; });
+        if (stop_) {
+          break;
+        }
+        ranges.swap(pending_);
+        pending_.clear();
+        hasPending_ = false;
+      }
+      if (!enabled_) {
+        continue;
+      }
+      try {
+        if (!storage_) {
+          storage_ = StorageFactory::get()->open(fileName_, IOFlags::OpenRead);
+        }
+        process(ranges);
+      } catch (cms::Exception const& e) {
+        enabled_ = false;
+        LogWarning("RootPrefetcher") << "Disabling prefetching for file " << fileName_ << ":\n" << e.what();
+      } catch (std::exception const& e) {
+        enabled_ = false;
+        LogWarning("RootPrefetcher") << "Disabling prefetching for file " << fileName_ << ":\n" << e.what();
+      }
+    }
+    storage_.reset();
+  }
+
+  void
+  RootPrefetcher::process(std::vector<Range>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](Range const& a, Range const& b) { return a.offset < b.offset; });
+    std::vector<IOPosBuffer> buffers;
+    buffers.reserve(ranges.size());
+    for (auto const& r : ranges) {
+      if (!buffers.empty() && r.offset <= static_cast<int64_t>(buffers.back().offset() + buffers.back().size()) + maxGap) {
+        IOOffset end = std::max<IOOffset>(buffers.back().offset() + buffers.back().size(), r.offset + r.length);
+        buffers.back().set_size(end - buffers.back().offset());
+      } else {
+        buffers.emplace_back(r.offset, static_cast<void*>(nullptr), r.length);
+      }
+    }
+
+    if (useHint_) {
+      IOSize bytes = 0;
+      for (auto const& b : buffers) bytes += b.size();
+      StorageAccount::Stamp stats(storageCounter(s_statsPrefetch, StorageAccount::Operation::prefetch));
+      if (storage_->prefetch(buffers.data(), buffers.size())) {
+        stats.tick(bytes, buffers.size());
+        return;
+      }
+      // The storage ignores hints; read the data instead, which fills the
+      // page cache or the cache of the storage system.
+      useHint_ = false;
+    }
+
+    if (buffer_.empty()) {
+      buffer_.resize(bufferSize);
+    }
+    std::vector<IOPosBuffer> batch;
+    size_t used = 0;
+    auto flush = [&]() {
+      if (batch.empty()) return;
+      StorageAccount::Stamp stats(storageCounter(s_statsReadv, StorageAccount::Operation::readv));
+      IOSize n = storage_->readv(batch.data(), batch.size());
+      stats.tick(n, batch.size());
+      batch.clear();
+      used = 0;
+    };
+    for (auto const& b : buffers) {
+      IOOffset offset = b.offset();
+      IOSize left = b.size();
+      while (left > 0) {
+        if (used == bufferSize) flush();
+        IOSize chunk = std::min<IOSize>(left, bufferSize - used);
+        batch.emplace_back(offset, &buffer_[used], chunk);
+        used += chunk;
+        offset += chunk;
+        left -= chunk;
+      }
+      // Stop early if a newer request is already waiting.
+      if (hasPendingRequest()) break;
+    }
+    flush();
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef IOPool_Input_RootPrefetcher_h
+#define IOPool_Input_RootPrefetcher_h
+
+/*----------------------------------------------------------------------
+
+RootPrefetcher.h // background reader warming the storage for upcoming baskets
+
+The prefetcher owns a dedicated thread and its own Storage handle on the
+input file. RootTree hands it the byte ranges of the baskets the next
+events will need; the thread sorts and coalesces them and issues them as
+a prefetch hint, or as vectored reads when the storage ignores hints, so
+that by the time ROOT asks for the baskets they are already in the page
+cache (or in the cache of the storage system). Only the latest request
+is kept: if the reader is behind, stale ranges are dropped.
+
+----------------------------------------------------------------------*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Storage;
+
+namespace edm {
+  class RootPrefetcher {
+  public:
+    struct Range {
+      int64_t offset;
+      int64_t length;
+    };
+
+    explicit RootPrefetcher(std::string const& fileName);
+    ~RootPrefetcher();
+
+    RootPrefetcher(RootPrefetcher const&) = delete; // Disallow copying and moving
+    RootPrefetcher& operator=(RootPrefetcher const&) = delete; // Disallow copying and moving
+
+    // Replaces any pending request; never blocks on I/O.
+    void request(std::vector<Range>&& ranges);
+
+    bool enabled() const {return enabled_;}
+
+  private:
+    void run();
+    void process(std::vector<Range>& ranges);
+    bool hasPendingRequest();
+
+    std::string const fileName_;
+    std::unique_ptr<Storage> storage_;
+    std::vector<char> buffer_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Range> pending_;
+    bool hasPending_;
+    bool stop_;
+    bool useHint_;
+    std::atomic<bool> enabled_;
+    std::thread thread_;
+  };
+}
+#endif
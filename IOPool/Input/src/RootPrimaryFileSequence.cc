@@ -33,7 +33,8 @@ namespace edm {
     treeCacheSize_(noEventSort_ ? pset.getUntrackedParameter<unsigned int>("cacheSize") : 0U),
     duplicateChecker_(new DuplicateChecker(pset)),
     usingGoToEvent_(false),
-    enablePrefetching_(false) {
+    enablePrefetching_(false),
+    prefetchEntries_(pset.getUntrackedParameter<unsigned int>("prefetchEntries")) {
 
     // The SiteLocalConfig controls the TTreeCache size and the prefetching settings.
     Service<SiteLocalConfig> pSLC;
@@ -114,7 +115,7 @@ namespace edm {
   RootPrimaryFileSequence::RootFileSharedPtr
   RootPrimaryFileSequence::makeRootFile(std::shared_ptr<InputFile> filePtr) {
       size_t currentIndexIntoFile = sequenceNumberOfFile();
-      return std::make_shared<RootFile>(
+      auto file = std::make_shared<RootFile>(
           fileName(),
           input_.processConfiguration(),
           logicalFileName(),
@@ -144,6 +145,10 @@ namespace edm {
           input_.labelRawDataLikeMC(),
           usingGoToEvent_,
           enablePrefetching_);
+      if(prefetchEntries_ != 0U) {
+        file->enableEventPrefetching(prefetchEntries_);
+      }
+      return file;
   }
 
   bool RootPrimaryFileSequence::nextFile() {
@@ -330,6 +335,9 @@ namespace edm {
                      "Note 3: Any sorting occurs independently in each input file (no sorting across input files).");
     desc.addUntracked<unsigned int>("cacheSize", roottree::defaultCacheSize)
         ->setComment("Size of ROOT TTree prefetch cache.  Affects performance.");
+    desc.addUntracked<unsigned int>("prefetchEntries", 0U)
+        ->setComment("If non-zero, a background thread reads ahead the baskets of this many upcoming events\n"
+                     "for the branches the job has read so far.  Mostly useful on remote or spinning storage.");
     std::string defaultString("permissive");
     desc.addUntracked<std::string>("branchesMustMatch", defaultString)
         ->setComment("'strict':     Branches in each input file must match those in the first file.\n"
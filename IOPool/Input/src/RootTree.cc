@@ -7,7 +7,9 @@
 #include "TTree.h"
 #include "TTreeIndex.h"
 #include "TTreeCache.h"
+#include "TMath.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -24,6 +26,27 @@ namespace edm {
       TBranch* branch = tree->GetBranch(BranchTypeToBranchEntryInfoBranchName(branchType).c_str());
       return branch;
     }
+    // Appends the file ranges of the baskets of branch and of all its sub-branches
+    // holding entries in [first, last).
+    void addBasketRanges(TBranch* branch, roottree::EntryNumber first, roottree::EntryNumber last, std::vector<RootPrefetcher::Range>& ranges) {
+      Int_t const nBaskets = branch->GetWriteBasket();
+      Long64_t const* basketEntry = branch->GetBasketEntry();
+      Int_t const* basketBytes = branch->GetBasketBytes();
+      if (nBaskets > 0 && basketEntry != nullptr && basketBytes != nullptr) {
+        for (Long64_t i = std::max(0LL, TMath::BinarySearch(static_cast<Long64_t>(nBaskets), basketEntry, first));
+             i < nBaskets && basketEntry[i] < last; ++i) {
+          Long64_t seek = branch->GetBasketSeek(i);
+          // A zero seek is a basket kept in memory with the tree header.
+          if (seek > 0 && basketBytes[i] > 0) {
+            ranges.push_back(RootPrefetcher::Range{seek, basketBytes[i]});
+          }
+        }
+      }
+      TObjArray* subBranches = branch->GetListOfBranches();
+      for (Int_t i = 0, n = subBranches->GetEntriesFast(); i < n; ++i) {
+        addBasketRanges(static_cast<TBranch*>(subBranches->UncheckedAt(i)), first, last, ranges);
+      }
+    }
   }
   RootTree::RootTree(std::shared_ptr<InputFile> filePtr,
                      BranchType const& branchType,
@@ -58,6 +81,10 @@ namespace edm {
     enablePrefetching_(enablePrefetching),
     enableTriggerCache_(branchType_ == InEvent),
     rootDelayedReader_(new RootDelayedReader(*this, filePtr, inputType)),
+    prefetcher_(),
+    readSet_(),
+    prefetchEntries_(0U),
+    prefetchedUpTo_(-1),
     branchEntryInfoBranch_(metaTree_ ? getProductProvenanceBranch(metaTree_, branchType_) : (tree_ ? getProductProvenanceBranch(tree_, branchType_) : nullptr)),
     infoTree_(dynamic_cast<TTree*>(filePtr_.get() != nullptr ? filePtr->Get(BranchTypeToInfoTreeName(branchType).c_str()) : nullptr)) // backward compatibility
     {
@@ -239,6 +266,48 @@ namespace edm {
     if (treeCache_ && treeCache_->IsLearning() && switchOverEntry_ >= 0 && entryNumber_ >= switchOverEntry_) {
       stopTraining();
     }
+    if (prefetcher_) {
+      prefetchAhead(entryNumber_);
+    }
+  }
+
+  void
+  RootTree::enablePrefetchAhead(std::string const& fileName, unsigned int nEntries) {
+    if (nEntries == 0U || branchType_ != InEvent) {
+      return;
+    }
+    prefetchEntries_ = nEntries;
+    prefetchedUpTo_ = -1;
+    readSet_.clear();
+    prefetcher_ = std::make_unique<RootPrefetcher>(fileName);
+  }
+
+  void
+  RootTree::prefetchAhead(EntryNumber entry) {
+    if (entry < 0 || entry >= entries_ || readSet_.empty() || !prefetcher_->enabled()) {
+      return;
+    }
+    EntryNumber const window = prefetchEntries_;
+    if (entry + 1 < prefetchedUpTo_ - window) {
+      // Backward jump: what was requested is no longer ahead of us.
+      prefetchedUpTo_ = -1;
+    }
+    // Refill when half of the window has been consumed, so requests are issued
+    // in batches rather than once per event.
+    if (entry + window / 2 < prefetchedUpTo_) {
+      return;
+    }
+    EntryNumber const first = std::max(entry + 1, prefetchedUpTo_);
+    EntryNumber const last = std::min(entry + 1 + window, entries_);
+    if (first >= last) {
+      return;
+    }
+    std::vector<RootPrefetcher::Range> ranges;
+    for (auto branch : readSet_) {
+      addBasketRanges(branch, first, last, ranges);
+    }
+    prefetchedUpTo_ = last;
+    prefetcher_->request(std::move(ranges));
   }
 
   // The actual implementation is done below; it's split in this strange
@@ -355,6 +424,9 @@ namespace edm {
 
   void
   RootTree::getEntry(TBranch* branch, EntryNumber entryNumber) const {
+    if (prefetcher_) {
+      readSet_.insert(branch);
+    }
     try {
       TTreeCache * cache = selectCache(branch, entryNumber);
       filePtr_->SetCacheRead(cache);
@@ -437,6 +509,9 @@ namespace edm {
     // The TFile is about to be closed, and destructed.
     // Just to play it safe, zero all pointers to quantities that are owned by the TFile.
     auxBranch_  = branchEntryInfoBranch_ = nullptr;
+    // Stop the prefetcher before the branches it refers to go away.
+    prefetcher_.reset();
+    readSet_.clear();
     tree_ = metaTree_ = infoTree_ = nullptr;
     // We own the treeCache_.
     // We make sure the treeCache_ is detached from the file,
@@ -12,6 +12,7 @@ RootTree.h // used by ROOT input sources
 #include "DataFormats/Provenance/interface/ProvenanceFwd.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Utilities/interface/InputType.h"
+#include "RootPrefetcher.h"
 
 #include "Rtypes.h"
 #include "TBranch.h"
@@ -166,11 +167,16 @@ namespace edm {
     void setSignals(signalslot::Signal<void(StreamContext const&, ModuleCallingContext const&)> const* preEventReadSource,
                     signalslot::Signal<void(StreamContext const&, ModuleCallingContext const&)> const* postEventReadSource);
 
+    // Start a background reader that fetches the baskets of the next nEntries entries
+    // for every branch read so far.
+    void enablePrefetchAhead(std::string const& fileName, unsigned int nEntries);
+
   private:
     void setCacheSize(unsigned int cacheSize);
     void setTreeMaxVirtualSize(int treeMaxVirtualSize);
     void startTraining();
     void stopTraining();
+    void prefetchAhead(EntryNumber entry);
 
     std::shared_ptr<InputFile> filePtr_;
 // We use bare pointers for pointers to some ROOT entities.
@@ -206,6 +212,12 @@ namespace edm {
     bool enablePrefetching_;
     bool enableTriggerCache_;
     std::unique_ptr<RootDelayedReader> rootDelayedReader_;
+// Background reader for upcoming baskets.  Branches enter readSet_ when they are first read,
+// so the lookahead covers exactly the products the job consumes.
+    std::unique_ptr<RootPrefetcher> prefetcher_;
+    mutable std::unordered_set<TBranch*> readSet_;
+    unsigned int prefetchEntries_;
+    EntryNumber prefetchedUpTo_;
 
     TBranch* branchEntryInfoBranch_; //backwards compatibility
     // below for backward compatibility
@@ -0,0 +1,22 @@
+# Same as PoolInputTest_cfg.py, with the background basket prefetcher enabled
+
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process("TESTRECO")
+process.load("FWCore.Framework.test.cmsExceptionsFatal_cff")
+
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(-1)
+)
+process.OtherThing = cms.EDProducer("OtherThingProducer")
+
+process.Analysis = cms.EDAnalyzer("OtherThingAnalyzer")
+
+process.source = cms.Source("PoolSource",
+    setRunNumber = cms.untracked.uint32(621),
+    prefetchEntries = cms.untracked.uint32(4),
+    fileNames = cms.untracked.vstring('file:PoolInputTest.root', 
+        'file:PoolInputOther.root')
+)
+
+process.p = cms.Path(process.OtherThing*process.Analysis)
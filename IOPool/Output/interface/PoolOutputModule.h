@@ -53,6 +53,7 @@ namespace edm {
     std::string const& basketOrder() const {return basketOrder_;}
     int const& treeMaxVirtualSize() const {return treeMaxVirtualSize_;}
     bool const& overrideInputFileSplitLevels() const {return overrideInputFileSplitLevels_;}
+    bool concurrentBranchFill() const {return concurrentBranchFill_;}
     DropMetaData const& dropMetaData() const {return dropMetaData_;}
     std::string const& catalog() const {return catalog_;}
     std::string const& moduleLabel() const {return moduleLabel_;}
@@ -193,6 +194,7 @@ namespace edm {
     BranchChildren branchChildren_;
     std::vector<BranchID> producedBranches_;
     bool overrideInputFileSplitLevels_;
+    bool const concurrentBranchFill_;
     edm::propagate_const<std::unique_ptr<RootOutputFile>> rootOutputFile_;
     std::string statusFileName_;
   };
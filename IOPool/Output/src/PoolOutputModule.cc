@@ -62,6 +62,7 @@ namespace edm {
     branchParents_(),
     branchChildren_(),
     overrideInputFileSplitLevels_(pset.getUntrackedParameter<bool>("overrideInputFileSplitLevels")),
+    concurrentBranchFill_(pset.getUntrackedParameter<bool>("concurrentBranchFill")),
     rootOutputFile_(),
     statusFileName_() {
 
@@ -457,6 +458,10 @@ namespace edm {
     desc.addUntracked<bool>("overrideInputFileSplitLevels", false)
         ->setComment("False: Use branch split levels and basket sizes from input file, if possible.\n"
                      "True:  Always use specified or default split levels and basket sizes.");
+    desc.addUntracked<bool>("concurrentBranchFill", false)
+        ->setComment("True:  Compress and flush the baskets of different event branches concurrently as TBB tasks (ROOT implicit MT),\n"
+                     "       writing them back to the file in branch order.\n"
+                     "False: Leave the event TTree with ROOT's default setting.");
     desc.addUntracked<bool>("writeStatusFile", false)
         ->setComment("Write a status file. Intended for use by workflow management.");
     desc.addUntracked<std::string>("dropMetaData", defaultString)
@@ -122,6 +122,9 @@ namespace edm {
     if (-1 != om->eventAutoFlushSize()) {
       eventTree_.setAutoFlush(-1*om->eventAutoFlushSize());
     }
+    // Set explicitly either way, since ROOT enables implicit MT on new trees
+    // whenever it is enabled globally.
+    eventTree_.setConcurrentFill(om_->concurrentBranchFill());
     eventTree_.addAuxiliary<EventAuxiliary>(BranchTypeToAuxiliaryBranchName(InEvent),
                                             pEventAux_, om_->auxItems()[InEvent].basketSize_);
     eventTree_.addAuxiliary<StoredProductProvenanceVector>(BranchTypeToProductProvenanceBranchName(InEvent),
@@ -20,6 +20,8 @@
 #include "Rtypes.h"
 #include "RVersion.h"
 
+#include "tbb/task_arena.h"
+
 #include <limits>
 
 namespace edm {
@@ -97,7 +99,8 @@ namespace edm {
       unclonedReadBranches_(),
       clonedReadBranchNames_(),
       currentlyFastCloning_(),
-      fastCloneAuxBranches_(false) {
+      fastCloneAuxBranches_(false),
+      concurrentFill_(false) {
 
     if(treeMaxVirtualSize >= 0) tree_->SetMaxVirtualSize(treeMaxVirtualSize);
   }
@@ -288,7 +291,18 @@ namespace edm {
 
   void
   RootOutputTree::writeTree() {
-    writeTTree(tree());
+    if(concurrentFill_) {
+      // The final flush also compresses baskets concurrently.
+      tbb::this_task_arena::isolate([this]{ writeTTree(tree()); });
+    } else {
+      writeTTree(tree());
+    }
+  }
+
+  void
+  RootOutputTree::setConcurrentFill(bool concurrentFill) {
+    concurrentFill_ = concurrentFill;
+    tree_->SetImplicitMT(concurrentFill);
   }
 
   void
@@ -318,6 +332,12 @@ namespace edm {
       fillTTree(unclonedAuxBranches_);
       fillTTree(producedBranches_);
       fillTTree(unclonedReadBranches_);
+    } else if(concurrentFill_) {
+      // With implicit MT, TTree::Fill serializes each branch on this thread but compresses
+      // full baskets (and, at auto flush, all baskets) in TBB tasks, then writes them back
+      // in branch order.  Isolate the wait so that this thread cannot pick up unrelated
+      // framework tasks while the output module holds its shared resource.
+      tbb::this_task_arena::isolate([this]{ tree_->Fill(); });
     } else {
       tree_->Fill();
     }
@@ -108,6 +108,9 @@ namespace edm {
     void setAutoFlush(Long64_t size) {
       tree_->SetAutoFlush(size);
     }
+
+    // Let ROOT compress and flush the baskets of different branches as TBB tasks.
+    void setConcurrentFill(bool concurrentFill);
   private:
     static void fillTTree(std::vector<TBranch*> const& branches);
 // We use bare pointers for pointers to some ROOT entities.
@@ -125,6 +128,7 @@ namespace edm {
     std::set<std::string> clonedReadBranchNames_;
     bool currentlyFastCloning_;
     bool fastCloneAuxBranches_;
+    bool concurrentFill_;
   };
 }
 #endif
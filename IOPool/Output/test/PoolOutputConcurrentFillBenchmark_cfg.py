@@ -0,0 +1,38 @@
+# Output throughput benchmark for 'concurrentBranchFill'.
+# Copies the events of an existing RECO or AOD file without fast cloning, so that
+# every product is serialized and compressed again.
+#
+# Usage: cmsRun PoolOutputConcurrentFillBenchmark_cfg.py <input file> <threads> <True|False>
+# e.g. for threads in 8 16 32; do for c in False True; do
+#        /usr/bin/time cmsRun PoolOutputConcurrentFillBenchmark_cfg.py file:aod.root $threads $c; done; done
+
+import FWCore.ParameterSet.Config as cms
+from sys import argv
+
+process = cms.Process("COPY")
+
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(-1)
+)
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(int(argv[3])),
+    numberOfStreams = cms.untracked.uint32(0)
+)
+process.InitRootHandlers = cms.Service("InitRootHandlers",
+    EnableIMT = cms.untracked.bool(True)
+)
+process.Timing = cms.Service("Timing",
+    summaryOnly = cms.untracked.bool(True)
+)
+
+process.source = cms.Source("PoolSource",
+    fileNames = cms.untracked.vstring(argv[2])
+)
+
+process.output = cms.OutputModule("PoolOutputModule",
+    fileName = cms.untracked.string('file:PoolOutputConcurrentFillBenchmark.root'),
+    fastCloning = cms.untracked.bool(False),
+    concurrentBranchFill = cms.untracked.bool(argv[4] == 'True')
+)
+
+process.ep = cms.EndPath(process.output)
@@ -33,4 +33,7 @@ cmsRun ${LOCAL_TEST_DIR}/TestProvC_cfg.py || die 'Failure using TestProvC_cfg.py
 cmsRun ${LOCAL_TEST_DIR}/PoolOutputTestUnscheduled_cfg.py || die 'Failure using PoolOutputTestUnscheduled_cfg.py' $?
 cmsRun ${LOCAL_TEST_DIR}/PoolOutputTestUnscheduledRead_cfg.py || die 'Failure using PoolOutputTestUnscheduledRead_cfg.py' $?
 
+cmsRun ${LOCAL_TEST_DIR}/PoolOutputConcurrentFillTest_cfg.py || die 'Failure using PoolOutputConcurrentFillTest_cfg.py' $?
+cmsRun ${LOCAL_TEST_DIR}/PoolOutputConcurrentFillRead_cfg.py || die 'Failure using PoolOutputConcurrentFillRead_cfg.py' $?
+
 popd
@@ -18,13 +18,18 @@ namespace edm {
   class StreamerInputFile {
   public:
 
-    /**Reads a Streamer file */
+    /**Reads a Streamer file.
+       With memoryMapped, local files are mapped into memory and the event
+       records point directly into the mapping instead of a private buffer;
+       remote files are always read through the StorageFactory. */
     explicit StreamerInputFile(std::string const& name,
-      std::shared_ptr<EventSkipperByID> eventSkipperByID = std::shared_ptr<EventSkipperByID>());
+      std::shared_ptr<EventSkipperByID> eventSkipperByID = std::shared_ptr<EventSkipperByID>(),
+      bool memoryMapped = false);
 
     /** Multiple Streamer files */
     explicit StreamerInputFile(std::vector<std::string> const& names,
-      std::shared_ptr<EventSkipperByID> eventSkipperByID = std::shared_ptr<EventSkipperByID>());
+      std::shared_ptr<EventSkipperByID> eventSkipperByID = std::shared_ptr<EventSkipperByID>(),
+      bool memoryMapped = false);
 
     ~StreamerInputFile();
 
@@ -44,8 +49,11 @@ namespace edm {
   private:
 
     void openStreamerFile(std::string const& name);
+    bool mapStreamerFile(std::string const& name);
     IOSize readBytes(char* buf, IOSize nBytes);
     IOOffset skipBytes(IOSize nBytes);
+    char* mappedBytes(IOSize nBytes, IOSize& nGot);
+    void adviseMapping();
 
     void readStartMessage();
     int readEventMessage();
@@ -79,6 +87,14 @@ namespace edm {
     edm::propagate_const<std::unique_ptr<Storage>> storage_;
 
     bool endOfFile_;
+
+    bool memoryMapped_; /** Map local files instead of reading them */
+    bool fileMapped_;   /** The current file is mapped */
+    char* mapBase_;     /** Start of the mapping of the current file, or null */
+    IOOffset mapSize_;
+    IOOffset mapPosition_; /** Current read position in the mapping */
+    IOOffset mapAdvised_;  /** End of the region already advised for readahead */
+    IOOffset mapReleased_; /** End of the region already released */
   };
 }
 
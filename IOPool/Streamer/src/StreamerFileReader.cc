@@ -16,7 +16,8 @@ namespace edm {
       streamerNames_(pset.getUntrackedParameter<std::vector<std::string> >("fileNames")),
       streamReader_(),
       eventSkipperByID_(EventSkipperByID::create(pset).release()),
-      initialNumberOfEventsToSkip_(pset.getUntrackedParameter<unsigned int>("skipEvents")) {
+      initialNumberOfEventsToSkip_(pset.getUntrackedParameter<unsigned int>("skipEvents")),
+      memoryMapped_(pset.getUntrackedParameter<bool>("memoryMapped")) {
     InputFileCatalog catalog(pset.getUntrackedParameter<std::vector<std::string> >("fileNames"), pset.getUntrackedParameter<std::string>("overrideCatalog"));
     streamerNames_ = catalog.fileNames();
     reset_();
@@ -29,9 +30,9 @@ namespace edm {
   void
   StreamerFileReader::reset_() {
     if (streamerNames_.size() > 1) {
-      streamReader_ = std::make_unique<StreamerInputFile>(streamerNames_, eventSkipperByID());
+      streamReader_ = std::make_unique<StreamerInputFile>(streamerNames_, eventSkipperByID(), memoryMapped_);
     } else if (streamerNames_.size() == 1) {
-      streamReader_ = std::make_unique<StreamerInputFile>(streamerNames_.at(0), eventSkipperByID());
+      streamReader_ = std::make_unique<StreamerInputFile>(streamerNames_.at(0), eventSkipperByID(), memoryMapped_);
     } else {
       throw Exception(errors::FileReadError, "StreamerFileReader::StreamerFileReader")
          << "No fileNames were specified\n";
@@ -115,6 +116,8 @@ namespace edm {
     desc.addUntracked<unsigned int>("skipEvents", 0U)
         ->setComment("Skip the first 'skipEvents' events that otherwise would have been processed.");
     desc.addUntracked<std::string>("overrideCatalog", std::string());
+    desc.addUntracked<bool>("memoryMapped", false)
+        ->setComment("If True, local files are memory mapped and events are deserialized in place instead of being read into a buffer first.");
     //This next parameter is read in the base class, but its default value depends on the derived class, so it is set here.
     desc.addUntracked<bool>("inputFileTransitionsEachEvent", false);
     StreamerInputSource::fillDescription(desc);
@@ -41,6 +41,7 @@ namespace edm {
     edm::propagate_const<std::unique_ptr<StreamerInputFile>> streamReader_;
     edm::propagate_const<std::shared_ptr<EventSkipperByID>> eventSkipperByID_;
     int initialNumberOfEventsToSkip_;
+    bool memoryMapped_;
   };
 } //end-of-namespace-def
 
@@ -10,17 +10,31 @@
 #include "Utilities/StorageFactory/interface/IOFlags.h"
 #include "Utilities/StorageFactory/interface/StorageFactory.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace edm {
 
+  namespace {
+    // Size of the readahead requested ahead of the read position in a mapped file.
+    IOOffset const mapReadAhead = 64 * 1024 * 1024;
+  }
+
   StreamerInputFile::~StreamerInputFile() {
     closeStreamerFile();
   }
 
   StreamerInputFile::StreamerInputFile(std::string const& name,
-                                       std::shared_ptr<EventSkipperByID> eventSkipperByID) :
+                                       std::shared_ptr<EventSkipperByID> eventSkipperByID,
+                                       bool memoryMapped) :
     startMsg_(),
     currentEvMsg_(),
     headerBuf_(1000*1000),
@@ -35,13 +49,21 @@ namespace edm {
     currProto_(0),
     newHeader_(false),
     storage_(),
-    endOfFile_(false) {
+    endOfFile_(false),
+    memoryMapped_(memoryMapped),
+    fileMapped_(false),
+    mapBase_(nullptr),
+    mapSize_(0),
+    mapPosition_(0),
+    mapAdvised_(0),
+    mapReleased_(0) {
     openStreamerFile(name);
     readStartMessage();
   }
 
   StreamerInputFile::StreamerInputFile(std::vector<std::string> const& names,
-                                       std::shared_ptr<EventSkipperByID> eventSkipperByID) :
+                                       std::shared_ptr<EventSkipperByID> eventSkipperByID,
+                                       bool memoryMapped) :
     startMsg_(),
     currentEvMsg_(),
     headerBuf_(1000*1000),
@@ -55,7 +77,15 @@ namespace edm {
     currRun_(0),
     currProto_(0),
     newHeader_(false),
-    endOfFile_(false) {
+    storage_(),
+    endOfFile_(false),
+    memoryMapped_(memoryMapped),
+    fileMapped_(false),
+    mapBase_(nullptr),
+    mapSize_(0),
+    mapPosition_(0),
+    mapAdvised_(0),
+    mapReleased_(0) {
     openStreamerFile(names.at(0));
     ++currentFile_;
     readStartMessage();
@@ -73,6 +103,11 @@ namespace edm {
 
     IOOffset size = -1;
     if(StorageFactory::get()->check(name, &size)) {
+      if(memoryMapped_ && mapStreamerFile(name)) {
+        currentFileOpen_ = true;
+        logFileAction("  Successfully mapped file ");
+        return;
+      }
       try {
         storage_ =StorageFactory::get()->open(name,
                                                    IOFlags::OpenRead);
@@ -93,17 +128,102 @@ namespace edm {
     logFileAction("  Successfully opened file ");
   }
 
+  bool
+  StreamerInputFile::mapStreamerFile(std::string const& name) {
+    // Only plain local files can be mapped; anything else goes through the StorageFactory.
+    std::string path = name;
+    if(path.compare(0, 5, "file:") == 0) {
+      path.erase(0, 5);
+    } else if(path.find(':') != std::string::npos && path.find(':') < path.find('/')) {
+      return false;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw Exception(errors::FileOpenError, "StreamerInputFile::mapStreamerFile")
+        << "Error Opening Streamer Input File: " << name << "\n"
+        << "open() failed: " << std::strerror(errno) << "\n";
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+      int err = errno;
+      ::close(fd);
+      throw Exception(errors::FileOpenError, "StreamerInputFile::mapStreamerFile")
+        << "Error Opening Streamer Input File: " << name << "\n"
+        << "fstat() failed: " << std::strerror(err) << "\n";
+    }
+    mapSize_ = st.st_size;
+    mapPosition_ = mapAdvised_ = mapReleased_ = 0;
+    if(mapSize_ > 0) {
+      void* base = ::mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(base == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        throw Exception(errors::FileOpenError, "StreamerInputFile::mapStreamerFile")
+          << "Error Opening Streamer Input File: " << name << "\n"
+          << "mmap() failed: " << std::strerror(err) << "\n";
+      }
+      mapBase_ = static_cast<char*>(base);
+      ::madvise(mapBase_, mapSize_, MADV_SEQUENTIAL);
+      adviseMapping();
+    }
+    // An empty file has nothing to map; reads simply return no data.
+    ::close(fd);
+    fileMapped_ = true;
+    return true;
+  }
+
+  void
+  StreamerInputFile::adviseMapping() {
+    IOOffset const pageSize = ::sysconf(_SC_PAGESIZE);
+    // Ask for the next window once half of the previous one has been consumed.
+    if(mapAdvised_ < mapSize_ && mapPosition_ + mapReadAhead / 2 >= mapAdvised_) {
+      IOOffset begin = mapAdvised_ - mapAdvised_ % pageSize;
+      IOOffset end = std::min(mapSize_, std::max(mapAdvised_, mapPosition_) + mapReadAhead);
+      ::madvise(mapBase_ + begin, end - begin, MADV_WILLNEED);
+      mapAdvised_ = end;
+    }
+    // Pages before the current position are not needed anymore.
+    IOOffset release = mapPosition_ - mapPosition_ % pageSize;
+    if(release >= mapReleased_ + mapReadAhead) {
+      ::madvise(mapBase_ + mapReleased_, release - mapReleased_, MADV_DONTNEED);
+      mapReleased_ = release;
+    }
+  }
+
   void
   StreamerInputFile::closeStreamerFile() {
-    if(currentFileOpen_ && storage_) {
+    if(currentFileOpen_ && fileMapped_) {
+      if(mapSize_ > 0) {
+        ::munmap(mapBase_, mapSize_);
+      }
+      mapBase_ = nullptr;
+      mapSize_ = 0;
+      fileMapped_ = false;
+      // The current record pointed into the mapping.
+      currentEvMsg_ = std::shared_ptr<EventMsgView>();
+      logFileAction("  Closed file ");
+    } else if(currentFileOpen_ && storage_) {
       storage_->close();
       logFileAction("  Closed file ");
     }
     currentFileOpen_ = false;
   }
 
+  char* StreamerInputFile::mappedBytes(IOSize nBytes, IOSize& nGot) {
+    nGot = std::min<IOOffset>(nBytes, mapSize_ - mapPosition_);
+    char* p = mapBase_ + mapPosition_;
+    mapPosition_ += nGot;
+    return p;
+  }
+
   IOSize StreamerInputFile::readBytes(char *buf, IOSize nBytes) {
     IOSize n = 0;
+    if(fileMapped_) {
+      char const* p = mappedBytes(nBytes, n);
+      std::copy(p, p + n, buf);
+      return n;
+    }
     try {
       n = storage_->read(buf, nBytes);
     }
@@ -117,6 +237,11 @@ namespace edm {
 
   IOOffset StreamerInputFile::skipBytes(IOSize nBytes) {
     IOOffset n = 0;
+    if(fileMapped_) {
+      IOSize nGot = 0;
+      mappedBytes(nBytes, nGot);
+      return nGot;
+    }
     try {
       // We wish to return the number of bytes skipped, not the final offset.
       n = storage_->position(0, Storage::CURRENT);
@@ -224,11 +349,23 @@ namespace edm {
   int StreamerInputFile::readEventMessage() {
     if(endOfFile_) return 0;
 
+    if(fileMapped_) {
+      adviseMapping();
+    }
+
     bool eventRead = false;
+    char* eventStart = nullptr;
     while(!eventRead) {
 
       IOSize nWant = sizeof(EventHeader);
-      IOSize nGot = readBytes(&eventBuf_[0], nWant);
+      IOSize nGot = 0;
+      if(fileMapped_) {
+        // The header is used in place; the record is contiguous in the mapping.
+        eventStart = mappedBytes(nWant, nGot);
+      } else {
+        eventStart = &eventBuf_[0];
+        nGot = readBytes(eventStart, nWant);
+      }
       if(nGot == 0) {
         // no more data available
         endOfFile_ = true;
@@ -239,7 +376,7 @@ namespace edm {
           << "Failed reading streamer file, first read in readEventMessage\n"
           << "Requested " << nWant << " bytes, read function returned " << nGot << " bytes\n";
       }
-      HeaderView head(&eventBuf_[0]);
+      HeaderView head(eventStart);
       uint32 code = head.code();
 
       // If it is not an event then something is wrong.
@@ -255,13 +392,20 @@ namespace edm {
       }
       eventRead = true;
       if(eventSkipperByID_) {
-        EventHeader *evh = (EventHeader *)(&eventBuf_[0]);
+        EventHeader *evh = (EventHeader *)(eventStart);
         if(eventSkipperByID_->skipIt(convert32(evh->run_), convert32(evh->lumi_), convert64(evh->event_))) {
           eventRead = false;
         }
       }
       nWant = eventSize - sizeof(EventHeader);
-      if(eventRead) {
+      if(eventRead && fileMapped_) {
+        mappedBytes(nWant, nGot);
+        if(nGot != nWant) {
+          throw Exception(errors::FileReadError, "StreamerInputFile::readEventMessage")
+            << "Failed reading streamer file, second read in readEventMessage\n"
+            << "Requested " << nWant << " bytes, mapped file has only " << nGot << " bytes left\n";
+        }
+      } else if(eventRead) {
         if(eventBuf_.size() < eventSize) eventBuf_.resize(eventSize);
         nGot = readBytes(&eventBuf_[sizeof(EventHeader)], nWant);
         if(nGot != nWant) {
@@ -278,7 +422,11 @@ namespace edm {
         }
       }
     }
-    currentEvMsg_ = std::make_shared<EventMsgView>((void*)&eventBuf_[0]); // propagate_const<T> has no reset() function
+    if(!fileMapped_) {
+      // eventBuf_ may have been reallocated for a large event.
+      eventStart = &eventBuf_[0];
+    }
+    currentEvMsg_ = std::make_shared<EventMsgView>((void*)eventStart); // propagate_const<T> has no reset() function
     return 1;
   }
 
@@ -231,20 +231,15 @@ namespace edm {
       // compressed
       dest_size = uncompressBuffer(const_cast<unsigned char*>((unsigned char const*)eventView.eventData()),
                                    eventView.eventLength(), dest_, origsize);
+      xbuf_.Reset();
+      xbuf_.SetBuffer(&dest_[0],dest_size,kFALSE);
     } else { // not compressed
-      // we need to copy anyway the buffer as we are using dest in xbuf
+      // The event is fully deserialized below, before the view goes away,
+      // so the buffer can be read in place (from the file buffer or the mapped file).
       dest_size = eventView.eventLength();
-      dest_.resize(dest_size);
-      unsigned char* pos = (unsigned char*) &dest_[0];
-      unsigned char const* from = (unsigned char const*) eventView.eventData();
-      std::copy(from,from+dest_size,pos);
+      xbuf_.Reset();
+      xbuf_.SetBuffer(const_cast<unsigned char*>((unsigned char const*)eventView.eventData()),dest_size,kFALSE);
     }
-    //TBuffer xbuf(TBuffer::kRead, dest_size,
-    //             (char const*) &dest[0],kFALSE);
-    //TBuffer xbuf(TBuffer::kRead, eventView.eventLength(),
-    //             (char const*) eventView.eventData(),kFALSE);
-    xbuf_.Reset();
-    xbuf_.SetBuffer(&dest_[0],dest_size,kFALSE);
     RootDebug tracer(10,10);
 
     //We do not yet know which EventPrincipal we will use, therefore
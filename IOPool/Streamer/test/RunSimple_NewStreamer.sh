@@ -19,6 +19,7 @@ cd ${OUTDIR}
 cmsRun --parameter-set NewStreamOut_cfg.py > out 2>&1 || die "cmsRun NewStreamOut_cfg.py" $?
 cmsRun --parameter-set NewStreamIn_cfg.py  > in  2>&1 || die "cmsRun NewStreamIn_cfg.py" $?
 cmsRun --parameter-set NewStreamIn2_cfg.py  > in2  2>&1 || die "cmsRun NewStreamIn2_cfg.py" $?
+cmsRun --parameter-set NewStreamInMapped_cfg.py  > inmapped  2>&1 || die "cmsRun NewStreamInMapped_cfg.py" $?
 cmsRun --parameter-set NewStreamCopy_cfg.py  > copy  2>&1 || die "cmsRun NewStreamCopy_cfg.py" $?
 cmsRun --parameter-set NewStreamCopy2_cfg.py  > copy2  2>&1 || die "cmsRun NewStreamCopy2_cfg.py" $?
 
@@ -29,6 +30,7 @@ ANS_OUT_SIZE=`grep -c CHECKSUM out`
 ANS_OUT=`grep CHECKSUM out`
 ANS_IN=`grep CHECKSUM in`
 ANS_IN2=`grep CHECKSUM in2`
+ANS_INMAPPED=`grep CHECKSUM inmapped`
 ANS_COPY=`grep CHECKSUM copy`
 
 if [ "${ANS_OUT_SIZE}" == "0" ]
@@ -49,6 +51,12 @@ then
     RC=1
 fi
 
+if [ "${ANS_OUT}" != "${ANS_INMAPPED}" ]
+then
+    echo "New Stream Test Failed (out!=inmapped)"
+    RC=1
+fi
+
 if [ "${ANS_OUT}" != "${ANS_COPY}" ]
 then
     echo "New Stream Test Failed (copy!=out)"
@@ -0,0 +1,91 @@
+/** Compares the buffered and the memory mapped reading modes of
+    StreamerInputFile on an existing streamer file.
+
+    Every event record is checksummed, as StreamerInputSource does before
+    deserializing it, so that both modes touch all the event data. The
+    buffered mode additionally copies every record into the reader's
+    buffer; the difference between the two timings is the cost of that
+    copy. Run it twice to compare with a warm page cache.
+
+    Usage: StreamerFileReadBenchmark <streamer file> [passes]
+*/
+
+#include "FWCore/Utilities/interface/Adler32Calculator.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "IOPool/Streamer/interface/EventMessage.h"
+#include "IOPool/Streamer/interface/StreamerInputFile.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+  struct Result {
+    double seconds = 0;
+    unsigned long long bytes = 0;
+    unsigned long long events = 0;
+    uint32_t checksum = 0;
+  };
+
+  Result readFile(std::string const& name, bool memoryMapped) {
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    edm::StreamerInputFile reader(name, std::shared_ptr<edm::EventSkipperByID>(), memoryMapped);
+    while(reader.next()) {
+      EventMsgView const* view = reader.currentRecord();
+      result.checksum ^= cms::Adler32((char const*)view->eventData(), view->eventLength());
+      result.bytes += view->size();
+      ++result.events;
+    }
+    reader.closeStreamerFile();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+  }
+
+  void print(char const* mode, Result const& r) {
+    std::cout << std::setw(10) << mode << ": " << r.events << " events, "
+              << std::fixed << std::setprecision(1) << r.bytes / 1.e6 << " MB in "
+              << std::setprecision(3) << r.seconds << " s ("
+              << std::setprecision(1) << r.bytes / 1.e6 / r.seconds << " MB/s)" << std::endl;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <streamer file> [passes]" << std::endl;
+    return 0;
+  }
+  std::string const name(argv[1]);
+  int const passes = argc > 2 ? std::atoi(argv[2]) : 3;
+
+  try {
+    Result buffered, mapped;
+    for(int i = 0; i < passes; ++i) {
+      Result b = readFile(name, false);
+      Result m = readFile(name, true);
+      if(b.checksum != m.checksum || b.events != m.events) {
+        std::cerr << "Buffered and memory mapped reading differ" << std::endl;
+        return 1;
+      }
+      // keep the best pass of each mode
+      if(i == 0 || b.seconds < buffered.seconds) buffered = b;
+      if(i == 0 || m.seconds < mapped.seconds) mapped = m;
+    }
+    print("buffered", buffered);
+    print("mapped", mapped);
+    double saved = buffered.seconds - mapped.seconds;
+    std::cout << "copy avoided: " << std::setprecision(1) << buffered.bytes / 1.e6 << " MB, saved "
+              << std::setprecision(3) << saved << " s";
+    if(saved > 0) {
+      std::cout << " (copy bandwidth " << std::setprecision(1) << buffered.bytes / 1.e6 / saved << " MB/s)";
+    }
+    std::cout << std::endl;
+  } catch(cms::Exception& e) {
+    std::cerr << "Exception caught:  " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
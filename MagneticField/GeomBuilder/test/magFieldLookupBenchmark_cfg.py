@@ -0,0 +1,21 @@
+# Benchmark of the magnetic volume lookup along random helices with
+# 1, 2, 4 ... maxThreads threads, e.g.
+# cmsRun magFieldLookupBenchmark_cfg.py
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process("MAGNETICFIELDBENCHMARK")
+
+process.source = cms.Source("EmptySource")
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(1)
+)
+
+process.load("MagneticField.Engine.volumeBasedMagneticField_160812_cfi")
+
+process.benchmark = cms.EDAnalyzer("MagFieldLookupBenchmark",
+    numberOfHelices = cms.untracked.uint32(20000),
+    stepsPerHelix = cms.untracked.uint32(200),
+    stepLength = cms.untracked.double(5.),
+    maxThreads = cms.untracked.uint32(8)
+)
+process.p1 = cms.Path(process.benchmark)
@@ -0,0 +1,148 @@
+/** \file
+ *
+ *  Benchmark of MagGeometry::findVolume with concurrent threads.
+ *  Points are taken along random helices starting at the origin, each
+ *  helix being walked by a single thread as a propagator would do. The
+ *  same set of helices is processed with 1, 2, 4 ... maxThreads threads
+ *  and the CPU time per lookup is printed for each number of threads; it
+ *  should stay flat if the lookup does not degrade with the number of
+ *  threads.
+ */
+
+#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "MagneticField/Engine/interface/MagneticField.h"
+#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
+#include "MagneticField/VolumeBasedEngine/interface/VolumeBasedMagneticField.h"
+#include "DataFormats/GeometryVector/interface/GlobalPoint.h"
+#include "DataFormats/GeometryVector/interface/Pi.h"
+
+#include "tbb/task_arena.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+class MagFieldLookupBenchmark : public edm::EDAnalyzer {
+ public:
+  MagFieldLookupBenchmark(const edm::ParameterSet& pset) :
+    numberOfHelices(pset.getUntrackedParameter<unsigned int>("numberOfHelices", 20000)),
+    stepsPerHelix(pset.getUntrackedParameter<unsigned int>("stepsPerHelix", 200)),
+    stepLength(pset.getUntrackedParameter<double>("stepLength", 5.)),
+    maxThreads(pset.getUntrackedParameter<unsigned int>("maxThreads", 8)),
+    seed(pset.getUntrackedParameter<unsigned int>("seed", 12345)) {}
+
+  void analyze(const edm::Event & event, const edm::EventSetup& eventSetup) override;
+
+ private:
+  void makeHelices();
+  // Time to process all the helices with nThreads threads, in seconds
+  double run(VolumeBasedMagneticField const& field, unsigned int nThreads, unsigned long& nFailures) const;
+
+  const unsigned int numberOfHelices;
+  const unsigned int stepsPerHelix;
+  const double stepLength;
+  const unsigned int maxThreads;
+  const unsigned int seed;
+
+  // points of helix i are [helixStart[i], helixStart[i+1])
+  vector<GlobalPoint> points;
+  vector<unsigned int> helixStart;
+};
+
+
+void MagFieldLookupBenchmark::makeHelices() {
+  points.clear();
+  helixStart.clear();
+  points.reserve(size_t(numberOfHelices)*stepsPerHelix);
+
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<double> ptDist(0.5, 20.);
+  std::uniform_real_distribution<double> etaDist(-2.5, 2.5);
+  std::uniform_real_distribution<double> phiDist(-Geom::pi(), Geom::pi());
+  std::bernoulli_distribution chargeDist(0.5);
+
+  for (unsigned int i=0; i<numberOfHelices; ++i) {
+    helixStart.push_back(points.size());
+    double pt = ptDist(engine);
+    double eta = etaDist(engine);
+    double phi0 = phiDist(engine);
+    double q = chargeDist(engine) ? 1. : -1.;
+    // radius of curvature in cm in a 3.8 T field
+    double rho = 100.*pt/(0.3*3.8);
+    double cotTheta = sinh(eta);
+    double sinTheta = 1./sqrt(1.+cotTheta*cotTheta);
+    for (unsigned int j=0; j<stepsPerHelix; ++j) {
+      double sT = j*stepLength*sinTheta; // transverse path length
+      double phi = phi0 - q*sT/rho;
+      GlobalPoint gp(q*rho*(sin(phi0)-sin(phi)), q*rho*(cos(phi)-cos(phi0)), sT*cotTheta);
+      if (gp.perp()>900. || fabs(gp.z())>2400.) break;
+      points.push_back(gp);
+    }
+  }
+  helixStart.push_back(points.size());
+}
+
+
+double MagFieldLookupBenchmark::run(VolumeBasedMagneticField const& field, unsigned int nThreads, unsigned long& nFailures) const {
+  std::atomic<unsigned long> failures{0};
+  auto start = std::chrono::steady_clock::now();
+  tbb::task_arena arena(nThreads);
+  arena.execute([&]() {
+      tbb::parallel_for(tbb::blocked_range<unsigned int>(0, numberOfHelices, 16),
+                        [&](tbb::blocked_range<unsigned int> const& r) {
+                          unsigned long f = 0;
+                          for (unsigned int i=r.begin(); i!=r.end(); ++i) {
+                            for (unsigned int j=helixStart[i]; j!=helixStart[i+1]; ++j) {
+                              if (field.findVolume(points[j])==nullptr) ++f;
+                            }
+                          }
+                          failures += f;
+                        });
+    });
+  auto stop = std::chrono::steady_clock::now();
+  nFailures = failures;
+  return std::chrono::duration<double>(stop-start).count();
+}
+
+
+void MagFieldLookupBenchmark::analyze(const edm::Event & event, const edm::EventSetup& eventSetup) {
+  edm::ESHandle<MagneticField> magfield;
+  eventSetup.get<IdealMagneticFieldRecord>().get(magfield);
+
+  const VolumeBasedMagneticField* field = dynamic_cast<const VolumeBasedMagneticField*>(magfield.product());
+  if (field==nullptr) {
+    cout << "MagFieldLookupBenchmark: the field is not a VolumeBasedMagneticField, nothing to do" << endl;
+    return;
+  }
+
+  if (points.empty()) makeHelices();
+  double nLookups = points.size();
+
+  cout << "MagFieldLookupBenchmark: " << numberOfHelices << " helices, " << points.size() << " points" << endl;
+
+  unsigned long nFailures = 0;
+  double t = run(*field, 1, nFailures);
+  cout << " first pass (1 thread): " << t*1e9/nLookups << " ns/lookup, failures: " << nFailures << endl;
+
+  cout << " threads   ns/lookup (wall)   ns/lookup (CPU)   failures" << endl;
+  for (unsigned int n=1; n<=maxThreads; n*=2) {
+    t = run(*field, n, nFailures);
+    cout << setw(8) << n << setw(19) << t*1e9/nLookups << setw(18) << n*t*1e9/nLookups
+         << setw(11) << nFailures << endl;
+  }
+}
+
+#include "FWCore/Framework/interface/MakerMacros.h"
+DEFINE_FWK_MODULE(MagFieldLookupBenchmark);
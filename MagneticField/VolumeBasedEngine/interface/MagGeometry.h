@@ -13,6 +13,7 @@
 
 #include <vector>
 #include <atomic>
+#include <memory>
 
 class MagBLayer;
 class MagESector;
@@ -62,7 +63,16 @@ private:
 
   bool inBarrel(const GlobalPoint& gp) const;
 
-  mutable std::atomic<MagVolume const*> lastVolume; // Cache last volume found
+  // Index of the cell of the volume grid containing gp, -1 if outside the grid
+  int gridIndex(const GlobalPoint& gp) const;
+
+  // Grid of cells in r, z and phi, each caching the last volume found in it.
+  // Unlike a single cache, threads working in different regions do not
+  // overwrite each other's entries. The last volume found by each thread is
+  // cached separately (see MagGeometry.cc); theCacheId tells which
+  // MagGeometry that entry belongs to.
+  std::unique_ptr<std::atomic<MagVolume const*>[]> theVolumeGrid;
+  const unsigned long long theCacheId;
 
   std::vector<MagBLayer const*> theBLayers;
   std::vector<MagESector const*> theESectors;
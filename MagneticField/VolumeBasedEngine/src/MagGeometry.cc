@@ -20,6 +20,24 @@
 using namespace std;
 using namespace edm;
 
+namespace {
+  // Extent and binning of the volume grid
+  constexpr float gridMaxR = 900.f;
+  constexpr float gridMaxZ = 2400.f;
+  constexpr int gridNR = 60;
+  constexpr int gridNZ = 120;
+  constexpr int gridNPhi = 24;
+
+  // Last volume found by the current thread, and the MagGeometry it comes from
+  struct LastVolume {
+    unsigned long long geometryId = 0;
+    MagVolume const* volume = nullptr;
+  };
+  thread_local LastVolume s_lastVolume;
+
+  std::atomic<unsigned long long> s_nextCacheId{1};
+}
+
 MagGeometry::MagGeometry(int geomVersion, const std::vector<MagBLayer *>& tbl,
 			 const std::vector<MagESector *>& tes,
 			 const std::vector<MagVolume6Faces*>& tbv,
@@ -31,7 +49,10 @@ MagGeometry::MagGeometry(int geomVersion, const std::vector<MagBLayer const*>& t
 			 const std::vector<MagESector const*>& tes,
 			 const std::vector<MagVolume6Faces const*>& tbv,
 			 const std::vector<MagVolume6Faces const*>& tev) : 
-  lastVolume(nullptr), theBLayers(tbl), theESectors(tes), theBVolumes(tbv), theEVolumes(tev), cacheLastVolume(true), geometryVersion(geomVersion)
+  theVolumeGrid(new std::atomic<MagVolume const*>[gridNR*gridNZ*gridNPhi]()),
+  theCacheId(s_nextCacheId++),
+  theBLayers(tbl), theESectors(tes), theBVolumes(tbv), theEVolumes(tev),
+  cacheLastVolume(true), geometryVersion(geomVersion)
 {
   vector<double> rBorders;
 
@@ -135,10 +156,21 @@ MagGeometry::findVolume1(const GlobalPoint & gp, double tolerance) const {
 // Use hierarchical structure for fast lookup.
 MagVolume const* 
 MagGeometry::findVolume(const GlobalPoint & gp, double tolerance) const{
-  // Check volume cache
-  auto lastVolumeCheck = lastVolume.load(std::memory_order_acquire);
-  if (lastVolumeCheck!=nullptr && lastVolumeCheck->inside(gp)){
-    return lastVolumeCheck;
+  // Check the last volume found by this thread
+  LastVolume& last = s_lastVolume;
+  if (cacheLastVolume && last.geometryId==theCacheId && last.volume->inside(gp)){
+    return last.volume;
+  }
+
+  // Check the last volume found in the grid cell; like the per-thread
+  // cache, the grid is not used when cacheLastVolume is off
+  int cell = cacheLastVolume ? gridIndex(gp) : -1;
+  if (cell>=0) {
+    auto cellVolume = theVolumeGrid[cell].load(std::memory_order_acquire);
+    if (cellVolume!=nullptr && cellVolume->inside(gp)){
+      if (cacheLastVolume) last = LastVolume{theCacheId, cellVolume};
+      return cellVolume;
+    }
   }
 
   MagVolume const* result=nullptr;
@@ -175,12 +207,31 @@ MagGeometry::findVolume(const GlobalPoint & gp, double tolerance) const{
     result = findVolume(gp, 0.03);
   }
 
-  if (cacheLastVolume) lastVolume.store(result,std::memory_order_release);
+  if (result!=nullptr) {
+    if (cell>=0) theVolumeGrid[cell].store(result,std::memory_order_release);
+    if (cacheLastVolume) last = LastVolume{theCacheId, result};
+  }
 
   return result;
 }
 
 
+int MagGeometry::gridIndex(const GlobalPoint& gp) const {
+  float R = gp.perp();
+  float Z = gp.z();
+  // also rejects NaN
+  if (!(R < gridMaxR && fabs(Z) < gridMaxZ)) return -1;
+  int iR = int(R*(gridNR/gridMaxR));
+  int iZ = int((Z+gridMaxZ)*(gridNZ/(2.f*gridMaxZ)));
+  int iPhi = int((gp.barePhi()+Geom::fpi())*(gridNPhi/Geom::ftwoPi()));
+  // guard against rounding at the upper edges
+  iR = min(iR, gridNR-1);
+  iZ = min(iZ, gridNZ-1);
+  iPhi = min(max(iPhi,0), gridNPhi-1);
+  return (iZ*gridNR + iR)*gridNPhi + iPhi;
+}
+
+
 
 
 bool MagGeometry::inBarrel(const GlobalPoint& gp) const {
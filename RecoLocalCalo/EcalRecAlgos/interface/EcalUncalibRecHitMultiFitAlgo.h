@@ -13,6 +13,9 @@
 #include "CondFormats/EcalObjects/interface/EcalPedestals.h"
 #include "CondFormats/EcalObjects/interface/EcalGainRatios.h"
 #include "RecoLocalCalo/EcalRecAlgos/interface/PulseChiSqSNNLS.h"
+#include "RecoLocalCalo/EcalRecAlgos/interface/PulseChiSqSNNLSFixed.h"
+
+#include <tuple>
 
 
 #include "TMatrixDSym.h"
@@ -35,8 +38,15 @@ class EcalUncalibRecHitMultiFitAlgo
   void setAddPedestalUncertainty(double x) { _addPedestalUncertainty = x; }
   void setSimplifiedNoiseModelForGainSwitch(bool b) { _simplifiedNoiseModelForGainSwitch = b; }
   void setGainSwitchUseMaxSample(bool b) { _gainSwitchUseMaxSample = b; }
+  void setUseFixedSizeFit(bool b) { _useFixedSizeFit = b; }
   
  private:
+   // runs the fit with the fixed-size solver matching the number of
+   // pulses, falling back to _pulsefunc for sizes without an instance
+   bool fixedSizeFit(const SampleVector &amplitudes, const SampleMatrix &noisecov, const BXVector &activeBX, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gainsPedestal, const SampleGainVector &badSamples);
+   template<int NPULSE>
+   bool fixedSizeFit(PulseChiSqSNNLSFixed<NPULSE> &pulsefunc, const SampleVector &amplitudes, const SampleMatrix &noisecov, const BXVector &activeBX, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gainsPedestal, const SampleGainVector &badSamples);
+
    PulseChiSqSNNLS _pulsefunc;
    PulseChiSqSNNLS _pulsefuncSingle;
    bool _computeErrors;
@@ -48,8 +58,21 @@ class EcalUncalibRecHitMultiFitAlgo
    double _addPedestalUncertainty;
    bool _simplifiedNoiseModelForGainSwitch;
    bool _gainSwitchUseMaxSample;
+   bool _useFixedSizeFit;
    BXVector _singlebx;
 
+   // fixed-size solvers, one per total number of pulses
+   std::tuple<PulseChiSqSNNLSFixed<1>, PulseChiSqSNNLSFixed<2>, PulseChiSqSNNLSFixed<3>,
+              PulseChiSqSNNLSFixed<4>, PulseChiSqSNNLSFixed<5>, PulseChiSqSNNLSFixed<6>,
+              PulseChiSqSNNLSFixed<7>, PulseChiSqSNNLSFixed<8>, PulseChiSqSNNLSFixed<9>,
+              PulseChiSqSNNLSFixed<10>, PulseChiSqSNNLSFixed<11>, PulseChiSqSNNLSFixed<12> > _pulsefuncFixed;
+
+   // result of the last fit with the fixed-size solvers
+   PulseVector _fitX;
+   PulseVector _fitErrors;
+   BXVector _fitBXs;
+   double _fitChiSq;
+
 };
 
 #endif
@@ -0,0 +1,486 @@
+#ifndef PulseChiSqSNNLSFixed_h
+#define PulseChiSqSNNLSFixed_h
+
+/** \class PulseChiSqSNNLSFixed
+  *  Fixed-size variant of PulseChiSqSNNLS.
+  *
+  *  The total number of fitted pulses (in/out-of-time pulses, dynamic
+  *  pedestals and bad sample step corrections) is a template parameter,
+  *  so every matrix in the active-set loop has compile-time dimensions:
+  *  no size bookkeeping, no runtime-sized temporaries, and the matrix
+  *  products are fully unrolled. The algorithm is the same as in
+  *  PulseChiSqSNNLS step by step, and gives the same results.
+  *
+  *  Use PulseChiSqSNNLSFixedNPulses() to find the template parameter
+  *  matching a given set of inputs.
+  */
+
+#define EIGEN_NO_DEBUG // kill throws in eigen code
+#include "RecoLocalCalo/EcalRecAlgos/interface/EigenMatrixTypes.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// total number of pulses PulseChiSqSNNLS::DoFit would fit for these inputs
+inline unsigned int PulseChiSqSNNLSFixedNPulses(const BXVector &bxs, const SampleGainVector &gains, const SampleGainVector &badSamples) {
+  unsigned int npulse = bxs.rows();
+  int ngains = gains.maxCoeff()+1;
+  for (int gainidx=0; gainidx<ngains; ++gainidx) {
+    SampleGainVector mask = gainidx*SampleGainVector::Ones();
+    if ((gains.array()==mask.array()).any()) ++npulse;
+  }
+  for (int isample=0; isample<SampleVector::RowsAtCompileTime; ++isample) {
+    if (badSamples.coeff(isample)>0) ++npulse;
+  }
+  return npulse;
+}
+
+namespace pulsechisqsnnlsfixed {
+
+  // solve the top-left nP x nP block of mat with a matrix of fixed size,
+  // dispatching on nP at runtime
+  template<int NPULSE, int K>
+  struct SubmatrixSolver {
+    static void solve(const Eigen::Matrix<double,NPULSE,NPULSE> &mat, const Eigen::Matrix<double,NPULSE,1> &invec,
+                      Eigen::Matrix<double,NPULSE,1> &outvec, unsigned int nP) {
+      if (nP==K) {
+        Eigen::Matrix<double,K,K> temp = mat.template topLeftCorner<K,K>();
+        outvec.template head<K>() = temp.ldlt().solve(invec.template head<K>());
+      }
+      else {
+        SubmatrixSolver<NPULSE,K-1>::solve(mat,invec,outvec,nP);
+      }
+    }
+  };
+
+  template<int NPULSE>
+  struct SubmatrixSolver<NPULSE,0> {
+    static void solve(const Eigen::Matrix<double,NPULSE,NPULSE> &, const Eigen::Matrix<double,NPULSE,1> &,
+                      Eigen::Matrix<double,NPULSE,1> &, unsigned int) {
+      throw cms::Exception("MultFitWeirdState")
+        << "Weird number of pulses encountered in multifit, module is configured incorrectly!";
+    }
+  };
+
+}
+
+template<int NPULSE>
+class PulseChiSqSNNLSFixed {
+  public:
+
+    typedef Eigen::Matrix<double,NPULSE,1> FixedPulseVector;
+    typedef Eigen::Matrix<char,NPULSE,1> FixedBXVector;
+    typedef Eigen::Matrix<double,NPULSE,NPULSE> FixedPulseMatrix;
+    typedef Eigen::Matrix<double,SampleVectorSize,NPULSE> FixedSamplePulseMatrix;
+    typedef typename FixedBXVector::Index Index;
+
+    static constexpr unsigned int nsamples = SampleVector::RowsAtCompileTime;
+    static constexpr unsigned int maxActive = NPULSE<SampleVectorSize ? NPULSE : SampleVectorSize;
+
+    PulseChiSqSNNLSFixed() : _chisq(0.), _computeErrors(true), _maxiters(50), _maxiterwarnings(true) {}
+
+    // same interface as PulseChiSqSNNLS::DoFit; returns false if the inputs
+    // do not correspond to exactly NPULSE pulses
+    bool DoFit(const SampleVector &samples, const SampleMatrix &samplecov, const BXVector &bxs, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gains = -1*SampleGainVector::Ones(), const SampleGainVector &badSamples = SampleGainVector::Zero());
+
+    const FixedPulseVector &X() const { return _ampvecmin; }
+    const FixedPulseVector &Errors() const { return _errvec; }
+    const FixedBXVector &BXs() const { return _bxsmin; }
+
+    double ChiSq() const { return _chisq; }
+    void disableErrorCalculation() { _computeErrors = false; }
+    void setMaxIters(int n) { _maxiters = n;}
+    void setMaxIterWarnings(bool b) { _maxiterwarnings = b;}
+
+  private:
+
+    bool Minimize(const SampleMatrix &samplecov, const FullSampleMatrix &fullpulsecov);
+    bool NNLS();
+    void NNLSUnconstrainParameter(Index idxp);
+    void NNLSConstrainParameter(Index minratioidx);
+    bool OnePulseMinimize();
+    bool updateCov(const SampleMatrix &samplecov, const FullSampleMatrix &fullpulsecov);
+    double ComputeChiSq();
+    double ComputeApproxUncertainty(unsigned int ipulse);
+
+    SampleVector _sampvec;
+    SampleMatrix _invcov;
+    FixedSamplePulseMatrix _pulsemat;
+    FixedPulseVector _ampvec;
+    FixedPulseVector _errvec;
+    FixedPulseVector _ampvecmin;
+
+    SampleDecompLLT _covdecomp;
+
+    FixedBXVector _bxs;
+    FixedBXVector _bxsmin;
+    unsigned int _nP;
+
+    FixedSamplePulseMatrix invcovp;
+    FixedPulseMatrix aTamat;
+    FixedPulseVector aTbvec;
+    FixedPulseVector updatework;
+
+    FixedPulseVector ampvecpermtest;
+
+    double _chisq;
+    bool _computeErrors;
+    int _maxiters;
+    bool _maxiterwarnings;
+};
+
+template<int NPULSE>
+bool PulseChiSqSNNLSFixed<NPULSE>::DoFit(const SampleVector &samples, const SampleMatrix &samplecov, const BXVector &bxs, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gains, const SampleGainVector &badSamples) {
+
+  if (PulseChiSqSNNLSFixedNPulses(bxs,gains,badSamples)!=NPULSE) return false;
+
+  const int npulse = bxs.rows();
+
+  _sampvec = samples;
+  _bxs.head(npulse) = bxs;
+
+  //construct dynamic pedestals if applicable
+  int ngains = gains.maxCoeff()+1;
+  int nPedestals = 0;
+  for (int gainidx=0; gainidx<ngains; ++gainidx) {
+    SampleGainVector mask = gainidx*SampleGainVector::Ones();
+    SampleVector pedestal = (gains.array()==mask.array()).cast<SampleVector::value_type>();
+    if (pedestal.maxCoeff()>0.) {
+      ++nPedestals;
+      _bxs[npulse+nPedestals-1] = 100 + gainidx; //bx values >=100 indicate dynamic pedestals
+      _pulsemat.col(npulse+nPedestals-1) = pedestal;
+    }
+  }
+
+  //construct negative step functions for saturated or potentially slew-rate-limited samples
+  for (int isample=0; isample<SampleVector::RowsAtCompileTime; ++isample) {
+    if (badSamples.coeff(isample)>0) {
+      SampleVector step = SampleVector::Zero();
+      //step correction has negative sign for saturated or slew-limited samples which have been forced to zero
+      step[isample] = -1.;
+
+      ++nPedestals;
+      _bxs[npulse+nPedestals-1] = -100 - isample; //bx values <=-100 indicate step corrections for saturated or slew-limited samples
+      _pulsemat.col(npulse+nPedestals-1) = step;
+    }
+  }
+
+  _ampvec.setZero();
+  _errvec.setZero();
+  _nP = 0;
+  _chisq = 0.;
+
+  if (NPULSE==1 && std::abs(_bxs.coeff(0))<100) {
+    _ampvec.coeffRef(0) = _sampvec.coeff(_bxs.coeff(0) + 5);
+  }
+
+  //initialize pulse template matrix
+  for (int ipulse=0; ipulse<npulse; ++ipulse) {
+    int bx = _bxs.coeff(ipulse);
+    int offset = 7-3-bx;
+    _pulsemat.col(ipulse) = fullpulse.segment<SampleVector::RowsAtCompileTime>(offset);
+  }
+
+  //unconstrain pedestals already for first iteration since they should always be non-zero
+  if (nPedestals>0) {
+    for (int i=0; i<NPULSE; ++i) {
+      int bx = _bxs.coeff(i);
+      if (bx>=100) {
+        NNLSUnconstrainParameter(i);
+      }
+    }
+  }
+
+  //do the actual fit
+  bool status = Minimize(samplecov,fullpulsecov);
+  _ampvecmin = _ampvec;
+  _bxsmin = _bxs;
+
+  if (!status) return status;
+
+  if(!_computeErrors) return status;
+
+  //compute MINOS-like uncertainties for in-time amplitude
+  bool foundintime = false;
+  unsigned int ipulseintime = 0;
+  for (unsigned int ipulse=0; ipulse<NPULSE; ++ipulse) {
+    if (_bxs.coeff(ipulse)==0) {
+      ipulseintime = ipulse;
+      foundintime = true;
+      break;
+    }
+  }
+  if (!foundintime) return status;
+
+  const unsigned int ipulseintimemin = ipulseintime;
+
+  double approxerr = ComputeApproxUncertainty(ipulseintime);
+  double chisq0 = _chisq;
+  double x0 = _ampvecmin[ipulseintime];
+
+  //move in time pulse first to active set if necessary
+  if (ipulseintime<_nP) {
+    _pulsemat.col(_nP-1).swap(_pulsemat.col(ipulseintime));
+    std::swap(_ampvec.coeffRef(_nP-1),_ampvec.coeffRef(ipulseintime));
+    std::swap(_bxs.coeffRef(_nP-1),_bxs.coeffRef(ipulseintime));
+    ipulseintime = _nP - 1;
+    --_nP;
+  }
+
+  SampleVector pulseintime = _pulsemat.col(ipulseintime);
+  _pulsemat.col(ipulseintime).setZero();
+
+  //two point interpolation for upper uncertainty when amplitude is away from boundary
+  double xplus100 = x0 + approxerr;
+  _ampvec.coeffRef(ipulseintime) = xplus100;
+  _sampvec = samples - _ampvec.coeff(ipulseintime)*pulseintime;
+  status &= Minimize(samplecov,fullpulsecov);
+  if (!status) return status;
+  double chisqplus100 = ComputeChiSq();
+
+  double sigmaplus = std::abs(xplus100-x0)/sqrt(chisqplus100-chisq0);
+
+  //if amplitude is sufficiently far from the boundary, compute also the lower uncertainty and average them
+  if ( (x0/sigmaplus) > 0.5 ) {
+    for (unsigned int ipulse=0; ipulse<NPULSE; ++ipulse) {
+      if (_bxs.coeff(ipulse)==0) {
+        ipulseintime = ipulse;
+        break;
+      }
+    }
+    double xminus100 = std::max(0.,x0-approxerr);
+    _ampvec.coeffRef(ipulseintime) = xminus100;
+    _sampvec = samples - _ampvec.coeff(ipulseintime)*pulseintime;
+    status &= Minimize(samplecov,fullpulsecov);
+    if (!status) return status;
+    double chisqminus100 = ComputeChiSq();
+
+    double sigmaminus = std::abs(xminus100-x0)/sqrt(chisqminus100-chisq0);
+    _errvec[ipulseintimemin] = 0.5*(sigmaplus + sigmaminus);
+
+  }
+  else {
+    _errvec[ipulseintimemin] = sigmaplus;
+  }
+
+  _chisq = chisq0;
+
+  return status;
+
+}
+
+template<int NPULSE>
+bool PulseChiSqSNNLSFixed<NPULSE>::Minimize(const SampleMatrix &samplecov, const FullSampleMatrix &fullpulsecov) {
+
+  int iter = 0;
+  bool status = false;
+  while (true) {
+
+    if (iter>=_maxiters) {
+      if (_maxiterwarnings) {
+        LogDebug("PulseChiSqSNNLSFixed::Minimize") << "Max Iterations reached at iter " << iter;
+      }
+      break;
+    }
+
+    status = updateCov(samplecov,fullpulsecov);
+    if (!status) break;
+    if (NPULSE>1) {
+      status = NNLS();
+    }
+    else {
+      //special case for one pulse fit (performance optimized)
+      status = OnePulseMinimize();
+    }
+    if (!status) break;
+
+    double chisqnow = ComputeChiSq();
+    double deltachisq = chisqnow-_chisq;
+
+    _chisq = chisqnow;
+    if (std::abs(deltachisq)<1e-3) {
+      break;
+    }
+    ++iter;
+  }
+
+  return status;
+
+}
+
+template<int NPULSE>
+bool PulseChiSqSNNLSFixed<NPULSE>::updateCov(const SampleMatrix &samplecov, const FullSampleMatrix &fullpulsecov) {
+
+  _invcov = samplecov;
+
+  for (unsigned int ipulse=0; ipulse<NPULSE; ++ipulse) {
+    if (_ampvec.coeff(ipulse)==0.) continue;
+    int bx = _bxs.coeff(ipulse);
+    if (std::abs(bx)>=100) continue; //no contribution to covariance from pedestal or saturation/slew step correction
+
+    int firstsamplet = std::max(0,bx + 3);
+    int offset = 7-3-bx;
+
+    const double ampveccoef = _ampvec.coeff(ipulse);
+    const double ampsq = ampveccoef*ampveccoef;
+
+    const unsigned int nsamplepulse = nsamples-firstsamplet;
+    _invcov.block(firstsamplet,firstsamplet,nsamplepulse,nsamplepulse) +=
+      ampsq*fullpulsecov.block(firstsamplet+offset,firstsamplet+offset,nsamplepulse,nsamplepulse);
+  }
+
+  _covdecomp.compute(_invcov);
+
+  return true;
+
+}
+
+template<int NPULSE>
+double PulseChiSqSNNLSFixed<NPULSE>::ComputeChiSq() {
+
+  return _covdecomp.matrixL().solve(_pulsemat*_ampvec - _sampvec).squaredNorm();
+
+}
+
+template<int NPULSE>
+double PulseChiSqSNNLSFixed<NPULSE>::ComputeApproxUncertainty(unsigned int ipulse) {
+
+  return 1./_covdecomp.matrixL().solve(_pulsemat.col(ipulse)).norm();
+
+}
+
+template<int NPULSE>
+bool PulseChiSqSNNLSFixed<NPULSE>::NNLS() {
+
+  //Fast NNLS (fnnls) algorithm as per http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.157.9203&rep=rep1&type=pdf
+
+  invcovp = _covdecomp.matrixL().solve(_pulsemat);
+  aTamat.noalias() = invcovp.transpose().lazyProduct(invcovp);
+  aTbvec.noalias() = invcovp.transpose().lazyProduct(_covdecomp.matrixL().solve(_sampvec));
+
+  int iter = 0;
+  Index idxwmax = 0;
+  double wmax = 0.0;
+  double threshold = 1e-11;
+  while (true) {
+    //can only perform this step if solution is guaranteed viable
+    if (iter>0 || _nP==0) {
+      if ( _nP==maxActive ) break;
+
+      const unsigned int nActive = NPULSE - _nP;
+
+      updatework = aTbvec - aTamat*_ampvec;
+      Index idxwmaxprev = idxwmax;
+      double wmaxprev = wmax;
+      wmax = updatework.tail(nActive).maxCoeff(&idxwmax);
+
+      //convergence
+      if (wmax<threshold || (idxwmax==idxwmaxprev && wmax==wmaxprev)) break;
+
+      //worst case protection
+      if (iter>=500) {
+        LogDebug("PulseChiSqSNNLSFixed::NNLS()") << "Max Iterations reached at iter " << iter;
+        break;
+      }
+
+      //unconstrain parameter
+      Index idxp = _nP + idxwmax;
+      NNLSUnconstrainParameter(idxp);
+    }
+
+    while (true) {
+
+      if (_nP==0) break;
+
+      ampvecpermtest = _ampvec;
+
+      //solve for unconstrained parameters
+      pulsechisqsnnlsfixed::SubmatrixSolver<NPULSE,maxActive>::solve(aTamat,aTbvec,ampvecpermtest,_nP);
+
+      //check solution
+      bool positive = true;
+      for (unsigned int i = 0; i < _nP; ++i)
+        positive &= (ampvecpermtest(i) > 0);
+      if (positive) {
+        _ampvec.head(_nP) = ampvecpermtest.head(_nP);
+        break;
+      }
+
+      //update parameter vector
+      Index minratioidx=0;
+
+      double minratio = std::numeric_limits<double>::max();
+      for (unsigned int ipulse=0; ipulse<_nP; ++ipulse) {
+        if (ampvecpermtest.coeff(ipulse)<=0.) {
+          const double c_ampvec = _ampvec.coeff(ipulse);
+          const double ratio = c_ampvec/(c_ampvec-ampvecpermtest.coeff(ipulse));
+          if (ratio<minratio) {
+            minratio = ratio;
+            minratioidx = ipulse;
+          }
+        }
+      }
+
+      _ampvec.head(_nP) += minratio*(ampvecpermtest.head(_nP)- _ampvec.head(_nP));
+
+      //avoid numerical problems with later ==0. check
+      _ampvec.coeffRef(minratioidx) = 0.;
+
+      NNLSConstrainParameter(minratioidx);
+    }
+    ++iter;
+
+    //adaptive convergence threshold to avoid infinite loops but still
+    //ensure best value is used
+    if (iter % 16 == 0) {
+      threshold *= 2;
+    }
+  }
+
+  return true;
+
+}
+
+template<int NPULSE>
+void PulseChiSqSNNLSFixed<NPULSE>::NNLSUnconstrainParameter(Index idxp) {
+
+  aTamat.col(_nP).swap(aTamat.col(idxp));
+  aTamat.row(_nP).swap(aTamat.row(idxp));
+  _pulsemat.col(_nP).swap(_pulsemat.col(idxp));
+  std::swap(aTbvec.coeffRef(_nP),aTbvec.coeffRef(idxp));
+  std::swap(_ampvec.coeffRef(_nP),_ampvec.coeffRef(idxp));
+  std::swap(_bxs.coeffRef(_nP),_bxs.coeffRef(idxp));
+  ++_nP;
+}
+
+template<int NPULSE>
+void PulseChiSqSNNLSFixed<NPULSE>::NNLSConstrainParameter(Index minratioidx) {
+  aTamat.col(_nP-1).swap(aTamat.col(minratioidx));
+  aTamat.row(_nP-1).swap(aTamat.row(minratioidx));
+  _pulsemat.col(_nP-1).swap(_pulsemat.col(minratioidx));
+  std::swap(aTbvec.coeffRef(_nP-1),aTbvec.coeffRef(minratioidx));
+  std::swap(_ampvec.coeffRef(_nP-1),_ampvec.coeffRef(minratioidx));
+  std::swap(_bxs.coeffRef(_nP-1),_bxs.coeffRef(minratioidx));
+  --_nP;
+
+}
+
+template<int NPULSE>
+bool PulseChiSqSNNLSFixed<NPULSE>::OnePulseMinimize() {
+
+  //only called for NPULSE==1, written on the first column so that it also
+  //compiles for the other instantiations
+  const SampleVector invcovp0 = _covdecomp.matrixL().solve(_pulsemat.col(0));
+
+  SingleMatrix aTamatval = invcovp0.transpose()*invcovp0;
+  SingleVector aTbvecval = invcovp0.transpose()*_covdecomp.matrixL().solve(_sampvec);
+  _ampvec.coeffRef(0) = std::max(0.,aTbvecval.coeff(0)/aTamatval.coeff(0));
+
+  return true;
+
+}
+
+#endif
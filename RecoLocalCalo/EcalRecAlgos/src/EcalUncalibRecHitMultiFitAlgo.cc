@@ -14,7 +14,9 @@ EcalUncalibRecHitMultiFitAlgo::EcalUncalibRecHitMultiFitAlgo() :
   _selectiveBadSampleCriteria(false),
   _addPedestalUncertainty(0.),
   _simplifiedNoiseModelForGainSwitch(true),
-  _gainSwitchUseMaxSample(false){
+  _gainSwitchUseMaxSample(false),
+  _useFixedSizeFit(false),
+  _fitChiSq(0.){
     
   _singlebx.resize(1);
   _singlebx << 0;
@@ -114,8 +116,9 @@ EcalUncalibratedRecHit EcalUncalibRecHitMultiFitAlgo::makeRecHit(const EcalDataF
     double maxpulseamplitude = maxamplitude / fullpulse[iFullPulseMax];
     EcalUncalibratedRecHit rh( dataFrame.id(), maxpulseamplitude, pedval, 0., 0., flags );
     rh.setAmplitudeError(0.);
-    for (unsigned int ipulse=0; ipulse<_pulsefunc.BXs().rows(); ++ipulse) {
-      int bx = _pulsefunc.BXs().coeff(ipulse);
+    const BXVector &lastBXs = _useFixedSizeFit ? _fitBXs : _pulsefunc.BXs();
+    for (unsigned int ipulse=0; ipulse<lastBXs.rows(); ++ipulse) {
+      int bx = lastBXs.coeff(ipulse);
       if (bx!=0) {
         rh.setOutOfTimeAmplitude(bx+5, 0.0);
       }
@@ -182,26 +185,40 @@ EcalUncalibratedRecHit EcalUncalibRecHitMultiFitAlgo::makeRecHit(const EcalDataF
     }
   }
   
+  //results of the full fit, read directly from _pulsefunc unless the fixed-size solvers are used
+  const PulseVector *fitX = &_pulsefunc.X();
+  const PulseVector *fitErrors = &_pulsefunc.Errors();
+  const BXVector *fitBXs = &_pulsefunc.BXs();
+  
   if (!usePrefit) {
   
-    if(!_computeErrors) _pulsefunc.disableErrorCalculation();
-    status = _pulsefunc.DoFit(amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
-    chisq = _pulsefunc.ChiSq();
+    if (_useFixedSizeFit) {
+      status = fixedSizeFit(amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+      chisq = _fitChiSq;
+      fitX = &_fitX;
+      fitErrors = &_fitErrors;
+      fitBXs = &_fitBXs;
+    }
+    else {
+      if(!_computeErrors) _pulsefunc.disableErrorCalculation();
+      status = _pulsefunc.DoFit(amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+      chisq = _pulsefunc.ChiSq();
+    }
     
     if (!status) {
       edm::LogWarning("EcalUncalibRecHitMultiFitAlgo::makeRecHit") << "Failed Fit" << std::endl;
     }
 
     unsigned int ipulseintime = 0;
-    for (unsigned int ipulse=0; ipulse<_pulsefunc.BXs().rows(); ++ipulse) {
-      if (_pulsefunc.BXs().coeff(ipulse)==0) {
+    for (unsigned int ipulse=0; ipulse<fitBXs->rows(); ++ipulse) {
+      if (fitBXs->coeff(ipulse)==0) {
         ipulseintime = ipulse;
         break;
       }
     }
     
-    amplitude = status ? _pulsefunc.X()[ipulseintime] : 0.;
-    amperr = status ? _pulsefunc.Errors()[ipulseintime] : 0.;
+    amplitude = status ? fitX->coeff(ipulseintime) : 0.;
+    amperr = status ? fitErrors->coeff(ipulseintime) : 0.;
   
   }
   
@@ -211,13 +228,13 @@ EcalUncalibratedRecHit EcalUncalibRecHitMultiFitAlgo::makeRecHit(const EcalDataF
   rh.setAmplitudeError(amperr);
   
   if (!usePrefit) {
-    for (unsigned int ipulse=0; ipulse<_pulsefunc.BXs().rows(); ++ipulse) {
-      int bx = _pulsefunc.BXs().coeff(ipulse);
+    for (unsigned int ipulse=0; ipulse<fitBXs->rows(); ++ipulse) {
+      int bx = fitBXs->coeff(ipulse);
       if (bx!=0 && std::abs(bx)<100) {
-        rh.setOutOfTimeAmplitude(bx+5, status ? _pulsefunc.X().coeff(ipulse) : 0.);
+        rh.setOutOfTimeAmplitude(bx+5, status ? fitX->coeff(ipulse) : 0.);
       }
       else if (bx==(100+gainsPedestal[iSampleMax])) {
-        rh.setPedestal(status ? _pulsefunc.X().coeff(ipulse) : 0.);
+        rh.setPedestal(status ? fitX->coeff(ipulse) : 0.);
       }
     }
   }
@@ -225,3 +242,42 @@ EcalUncalibratedRecHit EcalUncalibRecHitMultiFitAlgo::makeRecHit(const EcalDataF
   return rh;
 }
 
+template<int NPULSE>
+bool EcalUncalibRecHitMultiFitAlgo::fixedSizeFit(PulseChiSqSNNLSFixed<NPULSE> &pulsefunc, const SampleVector &amplitudes, const SampleMatrix &noisecov, const BXVector &activeBX, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gainsPedestal, const SampleGainVector &badSamples) {
+
+  if(!_computeErrors) pulsefunc.disableErrorCalculation();
+  bool status = pulsefunc.DoFit(amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  _fitX = pulsefunc.X();
+  _fitErrors = pulsefunc.Errors();
+  _fitBXs = pulsefunc.BXs();
+  _fitChiSq = pulsefunc.ChiSq();
+  return status;
+}
+
+bool EcalUncalibRecHitMultiFitAlgo::fixedSizeFit(const SampleVector &amplitudes, const SampleMatrix &noisecov, const BXVector &activeBX, const FullSampleVector &fullpulse, const FullSampleMatrix &fullpulsecov, const SampleGainVector &gainsPedestal, const SampleGainVector &badSamples) {
+
+  switch (PulseChiSqSNNLSFixedNPulses(activeBX,gainsPedestal,badSamples)) {
+  case 1: return fixedSizeFit(std::get<0>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 2: return fixedSizeFit(std::get<1>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 3: return fixedSizeFit(std::get<2>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 4: return fixedSizeFit(std::get<3>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 5: return fixedSizeFit(std::get<4>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 6: return fixedSizeFit(std::get<5>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 7: return fixedSizeFit(std::get<6>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 8: return fixedSizeFit(std::get<7>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 9: return fixedSizeFit(std::get<8>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 10: return fixedSizeFit(std::get<9>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 11: return fixedSizeFit(std::get<10>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  case 12: return fixedSizeFit(std::get<11>(_pulsefuncFixed),amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  default:
+    break;
+  }
+
+  if(!_computeErrors) _pulsefunc.disableErrorCalculation();
+  bool status = _pulsefunc.DoFit(amplitudes,noisecov,activeBX,fullpulse,fullpulsecov,gainsPedestal,badSamples);
+  _fitX = _pulsefunc.X();
+  _fitErrors = _pulsefunc.Errors();
+  _fitBXs = _pulsefunc.BXs();
+  _fitChiSq = _pulsefunc.ChiSq();
+  return status;
+}
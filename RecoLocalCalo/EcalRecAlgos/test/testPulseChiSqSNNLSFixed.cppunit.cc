@@ -0,0 +1,154 @@
+/* Unit test for PulseChiSqSNNLSFixed
+
+   Fits the same pulses with PulseChiSqSNNLS and with the fixed-size
+   solver matching the number of pulses, and checks that the amplitudes,
+   uncertainties, chi2 and ordering of the fitted pulses agree.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "RecoLocalCalo/EcalRecAlgos/interface/PulseChiSqSNNLS.h"
+#include "RecoLocalCalo/EcalRecAlgos/interface/PulseChiSqSNNLSFixed.h"
+
+#include <cmath>
+#include <random>
+
+class testPulseChiSqSNNLSFixed: public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(testPulseChiSqSNNLSFixed);
+  CPPUNIT_TEST(testSinglePulse);
+  CPPUNIT_TEST(testOutOfTimePulses);
+  CPPUNIT_TEST(testDynamicPedestal);
+  CPPUNIT_TEST(testBadSample);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown() {}
+
+  void testSinglePulse();
+  void testOutOfTimePulses();
+  void testDynamicPedestal();
+  void testBadSample();
+
+private:
+  template<int NPULSE>
+  void compare(const BXVector &bxs, const SampleGainVector &gains, const SampleGainVector &badSamples, double pedestal);
+
+  FullSampleVector fullpulse_;
+  FullSampleMatrix fullpulsecov_;
+  SampleMatrix noisecov_;
+  std::mt19937 rng_;
+};
+
+///registration of the test so that the runner can find it
+CPPUNIT_TEST_SUITE_REGISTRATION(testPulseChiSqSNNLSFixed);
+
+void testPulseChiSqSNNLSFixed::setUp()
+{
+  //alpha-beta parametrization of the EB pulse shape, in units of 25 ns,
+  //with the maximum of the in-time pulse on sample 5 (full pulse index 9)
+  const double alpha = 1.138;
+  const double beta = 1.655;
+  const double tmax = 9.;
+  for (int i=0; i<FullSampleVectorSize; ++i) {
+    double dt = i - tmax;
+    fullpulse_[i] = dt>-alpha*beta ? std::pow(1.+dt/(alpha*beta),alpha)*std::exp(-dt/beta) : 0.;
+  }
+  fullpulsecov_ = FullSampleMatrix::Zero();
+  for (int i=0; i<FullSampleVectorSize; ++i) {
+    fullpulsecov_(i,i) = 1e-6*fullpulse_[i]*fullpulse_[i];
+  }
+
+  //1.1 ADC counts of noise, correlated between neighbouring samples
+  const double rms = 1.1;
+  for (int i=0; i<SampleVectorSize; ++i) {
+    for (int j=0; j<SampleVectorSize; ++j) {
+      noisecov_(i,j) = rms*rms*std::exp(-0.6*std::abs(i-j));
+    }
+  }
+
+  rng_.seed(12345);
+}
+
+template<int NPULSE>
+void testPulseChiSqSNNLSFixed::compare(const BXVector &bxs, const SampleGainVector &gains, const SampleGainVector &badSamples, double pedestal)
+{
+  CPPUNIT_ASSERT(PulseChiSqSNNLSFixedNPulses(bxs,gains,badSamples)==NPULSE);
+
+  const SampleMatrix noiseL = noisecov_.llt().matrixL();
+  std::normal_distribution<double> gaus(0.,1.);
+  std::exponential_distribution<double> energy(1./40.);
+  std::uniform_real_distribution<double> flat(0.,1.);
+
+  PulseChiSqSNNLS pulsefunc;
+  PulseChiSqSNNLSFixed<NPULSE> pulsefuncFixed;
+  pulsefunc.setMaxIterWarnings(false);
+  pulsefuncFixed.setMaxIterWarnings(false);
+
+  for (int ievt=0; ievt<1000; ++ievt) {
+    //in-time pulse from a few to several hundred ADC counts, plus pileup
+    //in about a third of the other bunch crossings
+    SampleVector amplitudes = SampleVector::Constant(pedestal);
+    for (int ipulse=0; ipulse<bxs.rows(); ++ipulse) {
+      int bx = bxs.coeff(ipulse);
+      double amp = bx==0 ? 5.+energy(rng_)*5. : (flat(rng_)<0.3 ? energy(rng_) : 0.);
+      amplitudes += amp*fullpulse_.segment<SampleVectorSize>(7-3-bx);
+    }
+    SampleVector noise;
+    for (int i=0; i<SampleVectorSize; ++i) noise[i] = gaus(rng_);
+    amplitudes += noiseL*noise;
+    for (int i=0; i<SampleVectorSize; ++i) {
+      if (badSamples.coeff(i)>0) amplitudes[i] = 0.;
+    }
+
+    bool status = pulsefunc.DoFit(amplitudes,noisecov_,bxs,fullpulse_,fullpulsecov_,gains,badSamples);
+    bool statusFixed = pulsefuncFixed.DoFit(amplitudes,noisecov_,bxs,fullpulse_,fullpulsecov_,gains,badSamples);
+
+    CPPUNIT_ASSERT_EQUAL(status,statusFixed);
+    CPPUNIT_ASSERT(pulsefunc.BXs().rows()==NPULSE);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pulsefunc.ChiSq(),pulsefuncFixed.ChiSq(),1e-6*(1.+pulsefunc.ChiSq()));
+    for (int ipulse=0; ipulse<NPULSE; ++ipulse) {
+      CPPUNIT_ASSERT_EQUAL(int(pulsefunc.BXs().coeff(ipulse)),int(pulsefuncFixed.BXs().coeff(ipulse)));
+      double x = pulsefunc.X().coeff(ipulse);
+      double err = pulsefunc.Errors().coeff(ipulse);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(x,pulsefuncFixed.X().coeff(ipulse),1e-6*(1.+std::abs(x)));
+      //the uncertainty is not defined for some of the pulses with zero amplitude
+      if (std::isnan(err)) {
+        CPPUNIT_ASSERT(std::isnan(pulsefuncFixed.Errors().coeff(ipulse)));
+      }
+      else {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(err,pulsefuncFixed.Errors().coeff(ipulse),1e-6*(1.+std::abs(err)));
+      }
+    }
+  }
+}
+
+void testPulseChiSqSNNLSFixed::testSinglePulse()
+{
+  BXVector bxs(1);
+  bxs << 0;
+  compare<1>(bxs,-1*SampleGainVector::Ones(),SampleGainVector::Zero(),0.);
+}
+
+void testPulseChiSqSNNLSFixed::testOutOfTimePulses()
+{
+  BXVector bxs(10);
+  bxs << -5,-4,-3,-2,-1,0,1,2,3,4;
+  compare<10>(bxs,-1*SampleGainVector::Ones(),SampleGainVector::Zero(),0.);
+}
+
+void testPulseChiSqSNNLSFixed::testDynamicPedestal()
+{
+  BXVector bxs(10);
+  bxs << -5,-4,-3,-2,-1,0,1,2,3,4;
+  compare<11>(bxs,SampleGainVector::Zero(),SampleGainVector::Zero(),3.);
+}
+
+void testPulseChiSqSNNLSFixed::testBadSample()
+{
+  BXVector bxs(10);
+  bxs << -5,-4,-3,-2,-1,0,1,2,3,4;
+  SampleGainVector badSamples = SampleGainVector::Zero();
+  badSamples[4] = 1;
+  compare<12>(bxs,SampleGainVector::Zero(),badSamples,3.);
+}
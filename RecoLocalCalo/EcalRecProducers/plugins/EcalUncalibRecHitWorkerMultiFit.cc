@@ -61,6 +61,7 @@ EcalUncalibRecHitWorkerMultiFit::EcalUncalibRecHitWorkerMultiFit(const edm::Para
   addPedestalUncertaintyEB_ = ps.getParameter<double>("addPedestalUncertaintyEB");
   addPedestalUncertaintyEE_ = ps.getParameter<double>("addPedestalUncertaintyEE");
   simplifiedNoiseModelForGainSwitch_ = ps.getParameter<bool>("simplifiedNoiseModelForGainSwitch");
+  useFixedSizeFit_ = ps.getParameter<bool>("useFixedSizeFit");
   
   // algorithm to be used for timing
   auto const & timeAlgoName = ps.getParameter<std::string>("timealgo");
@@ -263,6 +264,7 @@ EcalUncalibRecHitWorkerMultiFit::run( const edm::Event & evt,
     bool barrel = (detid.subdetId()==EcalBarrel);
 
     multiFitMethod_.setSimplifiedNoiseModelForGainSwitch(simplifiedNoiseModelForGainSwitch_);
+    multiFitMethod_.setUseFixedSizeFit(useFixedSizeFit_);
     if (barrel) {
         multiFitMethod_.setDoPrefit(doPrefitEB_);
         multiFitMethod_.setPrefitMaxChiSq(prefitMaxChiSqEB_);
@@ -568,6 +570,7 @@ EcalUncalibRecHitWorkerMultiFit::getAlgoDescription() {
 	      edm::ParameterDescription<double>("addPedestalUncertaintyEB", 0., true) and
 	      edm::ParameterDescription<double>("addPedestalUncertaintyEE", 0., true) and
 	      edm::ParameterDescription<bool>("simplifiedNoiseModelForGainSwitch", true, true) and
+	      edm::ParameterDescription<bool>("useFixedSizeFit", false, true) and
 	      edm::ParameterDescription<std::string>("timealgo", "RatioMethod", true) and
 	      edm::ParameterDescription<std::vector<double>>("EBtimeFitParameters", {-2.015452e+00, 3.130702e+00, -1.234730e+01, 4.188921e+01, -8.283944e+01, 9.101147e+01, -5.035761e+01, 1.105621e+01}, true) and
 	      edm::ParameterDescription<std::vector<double>>("EEtimeFitParameters", {-2.390548e+00, 3.553628e+00, -1.762341e+01, 6.767538e+01, -1.332130e+02, 1.407432e+02, -7.541106e+01, 1.620277e+01}, true) and
@@ -101,6 +101,7 @@ class EcalUncalibRecHitWorkerMultiFit final : public EcalUncalibRecHitWorkerBase
                 double addPedestalUncertaintyEB_;
                 double addPedestalUncertaintyEE_;
                 bool simplifiedNoiseModelForGainSwitch_;
+                bool useFixedSizeFit_;
 
                 // ratio method
                 std::vector<double> EBtimeFitParameters_; 
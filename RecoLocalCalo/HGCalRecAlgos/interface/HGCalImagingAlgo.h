@@ -17,12 +17,14 @@
 #include "RecoLocalCalo/HGCalRecAlgos/interface/RecHitTools.h"
 
 // C/C++ headers
+#include <ostream>
 #include <string>
 #include <vector>
 #include <set>
 #include <numeric>
 
 #include "KDTreeLinkerAlgoT.h"
+#include "HGCalLayerTiles.h"
 
 
 template <typename T>
@@ -128,7 +130,24 @@ void setVerbosity(VerbosityLevel the_verbosity)
         verbosity = the_verbosity;
 }
 
+// use per-layer tiles instead of KDTrees for the neighbour searches
+void setUseTiles(bool use_tiles)
+{
+        useTiles = use_tiles;
+}
+
+// with tiles, cluster the layers concurrently (TBB)
+void setParallelLayers(bool parallel_layers)
+{
+        parallelLayers = parallel_layers;
+}
+
 void populate(const HGCRecHitCollection &hits);
+// adds a hit to a layer (index as in populate, the positive endcap from
+// maxlayer+1) without the geometry, as populate does for a rechit above
+// threshold; used by the tests
+void addHit(const unsigned int layer, const DetId detid, const float x, const float y, const float z,
+            const float energy, const float sigmaNoise = 1.f);
 // this is the method that will start the clusterisation (it is possible to invoke this method more than once - but make sure it is with
 // different hit collections (or else use reset)
 void makeClusters();
@@ -208,6 +227,11 @@ VerbosityLevel verbosity;
 // initialization bool
 bool initialized;
 
+// neighbour search backend
+bool useTiles = false;
+bool parallelLayers = false;
+std::vector<HGCalLayerTiles> tiles_;
+
 struct Hexel {
 
         double x;
@@ -250,8 +274,10 @@ struct Hexel {
                 tools(nullptr)
         {
         }
+        // equal densities are ordered by detid, so that the clustering
+        // does not depend on the order of the hits
         bool operator > (const Hexel& rhs) const {
-                return (rho > rhs.rho);
+                return (rho > rhs.rho || (rho == rhs.rho && detid < rhs.detid));
         }
 
 };
@@ -268,7 +294,9 @@ std::vector<size_t> sort_by_delta(const std::vector<KDNode> &v){
         std::iota (std::begin(idx), std::end(idx), 0);
         sort(idx.begin(), idx.end(),
              [&v](size_t i1, size_t i2) {
-                        return v[i1].data.delta > v[i2].data.delta;
+                        // ties as for sorted_indices, independent of the order of the hits
+                        if(v[i1].data.delta != v[i2].data.delta) return v[i1].data.delta > v[i2].data.delta;
+                        return v[i1].data > v[i2].data;
                 });
         return idx;
 }
@@ -289,9 +317,23 @@ inline double distance2(const Hexel &pt1, const Hexel &pt2) {   //distance squar
 inline double distance(const Hexel &pt1, const Hexel &pt2) {   //2-d distance on the layer (x-y)
         return std::sqrt(distance2(pt1,pt2));
 }
+inline float criticalDistance(const unsigned int layer) const {
+        if( layer <= lastLayerEE ) return vecDeltas[0];
+        else if( layer <= lastLayerFH ) return vecDeltas[1];
+        return vecDeltas[2];
+}
 double calculateLocalDensity(std::vector<KDNode> &, KDTree &, const unsigned int);   //return max density
+double calculateLocalDensity(std::vector<KDNode> &, const HGCalLayerTiles &, const unsigned int);   //return max density
 double calculateDistanceToHigher(std::vector<KDNode> &);
 int findAndAssignClusters(std::vector<KDNode> &, KDTree &, double, KDTreeBox &, const unsigned int);
+// flags cluster centers and assigns all hits to clusters, returns number of clusters
+unsigned int assignClusterCenters(std::vector<KDNode> &, double, const unsigned int, std::ostream &);
+// appends the clusters of one layer to current_v
+void storeClusters(const std::vector<KDNode> &, const unsigned int);
+// full per-layer clustering with tiles; only touches the given layer, so
+// layers can run concurrently; the verbose output goes to the given
+// stream; returns number of clusters
+unsigned int clusterLayerWithTiles(std::vector<KDNode> &, HGCalLayerTiles &, const unsigned int, std::ostream &);
 math::XYZPoint calculatePosition(std::vector<KDNode> &);
 
 // attempt to find subclusters within a given set of hexels
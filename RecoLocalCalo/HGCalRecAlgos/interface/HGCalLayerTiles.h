@@ -0,0 +1,127 @@
+#ifndef RecoLocalCalo_HGCalRecAlgos_HGCalLayerTiles_h
+#define RecoLocalCalo_HGCalRecAlgos_HGCalLayerTiles_h
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Flat spatial index for the hits of one HGCal layer: a regular x-y grid
+// of square tiles, with the hits of each tile stored contiguously.
+// Hit indices and coordinates are kept in tile order in plain arrays
+// (counting sort on fill, no per-tile allocations), so that a box query
+// is a scan over a few contiguous ranges. The arrays are reused from one
+// fill to the next.
+class HGCalLayerTiles
+{
+public:
+
+  HGCalLayerTiles() : nBinsX_(0), nBinsY_(0), xMin_(0.f), yMin_(0.f), invBinSize_(1.f) {}
+
+  // index the hits in nodes (anything with dims[0] = x, dims[1] = y); the
+  // bin size is normally set to the search radius, so that a query touches
+  // at most 3x3 tiles
+  template <typename Node>
+  void fill(const std::vector<Node>& nodes,
+            float xmin, float xmax, float ymin, float ymax, float binSize);
+
+  void clear() {
+    nBinsX_ = nBinsY_ = 0;
+    binStart_.clear();
+    index_.clear();
+    x_.clear();
+    y_.clear();
+  }
+
+  // calls f(i) for the index i in the filled vector of every hit with
+  // xmin <= x <= xmax and ymin <= y <= ymax (same box convention as
+  // KDTreeLinkerAlgo::search)
+  template <typename F>
+  void forEachInBox(float xmin, float xmax, float ymin, float ymax, F&& f) const;
+
+  unsigned int nBinsX() const { return nBinsX_; }
+  unsigned int nBinsY() const { return nBinsY_; }
+
+private:
+
+  int binX(float x) const {
+    return std::min<int>(nBinsX_-1, std::max(0, int((x - xMin_)*invBinSize_)));
+  }
+  int binY(float y) const {
+    return std::min<int>(nBinsY_-1, std::max(0, int((y - yMin_)*invBinSize_)));
+  }
+
+  unsigned int nBinsX_;
+  unsigned int nBinsY_;
+  float xMin_;
+  float yMin_;
+  float invBinSize_;
+
+  // hits of tile b are [binStart_[b], binStart_[b+1]) in the arrays below
+  std::vector<unsigned int> binStart_;
+  std::vector<unsigned int> index_;
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<unsigned int> hitBin_;
+};
+
+template <typename Node>
+void HGCalLayerTiles::fill(const std::vector<Node>& nodes,
+                           float xmin, float xmax, float ymin, float ymax, float binSize) {
+  const unsigned int n = nodes.size();
+  if (n == 0) {
+    clear();
+    return;
+  }
+
+  // cap the number of tiles so that a few far-away hits cannot blow up the grid
+  constexpr unsigned int maxBinsPerDim = 512;
+  const float width = std::max(xmax - xmin, ymax - ymin);
+  if (binSize <= 0.f || width/binSize > maxBinsPerDim) binSize = std::max(width/maxBinsPerDim, 1e-3f);
+
+  xMin_ = xmin;
+  yMin_ = ymin;
+  invBinSize_ = 1.f/binSize;
+  nBinsX_ = std::max(1, int(std::ceil((xmax - xmin)*invBinSize_)) + 1);
+  nBinsY_ = std::max(1, int(std::ceil((ymax - ymin)*invBinSize_)) + 1);
+
+  const unsigned int nBins = nBinsX_*nBinsY_;
+  binStart_.assign(nBins + 1, 0);
+  hitBin_.resize(n);
+  index_.resize(n);
+  x_.resize(n);
+  y_.resize(n);
+
+  // counting sort of the hits by tile
+  for (unsigned int i = 0; i < n; ++i) {
+    const unsigned int b = binY(nodes[i].dims[1])*nBinsX_ + binX(nodes[i].dims[0]);
+    hitBin_[i] = b;
+    ++binStart_[b + 1];
+  }
+  for (unsigned int b = 0; b < nBins; ++b) binStart_[b + 1] += binStart_[b];
+  for (unsigned int i = 0; i < n; ++i) {
+    const unsigned int pos = binStart_[hitBin_[i]]++;
+    index_[pos] = i;
+    x_[pos] = nodes[i].dims[0];
+    y_[pos] = nodes[i].dims[1];
+  }
+  // the increments above shifted every start to the next tile's start
+  for (unsigned int b = nBins; b > 0; --b) binStart_[b] = binStart_[b - 1];
+  binStart_[0] = 0;
+}
+
+template <typename F>
+void HGCalLayerTiles::forEachInBox(float xmin, float xmax, float ymin, float ymax, F&& f) const {
+  if (nBinsX_ == 0) return;
+  const int bxMin = binX(xmin), bxMax = binX(xmax);
+  const int byMin = binY(ymin), byMax = binY(ymax);
+  for (int by = byMin; by <= byMax; ++by) {
+    // tiles of a row are adjacent, so the whole x range is one contiguous scan
+    const unsigned int begin = binStart_[by*nBinsX_ + bxMin];
+    const unsigned int end = binStart_[by*nBinsX_ + bxMax + 1];
+    for (unsigned int k = begin; k < end; ++k) {
+      if (x_[k] >= xmin && x_[k] <= xmax && y_[k] >= ymin && y_[k] <= ymax) f(index_[k]);
+    }
+  }
+}
+
+#endif
@@ -10,6 +10,11 @@
 //
 #include "DataFormats/CaloRecHit/interface/CaloID.h"
 
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <sstream>
+
 void HGCalImagingAlgo::populate(const HGCRecHitCollection& hits){
   //loop over all hits and create the Hexel structure, skip energies below ecut
 
@@ -63,12 +68,61 @@ void HGCalImagingAlgo::populate(const HGCRecHitCollection& hits){
   } // end loop hits
 
 }
+
+void HGCalImagingAlgo::addHit(const unsigned int layer, const DetId detid, const float x, const float y, const float z,
+                              const float energy, const float sigmaNoise){
+  Hexel hexel;
+  hexel.x = x; hexel.y = y; hexel.z = z;
+  hexel.weight = energy;
+  hexel.detid = detid;
+  hexel.sigmaNoise = sigmaNoise;
+
+  if(points[layer].empty()){
+    minpos[layer][0] = x; minpos[layer][1] = y;
+    maxpos[layer][0] = x; maxpos[layer][1] = y;
+  }else{
+    minpos[layer][0] = std::min(x,minpos[layer][0]);
+    minpos[layer][1] = std::min(y,minpos[layer][1]);
+    maxpos[layer][0] = std::max(x,maxpos[layer][0]);
+    maxpos[layer][1] = std::max(y,maxpos[layer][1]);
+  }
+  points[layer].emplace_back(hexel,x,y);
+}
 // Create a vector of Hexels associated to one cluster from a collection of HGCalRecHits - this can be used
 // directly to make the final cluster list - this method can be invoked multiple times for the same event
 // with different input (reset should be called between events)
 void HGCalImagingAlgo::makeClusters()
 {
 
+  if (useTiles) {
+    const unsigned int nLayers = 2*(maxlayer+1);
+    tiles_.resize(nLayers);
+    std::vector<unsigned int> nClusters(nLayers, 0);
+    // the verbose output of each layer is kept until its clusters are stored
+    std::vector<std::ostringstream> logs(verbosity < pINFO ? nLayers : 0);
+    auto log = [&](unsigned int i) -> std::ostream & { return logs.empty() ? std::cout : logs[i]; };
+
+    // layers are independent until their clusters are stored, which is
+    // done afterwards in layer order so the output does not depend on
+    // the scheduling
+    if (parallelLayers) {
+      tbb::this_task_arena::isolate([&] {
+          tbb::parallel_for(0U, nLayers, [&](unsigned int i) {
+              nClusters[i] = clusterLayerWithTiles(points[i], tiles_[i], i, log(i));
+            });
+        });
+    } else {
+      for (unsigned int i = 0; i < nLayers; ++i)
+        nClusters[i] = clusterLayerWithTiles(points[i], tiles_[i], i, log(i));
+    }
+
+    for (unsigned int i = 0; i < nLayers; ++i) {
+      if (!logs.empty()) std::cout << logs[i].str();
+      if (nClusters[i] > 0) storeClusters(points[i], nClusters[i]);
+    }
+    return;
+  }
+
   // used for speedy search
   std::vector<KDTree> hit_kdtree(2*(maxlayer+1));
 
@@ -209,10 +263,8 @@ math::XYZPoint HGCalImagingAlgo::calculatePosition(std::vector<KDNode> &v){
 double HGCalImagingAlgo::calculateLocalDensity(std::vector<KDNode> &nd, KDTree &lp, const unsigned int layer){
 
   double maxdensity = 0.;
-  float delta_c; // maximum search distance (critical distance) for local density calculation
-  if( layer<= lastLayerEE ) delta_c = vecDeltas[0];
-  else if( layer <= lastLayerFH) delta_c = vecDeltas[1];
-  else delta_c = vecDeltas[2];
+  // maximum search distance (critical distance) for local density calculation
+  const float delta_c = criticalDistance(layer);
 
   // for each node calculate local density rho and store it
   for(unsigned int i = 0; i < nd.size(); ++i){
@@ -289,66 +341,21 @@ int HGCalImagingAlgo::findAndAssignClusters(std::vector<KDNode> &nd,KDTree &lp,
   //so when filling the cluster temporary vector of Hexels we resize each time by the number
   //of clusters found. This is always equal to the number of cluster centers...
 
-  unsigned int clusterIndex = 0;
-  float delta_c; // critical distance
-  if( layer<=lastLayerEE ) delta_c = vecDeltas[0];
-  else if( layer<=lastLayerFH ) delta_c = vecDeltas[1];
-  else delta_c = vecDeltas[2];
-
-  std::vector<size_t> rs = sorted_indices(nd); // indices sorted by decreasing rho
-  std::vector<size_t> ds = sort_by_delta(nd); // sort in decreasing distance to higher
+  const float delta_c = criticalDistance(layer);
 
-  const unsigned int nd_size = nd.size();
-  for(unsigned int i=0; i < nd_size; ++i){
-
-    if(nd[ds[i]].data.delta < delta_c) break; // no more cluster centers to be looked at
-    if(dependSensor){
-
-      float rho_c = kappa*nd[ds[i]].data.sigmaNoise;
-      if(nd[ds[i]].data.rho < rho_c ) continue; // set equal to kappa times noise threshold
-
-    }
-    else if(nd[ds[i]].data.rho*kappa < maxdensity)
-      continue;
-
-
-    nd[ds[i]].data.clusterIndex = clusterIndex;
-    if (verbosity < pINFO)
-      {
-	    std::cout << "Adding new cluster with index " << clusterIndex+cluster_offset << std::endl;
-	    std::cout << "Cluster center is hit " << ds[i] << std::endl;
-      }
-    clusterIndex++;
-  }
+  unsigned int clusterIndex = assignClusterCenters(nd, maxdensity, layer, std::cout);
 
   //at this point clusterIndex is equal to the number of cluster centers - if it is zero we are
   //done
   if(clusterIndex==0) return clusterIndex;
 
-  //assign remaining points to clusters, using the nearestHigher set from previous step (always set except
-  // for top density hit that is skipped...)
-  for(unsigned int oi =1; oi < nd_size; ++oi){
-    unsigned int i = rs[oi];
-    int ci = nd[i].data.clusterIndex;
-    if(ci == -1){ // clusterIndex is initialised with -1 if not yet used in cluster
-      nd[i].data.clusterIndex =  nd[nd[i].data.nearestHigher].data.clusterIndex;
-    }
-  }
-
-  //make room in the temporary cluster vector for the additional clusterIndex clusters
-  // from this layer
-  if (verbosity < pINFO)
-    {
-      std::cout << "resizing cluster vector by "<< clusterIndex << std::endl;
-    }
-  current_v.resize(cluster_offset+clusterIndex);
-
   //assign points closer than dc to other clusters to border region
   //and find critical border density
   std::vector<double> rho_b(clusterIndex,0.);
   lp.clear();
   lp.build(nd,bounds);
   //now loop on all hits again :( and check: if there are hits from another cluster within d_c -> flag as border hit
+  const unsigned int nd_size = nd.size();
   for(unsigned int i = 0; i < nd_size; ++i){
     int ci = nd[i].data.clusterIndex;
     bool flag_isolated = true;
@@ -384,11 +391,75 @@ int HGCalImagingAlgo::findAndAssignClusters(std::vector<KDNode> &nd,KDTree &lp,
       rho_b[ci] = nd[i].data.rho;
   } // end loop all hits
 
-  //flag points in cluster with density < rho_b as halo points, then fill the cluster vector
+  //flag points in cluster with density < rho_b as halo points
+  for(unsigned int i = 0; i < nd_size; ++i){
+    int ci = nd[i].data.clusterIndex;
+    if(ci!=-1 && nd[i].data.rho <= rho_b[ci]) nd[i].data.isHalo = true;
+  }
+
+  storeClusters(nd, clusterIndex);
+  return clusterIndex;
+}
+
+unsigned int HGCalImagingAlgo::assignClusterCenters(std::vector<KDNode> &nd, double maxdensity, const unsigned int layer, std::ostream &log){
+
+  unsigned int clusterIndex = 0;
+  const float delta_c = criticalDistance(layer);
+
+  std::vector<size_t> rs = sorted_indices(nd); // indices sorted by decreasing rho
+  std::vector<size_t> ds = sort_by_delta(nd); // sort in decreasing distance to higher
+
+  const unsigned int nd_size = nd.size();
+  for(unsigned int i=0; i < nd_size; ++i){
+
+    if(nd[ds[i]].data.delta < delta_c) break; // no more cluster centers to be looked at
+    if(dependSensor){
+
+      float rho_c = kappa*nd[ds[i]].data.sigmaNoise;
+      if(nd[ds[i]].data.rho < rho_c ) continue; // set equal to kappa times noise threshold
+
+    }
+    else if(nd[ds[i]].data.rho*kappa < maxdensity)
+      continue;
+
+
+    nd[ds[i]].data.clusterIndex = clusterIndex;
+    if (verbosity < pINFO)
+      {
+	    log << "Adding new cluster with index " << clusterIndex << " on layer " << layer << std::endl;
+	    log << "Cluster center is hit " << ds[i] << std::endl;
+      }
+    clusterIndex++;
+  }
+
+  if(clusterIndex==0) return clusterIndex;
+
+  //assign remaining points to clusters, using the nearestHigher set from previous step (always set except
+  // for top density hit that is skipped...)
+  for(unsigned int oi =1; oi < nd_size; ++oi){
+    unsigned int i = rs[oi];
+    int ci = nd[i].data.clusterIndex;
+    if(ci == -1){ // clusterIndex is initialised with -1 if not yet used in cluster
+      nd[i].data.clusterIndex =  nd[nd[i].data.nearestHigher].data.clusterIndex;
+    }
+  }
+  return clusterIndex;
+}
+
+void HGCalImagingAlgo::storeClusters(const std::vector<KDNode> &nd, const unsigned int nClusters){
+
+  //make room in the temporary cluster vector for the additional clusters
+  // from this layer
+  if (verbosity < pINFO)
+    {
+      std::cout << "resizing cluster vector by "<< nClusters << std::endl;
+    }
+  current_v.resize(cluster_offset+nClusters);
+
+  const unsigned int nd_size = nd.size();
   for(unsigned int i = 0; i < nd_size; ++i){
     int ci = nd[i].data.clusterIndex;
     if(ci!=-1) {
-      if (nd[i].data.rho <= rho_b[ci]) nd[i].data.isHalo = true;
       current_v[ci+cluster_offset].push_back(nd[i]);
       if (verbosity < pINFO)
 	  {
@@ -401,10 +472,73 @@ int HGCalImagingAlgo::findAndAssignClusters(std::vector<KDNode> &nd,KDTree &lp,
   //prepare the offset for the next layer if there is one
   if (verbosity < pINFO)
     {
-      std::cout << "moving cluster offset by " << clusterIndex << std::endl;
+      std::cout << "moving cluster offset by " << nClusters << std::endl;
     }
-  cluster_offset += clusterIndex;
-  return clusterIndex;
+  cluster_offset += nClusters;
+}
+
+double HGCalImagingAlgo::calculateLocalDensity(std::vector<KDNode> &nd, const HGCalLayerTiles &tiles, const unsigned int layer){
+
+  double maxdensity = 0.;
+  const float delta_c = criticalDistance(layer);
+
+  // same as the KDTree version, with the tiles providing the candidates
+  // inside the +/- delta_c window
+  for(unsigned int i = 0; i < nd.size(); ++i){
+    tiles.forEachInBox(nd[i].dims[0]-delta_c,nd[i].dims[0]+delta_c,
+		       nd[i].dims[1]-delta_c,nd[i].dims[1]+delta_c,
+		       [&](unsigned int j){
+			 if(distance(nd[i].data,nd[j].data) < delta_c){
+			   nd[i].data.rho += nd[j].data.weight;
+			   if(nd[i].data.rho > maxdensity) maxdensity = nd[i].data.rho;
+			 }
+		       });
+  }
+  return maxdensity;
+}
+
+unsigned int HGCalImagingAlgo::clusterLayerWithTiles(std::vector<KDNode> &nd, HGCalLayerTiles &tiles, const unsigned int layer, std::ostream &log){
+
+  // layer is the index into points (both endcaps), actualLayer the physical one
+  const unsigned int actualLayer = layer > maxlayer ? (layer-(maxlayer+1)) : layer;
+  const float delta_c = criticalDistance(actualLayer);
+
+  tiles.fill(nd, minpos[layer][0], maxpos[layer][0], minpos[layer][1], maxpos[layer][1], delta_c);
+
+  double maxdensity = calculateLocalDensity(nd, tiles, actualLayer);
+  calculateDistanceToHigher(nd);
+  unsigned int nClusters = assignClusterCenters(nd, maxdensity, actualLayer, log);
+  if(nClusters==0) return nClusters;
+
+  // border and halo flagging; the tiles index nd by position, so unlike
+  // the KDTree they see the cluster indices just assigned without a rebuild
+  std::vector<double> rho_b(nClusters,0.);
+  const unsigned int nd_size = nd.size();
+  for(unsigned int i = 0; i < nd_size; ++i){
+    int ci = nd[i].data.clusterIndex;
+    if(ci != -1){
+      bool flag_isolated = true;
+      bool isBorder = false;
+      tiles.forEachInBox(nd[i].dims[0]-delta_c,nd[i].dims[0]+delta_c,
+			 nd[i].dims[1]-delta_c,nd[i].dims[1]+delta_c,
+			 [&](unsigned int j){
+			   if(isBorder || nd[j].data.clusterIndex==-1) return;
+			   float dist = distance(nd[j].data,nd[i].data);
+			   if(dist < delta_c && nd[j].data.clusterIndex!=ci) isBorder = true;
+			   else if(dist < delta_c && dist != 0.) flag_isolated = false;
+			 });
+      if(isBorder || flag_isolated) nd[i].data.isBorder = true;
+      if(nd[i].data.isBorder && rho_b[ci] < nd[i].data.rho)
+	rho_b[ci] = nd[i].data.rho;
+    }
+  }
+
+  for(unsigned int i = 0; i < nd_size; ++i){
+    int ci = nd[i].data.clusterIndex;
+    if(ci!=-1 && nd[i].data.rho <= rho_b[ci]) nd[i].data.isHalo = true;
+  }
+
+  return nClusters;
 }
 
 // find local maxima within delta_c, marking the indices in the cluster
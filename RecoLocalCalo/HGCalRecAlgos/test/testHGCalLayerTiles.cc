@@ -0,0 +1,230 @@
+//
+// Cross-check and timing of the two neighbour searches available to
+// HGCalImagingAlgo: KDTreeLinkerAlgo and HGCalLayerTiles. For random hits
+// on a layer-sized area, the weighted local density within the critical
+// distance is computed with both and compared hit by hit.
+// Then showers on a grid of cells, where equal distances are common, are
+// clustered by HGCalImagingAlgo with the KDTrees, with the tiles and with
+// the tiles and parallel layers, and the clusters (hits and fractions,
+// energy and position) are compared.
+//
+// Usage: testHGCalLayerTiles [nHitsPerLayer] [nLayers]
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "RecoLocalCalo/HGCalRecAlgos/interface/KDTreeLinkerAlgoT.h"
+#include "RecoLocalCalo/HGCalRecAlgos/interface/HGCalLayerTiles.h"
+#include "RecoLocalCalo/HGCalRecAlgos/interface/HGCalImagingAlgo.h"
+
+namespace {
+  struct Hit {
+    unsigned int id;
+    float weight;
+    double rho;
+  };
+  typedef KDTreeNodeInfoT<Hit,2> Node;
+
+  inline float dist2(const Node& a, const Node& b) {
+    const float dx = a.dims[0]-b.dims[0], dy = a.dims[1]-b.dims[1];
+    return dx*dx + dy*dy;
+  }
+
+  // showers on top of a flat noise floor, roughly like a busy pileup layer
+  std::vector<Node> makeLayer(std::mt19937& rng, unsigned int n) {
+    std::uniform_real_distribution<float> r(32.f, 160.f), phi(-M_PI, M_PI);
+    std::normal_distribution<float> core(0.f, 1.5f);
+    std::exponential_distribution<float> energy(1.f);
+    std::vector<Node> nodes;
+    nodes.reserve(n);
+    float cx = 0.f, cy = 0.f;
+    for (unsigned int i = 0; i < n; ++i) {
+      float x, y;
+      if (i % 20 == 0 || i % 2 == 1) {
+        const float rr = r(rng), pp = phi(rng);
+        x = rr*std::cos(pp);
+        y = rr*std::sin(pp);
+        if (i % 20 == 0) { cx = x; cy = y; }
+      } else {
+        x = cx + core(rng);
+        y = cy + core(rng);
+      }
+      nodes.emplace_back(Hit{i, energy(rng), 0.}, x, y);
+    }
+    return nodes;
+  }
+
+  void bounds(const std::vector<Node>& nodes, float& xmin, float& xmax, float& ymin, float& ymax) {
+    xmin = ymin = 1e9f;
+    xmax = ymax = -1e9f;
+    for (auto const& n : nodes) {
+      xmin = std::min(xmin, n.dims[0]); xmax = std::max(xmax, n.dims[0]);
+      ymin = std::min(ymin, n.dims[1]); ymax = std::max(ymax, n.dims[1]);
+    }
+  }
+
+  struct CellHit {
+    unsigned int layer;
+    DetId detid;
+    float x, y, z, energy;
+  };
+
+  // showers on a grid of 1 cm cells, above a small noise
+  std::vector<CellHit> makeGridHits(std::mt19937& rng, unsigned int nLayers) {
+    const int nCells = 80;
+    std::uniform_int_distribution<int> cell(0, nCells-1);
+    std::exponential_distribution<float> energy(1.f), noise(20.f);
+    std::vector<CellHit> hits;
+    for (unsigned int l = 0; l < nLayers; ++l) {
+      // both endcaps, as indexed by HGCalImagingAlgo
+      const unsigned int layer = 1 + l%HGCalImagingAlgo::maxlayer + (l/HGCalImagingAlgo::maxlayer)*(HGCalImagingAlgo::maxlayer+1);
+      std::vector<float> e(nCells*nCells);
+      for (auto& c : e) c = noise(rng);
+      for (unsigned int s = 0; s < 20; ++s) {
+        const int cx = cell(rng), cy = cell(rng);
+        const float e0 = 10.f*energy(rng);
+        for (int ix = std::max(0, cx-4); ix <= std::min(nCells-1, cx+4); ++ix)
+          for (int iy = std::max(0, cy-4); iy <= std::min(nCells-1, cy+4); ++iy)
+            e[ix*nCells+iy] += e0*std::exp(-std::hypot(float(ix-cx), float(iy-cy)));
+      }
+      for (int ix = 0; ix < nCells; ++ix)
+        for (int iy = 0; iy < nCells; ++iy)
+          if (e[ix*nCells+iy] > 0.1f)
+            hits.push_back(CellHit{layer, DetId((layer << 16) | (ix << 8) | iy), float(ix - nCells/2), float(iy - nCells/2),
+                                   320.f + layer, e[ix*nCells+iy]});
+    }
+    // the hits of the layers mixed, as in the rechit collections
+    std::shuffle(hits.begin(), hits.end(), rng);
+    return hits;
+  }
+
+  std::vector<reco::BasicCluster> cluster(const std::vector<CellHit>& hits, bool useTiles, bool parallelLayers, double& time) {
+    HGCalImagingAlgo algo({2., 2., 5.}, 9., 0., reco::CaloCluster::hgcal_em, false,
+                          {}, {}, {}, 1., {}, 1.);
+    algo.setUseTiles(useTiles);
+    algo.setParallelLayers(parallelLayers);
+    for (auto const& h : hits) algo.addHit(h.layer, h.detid, h.x, h.y, h.z, h.energy);
+    auto start = std::chrono::steady_clock::now();
+    algo.makeClusters();
+    auto stop = std::chrono::steady_clock::now();
+    time = std::chrono::duration<double>(stop-start).count();
+    return algo.getClusters(false);
+  }
+
+  // the clusters must be the same and in the same order; the hits of a
+  // cluster are in the order of the hits of the layer, which the KDTree
+  // reorders, so they are compared as sorted lists
+  unsigned int compare(const std::vector<reco::BasicCluster>& ref, const std::vector<reco::BasicCluster>& test, const char* name) {
+    if (ref.size() != test.size()) {
+      std::cout << name << ": " << test.size() << " clusters instead of " << ref.size() << "\n";
+      return 1;
+    }
+    unsigned int nBad = 0;
+    for (unsigned int i = 0; i < ref.size(); ++i) {
+      auto a = ref[i].hitsAndFractions(), b = test[i].hitsAndFractions();
+      std::sort(a.begin(), a.end());
+      std::sort(b.begin(), b.end());
+      const bool sameHits = a == b;
+      const bool sameEnergy = std::abs(ref[i].energy() - test[i].energy()) <= 1e-9*std::max(1., ref[i].energy());
+      const bool samePosition = (ref[i].position() - test[i].position()).r() <= 1e-4*(1. + ref[i].position().r());
+      if (!(sameHits && sameEnergy && samePosition)) {
+        if (nBad < 10)
+          std::cout << name << ": cluster " << i << " differs: " << a.size() << "/" << b.size() << " hits, energy "
+                    << ref[i].energy() << "/" << test[i].energy() << ", position " << ref[i].position()
+                    << "/" << test[i].position() << "\n";
+        ++nBad;
+      }
+    }
+    return nBad;
+  }
+}
+
+int main(int argc, char** argv) {
+  const unsigned int nHits = argc > 1 ? std::atoi(argv[1]) : 5000;
+  const unsigned int nLayers = argc > 2 ? std::atoi(argv[2]) : 104;
+  const float delta_c = 2.f;
+
+  std::mt19937 rng(4321);
+  std::vector<std::vector<Node> > layers;
+  for (unsigned int l = 0; l < nLayers; ++l) layers.push_back(makeLayer(rng, nHits));
+
+  // the KDTree reorders its input, so each method works on its own copy
+  std::vector<std::vector<Node> > kdLayers(layers), tileLayers(layers);
+  HGCalLayerTiles tiles;
+  double tKD = 0, tTiles = 0;
+
+  for (unsigned int l = 0; l < nLayers; ++l) {
+    float xmin, xmax, ymin, ymax;
+    bounds(layers[l], xmin, xmax, ymin, ymax);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Node>& nd = kdLayers[l];
+    KDTreeLinkerAlgo<Hit,2> tree;
+    KDTreeBox box(xmin, xmax, ymin, ymax);
+    tree.build(nd, box);
+    std::vector<Node> found;
+    for (auto& n : nd) {
+      found.clear();
+      tree.search(KDTreeBox(n.dims[0]-delta_c, n.dims[0]+delta_c, n.dims[1]-delta_c, n.dims[1]+delta_c), found);
+      for (auto const& f : found)
+        if (dist2(n, f) < delta_c*delta_c) n.data.rho += f.data.weight;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    tKD += std::chrono::duration<double>(stop-start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Node>& td = tileLayers[l];
+    tiles.fill(td, xmin, xmax, ymin, ymax, delta_c);
+    for (auto& n : td) {
+      tiles.forEachInBox(n.dims[0]-delta_c, n.dims[0]+delta_c, n.dims[1]-delta_c, n.dims[1]+delta_c,
+                         [&](unsigned int j) {
+                           if (dist2(n, td[j]) < delta_c*delta_c) n.data.rho += td[j].data.weight;
+                         });
+    }
+    stop = std::chrono::steady_clock::now();
+    tTiles += std::chrono::duration<double>(stop-start).count();
+  }
+
+  // compare per hit; the summation order differs between the two searches
+  unsigned int nBad = 0;
+  for (unsigned int l = 0; l < nLayers; ++l) {
+    std::vector<double> rhoKD(nHits);
+    for (auto const& n : kdLayers[l]) rhoKD[n.data.id] = n.data.rho;
+    for (auto const& n : tileLayers[l]) {
+      if (std::abs(rhoKD[n.data.id] - n.data.rho) > 1e-9*std::max(1., n.data.rho)) {
+        if (nBad < 10)
+          std::cout << "layer " << l << " hit " << n.data.id << ": kdtree " << rhoKD[n.data.id]
+                    << " tiles " << n.data.rho << "\n";
+        ++nBad;
+      }
+    }
+  }
+
+  std::cout << "hits: " << nHits << " x " << nLayers << " layers\n"
+            << "kdtree: " << 1e3*tKD/nLayers << " ms/layer\n"
+            << "tiles:  " << 1e3*tTiles/nLayers << " ms/layer\n"
+            << "mismatches: " << nBad << std::endl;
+
+  // the clusters of the three clustering modes
+  const unsigned int nClusterLayers = std::min(nLayers, 2*HGCalImagingAlgo::maxlayer);
+  std::vector<CellHit> gridHits = makeGridHits(rng, nClusterLayers);
+  double tClusterKD, tClusterTiles, tClusterParallel;
+  std::vector<reco::BasicCluster> kdClusters = cluster(gridHits, false, false, tClusterKD);
+  unsigned int nBadClusters = compare(kdClusters, cluster(gridHits, true, false, tClusterTiles), "tiles");
+  nBadClusters += compare(kdClusters, cluster(gridHits, true, true, tClusterParallel), "parallel tiles");
+
+  std::cout << "grid hits: " << gridHits.size() << " on " << nClusterLayers << " layers, "
+            << kdClusters.size() << " clusters\n"
+            << "kdtree clustering:         " << 1e3*tClusterKD << " ms\n"
+            << "tiles clustering:          " << 1e3*tClusterTiles << " ms\n"
+            << "parallel tiles clustering: " << 1e3*tClusterParallel << " ms\n"
+            << "cluster mismatches: " << nBadClusters << std::endl;
+
+  return nBad == 0 && nBadClusters == 0 ? 0 : 1;
+}
@@ -96,6 +96,8 @@ HGCalClusterProducer::HGCalClusterProducer(const edm::ParameterSet &ps) :
   }else{
     algo = std::make_unique<HGCalImagingAlgo>(vecDeltas, kappa, ecut, algoId, dependSensor, dEdXweights, thicknessCorrection, fcPerMip, fcPerEle, nonAgedNoises, noiseMip, verbosity);
   }
+  algo->setUseTiles(ps.getParameter<bool>("useTiles"));
+  algo->setParallelLayers(ps.getParameter<bool>("parallelLayers"));
 
   auto sumes = consumesCollector();
 
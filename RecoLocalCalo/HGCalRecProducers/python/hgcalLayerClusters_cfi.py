@@ -20,6 +20,10 @@ hgcalLayerClusters =  cms.EDProducer(
     multiclusterRadii = cms.vdouble(2.,5.,5.),
     minClusters = cms.uint32(3),
     verbosity = cms.untracked.uint32(3),
+    # neighbour search on per-layer tiles instead of KD-trees,
+    # optionally clustering the layers in parallel
+    useTiles = cms.bool(False),
+    parallelLayers = cms.bool(False),
     HGCEEInput = cms.InputTag('HGCalRecHit:HGCEERecHits'),
     HGCFHInput = cms.InputTag('HGCalRecHit:HGCHEFRecHits'),
     HGCBHInput = cms.InputTag('HGCalRecHit:HGCHEBRecHits'),
@@ -1,6 +1,8 @@
 #ifndef RecoLocalCalo_HcalRecAlgos_AbsHBHEPhase1Algo_h_
 #define RecoLocalCalo_HcalRecAlgos_AbsHBHEPhase1Algo_h_
 
+#include <vector>
+
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "DataFormats/HcalRecHit/interface/HBHERecHit.h"
 #include "DataFormats/HcalRecHit/interface/HBHEChannelInfo.h"
@@ -51,6 +53,27 @@ public:
                                    const HcalRecoParam* params,
                                    const HcalCalibrations& calibs,
                                    bool isRealData) = 0;
+
+    // Does this class want to receive the channels of a collection
+    // as one block, through "reconstructBatch"?
+    inline virtual bool prefersBatch() const {return false;}
+
+    // Reconstructs a block of channels, filling "rechits" with one
+    // rechit per channel, in the same order and with the same
+    // convention as "reconstruct". "params" and "calibs" hold one
+    // pointer per channel ("params" pointers are allowed to be null).
+    // The default implementation calls "reconstruct" channel by channel.
+    inline virtual void reconstructBatch(const std::vector<HBHEChannelInfo>& infos,
+                                         const std::vector<const HcalRecoParam*>& params,
+                                         const std::vector<const HcalCalibrations*>& calibs,
+                                         const bool isRealData,
+                                         std::vector<HBHERecHit>& rechits)
+    {
+        rechits.clear();
+        rechits.reserve(infos.size());
+        for (unsigned i=0; i<infos.size(); ++i)
+            rechits.push_back(reconstruct(infos[i], params[i], *calibs[i], isRealData));
+    }
 };
 
 #endif // RecoLocalCalo_HcalRecAlgos_AbsHBHEPhase1Algo_h_
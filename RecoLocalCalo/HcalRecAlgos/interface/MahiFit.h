@@ -14,6 +14,8 @@
 
 #include <Math/Functor.h>
 
+#include <vector>
+
 struct MahiNnlsWorkspace {
 
   unsigned int nPulseTot;
@@ -81,6 +83,45 @@ struct MahiNnlsWorkspace {
 
 };
 
+// Structure-of-arrays block of HBHE channels for batched Mahi
+// reconstruction. Time slice quantities are kept in one array per time
+// slice, so that loops over channels at a fixed time slice run over
+// contiguous memory. All channels of a block must share the number of
+// samples and the sample of interest.
+struct MahiChannelBlock {
+
+  unsigned int nSamples = 0;
+  unsigned int soi = 0;
+
+  std::array<std::vector<double>, MaxSVSize> charge;
+  std::array<std::vector<double>, MaxSVSize> pedestal;
+  std::array<std::vector<double>, MaxSVSize> pedestalWidth;
+  std::array<std::vector<float>, MaxSVSize> dfcPerADC;
+
+  std::vector<double> fcByPE;
+  std::vector<double> gain;
+  std::vector<int> recoShape;
+  std::vector<char> hasTimeInfo;
+
+  unsigned int size() const { return recoShape.size(); }
+  bool empty() const { return recoShape.empty(); }
+
+  void clear();
+  void reserve(unsigned int n);
+  void push_back(const HBHEChannelInfo& channelData);
+};
+
+// Per-channel output of MahiFit::phase1ApplyBatch, in block order
+struct MahiBatchResult {
+
+  std::vector<float> energy;
+  std::vector<float> time;
+  std::vector<float> chi2;
+  std::vector<char> useTriple;
+
+  void resize(unsigned int n);
+};
+
 class MahiFit
 {
  public:
@@ -99,6 +140,16 @@ class MahiFit
 		   bool& useTriple,
 		   float& chi2) const;
 
+  // Reconstructs all channels of the block. The channel-wise input
+  // preparation runs over the whole block at once; the fits are then
+  // done with channels grouped by pulse shape, so the pulse shape
+  // template is set up once per group rather than once per channel.
+  // Results are identical to calling phase1Apply on each channel.
+  void phase1ApplyBatch(const MahiChannelBlock& block,
+			const HcalPulseShapes& pulseShapes,
+			const HcalTimeSlew* hcalTimeSlewDelay,
+			MahiBatchResult& result);
+
   void doFit(std::array<float,3> &correctedOutput, const int nbx) const;
 
   void setPulseShapeTemplate  (const HcalPulseShapes::Shape& ps,const HcalTimeSlew * hcalTimeSlewDelay);
@@ -110,6 +161,9 @@ class MahiFit
 
  private:
 
+  void fitChannel(double tstrig, double tsTOT,
+		  std::array<float,3> &reconstructedVals, bool& useTriple) const;
+
   double minimize() const;
   void onePulseMinimize() const;
   void updateCov() const;
@@ -129,6 +183,14 @@ class MahiFit
 
   mutable MahiNnlsWorkspace nnlsWork_;
 
+  // SoA scratch space for phase1ApplyBatch, reused between calls
+  std::array<std::vector<double>, MaxSVSize> batchAmplitudes_;
+  std::array<std::vector<double>, MaxSVSize> batchNoiseTerms_;
+  std::vector<float> batchPedVal_;
+  std::vector<double> batchTsTOT_;
+  std::vector<double> batchTsTrig_;
+  std::vector<unsigned int> batchOrder_;
+
   //hard coded in initializer
   const unsigned int fullTSSize_;
   const unsigned int fullTSofInterest_;
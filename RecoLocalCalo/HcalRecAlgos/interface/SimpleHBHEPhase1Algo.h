@@ -40,6 +40,12 @@ public:
     //
     //   detFit           -- "Method 3" (a.k.a. "deterministic fit") object
     //
+    //   mahi             -- Mahi object
+    //
+    //   batchMahi        -- run Mahi on the blocks of channels given to
+    //                       "reconstructBatch" (MahiFit::phase1ApplyBatch)
+    //                       instead of channel by channel
+    //
     SimpleHBHEPhase1Algo(int firstSampleShift,
                          int samplesToAdd,
                          float phaseNS,
@@ -47,7 +53,8 @@ public:
                          bool correctForPhaseContainment,
                          std::unique_ptr<PulseShapeFitOOTPileupCorrection> m2,
                          std::unique_ptr<HcalDeterministicFit> detFit,
-			 std::unique_ptr<MahiFit> mahi);
+			 std::unique_ptr<MahiFit> mahi,
+                         bool batchMahi = false);
 
     inline ~SimpleHBHEPhase1Algo() override {}
 
@@ -61,6 +68,15 @@ public:
                                    const HcalRecoParam* params,
                                    const HcalCalibrations& calibs,
                                    bool isRealData) override;
+
+    inline bool prefersBatch() const override {return mahiOOTpuCorr_ && batchMahi_;}
+
+    void reconstructBatch(const std::vector<HBHEChannelInfo>& infos,
+                          const std::vector<const HcalRecoParam*>& params,
+                          const std::vector<const HcalCalibrations*>& calibs,
+                          bool isRealData,
+                          std::vector<HBHERecHit>& rechits) override;
+
     // Basic accessors
     inline int getFirstSampleShift() const {return firstSampleShift_;}
     inline int getSamplesToAdd() const {return samplesToAdd_;}
@@ -89,6 +105,16 @@ protected:
                  double reconstructedCharge,
                  const HcalCalibrations& calibs,
                  int nSamplesToExamine) const;
+
+    // Rechit of one channel. If "mahiBatch" is not null, the Mahi
+    // results are taken from its entry "iBatch" instead of being
+    // computed here.
+    HBHERecHit reconstructChannel(const HBHEChannelInfo& info,
+                                  const HcalRecoParam* params,
+                                  const HcalCalibrations& calibs,
+                                  bool isRealData,
+                                  const MahiBatchResult* mahiBatch,
+                                  unsigned iBatch);
 private:
     HcalPulseContainmentManager pulseCorr_;
 
@@ -108,6 +134,14 @@ private:
     // Mahi algorithm
     std::unique_ptr<MahiFit> mahiOOTpuCorr_;
 
+    // Batched Mahi: the channel blocks (one per number of samples and
+    // sample of interest) and the results, reused between calls
+    bool batchMahi_;
+    MahiChannelBlock mahiBlock_;
+    MahiBatchResult mahiBlockResult_;
+    MahiBatchResult mahiResult_;
+    std::vector<unsigned> mahiBlockIndex_;
+
     HcalPulseShapes theHcalPulseShapes_;
 };
 
@@ -1,5 +1,66 @@
 #include "RecoLocalCalo/HcalRecAlgos/interface/MahiFit.h" 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+
+void MahiChannelBlock::clear() {
+  nSamples = 0;
+  soi = 0;
+  for (unsigned int iTS=0; iTS<MaxSVSize; ++iTS) {
+    charge[iTS].clear();
+    pedestal[iTS].clear();
+    pedestalWidth[iTS].clear();
+    dfcPerADC[iTS].clear();
+  }
+  fcByPE.clear();
+  gain.clear();
+  recoShape.clear();
+  hasTimeInfo.clear();
+}
+
+void MahiChannelBlock::reserve(unsigned int n) {
+  for (unsigned int iTS=0; iTS<MaxSVSize; ++iTS) {
+    charge[iTS].reserve(n);
+    pedestal[iTS].reserve(n);
+    pedestalWidth[iTS].reserve(n);
+    dfcPerADC[iTS].reserve(n);
+  }
+  fcByPE.reserve(n);
+  gain.reserve(n);
+  recoShape.reserve(n);
+  hasTimeInfo.reserve(n);
+}
+
+void MahiChannelBlock::push_back(const HBHEChannelInfo& channelData) {
+  if (empty()) {
+    nSamples = channelData.nSamples();
+    soi = channelData.soi();
+  }
+  else if (channelData.nSamples()!=nSamples || channelData.soi()!=soi) {
+    throw cms::Exception("HcalMahiWeirdState")
+      << "Channel with " << channelData.nSamples() << " samples and SOI " << channelData.soi()
+      << " added to a Mahi block with " << nSamples << " samples and SOI " << soi;
+  }
+
+  for (unsigned int iTS=0; iTS<nSamples; ++iTS) {
+    charge[iTS].push_back(channelData.tsRawCharge(iTS));
+    pedestal[iTS].push_back(channelData.tsPedestal(iTS));
+    pedestalWidth[iTS].push_back(channelData.tsPedestalWidth(iTS));
+    dfcPerADC[iTS].push_back(channelData.tsDFcPerADC(iTS));
+  }
+  fcByPE.push_back(channelData.fcByPE());
+  gain.push_back(channelData.tsGain(0));
+  recoShape.push_back(channelData.recoShape());
+  hasTimeInfo.push_back(channelData.hasTimeInfo());
+}
+
+void MahiBatchResult::resize(unsigned int n) {
+  energy.resize(n);
+  time.resize(n);
+  chi2.resize(n);
+  useTriple.resize(n);
+}
 
 MahiFit::MahiFit() :
   fullTSSize_(19), 
@@ -96,6 +157,17 @@ void MahiFit::phase1Apply(const HBHEChannelInfo& channelData,
     }
   }
 
+  fitChannel(tstrig, tsTOT, reconstructedVals, useTriple);
+  
+  reconstructedEnergy = reconstructedVals[0]*channelData.tsGain(0);
+  reconstructedTime = reconstructedVals[1];
+  chi2 = reconstructedVals[2];
+
+}
+
+void MahiFit::fitChannel(double tstrig, double tsTOT,
+			 std::array<float,3> &reconstructedVals, bool& useTriple) const {
+
   if(tstrig >= ts4Thresh_ && tsTOT > 0) {
 
     useTriple=false;
@@ -118,10 +190,118 @@ void MahiFit::phase1Apply(const HBHEChannelInfo& channelData,
     reconstructedVals.at(1) = -9999.; //time
     reconstructedVals.at(2) = -9999.; //chi2
   }
-  
-  reconstructedEnergy = reconstructedVals[0]*channelData.tsGain(0);
-  reconstructedTime = reconstructedVals[1];
-  chi2 = reconstructedVals[2];
+
+}
+
+void MahiFit::phase1ApplyBatch(const MahiChannelBlock& block,
+			       const HcalPulseShapes& pulseShapes,
+			       const HcalTimeSlew* hcalTimeSlewDelay,
+			       MahiBatchResult& result) {
+
+  const unsigned int nCh = block.size();
+  const unsigned int nTS = block.nSamples;
+
+  result.resize(nCh);
+  if (nCh==0) return;
+
+  assert(nTS==8||nTS==10);
+
+  for (unsigned int iTS=0; iTS<nTS; ++iTS) {
+    batchAmplitudes_[iTS].resize(nCh);
+    batchNoiseTerms_[iTS].resize(nCh);
+  }
+  batchPedVal_.resize(nCh);
+  batchTsTOT_.assign(nCh, 0.);
+  batchTsTrig_.assign(nCh, 0.);
+
+  //Average pedestal width (for covariance matrix constraint)
+  {
+    const double* w0 = block.pedestalWidth[0].data();
+    const double* w1 = block.pedestalWidth[1].data();
+    const double* w2 = block.pedestalWidth[2].data();
+    const double* w3 = block.pedestalWidth[3].data();
+    for (unsigned int iCh=0; iCh<nCh; ++iCh) {
+      batchPedVal_[iCh] = 0.25*( w0[iCh]*w0[iCh] + w1[iCh]*w1[iCh] +
+				 w2[iCh]*w2[iCh] + w3[iCh]*w3[iCh] );
+    }
+  }
+
+  // same arithmetic as phase1Apply, with the channel loop innermost
+  const double* gain = block.gain.data();
+  const double* fcByPE = block.fcByPE.data();
+  for (unsigned int iTS=0; iTS<nTS; ++iTS) {
+    const double* charge = block.charge[iTS].data();
+    const double* ped = block.pedestal[iTS].data();
+    const double* pedWidth = block.pedestalWidth[iTS].data();
+    const float* dfcPerADC = block.dfcPerADC[iTS].data();
+    double* amplitudes = batchAmplitudes_[iTS].data();
+    double* noiseTerms = batchNoiseTerms_[iTS].data();
+    double* tsTOT = batchTsTOT_.data();
+
+    for (unsigned int iCh=0; iCh<nCh; ++iCh) {
+      const double amp = charge[iCh] - ped[iCh];
+      amplitudes[iCh] = amp;
+
+      //ADC granularity
+      const double noiseADC = (1./sqrt(12))*dfcPerADC[iCh];
+
+      //Photostatistics
+      const double noisePhoto = amp>pedWidth[iCh] ? sqrt(amp*fcByPE[iCh]) : 0.;
+
+      //Total uncertainty from all sources
+      noiseTerms[iCh] = noiseADC*noiseADC + noisePhoto*noisePhoto + pedWidth[iCh]*pedWidth[iCh];
+
+      tsTOT[iCh] += amp*gain[iCh];
+    }
+  }
+  for (unsigned int iCh=0; iCh<nCh; ++iCh) {
+    batchTsTrig_[iCh] = batchAmplitudes_[block.soi][iCh]*gain[iCh];
+  }
+
+  // group channels by pulse shape so that the template is rebuilt
+  // only when the shape changes
+  batchOrder_.resize(nCh);
+  for (unsigned int iCh=0; iCh<nCh; ++iCh) batchOrder_[iCh] = iCh;
+  std::stable_sort(batchOrder_.begin(), batchOrder_.end(),
+		   [&block](unsigned int a, unsigned int b) { return block.recoShape[a] < block.recoShape[b]; });
+
+  for (unsigned int iCh : batchOrder_) {
+
+    std::array<float,3> reconstructedVals {{ 0.0, -9999, -9999 }};
+    bool useTriple = false;
+
+    const double tstrig = batchTsTrig_[iCh];
+    const double tsTOT = batchTsTOT_[iCh];
+
+    if (tstrig >= ts4Thresh_ && tsTOT > 0) {
+      setPulseShapeTemplate(pulseShapes.getShape(block.recoShape[iCh]), hcalTimeSlewDelay);
+
+      resetWorkspace();
+
+      nnlsWork_.tsSize = nTS;
+      nnlsWork_.tsOffset = block.soi;
+      nnlsWork_.fullTSOffset = fullTSofInterest_ - nnlsWork_.tsOffset;
+
+      // 1 sigma time constraint
+      if (block.hasTimeInfo[iCh]) nnlsWork_.dt=timeSigmaSiPM_;
+      else nnlsWork_.dt=timeSigmaHPD_;
+
+      nnlsWork_.pedConstraint = batchPedVal_[iCh]*SampleMatrix::Ones(nTS, nTS);
+      nnlsWork_.amplitudes.resize(nTS);
+      nnlsWork_.noiseTerms.resize(nTS);
+      for (unsigned int iTS=0; iTS<nTS; ++iTS) {
+	nnlsWork_.amplitudes.coeffRef(iTS) = batchAmplitudes_[iTS][iCh];
+	nnlsWork_.noiseTerms.coeffRef(iTS) = batchNoiseTerms_[iTS][iCh];
+      }
+    }
+
+    fitChannel(tstrig, tsTOT, reconstructedVals, useTriple);
+
+    result.energy[iCh] = reconstructedVals[0]*gain[iCh];
+    result.time[iCh] = reconstructedVals[1];
+    result.chi2[iCh] = reconstructedVals[2];
+    result.useTriple[iCh] = useTriple;
+  }
 
 }
 
@@ -25,7 +25,8 @@ SimpleHBHEPhase1Algo::SimpleHBHEPhase1Algo(
     const bool correctForPhaseContainment,
     std::unique_ptr<PulseShapeFitOOTPileupCorrection> m2,
     std::unique_ptr<HcalDeterministicFit> detFit,
-    std::unique_ptr<MahiFit> mahi)
+    std::unique_ptr<MahiFit> mahi,
+    const bool batchMahi)
     : pulseCorr_(PulseContainmentFractionalError),
       firstSampleShift_(firstSampleShift),
       samplesToAdd_(samplesToAdd),
@@ -35,7 +36,8 @@ SimpleHBHEPhase1Algo::SimpleHBHEPhase1Algo(
       corrFPC_(correctForPhaseContainment),
       psFitOOTpuCorr_(std::move(m2)),
       hltOOTpuCorr_(std::move(detFit)),
-      mahiOOTpuCorr_(std::move(mahi))
+      mahiOOTpuCorr_(std::move(mahi)),
+      batchMahi_(batchMahi)
 {
   hcalTimeSlew_delay_ = nullptr;
 }
@@ -61,6 +63,66 @@ HBHERecHit SimpleHBHEPhase1Algo::reconstruct(const HBHEChannelInfo& info,
                                              const HcalRecoParam* params,
                                              const HcalCalibrations& calibs,
                                              const bool isData)
+{
+    return reconstructChannel(info, params, calibs, isData, nullptr, 0);
+}
+
+void SimpleHBHEPhase1Algo::reconstructBatch(const std::vector<HBHEChannelInfo>& infos,
+                                            const std::vector<const HcalRecoParam*>& params,
+                                            const std::vector<const HcalCalibrations*>& calibs,
+                                            const bool isData,
+                                            std::vector<HBHERecHit>& rechits)
+{
+    if (!prefersBatch())
+    {
+        AbsHBHEPhase1Algo::reconstructBatch(infos, params, calibs, isData, rechits);
+        return;
+    }
+
+    // Mahi for all channels, in blocks of channels sharing
+    // the number of samples and the sample of interest
+    const unsigned n = infos.size();
+    mahiResult_.resize(n);
+    std::vector<bool> done(n, false);
+    for (unsigned first=0; first<n; ++first)
+    {
+        if (done[first])
+            continue;
+        const unsigned nSamples = infos[first].nSamples();
+        const unsigned soi = infos[first].soi();
+        mahiBlock_.clear();
+        mahiBlockIndex_.clear();
+        for (unsigned i=first; i<n; ++i)
+            if (!done[i] && infos[i].nSamples() == nSamples && infos[i].soi() == soi)
+            {
+                mahiBlock_.push_back(infos[i]);
+                mahiBlockIndex_.push_back(i);
+                done[i] = true;
+            }
+        mahiOOTpuCorr_->phase1ApplyBatch(mahiBlock_, theHcalPulseShapes_,
+                                         hcalTimeSlew_delay_, mahiBlockResult_);
+        for (unsigned j=0; j<mahiBlockIndex_.size(); ++j)
+        {
+            const unsigned i = mahiBlockIndex_[j];
+            mahiResult_.energy[i] = mahiBlockResult_.energy[j];
+            mahiResult_.time[i] = mahiBlockResult_.time[j];
+            mahiResult_.chi2[i] = mahiBlockResult_.chi2[j];
+            mahiResult_.useTriple[i] = mahiBlockResult_.useTriple[j];
+        }
+    }
+
+    rechits.clear();
+    rechits.reserve(n);
+    for (unsigned i=0; i<n; ++i)
+        rechits.push_back(reconstructChannel(infos[i], params[i], *calibs[i], isData, &mahiResult_, i));
+}
+
+HBHERecHit SimpleHBHEPhase1Algo::reconstructChannel(const HBHEChannelInfo& info,
+                                                    const HcalRecoParam* params,
+                                                    const HcalCalibrations& calibs,
+                                                    const bool isData,
+                                                    const MahiBatchResult* mahiBatch,
+                                                    const unsigned iBatch)
 {
     HBHERecHit rh;
 
@@ -113,8 +175,15 @@ HBHERecHit SimpleHBHEPhase1Algo::reconstruct(const HBHEChannelInfo& info,
     const MahiFit* mahi = mahiOOTpuCorr_.get();
 
     if (mahi) {
-      mahiOOTpuCorr_->setPulseShapeTemplate(theHcalPulseShapes_.getShape(info.recoShape()),hcalTimeSlew_delay_);
-      mahi->phase1Apply(info,m4E,m4T,m4UseTriple,m4chi2);
+      if (mahiBatch) {
+        m4E = mahiBatch->energy[iBatch];
+        m4T = mahiBatch->time[iBatch];
+        m4chi2 = mahiBatch->chi2[iBatch];
+        m4UseTriple = mahiBatch->useTriple[iBatch];
+      } else {
+        mahiOOTpuCorr_->setPulseShapeTemplate(theHcalPulseShapes_.getShape(info.recoShape()),hcalTimeSlew_delay_);
+        mahi->phase1Apply(info,m4E,m4T,m4UseTriple,m4chi2);
+      }
       m4E *= hbminusCorrectionFactor(channelId, m4E, isData);
     }
 
@@ -125,7 +125,8 @@ parseHBHEPhase1AlgoDescription(const edm::ParameterSet& ps)
                                      ps.getParameter<double>("correctionPhaseNS"),
                                      ps.getParameter<double>("tdcTimeShift"),
                                      ps.getParameter<bool>  ("correctForPhaseContainment"),
-                                     std::move(m2), std::move(detFit), std::move(mahi))
+                                     std::move(m2), std::move(detFit), std::move(mahi),
+                                     ps.existsAs<bool>("batchMahi") && ps.getParameter<bool>("batchMahi"))
             );
     }
 
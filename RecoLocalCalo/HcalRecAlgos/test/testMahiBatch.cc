@@ -0,0 +1,119 @@
+//
+// Cross-check and throughput comparison of MahiFit::phase1Apply (one
+// channel at a time) and MahiFit::phase1ApplyBatch (SoA channel block)
+// on randomly generated HBHE channels.
+//
+// Usage: testMahiBatch [nChannels] [nRepeat]
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "RecoLocalCalo/HcalRecAlgos/interface/MahiFit.h"
+
+namespace {
+  std::unique_ptr<MahiFit> makeMahi() {
+    auto mahi = std::make_unique<MahiFit>();
+    // defaults of HBHEMahiParameters_cfi
+    mahi->setParameters(true, 0.0, 15.0, true, HcalTimeSlew::Medium,
+                        0.0, 5.0, 5.0, {-1, 0, 1}, 500, 500, 1e-3, 1e-11);
+    return mahi;
+  }
+
+  std::vector<HBHEChannelInfo> makeChannels(unsigned int n) {
+    std::mt19937 rng(12345);
+    std::exponential_distribution<double> signal(1./200.);
+    std::exponential_distribution<double> pileup(1./40.);
+    std::normal_distribution<double> noise(0., 1.);
+    std::uniform_real_distribution<double> flat(0., 1.);
+
+    // rough SiPM-like pulse fractions around the SOI
+    const double frac[10] = {0., 0., 0., 0.02, 0.65, 0.28, 0.04, 0.01, 0., 0.};
+    const int shapes[2] = {205, 207};
+
+    std::vector<HBHEChannelInfo> channels;
+    channels.reserve(n);
+    for (unsigned int i=0; i<n; ++i) {
+      HBHEChannelInfo info(true, false);
+      info.setChannelInfo(HcalDetId(HcalBarrel, 1+i%16, 1+i%72, 1), shapes[i%2], 10, 4, 0,
+                          0., 50., 0., false, false, false);
+      const double amp = signal(rng);
+      const double ootAmp = flat(rng) < 0.5 ? pileup(rng) : 0.;
+      for (unsigned int ts=0; ts<10; ++ts) {
+        const double ped = 8.;
+        const double q = ped + amp*frac[ts] + ootAmp*(ts>0 ? frac[ts-1] : 0.) + 2.*noise(rng);
+        info.setSample(ts, 0, 3.1f, q, ped, 2., 0.0025, 0., -100.f);
+      }
+      channels.push_back(info);
+    }
+    return channels;
+  }
+}
+
+int main(int argc, char** argv) {
+  const unsigned int nChannels = argc > 1 ? std::atoi(argv[1]) : 7000;
+  const unsigned int nRepeat = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  HcalPulseShapes pulseShapes;
+  HcalTimeSlew timeSlew;
+  timeSlew.addM2ParameterSet(23.960177, -3.178648, 16.00);
+  timeSlew.addM2ParameterSet(13.307784, -1.556668, 10.00);
+  timeSlew.addM2ParameterSet(9.109694, -1.075824, 6.25);
+
+  const std::vector<HBHEChannelInfo> channels = makeChannels(nChannels);
+
+  auto single = makeMahi();
+  auto batched = makeMahi();
+
+  std::vector<float> energy(nChannels), time(nChannels), chi2(nChannels);
+  std::vector<char> useTriple(nChannels);
+
+  MahiChannelBlock block;
+  MahiBatchResult result;
+
+  double tSingle = 0, tBatch = 0;
+  for (unsigned int iRep=0; iRep<nRepeat; ++iRep) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i=0; i<nChannels; ++i) {
+      bool triple = false;
+      single->setPulseShapeTemplate(pulseShapes.getShape(channels[i].recoShape()), &timeSlew);
+      single->phase1Apply(channels[i], energy[i], time[i], triple, chi2[i]);
+      useTriple[i] = triple;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    tSingle += std::chrono::duration<double>(stop-start).count();
+
+    start = std::chrono::steady_clock::now();
+    block.clear();
+    block.reserve(nChannels);
+    for (auto const& info : channels) block.push_back(info);
+    batched->phase1ApplyBatch(block, pulseShapes, &timeSlew, result);
+    stop = std::chrono::steady_clock::now();
+    tBatch += std::chrono::duration<double>(stop-start).count();
+  }
+
+  unsigned int nBad = 0;
+  for (unsigned int i=0; i<nChannels; ++i) {
+    const float tol = 1e-4f*std::max(1.f, std::abs(energy[i]));
+    if (std::abs(energy[i]-result.energy[i]) > tol ||
+        std::abs(time[i]-result.time[i]) > 1e-4f ||
+        std::abs(chi2[i]-result.chi2[i]) > 1e-4f*std::max(1.f, std::abs(chi2[i])) ||
+        useTriple[i] != result.useTriple[i]) {
+      if (nBad < 10)
+        std::cout << "channel " << i << ": single (" << energy[i] << ", " << time[i] << ", " << chi2[i]
+                  << ") batch (" << result.energy[i] << ", " << result.time[i] << ", " << result.chi2[i] << ")\n";
+      ++nBad;
+    }
+  }
+
+  std::cout << "channels: " << nChannels << " x " << nRepeat << "\n"
+            << "per-channel: " << 1e6*tSingle/(nChannels*nRepeat) << " us/channel\n"
+            << "batched:     " << 1e6*tBatch/(nChannels*nRepeat) << " us/channel\n"
+            << "mismatches:  " << nBad << std::endl;
+
+  return nBad == 0 ? 0 : 1;
+}
@@ -10,5 +10,7 @@ mahiParameters = cms.PSet(
     nMaxItersMin      = cms.int32(500),
     nMaxItersNNLS     = cms.int32(500),
     deltaChiSqThresh  = cms.double(1e-3),
-    nnlsThresh        = cms.double(1e-11)
+    nnlsThresh        = cms.double(1e-11),
+    # fit the channels of a collection as one block
+    batchMahi         = cms.bool(False)
 )
@@ -21,6 +21,7 @@
 #include <cmath>
 #include <utility>
 #include <algorithm>
+#include <vector>
 
 // user include files
 #include "FWCore/Framework/interface/Frameworkfwd.h"
@@ -326,6 +327,13 @@ private:
     std::unique_ptr<HBHEPulseShapeFlagSetter> hbhePulseShapeFlagSetterQIE8_;
     std::unique_ptr<HBHEPulseShapeFlagSetter> hbhePulseShapeFlagSetterQIE11_;
 
+    // Channels given to the reco algorithm as one block, when it
+    // prefers so, and their rechits (reused between events)
+    std::vector<HBHEChannelInfo> batchInfos_;
+    std::vector<const HcalRecoParam*> batchParams_;
+    std::vector<const HcalCalibrations*> batchCalibs_;
+    std::vector<HBHERecHit> batchRecHits_;
+
     // For the function below, arguments "infoColl" and/or "rechits"
     // are allowed to be null.
     template<class DataFrame, class Collection>
@@ -444,6 +452,18 @@ void HBHEPhase1Reconstructor::processData(const Collection& coll,
     // not going to be constructed from such channels.
     const bool skipDroppedChannels = !(infos && saveDroppedInfos_);
 
+    // If the reco algorithm prefers so, the rechits are reconstructed
+    // after the loop, from all the channels at once
+    const bool batch = rechits && reco_->prefersBatch();
+    std::vector<typename Collection::const_iterator> batchFrames;
+    if (batch)
+    {
+        batchInfos_.clear();
+        batchParams_.clear();
+        batchCalibs_.clear();
+        batchFrames.reserve(coll.size());
+    }
+
     // Iterate over the input collection
     for (typename Collection::const_iterator it = coll.begin();
          it != coll.end(); ++it)
@@ -543,6 +563,14 @@ void HBHEPhase1Reconstructor::processData(const Collection& coll,
             const HcalRecoParam* pptr = nullptr;
             if (recoParamsFromDB_)
                 pptr = param_ts;
+            if (batch)
+            {
+                batchInfos_.push_back(*channelInfo);
+                batchParams_.push_back(pptr);
+                batchCalibs_.push_back(&calib);
+                batchFrames.push_back(it);
+                continue;
+            }
             HBHERecHit rh = reco_->reconstruct(*channelInfo, pptr, calib, isRealData);
             if (rh.id().rawId())
             {
@@ -552,6 +580,25 @@ void HBHEPhase1Reconstructor::processData(const Collection& coll,
             }
         }
     }
+
+    if (batch)
+    {
+        reco_->reconstructBatch(batchInfos_, batchParams_, batchCalibs_, isRealData, batchRecHits_);
+        for (unsigned i=0; i<batchRecHits_.size(); ++i)
+        {
+            HBHERecHit& rh = batchRecHits_[i];
+            if (rh.id().rawId())
+            {
+                const DFrame& frame(*batchFrames[i]);
+                const HcalDetId cell(frame.id());
+                const HcalQIECoder* channelCoder = cond.getHcalCoder(cell);
+                const HcalCoderDb coder(*channelCoder, *cond.getHcalShape(channelCoder));
+                setAsicSpecificBits(frame, coder, batchInfos_[i], *batchCalibs_[i], &rh);
+                setCommonStatusBits(batchInfos_[i], *batchCalibs_[i], &rh);
+                rechits->push_back(rh);
+            }
+        }
+    }
 }
 
 void HBHEPhase1Reconstructor::setCommonStatusBits(
@@ -0,0 +1,200 @@
+#ifndef RECOPIXELVERTEXING_PIXELTRIPLETS_CACELLSOA_h
+#define RECOPIXELVERTEXING_PIXELTRIPLETS_CACELLSOA_h
+
+#include "RecoTracker/TkHitPairs/interface/RecHitsSortedInPhi.h"
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+// Structure-of-arrays storage of all the cells of a region: one array per
+// quantity, indexed by cell id. The coordinates of both hits are copied in
+// when the cells of a layer pair are created, so the connection and evolution steps only
+// stream through flat arrays instead of going back to the HitDoublets.
+// Outer neighbors are kept in a fixed number of slots per cell, the rare
+// cells with more spill into a side map; the neighbor order is the
+// insertion order, as for CACell.
+class CACellSoA {
+public:
+  using Hit = RecHitsSortedInPhi::Hit;
+  using CAntuple = std::vector<unsigned int>;
+  using CAntuplet = std::vector<unsigned int>;
+
+  static constexpr unsigned int maxInlineNeighbors = 4;
+
+  unsigned int size() const { return theDoubletIds.size(); }
+  bool empty() const { return theDoubletIds.empty(); }
+
+  void clear() {
+    theDoublets.clear(); theDoubletIds.clear();
+    theInnerX.clear(); theInnerY.clear(); theInnerZ.clear(); theInnerR.clear();
+    theOuterX.clear(); theOuterY.clear(); theOuterZ.clear(); theOuterR.clear();
+    theNeighbors.clear(); theNumberOfNeighbors.clear(); theOverflow.clear();
+    theCAState.clear(); theHasSameStateNeighbors.clear();
+  }
+
+  void reserve(unsigned int n) {
+    theDoublets.reserve(n); theDoubletIds.reserve(n);
+    theInnerX.reserve(n); theInnerY.reserve(n); theInnerZ.reserve(n); theInnerR.reserve(n);
+    theOuterX.reserve(n); theOuterY.reserve(n); theOuterZ.reserve(n); theOuterR.reserve(n);
+    theNeighbors.reserve(n*maxInlineNeighbors); theNumberOfNeighbors.reserve(n);
+  }
+
+  // adds one cell per doublet, with ids size() .. size()+doublets->size()-1
+  void addCells(const HitDoublets* doublets) {
+    const unsigned int first = size();
+    const unsigned int n = doublets->size();
+    const unsigned int last = first + n;
+    theDoublets.resize(last, doublets);
+    theDoubletIds.resize(last);
+    theInnerX.resize(last); theInnerY.resize(last); theInnerZ.resize(last); theInnerR.resize(last);
+    theOuterX.resize(last); theOuterY.resize(last); theOuterZ.resize(last); theOuterR.resize(last);
+    theNeighbors.resize(last*maxInlineNeighbors);
+    theNumberOfNeighbors.resize(last, 0);
+    // one pass per quantity, reading the hit arrays of the two layers
+    auto const & in = doublets->innerLayer();
+    auto const & out = doublets->outerLayer();
+    for (unsigned int i = 0; i < n; ++i) theDoubletIds[first+i] = i;
+    for (unsigned int i = 0; i < n; ++i) {
+      auto ii = doublets->innerHitId(i);
+      theInnerX[first+i] = in.x[ii]; theInnerY[first+i] = in.y[ii];
+      theInnerZ[first+i] = in.z[ii]; theInnerR[first+i] = in.rv(ii);
+    }
+    for (unsigned int i = 0; i < n; ++i) {
+      auto io = doublets->outerHitId(i);
+      theOuterX[first+i] = out.x[io]; theOuterY[first+i] = out.y[io];
+      theOuterZ[first+i] = out.z[io]; theOuterR[first+i] = out.rv(io);
+    }
+  }
+
+  Hit const & getInnerHit(unsigned int cell) const {
+    return theDoublets[cell]->hit(theDoubletIds[cell], HitDoublets::inner);
+  }
+
+  Hit const & getOuterHit(unsigned int cell) const {
+    return theDoublets[cell]->hit(theDoubletIds[cell], HitDoublets::outer);
+  }
+
+  float getInnerX(unsigned int cell) const { return theInnerX[cell]; }
+  float getInnerY(unsigned int cell) const { return theInnerY[cell]; }
+  float getInnerZ(unsigned int cell) const { return theInnerZ[cell]; }
+  float getInnerR(unsigned int cell) const { return theInnerR[cell]; }
+  float getOuterX(unsigned int cell) const { return theOuterX[cell]; }
+  float getOuterY(unsigned int cell) const { return theOuterY[cell]; }
+  float getOuterZ(unsigned int cell) const { return theOuterZ[cell]; }
+  float getOuterR(unsigned int cell) const { return theOuterR[cell]; }
+
+  void tagAsOuterNeighbor(unsigned int cell, unsigned int otherCell) {
+    auto n = theNumberOfNeighbors[cell]++;
+    if (n < maxInlineNeighbors) theNeighbors[cell*maxInlineNeighbors+n] = otherCell;
+    else theOverflow[cell].push_back(otherCell);
+  }
+
+  unsigned int numberOfOuterNeighbors(unsigned int cell) const { return theNumberOfNeighbors[cell]; }
+
+  unsigned int outerNeighbor(unsigned int cell, unsigned int i) const {
+    return i < maxInlineNeighbors ? theNeighbors[cell*maxInlineNeighbors+i]
+                                  : theOverflow.find(cell)->second[i-maxInlineNeighbors];
+  }
+
+  // number of cells whose neighbors did not fit in the inline slots
+  unsigned int numberOfOverflowingCells() const { return theOverflow.size(); }
+
+  // same cuts as CACell::areAlignedRZ, for the cell triplet (r1,z1) - cell - (ro,zo)
+  int areAlignedRZ(unsigned int cell, float r1, float z1, float ro, float zo, const float ptmin, const float thetaCut) const
+  {
+    float radius_diff = std::abs(r1 - ro);
+    float distance_13_squared = radius_diff*radius_diff + (z1 - zo)*(z1 - zo);
+
+    float pMin = ptmin*std::sqrt(distance_13_squared); //this needs to be divided by radius_diff later
+
+    float tan_12_13_half_mul_distance_13_squared = fabs(z1 * (getInnerR(cell) - ro) + getInnerZ(cell) * (ro - r1) + zo * (r1 - getInnerR(cell))) ;
+    return tan_12_13_half_mul_distance_13_squared * pMin <= thetaCut * distance_13_squared * radius_diff;
+  }
+
+  // same cuts as CACell::haveSimilarCurvature, otherCell being the inner one
+  bool haveSimilarCurvature(unsigned int cell, unsigned int otherCell, const float ptmin,
+			    const float region_origin_x, const float region_origin_y, const float region_origin_radius, const float phiCut, const float hardPtCut) const
+  {
+    auto x1 = getInnerX(otherCell);
+    auto y1 = getInnerY(otherCell);
+
+    auto x2 = getInnerX(cell);
+    auto y2 = getInnerY(cell);
+
+    auto x3 = getOuterX(cell);
+    auto y3 = getOuterY(cell);
+
+    float distance_13_squared = (x1 - x3)*(x1 - x3) + (y1 - y3)*(y1 - y3);
+    float tan_12_13_half_mul_distance_13_squared = std::abs(y1 * (x2 - x3) + y2 * (x3 - x1) + y3 * (x1 - x2)) ;
+    // high pt : just straight
+    if(tan_12_13_half_mul_distance_13_squared * ptmin <= 1.0e-4f*distance_13_squared)
+      {
+	float distance_3_beamspot_squared = (x3-region_origin_x) * (x3-region_origin_x) + (y3-region_origin_y) * (y3-region_origin_y);
+
+	float dot_bs3_13 = ((x1 - x3)*( region_origin_x - x3) + (y1 - y3) * (region_origin_y-y3));
+	float proj_bs3_on_13_squared = dot_bs3_13*dot_bs3_13/distance_13_squared;
+
+	float distance_13_beamspot_squared  = distance_3_beamspot_squared -  proj_bs3_on_13_squared;
+
+	return distance_13_beamspot_squared < (region_origin_radius+phiCut)*(region_origin_radius+phiCut);
+      }
+
+    //87 cm/GeV = 1/(3.8T * 0.3)
+
+    //take less than radius given by the hardPtCut and reject everything below
+    float minRadius = hardPtCut*87.f;  // FIXME move out and use real MagField
+
+    auto det = (x1 - x2) * (y2 - y3) - (x2 - x3) * (y1 - y2);
+
+    auto offset = x2 * x2 + y2*y2;
+
+    auto bc = (x1 * x1 + y1 * y1 - offset)*0.5f;
+
+    auto cd = (offset - x3 * x3 - y3 * y3)*0.5f;
+
+    auto idet = 1.f / det;
+
+    auto x_center = (bc * (y2 - y3) - cd * (y1 - y2)) * idet;
+    auto y_center = (cd * (x1 - x2) - bc * (x2 - x3)) * idet;
+
+    auto radius = std::sqrt((x2 - x_center)*(x2 - x_center) + (y2 - y_center)*(y2 - y_center));
+
+    if(radius < minRadius)  return false;  // hard cut on pt
+
+    auto centers_distance_squared = (x_center - region_origin_x)*(x_center - region_origin_x) + (y_center - region_origin_y)*(y_center - region_origin_y);
+    auto region_origin_radius_plus_tolerance = region_origin_radius + phiCut;
+    auto minimumOfIntersectionRange = (radius - region_origin_radius_plus_tolerance)*(radius - region_origin_radius_plus_tolerance);
+
+    if (centers_distance_squared >= minimumOfIntersectionRange) {
+      auto maximumOfIntersectionRange = (radius + region_origin_radius_plus_tolerance)*(radius + region_origin_radius_plus_tolerance);
+      return centers_distance_squared <= maximumOfIntersectionRange;
+    }
+
+    return false;
+  }
+
+  // CA state, one entry per cell
+  std::vector<unsigned char> theCAState;
+  std::vector<unsigned char> theHasSameStateNeighbors;
+
+private:
+
+  std::vector<const HitDoublets*> theDoublets;
+  std::vector<int> theDoubletIds;
+
+  std::vector<float> theInnerX;
+  std::vector<float> theInnerY;
+  std::vector<float> theInnerZ;
+  std::vector<float> theInnerR;
+  std::vector<float> theOuterX;
+  std::vector<float> theOuterY;
+  std::vector<float> theOuterZ;
+  std::vector<float> theOuterR;
+
+  std::vector<unsigned int> theNeighbors; // maxInlineNeighbors slots per cell
+  std::vector<unsigned short> theNumberOfNeighbors;
+  std::unordered_map<unsigned int, std::vector<unsigned int> > theOverflow;
+};
+
+#endif /*CACELLSOA_H_ */
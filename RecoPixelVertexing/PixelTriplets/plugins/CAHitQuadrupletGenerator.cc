@@ -11,7 +11,7 @@
 
 
 
-#include "CellularAutomaton.h"
+#include "CellularAutomatonSoA.h"
 
 #include "CommonTools/Utils/interface/DynArray.h"
 
@@ -186,7 +186,7 @@ void CAHitQuadrupletGenerator::hitNtuplets(const IntermediateHitDoublets& region
   std::vector<const HitDoublets *> hitDoublets;
 
   const int numberOfHitsInNtuplet = 4;
-  std::vector<CACell::CAntuplet> foundQuadruplets;
+  std::vector<CACellSoA::CAntuplet> foundQuadruplets;
 
 
 
@@ -205,7 +205,7 @@ void CAHitQuadrupletGenerator::hitNtuplets(const IntermediateHitDoublets& region
 
 	  fillGraph(layers, regionLayerPairs, g, hitDoublets);
 
-	CellularAutomaton ca(g);
+	CellularAutomatonSoA ca(g);
 
 	ca.createAndConnectCells(hitDoublets, region, caThetaCut,
 			caPhiCut, caHardPtCut);
@@ -238,13 +238,13 @@ void CAHitQuadrupletGenerator::hitNtuplets(const IntermediateHitDoublets& region
     		};
     		for(unsigned int i = 0; i< 3; ++i)
     		{
-        		auto const& ahit = allCells[foundQuadruplets[quadId][i]].getInnerHit();
+        		auto const& ahit = allCells.getInnerHit(foundQuadruplets[quadId][i]);
         		gps[i] = ahit->globalPosition();
         		ges[i] = ahit->globalPositionError();
         		barrels[i] = isBarrel(ahit->geographicalId().subdetId());
     		}
 
-    		auto const& ahit = allCells[foundQuadruplets[quadId][2]].getOuterHit();
+    		auto const& ahit = allCells.getOuterHit(foundQuadruplets[quadId][2]);
     		gps[3] = ahit->globalPosition();
     		ges[3] = ahit->globalPositionError();
     		barrels[3] = isBarrel(ahit->geographicalId().subdetId());
@@ -258,9 +258,9 @@ void CAHitQuadrupletGenerator::hitNtuplets(const IntermediateHitDoublets& region
     		const float thisMaxChi2 = maxChi2Eval.value(abscurv);
     		if (theComparitor)
     		{
-      			SeedingHitSet tmpTriplet(allCells[foundQuadruplets[quadId][0]].getInnerHit(),
-						 allCells[foundQuadruplets[quadId][2]].getInnerHit(),
-						 allCells[foundQuadruplets[quadId][2]].getOuterHit());
+      			SeedingHitSet tmpTriplet(allCells.getInnerHit(foundQuadruplets[quadId][0]),
+						 allCells.getInnerHit(foundQuadruplets[quadId][2]),
+						 allCells.getOuterHit(foundQuadruplets[quadId][2]));
 
 
       			if (!theComparitor->compatible(tmpTriplet) )
@@ -306,10 +306,10 @@ void CAHitQuadrupletGenerator::hitNtuplets(const IntermediateHitDoublets& region
       			if (edm::isNotFinite(chi2)) continue;
       			if (fitFastCircleChi2Cut && chi2 > thisMaxChi2) continue;
     		}
-		result[index].emplace_back(allCells[foundQuadruplets[quadId][0]].getInnerHit(),
-					   allCells[foundQuadruplets[quadId][1]].getInnerHit(),
-					   allCells[foundQuadruplets[quadId][2]].getInnerHit(),
-					   allCells[foundQuadruplets[quadId][2]].getOuterHit());
+		result[index].emplace_back(allCells.getInnerHit(foundQuadruplets[quadId][0]),
+					   allCells.getInnerHit(foundQuadruplets[quadId][1]),
+					   allCells.getInnerHit(foundQuadruplets[quadId][2]),
+					   allCells.getOuterHit(foundQuadruplets[quadId][2]));
         }
 	index++;
      }
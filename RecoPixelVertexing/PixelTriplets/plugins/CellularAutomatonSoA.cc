@@ -0,0 +1,213 @@
+#include "CellularAutomatonSoA.h"
+
+#include<queue>
+
+
+void CellularAutomatonSoA::createAndConnectCells(const std::vector<const HitDoublets *>& hitDoublets,
+		const float ptmin, const float region_origin_x, const float region_origin_y, const float region_origin_radius,
+		const float thetaCut, const float phiCut, const float hardPtCut)
+{
+	int tsize=0;
+	for ( auto hd :  hitDoublets) tsize+=hd->size();
+	allCells.clear();
+	allCells.reserve(tsize);
+	unsigned int cellId = 0;
+
+	// same traversal of the layer pairs as CellularAutomaton, so that the
+	// cells get the same ids
+	std::vector<bool> alreadyVisitedLayerPairs(theLayerGraph.theLayerPairs.size(), false);
+	for (int rootVertex : theLayerGraph.theRootLayers)
+	{
+
+		std::queue<int> LayerPairsToVisit;
+
+		for (int LayerPair : theLayerGraph.theLayers[rootVertex].theOuterLayerPairs)
+		{
+			LayerPairsToVisit.push(LayerPair);
+		}
+
+		while (!LayerPairsToVisit.empty())
+		{
+			auto currentLayerPair = LayerPairsToVisit.front();
+			auto & currentLayerPairRef = theLayerGraph.theLayerPairs[currentLayerPair];
+			auto & currentInnerLayerRef = theLayerGraph.theLayers[currentLayerPairRef.theLayers[0]];
+			auto & currentOuterLayerRef = theLayerGraph.theLayers[currentLayerPairRef.theLayers[1]];
+			bool allInnerLayerPairsAlreadyVisited	{ true };
+
+			for (auto innerLayerPair : currentInnerLayerRef.theInnerLayerPairs)
+			{
+				allInnerLayerPairsAlreadyVisited &=
+						alreadyVisitedLayerPairs[innerLayerPair];
+			}
+
+			if (alreadyVisitedLayerPairs[currentLayerPair] == false
+					&& allInnerLayerPairsAlreadyVisited)
+			{
+
+				const HitDoublets* doubletLayerPairId =
+						hitDoublets[currentLayerPair];
+				auto numberOfDoublets = doubletLayerPairId->size();
+				currentLayerPairRef.theFoundCells[0] = cellId;
+				currentLayerPairRef.theFoundCells[1] = cellId+numberOfDoublets;
+				// the cells of a layer pair are only connected to cells of
+				// inner layer pairs, so they can all be created first
+				allCells.addCells(doubletLayerPairId);
+				for (unsigned int i = 0; i < numberOfDoublets; ++i)
+				{
+				  currentOuterLayerRef.isOuterHitOfCell[doubletLayerPairId->outerHitId(i)].push_back(cellId);
+
+				  auto & neigCells = currentInnerLayerRef.isOuterHitOfCell[doubletLayerPairId->innerHitId(i)];
+				  checkAlignmentAndTag(cellId, neigCells, ptmin, region_origin_x,
+						       region_origin_y, region_origin_radius, thetaCut,
+						       phiCut, hardPtCut);
+
+				  cellId++;
+				}
+				assert(cellId==currentLayerPairRef.theFoundCells[1]);
+				for (auto outerLayerPair : currentOuterLayerRef.theOuterLayerPairs)
+				{
+					LayerPairsToVisit.push(outerLayerPair);
+				}
+
+				alreadyVisitedLayerPairs[currentLayerPair] = true;
+			}
+			LayerPairsToVisit.pop();
+		}
+
+	}
+
+}
+
+void CellularAutomatonSoA::checkAlignmentAndTag(unsigned int cellId, const std::vector<unsigned int>& innerCells, const float ptmin,
+		const float region_origin_x, const float region_origin_y, const float region_origin_radius,
+		const float thetaCut, const float phiCut, const float hardPtCut)
+{
+  int ncells = innerCells.size();
+  int constexpr VSIZE = 16;
+  int ok[VSIZE];
+  float r1[VSIZE];
+  float z1[VSIZE];
+  auto ro = allCells.getOuterR(cellId);
+  auto zo = allCells.getOuterZ(cellId);
+  auto loop = [&](int i, int vs) {
+    // gather from the flat arrays
+    for (int j=0;j<vs; ++j) {
+      auto koc = innerCells[i+j];
+      r1[j] = allCells.getInnerR(koc);
+      z1[j] = allCells.getInnerZ(koc);
+    }
+    for (int j=0;j<vs; ++j) ok[j] = allCells.areAlignedRZ(cellId, r1[j], z1[j], ro, zo, ptmin, thetaCut);
+    for (int j=0;j<vs; ++j) {
+      auto koc = innerCells[i+j];
+      if (ok[j] && allCells.haveSimilarCurvature(cellId, koc, ptmin, region_origin_x, region_origin_y,
+						 region_origin_radius, phiCut, hardPtCut)) {
+	allCells.tagAsOuterNeighbor(koc, cellId);
+      }
+    }
+  };
+  auto lim = VSIZE*(ncells/VSIZE);
+  for (int i=0; i<lim; i+=VSIZE) loop(i, VSIZE);
+  loop(lim, ncells-lim);
+}
+
+void CellularAutomatonSoA::evolveCell(unsigned int cellId)
+{
+  auto & hasSame = allCells.theHasSameStateNeighbors;
+  auto const & state = allCells.theCAState;
+  hasSame[cellId] = 0;
+  auto mystate = state[cellId];
+  for (unsigned int i = 0, n = allCells.numberOfOuterNeighbors(cellId); i < n; ++i) {
+    if (state[allCells.outerNeighbor(cellId, i)] == mystate) {
+      hasSame[cellId] = 1;
+      break;
+    }
+  }
+}
+
+void CellularAutomatonSoA::evolve(const unsigned int minHitsPerNtuplet)
+{
+  auto & state = allCells.theCAState;
+  auto & hasSame = allCells.theHasSameStateNeighbors;
+  state.assign(allCells.size(), 0);
+  hasSame.assign(allCells.size(), 0);
+
+  unsigned int numberOfIterations = minHitsPerNtuplet - 2;
+  // keeping the last iteration for later
+  for (unsigned int iteration = 0; iteration < numberOfIterations - 1;
+       ++iteration)
+    {
+      for (auto& layerPair : theLayerGraph.theLayerPairs)
+	{
+	  for (auto i =layerPair.theFoundCells[0]; i<layerPair.theFoundCells[1]; ++i)
+	    {
+	      evolveCell(i);
+	    }
+	}
+
+      // plain loop over the two state arrays
+      for (auto& layerPair : theLayerGraph.theLayerPairs)
+	{
+	  for (auto i =layerPair.theFoundCells[0]; i<layerPair.theFoundCells[1]; ++i)
+	    {
+	      state[i] += hasSame[i];
+	    }
+	}
+
+    }
+
+  //last iteration
+
+  theRootCells.clear();
+  for(int rootLayerId : theLayerGraph.theRootLayers)
+    {
+      for(int rootLayerPair: theLayerGraph.theLayers[rootLayerId].theOuterLayerPairs)
+	{
+	  auto foundCells = theLayerGraph.theLayerPairs[rootLayerPair].theFoundCells;
+	  for (auto i =foundCells[0]; i<foundCells[1]; ++i)
+	    {
+	      evolveCell(i);
+	      state[i] += hasSame[i];
+	      if (state[i] >= minHitsPerNtuplet - 2)
+		{
+		  theRootCells.push_back(i);
+		}
+	    }
+	}
+    }
+
+}
+
+void CellularAutomatonSoA::findNtuplets(unsigned int cellId, std::vector<CACellSoA::CAntuplet>& foundNtuplets,
+		CACellSoA::CAntuplet& tmpNtuplet, const unsigned int minHitsPerNtuplet) const
+{
+  // see CACell::findNtuplets
+  if (tmpNtuplet.size() == minHitsPerNtuplet - 1)
+    {
+      foundNtuplets.push_back(tmpNtuplet);
+    }
+  else
+    {
+      for (unsigned int i = 0, n = allCells.numberOfOuterNeighbors(cellId); i < n; ++i) {
+	auto oc = allCells.outerNeighbor(cellId, i);
+	tmpNtuplet.push_back(oc);
+	findNtuplets(oc, foundNtuplets, tmpNtuplet, minHitsPerNtuplet);
+	tmpNtuplet.pop_back();
+      }
+    }
+}
+
+void CellularAutomatonSoA::findNtuplets(
+		std::vector<CACellSoA::CAntuplet>& foundNtuplets,
+		const unsigned int minHitsPerNtuplet)
+{
+	CACellSoA::CAntuple tmpNtuplet;
+	tmpNtuplet.reserve(minHitsPerNtuplet);
+
+	for (auto root_cell : theRootCells)
+	{
+	  tmpNtuplet.clear();
+	  tmpNtuplet.push_back(root_cell);
+	  findNtuplets(root_cell, foundNtuplets, tmpNtuplet, minHitsPerNtuplet);
+	}
+
+}
@@ -0,0 +1,49 @@
+#ifndef RECOPIXELVERTEXING_PIXELTRIPLETS_PLUGINS_CELLULARAUTOMATONSOA_H_
+#define RECOPIXELVERTEXING_PIXELTRIPLETS_PLUGINS_CELLULARAUTOMATONSOA_H_
+#include "CACellSoA.h"
+#include "CAGraph.h"
+#include "RecoTracker/TkTrackingRegions/interface/TrackingRegion.h"
+
+// Same algorithm and output as CellularAutomaton, with the cells in a
+// CACellSoA. The cell ids, and hence the found ntuplets and their order,
+// are identical to the ones of CellularAutomaton.
+class CellularAutomatonSoA
+{
+public:
+  CellularAutomatonSoA(CAGraph& graph)
+    : theLayerGraph(graph)
+  {
+
+  }
+
+  CACellSoA & getAllCells() { return allCells;}
+
+  void createAndConnectCells(const std::vector<const HitDoublets *>& hitDoublets,
+			     const TrackingRegion& region, const float thetaCut, const float phiCut, const float hardPtCut) {
+    createAndConnectCells(hitDoublets, region.ptMin(), region.origin().x(), region.origin().y(), region.originRBound(),
+			  thetaCut, phiCut, hardPtCut);
+  }
+  void createAndConnectCells(const std::vector<const HitDoublets *>&,
+			     const float ptmin, const float region_origin_x, const float region_origin_y,
+			     const float region_origin_radius, const float, const float, const float);
+
+  void evolve(const unsigned int);
+  void findNtuplets(std::vector<CACellSoA::CAntuplet>&, const unsigned int);
+
+private:
+  // connects the last created cell to its compatible inner cells
+  void checkAlignmentAndTag(unsigned int cellId, const std::vector<unsigned int>& innerCells, const float ptmin,
+			    const float region_origin_x, const float region_origin_y, const float region_origin_radius,
+			    const float thetaCut, const float phiCut, const float hardPtCut);
+  void evolveCell(unsigned int cellId);
+  void findNtuplets(unsigned int cellId, std::vector<CACellSoA::CAntuplet>& foundNtuplets,
+		    CACellSoA::CAntuplet& tmpNtuplet, const unsigned int minHitsPerNtuplet) const;
+
+  CAGraph & theLayerGraph;
+
+  CACellSoA allCells;
+
+  std::vector<unsigned int> theRootCells;
+};
+
+#endif
@@ -0,0 +1,166 @@
+// Replays the doublets of a synthetic high-pileup event (four barrel
+// pixel layers, tracks from the beam line plus random hits) through
+// CellularAutomaton (cells as CACell objects) and CellularAutomatonSoA
+// (cells in a CACellSoA), checks that the found quadruplets are the same
+// and in the same order, and prints the time per event of each.
+//
+// Usage: CellularAutomatonSoA_t [nTracks] [nNoiseHitsPerLayer] [nRepeat]
+
+#include "RecoPixelVertexing/PixelTriplets/plugins/CellularAutomaton.cc"
+#include "RecoPixelVertexing/PixelTriplets/plugins/CellularAutomatonSoA.cc"
+#include "RecoTracker/TkTrackingRegions/interface/GlobalTrackingRegion.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+  constexpr unsigned int nLayers = 4;
+  const float layerRadius[nLayers] = {2.9f, 6.8f, 10.9f, 16.0f};
+
+  struct Event {
+    std::vector<std::unique_ptr<RecHitsSortedInPhi> > layers;
+    std::vector<std::unique_ptr<HitDoublets> > doublets;
+  };
+
+  Event makeEvent(unsigned int nTracks, unsigned int nNoise) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> phi(-M_PI, M_PI), eta(-2.5f, 2.5f), zVtx(-5.f, 5.f), flat(0.f, 1.f);
+    std::normal_distribution<float> smear(0.f, 0.002f);
+
+    Event ev;
+    std::vector<std::vector<std::array<float,3> > > hits(nLayers);
+    // tracks: circles through the beam line in x-y, straight lines in r-z
+    for (unsigned int t = 0; t < nTracks; ++t) {
+      const float pt = 0.3f/(flat(rng)+0.01f), phi0 = phi(rng), cot = std::sinh(eta(rng)), z0 = zVtx(rng);
+      const float q = flat(rng) < 0.5f ? -1.f : 1.f;
+      const float radius = pt*87.f;
+      for (unsigned int l = 0; l < nLayers; ++l) {
+        const float r = layerRadius[l];
+        if (r > 2.f*radius) break;
+        const float dphi = q*std::asin(r/(2.f*radius));
+        const float p = phi0 + dphi;
+        const float s = 2.f*radius*std::abs(dphi);
+        const float z = z0 + cot*s;
+        if (std::abs(z) > 26.f) break;
+        hits[l].push_back({{r*std::cos(p) + smear(rng), r*std::sin(p) + smear(rng), z + smear(rng)}});
+      }
+    }
+    for (unsigned int l = 0; l < nLayers; ++l) {
+      for (unsigned int i = 0; i < nNoise; ++i) {
+        const float p = phi(rng);
+        hits[l].push_back({{layerRadius[l]*std::cos(p), layerRadius[l]*std::sin(p), 52.f*flat(rng)-26.f}});
+      }
+    }
+
+    for (unsigned int l = 0; l < nLayers; ++l) {
+      auto layer = std::make_unique<RecHitsSortedInPhi>(true);
+      for (auto const& h : hits[l]) {
+        const float r = std::sqrt(h[0]*h[0]+h[1]*h[1]);
+        layer->theHits.emplace_back(std::atan2(h[1], h[0]));
+        layer->x.push_back(h[0]); layer->y.push_back(h[1]); layer->z.push_back(h[2]);
+        layer->u.push_back(r); layer->v.push_back(h[2]);
+      }
+      ev.layers.push_back(std::move(layer));
+    }
+
+    // doublets of consecutive layers inside loose phi and z windows
+    for (unsigned int l = 0; l+1 < nLayers; ++l) {
+      auto const& in = *ev.layers[l];
+      auto const& out = *ev.layers[l+1];
+      auto d = std::make_unique<HitDoublets>(in, out);
+      for (unsigned int io = 0; io < out.size(); ++io) {
+        for (unsigned int ii = 0; ii < in.size(); ++ii) {
+          const float dphi = std::abs(reco::deltaPhi(in.phi(ii), out.phi(io)));
+          const float zPred = out.z[io]*in.u[ii]/out.u[io];
+          if (dphi < 0.03f && std::abs(in.z[ii]-zPred) < 3.f) d->add(ii, io);
+        }
+      }
+      ev.doublets.push_back(std::move(d));
+    }
+    return ev;
+  }
+
+  CAGraph makeGraph(const Event& ev) {
+    CAGraph g;
+    for (unsigned int l = 0; l < nLayers; ++l) g.theLayers.emplace_back("BPix"+std::to_string(l+1), ev.layers[l]->size());
+    for (unsigned int l = 0; l+1 < nLayers; ++l) {
+      g.theLayerPairs.emplace_back(l, l+1);
+      g.theLayers[l].theOuterLayers.push_back(l+1);
+      g.theLayers[l].theOuterLayerPairs.push_back(l);
+      g.theLayers[l+1].theInnerLayers.push_back(l);
+      g.theLayers[l+1].theInnerLayerPairs.push_back(l);
+    }
+    g.theRootLayers.push_back(0);
+    return g;
+  }
+
+  void resetGraph(CAGraph& g) {
+    for (auto& layer : g.theLayers)
+      for (auto& v : layer.isOuterHitOfCell) v.clear();
+  }
+}
+
+int main(int argc, char** argv) {
+  const unsigned int nTracks = argc > 1 ? std::atoi(argv[1]) : 4000;
+  const unsigned int nNoise = argc > 2 ? std::atoi(argv[2]) : 1000;
+  const unsigned int nRepeat = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  const Event ev = makeEvent(nTracks, nNoise);
+  std::vector<const HitDoublets*> hitDoublets;
+  unsigned int nDoublets = 0;
+  for (auto const& d : ev.doublets) {
+    hitDoublets.push_back(d.get());
+    nDoublets += d->size();
+  }
+
+  const GlobalTrackingRegion region(0.5f, GlobalPoint(0, 0, 0), 0.02f, 15.9f);
+  const float thetaCut = 0.002f, phiCut = 0.2f, hardPtCut = 0.f;
+  const unsigned int minHits = 4;
+
+  CAGraph g = makeGraph(ev);
+  std::vector<CACell::CAntuplet> foundAoS, foundSoA;
+  unsigned int overflowing = 0;
+
+  double tAoS = 0, tSoA = 0;
+  for (unsigned int rep = 0; rep < nRepeat; ++rep) {
+    resetGraph(g);
+    foundAoS.clear();
+    auto start = std::chrono::steady_clock::now();
+    {
+      CellularAutomaton ca(g);
+      ca.createAndConnectCells(hitDoublets, region, thetaCut, phiCut, hardPtCut);
+      ca.evolve(minHits);
+      ca.findNtuplets(foundAoS, minHits);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    tAoS += std::chrono::duration<double>(stop-start).count();
+
+    resetGraph(g);
+    foundSoA.clear();
+    start = std::chrono::steady_clock::now();
+    {
+      CellularAutomatonSoA ca(g);
+      ca.createAndConnectCells(hitDoublets, region, thetaCut, phiCut, hardPtCut);
+      ca.evolve(minHits);
+      ca.findNtuplets(foundSoA, minHits);
+      overflowing = ca.getAllCells().numberOfOverflowingCells();
+    }
+    stop = std::chrono::steady_clock::now();
+    tSoA += std::chrono::duration<double>(stop-start).count();
+  }
+
+  const bool same = foundAoS == foundSoA;
+  std::cout << "doublets: " << nDoublets << ", quadruplets: " << foundAoS.size() << " (AoS) "
+            << foundSoA.size() << " (SoA), cells with spilled neighbors: " << overflowing << "\n"
+            << "CellularAutomaton:    " << 1e3*tAoS/nRepeat << " ms/event\n"
+            << "CellularAutomatonSoA: " << 1e3*tSoA/nRepeat << " ms/event\n"
+            << (same ? "identical output" : "OUTPUT DIFFERS") << std::endl;
+
+  return same ? 0 : 1;
+}
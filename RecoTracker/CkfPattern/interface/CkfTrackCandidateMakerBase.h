@@ -25,8 +25,10 @@
 #include "DataFormats/SiPixelCluster/interface/SiPixelCluster.h"
 #include "DataFormats/Phase2TrackerCluster/interface/Phase2TrackerCluster1D.h"
 #include "RecoTracker/MeasurementDet/interface/MeasurementTrackerEvent.h"
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
 
 #include <memory>
+#include <vector>
 
 class TransientInitialStateEstimator;
 
@@ -56,6 +58,14 @@ namespace cms
 
     std::unique_ptr<BaseCkfTrajectoryBuilder> theTrajectoryBuilder;
 
+    /// builders of the tasks building the seeds concurrently, besides
+    /// theTrajectoryBuilder; none if the seeds are built in one loop
+    std::vector<std::unique_ptr<BaseCkfTrajectoryBuilder> > theTaskBuilders;
+
+    /// arenas of the trajectory states and measurements built for a seed,
+    /// of the seed loop then of each building task; none if they use the heap
+    std::vector<std::unique_ptr<TrackingArena> > theArenas;
+
     std::string theTrajectoryCleanerName;
     const TrajectoryCleaner*               theTrajectoryCleaner;
 
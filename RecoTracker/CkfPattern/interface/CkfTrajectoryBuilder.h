@@ -9,6 +9,7 @@ class MeasurementEstimator;
 class TrajectorySeed;
 class TrajectoryStateOnSurface;
 class TrajectoryFilter;
+class KFBatchUpdator;
 
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
@@ -70,6 +71,9 @@ public:
   bool theIntermediateCleaning;	/**< Tells whether an intermediary cleaning stage 
                                      should take place during TB. */
   bool theAlwaysUseInvalidHits;
+  bool theBatchedUpdate;        /**< Tells whether the hits compatible with all
+                                     the candidates of an iteration are updated
+                                     in one batch (KFUpdator only). */
 
 
  protected:
@@ -81,6 +85,8 @@ public:
   unsigned int limitedCandidates(const boost::shared_ptr<const TrajectorySeed> & sharedSeed, TempTrajectoryContainer &candidates, TrajectoryContainer& result) const;
   
   void updateTrajectory( TempTrajectory& traj, TM && tm) const;
+  /// update with the state of the pair index of the batch, if any
+  void updateTrajectory( TempTrajectory& traj, TM && tm, const KFBatchUpdator& batch, int index) const;
 
   /*  
       //not mature for integration.  
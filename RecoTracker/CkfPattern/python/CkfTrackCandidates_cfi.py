@@ -16,6 +16,12 @@ ckfTrackCandidates = cms.EDProducer("CkfTrackCandidateMaker",
 #    SeedLabel = cms.string(''),
     maxNSeeds = cms.uint32(500000),
     maxSeedsBeforeCleaning = cms.uint32(5000),
+# Build the seeds with this many concurrent tasks (0 or 1: in one loop);
+# the candidates are those of the loop
+    buildingTasks = cms.uint32(0),
+# Take the trajectory states and measurements from arenas of the module
+# instead of the heap
+    stateArena = cms.bool(False),
 # SeedProducer:SeedLabel descoped to src
     src = cms.InputTag('globalMixedSeeds'),                                  
     SimpleMagneticField = cms.string(''),                                    
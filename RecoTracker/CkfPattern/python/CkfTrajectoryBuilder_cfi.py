@@ -18,6 +18,8 @@ CkfTrajectoryBuilder = cms.PSet(
     propagatorOpposite = cms.string('PropagatorWithMaterialOpposite'),
 #    propagatorOpposite = cms.string('PropagatorWithMaterialParabolicMfOpposite'),
     lostHitPenalty = cms.double(30.0),
+    # update the hits of all the candidates of an iteration in one batch
+    batchedUpdate = cms.bool(False),
     #SharedSeedCheck = cms.bool(False)
 )
 
@@ -41,9 +41,8 @@
 // #define VI_TBB
 
 #include <thread>
-#ifdef VI_TBB
 #include "tbb/parallel_for.h"
-#endif
+#include "tbb/task_arena.h"
 
 #include "RecoTracker/CkfPattern/interface/PrintoutHelper.h"
 
@@ -94,6 +93,15 @@ namespace cms{
         maskPixels_ = iC.consumes<PixelClusterMask>(conf.getParameter<edm::InputTag>("phase2clustersToSkip"));
         maskPhase2OTs_ = iC.consumes<Phase2OTClusterMask>(conf.getParameter<edm::InputTag>("phase2clustersToSkip"));
       }
+      // the seeds are built by as many concurrent tasks as builders
+      unsigned int buildingTasks = conf.existsAs<unsigned int>("buildingTasks") ? conf.getParameter<unsigned int>("buildingTasks") : 0;
+      for (unsigned int i = 1; i < buildingTasks; ++i)
+        theTaskBuilders.emplace_back(createBaseCkfTrajectoryBuilder(conf.getParameter<edm::ParameterSet>("TrajectoryBuilderPSet"), iC));
+      // the trajectory states and measurements are taken from arenas of
+      // the module
+      if (conf.existsAs<bool>("stateArena") && conf.getParameter<bool>("stateArena"))
+        for (unsigned int i = 0; i < std::max(buildingTasks, 1U) + 1; ++i)
+          theArenas.emplace_back(std::make_unique<TrackingArena>());
 #ifndef VI_REPRODUCIBLE
     std::string cleaner = conf.getParameter<std::string>("RedundantSeedCleaner");
     if (cleaner == "CachingSeedCleanerBySharedInput") {
@@ -144,6 +152,7 @@ namespace cms{
     es.get<NavigationSchoolRecord>().get(theNavigationSchoolName, navigationSchoolH);
     theNavigationSchool = navigationSchoolH.product();
     theTrajectoryBuilder->setNavigationSchool(theNavigationSchool);
+    for (auto & builder : theTaskBuilders) builder->setNavigationSchool(theNavigationSchool);
   }
 
   // Functions that gets called by framework every event
@@ -189,6 +198,8 @@ namespace cms{
         //std::cout << "Trajectory builder " << conf_.getParameter<std::string>("@module_label") << " created without masks " << std::endl;
         theTrajectoryBuilder->setEvent(e, es, &*data);
     }
+    for (auto & builder : theTaskBuilders)
+      builder->setEvent(e, es, dataWithMasks ? &*dataWithMasks : &*data);
     // TISE ES must be set here due to dependence on theTrajectoryBuilder
     theInitialState->setEventSetup( es, static_cast<TkTransientTrackingRecHitBuilder const *>(theTrajectoryBuilder->hitBuilder())->cloner() );
 
@@ -267,38 +278,17 @@ namespace cms{
 #endif
 
       std::atomic<unsigned int> ntseed(0);
-      auto theLoop = [&](size_t ii) {
-        auto j = indeces[ii];
-
-        ntseed++;
-
-        // to be moved inside a par section (how with tbb??)
-        std::vector<Trajectory> theTmpTrajectories;
-
-
-	LogDebug("CkfPattern") << "======== Begin to look for trajectories from seed " << j << " ========\n";
-
-        { Lock lock(theMutex);
-	// Check if seed hits already used by another track
-	if (theSeedCleaner && !theSeedCleaner->good( &((*collseed)[j])) ) {
-          LogDebug("CkfTrackCandidateMakerBase")<<" Seed cleaning kills seed "<<j;
-          (*outputSeedStopInfos)[j].setStopReason(SeedStopReason::SEED_CLEANING);
-          return;  // from the lambda!
-        }}
 
+      // Build trajectories from seed j with builder; returns NOT_STOPPED if
+      // trajectories are left, the reason the seed stops otherwise
+      auto buildSeedTrajectories = [&](BaseCkfTrajectoryBuilder const & builder, size_t j,
+                                       std::vector<Trajectory> & theTmpTrajectories, unsigned int & nCandPerSeed) {
 
 	// Build trajectory from seed outwards
         theTmpTrajectories.clear();
-        unsigned int nCandPerSeed = 0;
-        auto const & startTraj = theTrajectoryBuilder->buildTrajectories( (*collseed)[j], theTmpTrajectories, nCandPerSeed, nullptr );
-        {
-          Lock lock(theMutex);
-          (*outputSeedStopInfos)[j].setCandidatesPerSeed(nCandPerSeed);
-          if(theTmpTrajectories.empty()) {
-            (*outputSeedStopInfos)[j].setStopReason(SeedStopReason::NO_TRAJECTORY);
-            return; // from the lambda!
-          }
-        }
+        nCandPerSeed = 0;
+        auto const & startTraj = builder.buildTrajectories( (*collseed)[j], theTmpTrajectories, nCandPerSeed, nullptr );
+        if(theTmpTrajectories.empty()) return SeedStopReason::NO_TRAJECTORY;
 
 	LogDebug("CkfPattern") << "======== In-out trajectory building found " << theTmpTrajectories.size()
 			            << " trajectories from seed " << j << " ========\n"
@@ -319,16 +309,12 @@ namespace cms{
 	// seed and if possible further inwards.
 
 	if (doSeedingRegionRebuilding) {
-	  theTrajectoryBuilder->rebuildTrajectories(startTraj,(*collseed)[j],theTmpTrajectories);
+	  builder.rebuildTrajectories(startTraj,(*collseed)[j],theTmpTrajectories);
 
   	  LogDebug("CkfPattern") << "======== Out-in trajectory building found " << theTmpTrajectories.size()
   			              << " valid/invalid trajectories from seed " << j << " ========\n"
 				 <<PrintoutHelper::dumpCandidates(theTmpTrajectories);
-          if(theTmpTrajectories.empty()) {
-            Lock lock(theMutex);
-            (*outputSeedStopInfos)[j].setStopReason(SeedStopReason::SEED_REGION_REBUILD);
-            return;
-          }
+          if(theTmpTrajectories.empty()) return SeedStopReason::SEED_REGION_REBUILD;
         }
 
 
@@ -339,7 +325,33 @@ namespace cms{
                                << j << " ========\n"
 			       <<PrintoutHelper::dumpCandidates(theTmpTrajectories);
 
-        { Lock lock(theMutex);
+        return SeedStopReason::NOT_STOPPED;
+      };
+
+      // The same, with the states and measurements taken from arena, if
+      // any: a round of the arena per seed, the states of the trajectories
+      // left are moved to the heap
+      auto buildSeed = [&](BaseCkfTrajectoryBuilder const & builder, size_t j,
+                           std::vector<Trajectory> & theTmpTrajectories, unsigned int & nCandPerSeed,
+                           TrackingArena * arena) {
+        TrackingArena::Scope arenaScope(arena);
+        TrackingArena::Round arenaRound;
+        auto stopReason = buildSeedTrajectories(builder, j, theTmpTrajectories, nCandPerSeed);
+        if (arena)
+          for (auto & traj : theTmpTrajectories) traj.moveStatesToHeap();
+        return stopReason;
+      };
+
+      // Store the trajectories built from seed j
+      auto storeSeed = [&](size_t j, std::vector<Trajectory> & theTmpTrajectories, unsigned int nCandPerSeed,
+                           SeedStopReason stopReason) {
+        Lock lock(theMutex);
+        (*outputSeedStopInfos)[j].setCandidatesPerSeed(nCandPerSeed);
+        if (stopReason != SeedStopReason::NOT_STOPPED) {
+          (*outputSeedStopInfos)[j].setStopReason(stopReason);
+          return;
+        }
+
 	for(vector<Trajectory>::iterator it=theTmpTrajectories.begin();
 	    it!=theTmpTrajectories.end(); it++){
 	  if( it->isValid() ) {
@@ -352,13 +364,12 @@ namespace cms{
             if (theSeedCleaner && rawResult.back().foundHits()>3) theSeedCleaner->add( &rawResult.back() );
             //if (theSeedCleaner ) theSeedCleaner->add( & (*it) );
 	  }
-	}}
+	}
 
         theTmpTrajectories.clear();
 
 	LogDebug("CkfPattern") << "rawResult trajectories found so far = " << rawResult.size();
 
-        { Lock lock(theMutex);
 	if ( maxSeedsBeforeCleaning_ >0 && rawResult.size() > maxSeedsBeforeCleaning_+lastCleanResult) {
           theTrajectoryCleaner->clean(rawResult);
           rawResult.erase(std::remove_if(rawResult.begin()+lastCleanResult,rawResult.end(),
@@ -366,21 +377,103 @@ namespace cms{
 			  rawResult.end());
           lastCleanResult=rawResult.size();
         }
+      };
+
+      // Check if seed hits already used by another track
+      auto cleanSeed = [&](size_t j) {
+        if (theSeedCleaner && !theSeedCleaner->good( &((*collseed)[j])) ) {
+          LogDebug("CkfTrackCandidateMakerBase")<<" Seed cleaning kills seed "<<j;
+          (*outputSeedStopInfos)[j].setStopReason(SeedStopReason::SEED_CLEANING);
+          return true;
+        }
+        return false;
+      };
+
+      auto theLoop = [&](size_t ii) {
+        auto j = indeces[ii];
+
+        ntseed++;
+
+        // to be moved inside a par section (how with tbb??)
+        std::vector<Trajectory> theTmpTrajectories;
+
+
+	LogDebug("CkfPattern") << "======== Begin to look for trajectories from seed " << j << " ========\n";
+
+        { Lock lock(theMutex);
+        if (cleanSeed(j)) return;  // from the lambda!
         }
 
+        unsigned int nCandPerSeed = 0;
+        // the arena of the loop is for one thread only
+#if defined(VI_TBB) || defined(VI_OMP)
+        TrackingArena * arena = nullptr;
+#else
+        TrackingArena * arena = theArenas.empty() ? nullptr : theArenas[0].get();
+#endif
+        auto stopReason = buildSeed(*theTrajectoryBuilder, j, theTmpTrajectories, nCandPerSeed, arena);
+        storeSeed(j, theTmpTrajectories, nCandPerSeed, stopReason);
       };
       // end of loop over seeds
 
+      // Concurrent building: the seeds are built in blocks, each block by
+      // tasks taking the seeds one after the other, then the trajectories
+      // are stored in the order of the seeds, as by the loop. The seed
+      // cleaner only learns new trajectories, so that the seeds it kills
+      // before a block is built are killed when the block is stored too;
+      // the others are checked again when stored.
+      auto theBlockLoop = [&]() {
+        size_t nTasks = theTaskBuilders.size() + 1;
+        size_t blockSize = theSeedCleaner ? 8*nTasks : collseed_size;
+        std::vector<std::vector<Trajectory> > blockTrajectories(blockSize);
+        std::vector<unsigned int> blockCands(blockSize);
+        std::vector<SeedStopReason> blockStopReasons(blockSize);
+        std::vector<char> blockBuilt(blockSize);
+        for (size_t begin = 0; begin < collseed_size; begin += blockSize) {
+          size_t end = std::min(begin+blockSize, collseed_size);
+          for (size_t ii = begin; ii < end; ++ii)
+            blockBuilt[ii-begin] = !cleanSeed(indeces[ii]);
+
+          std::atomic<size_t> next(begin);
+          // isolated, so that the threads waiting for the block take no
+          // unrelated task (e.g. another module) half way through it
+          tbb::this_task_arena::isolate([&] {
+            tbb::parallel_for(size_t(0), nTasks, [&](size_t task) {
+                auto const & builder = task == 0 ? *theTrajectoryBuilder : *theTaskBuilders[task-1];
+                auto arena = theArenas.empty() ? nullptr : theArenas[task+1].get();
+                for (size_t ii = next++; ii < end; ii = next++) {
+                  if (!blockBuilt[ii-begin]) continue;
+                  LogDebug("CkfPattern") << "======== Begin to look for trajectories from seed " << indeces[ii] << " ========\n";
+                  blockStopReasons[ii-begin] = buildSeed(builder, indeces[ii], blockTrajectories[ii-begin], blockCands[ii-begin], arena);
+                }
+              });
+            });
+
+          for (size_t ii = begin; ii < end; ++ii) {
+            ntseed++;
+            if (!blockBuilt[ii-begin]) continue;
+            if (cleanSeed(indeces[ii])) {
+              blockTrajectories[ii-begin].clear();
+              continue;
+            }
+            storeSeed(indeces[ii], blockTrajectories[ii-begin], blockCands[ii-begin], blockStopReasons[ii-begin]);
+          }
+        }
+      };
+
 
 #ifdef VI_TBB
      tbb::parallel_for(0UL,collseed_size,1UL,theLoop);
 #else
+      if (!theTaskBuilders.empty()) theBlockLoop();
+      else {
 #ifdef VI_OMP
 #pragma omp parallel for schedule(dynamic,4)
 #endif
       for (size_t j = 0; j < collseed_size; j++){
        theLoop(j);
       }
+      }
 #endif
       assert(ntseed==collseed_size);
       if (theSeedCleaner) theSeedCleaner->done();
@@ -7,6 +7,8 @@
 #include "TrackingTools/GeomPropagators/interface/Propagator.h"
 #include "TrackingTools/PatternTools/interface/TrajectoryStateUpdator.h"
 #include "TrackingTools/KalmanUpdators/interface/Chi2MeasurementEstimatorBase.h"
+#include "TrackingTools/KalmanUpdators/interface/KFUpdator.h"
+#include "TrackingTools/KalmanUpdators/interface/KFBatchUpdator.h"
 
 #include "TrackingTools/PatternTools/interface/Trajectory.h"
 #include "TrackingTools/PatternTools/interface/TrajMeasLessEstim.h"
@@ -39,6 +41,7 @@ CkfTrajectoryBuilder::CkfTrajectoryBuilder(const edm::ParameterSet& conf, Trajec
   theLostHitPenalty       = conf.getParameter<double>("lostHitPenalty");
   theIntermediateCleaning = conf.getParameter<bool>("intermediateCleaning");
   theAlwaysUseInvalidHits = conf.getParameter<bool>("alwaysUseInvalidHits");
+  theBatchedUpdate        = conf.existsAs<bool>("batchedUpdate") && conf.getParameter<bool>("batchedUpdate");
   /*
     theSharedSeedCheck = conf.getParameter<bool>("SharedSeedCheck");
     std::stringstream ss;
@@ -195,38 +198,71 @@ limitedCandidates(const boost::shared_ptr<const TrajectorySeed> & sharedSeed, Te
     return  (a.chiSquared() + a.lostHits()*theLostHitPenalty)  <
     (b.chiSquared() + b.lostHits()*theLostHitPenalty);
   };
+
+  // the measurements used to update a candidate
+  auto lastMeasurement = [&](std::vector<TM> & meas) {
+    if ( theAlwaysUseInvalidHits || !meas.front().recHit()->isValid()) return meas.end();
+    return find_if( meas.begin(), meas.end(), RecHitIsInvalid());
+  };
+
+  // batched update: the measurements of all the candidates of an iteration
+  // are found first, then their valid hits updated together
+  bool batched = theBatchedUpdate && dynamic_cast<const KFUpdator*>(theUpdator);
+  KFBatchUpdator batchUpdator;
+  std::vector<std::vector<TM> > candMeas;
+  std::vector<int> batchIndex;
   
  
   while ( !candidates.empty()) {
 
     newCand.clear();
-    for (auto traj=candidates.begin(); traj!=candidates.end(); traj++) {
-      std::vector<TM> meas;
-      findCompatibleMeasurements(*sharedSeed, *traj, meas);
-
-      // --- method for debugging
-      if(!analyzeMeasurementsDebugger(*traj,meas,
-				      theMeasurementTracker,
-				      forwardPropagator(*sharedSeed),theEstimator,
-				      theTTRHBuilder)) return nCands;
-      // ---
+    auto candEnd = candidates.end();
+    if (batched) {
+      candMeas.resize(candidates.size());
+      batchUpdator.clear();
+      batchIndex.clear();
+      for (auto traj=candidates.begin(); traj!=candEnd; traj++) {
+	std::vector<TM> & meas = candMeas[traj-candidates.begin()];
+	meas.clear();
+	findCompatibleMeasurements(*sharedSeed, *traj, meas);
+	// --- method for debugging: the candidates before are still built
+	if(!analyzeMeasurementsDebugger(*traj,meas,
+					theMeasurementTracker,
+					forwardPropagator(*sharedSeed),theEstimator,
+					theTTRHBuilder)) { candEnd = traj; break; }
+	// ---
+	if ( meas.empty()) continue;
+	for(auto itm = meas.begin(), last = lastMeasurement(meas); itm != last; itm++)
+	  batchIndex.push_back(itm->recHit()->isValid() ? batchUpdator.add(itm->predictedState(), *itm->recHit()) : -1);
+      }
+      batchUpdator.update();
+    }
+    auto nextIndex = batchIndex.begin();
+
+    for (auto traj=candidates.begin(); traj!=candEnd; traj++) {
+      std::vector<TM> localMeas;
+      std::vector<TM> & meas = batched ? candMeas[traj-candidates.begin()] : localMeas;
+      if (!batched) {
+	findCompatibleMeasurements(*sharedSeed, *traj, meas);
+
+	// --- method for debugging
+	if(!analyzeMeasurementsDebugger(*traj,meas,
+					theMeasurementTracker,
+					forwardPropagator(*sharedSeed),theEstimator,
+					theTTRHBuilder)) return nCands;
+	// ---
+      }
 
       if ( meas.empty()) {
 	addToResult(sharedSeed, *traj, result);
       }
       else {
-	std::vector<TM>::const_iterator last;
-	if ( theAlwaysUseInvalidHits) last = meas.end();
-	else {
-	  if (meas.front().recHit()->isValid()) {
-	    last = find_if( meas.begin(), meas.end(), RecHitIsInvalid());
-	  }
-	  else last = meas.end();
-	}
+	auto last = lastMeasurement(meas);
 
 	for(auto itm = meas.begin(); itm != last; itm++) {
 	  TempTrajectory newTraj = *traj;
-	  updateTrajectory( newTraj, std::move(*itm));
+	  if (batched) updateTrajectory( newTraj, std::move(*itm), batchUpdator, *nextIndex++);
+	  else updateTrajectory( newTraj, std::move(*itm));
 
 	  if ( toBeContinued(newTraj)) {
 	    newCand.push_back(std::move(newTraj));  std::push_heap(newCand.begin(),newCand.end(),trajCandLess);
@@ -295,6 +331,7 @@ limitedCandidates(const boost::shared_ptr<const TrajectorySeed> & sharedSeed, Te
       */
 
     } // end loop on candidates
+    if (candEnd != candidates.end()) return nCands;
 
     std::sort_heap(newCand.begin(),newCand.end(),trajCandLess);
     if (theIntermediateCleaning) IntermediateTrajectoryCleaner::clean(newCand);
@@ -327,6 +364,19 @@ void CkfTrajectoryBuilder::updateTrajectory( TempTrajectory& traj,
   }
 }
 
+void CkfTrajectoryBuilder::updateTrajectory( TempTrajectory& traj,
+					     TM && tm, const KFBatchUpdator& batch, int index) const
+{
+  if (index < 0) {
+    updateTrajectory(traj, std::move(tm));
+    return;
+  }
+  auto && predictedState = tm.predictedState();
+  auto && upState = batch.updatedState(index, predictedState);
+  traj.emplace( std::move(predictedState), std::move(upState),
+	       std::move(tm.recHit()), tm.estimate(), tm.layer());
+}
+
 
 void 
 CkfTrajectoryBuilder::findCompatibleMeasurements(const TrajectorySeed&seed,
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Time per event of the heavy-ion reconstruction with the seeds built in
+# one loop, then by as many concurrent tasks as threads, and the speedup
+# of each number of threads.
+#
+# parallelBuildingScan.sh file:raw.root [events] [threads...]
+
+input=$1
+events=${2:-20}
+shift; [ $# -gt 0 ] && shift
+threads=${@:-1 2 4 8 16}
+
+config=${CMSSW_BASE}/src/RecoTracker/CkfPattern/test/parallelBuilding_cfg.py
+[ -f $config ] || config=${CMSSW_RELEASE_BASE}/src/RecoTracker/CkfPattern/test/parallelBuilding_cfg.py
+
+eventTime() {
+  cmsRun $config inputFiles=$input maxEvents=$events threads=$1 buildingTasks=$2 2>&1 \
+    | awk '/- Avg event:/ { print $NF }'
+}
+
+loop=$(eventTime 1 0)
+[ -n "$loop" ] || { echo "parallelBuildingScan: cmsRun failed"; exit 1; }
+printf "%8s %16s %10s\n" threads "s/event" speedup
+printf "%8s %16.3f %10s\n" loop $loop 1.00
+for n in $threads; do
+  t=$(eventTime $n $n)
+  printf "%8d %16.3f %10.2f\n" $n $t $(echo "$loop / $t" | bc -l)
+done
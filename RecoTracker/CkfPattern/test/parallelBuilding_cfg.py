@@ -0,0 +1,47 @@
+# Heavy-ion reconstruction of RAW events with the seeds of every CKF
+# iteration built by concurrent tasks, timed per event by the Timing
+# service. One stream, so that the time per event shows the building
+# tasks running on the threads.
+#
+# cmsRun parallelBuilding_cfg.py inputFiles=file:raw.root threads=8 buildingTasks=8
+
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+from Configuration.StandardSequences.Eras import eras
+
+options = VarParsing.VarParsing('analysis')
+options.register('threads', 1, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "number of threads")
+options.register('buildingTasks', 0, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "concurrent tasks building the seeds, 0 for the loop")
+options.parseArguments()
+
+process = cms.Process('RECO', eras.Run2_HI)
+
+process.load('Configuration.StandardSequences.Services_cff')
+process.load('FWCore.MessageService.MessageLogger_cfi')
+process.load('Configuration.StandardSequences.GeometryRecoDB_cff')
+process.load('Configuration.StandardSequences.MagneticField_cff')
+process.load('Configuration.StandardSequences.RawToDigi_cff')
+process.load('Configuration.StandardSequences.ReconstructionHeavyIons_cff')
+process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_cff')
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:run2_mc_hi', '')
+
+process.source = cms.Source('PoolSource', fileNames = cms.untracked.vstring(options.inputFiles))
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.threads),
+    numberOfStreams = cms.untracked.uint32(1),
+)
+
+for name, producer in process.producers_().items():
+    if producer.type_() == 'CkfTrackCandidateMaker':
+        producer.buildingTasks = cms.uint32(options.buildingTasks)
+
+process.Timing = cms.Service('Timing', summaryOnly = cms.untracked.bool(True))
+process.MessageLogger.cerr.FwkReport.reportEvery = 10
+
+process.raw2digi_step = cms.Path(process.RawToDigi)
+process.reconstruction_step = cms.Path(process.reconstructionHeavyIons)
+process.schedule = cms.Schedule(process.raw2digi_step, process.reconstruction_step)
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Time per event and peak memory of the reconstruction with the trajectory
+# states taken from the heap, then from the arenas of the modules; then
+# the states alone, as built by testArena, one mode per process.
+#
+# stateArenaBenchmark.sh file:raw.root [events] [threads]
+
+input=$1
+events=${2:-100}
+threads=${3:-1}
+
+config=${CMSSW_BASE}/src/RecoTracker/CkfPattern/test/stateArena_cfg.py
+[ -f $config ] || config=${CMSSW_RELEASE_BASE}/src/RecoTracker/CkfPattern/test/stateArena_cfg.py
+
+printf "%8s %16s %16s\n" states "s/event" "peak VSize MB"
+for arena in 0 1; do
+  cmsRun $config inputFiles=$input maxEvents=$events threads=$threads stateArena=$arena > stateArena_$arena.log 2>&1 \
+    || { echo "stateArenaBenchmark: cmsRun failed, see stateArena_$arena.log"; exit 1; }
+  t=$(awk '/- Avg event:/ { print $NF }' stateArena_$arena.log)
+  vsize=$(awk '/Peak virtual size/ { print $(NF-1) }' stateArena_$arena.log)
+  [ $arena = 0 ] && name=heap || name=arena
+  printf "%8s %16.3f %16s\n" $name $t "${vsize:--}"
+done
+
+which testArena > /dev/null 2>&1 || exit 0
+for mode in heap arena round; do
+  testArena $mode || exit 1
+done
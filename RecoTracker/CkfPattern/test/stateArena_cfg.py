@@ -0,0 +1,49 @@
+# Reconstruction of RAW events with the trajectory states and measurements
+# of the CKF track candidate makers and of the track fits taken from arenas
+# of the modules (stateArena=1) or from the heap (stateArena=0), timed per
+# event by the Timing service, with the memory of the job followed by
+# SimpleMemoryCheck.
+#
+# cmsRun stateArena_cfg.py inputFiles=file:raw.root threads=4 stateArena=1
+
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+from Configuration.StandardSequences.Eras import eras
+
+options = VarParsing.VarParsing('analysis')
+options.register('threads', 1, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "number of threads and streams")
+options.register('stateArena', 0, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "1 to take the states from arenas")
+options.parseArguments()
+
+process = cms.Process('RECO', eras.Run2_2017)
+
+process.load('Configuration.StandardSequences.Services_cff')
+process.load('FWCore.MessageService.MessageLogger_cfi')
+process.load('Configuration.StandardSequences.GeometryRecoDB_cff')
+process.load('Configuration.StandardSequences.MagneticField_cff')
+process.load('Configuration.StandardSequences.RawToDigi_cff')
+process.load('Configuration.StandardSequences.Reconstruction_cff')
+process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_cff')
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:phase1_2017_realistic', '')
+
+process.source = cms.Source('PoolSource', fileNames = cms.untracked.vstring(options.inputFiles))
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.threads),
+    numberOfStreams = cms.untracked.uint32(options.threads),
+)
+
+for name, producer in process.producers_().items():
+    if producer.type_() in ('CkfTrackCandidateMaker', 'TrackProducer'):
+        producer.stateArena = cms.bool(bool(options.stateArena))
+
+process.Timing = cms.Service('Timing', summaryOnly = cms.untracked.bool(True))
+process.SimpleMemoryCheck = cms.Service('SimpleMemoryCheck', ignoreTotal = cms.untracked.int32(1))
+process.MessageLogger.cerr.FwkReport.reportEvery = 10
+
+process.raw2digi_step = cms.Path(process.RawToDigi)
+process.reconstruction_step = cms.Path(process.reconstruction_trackingOnly)
+process.schedule = cms.Schedule(process.raw2digi_step, process.reconstruction_step)
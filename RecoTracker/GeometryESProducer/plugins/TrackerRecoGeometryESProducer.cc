@@ -10,6 +10,7 @@
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/Framework/interface/ModuleFactory.h"
 #include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/ParameterSet/interface/ParameterSetDescription.h"
 
 
 #include <memory>
@@ -27,10 +28,21 @@ TrackerRecoGeometryESProducer::TrackerRecoGeometryESProducer(const edm::Paramete
     // The default parameter ("") makes this change transparent to the user
     // See FastSimulation/Configuration/data/ for examples of cfi's.
     geoLabel = p.getUntrackedParameter<std::string>("trackerGeometryLabel","");
+    // precomputed lookup tables of the compatible dets of the layers
+    compatibleDetsLookup = p.getParameter<bool>("compatibleDetsLookup");
 }
 
 TrackerRecoGeometryESProducer::~TrackerRecoGeometryESProducer() {}
 
+void TrackerRecoGeometryESProducer::fillDescriptions(edm::ConfigurationDescriptions & descriptions) {
+  edm::ParameterSetDescription desc;
+  desc.addUntracked<std::string>("trackerGeometryLabel","");
+  // tracked, so that the configurations with the lookup can be told apart
+  desc.add<bool>("compatibleDetsLookup",false)->setComment("Skip the compatibleDets() searches of a layer with a precomputed lookup when no det is in reach.");
+  // no cfi generated, the one of the package is hand-written
+  descriptions.addDefault(desc);
+}
+
 std::unique_ptr<GeometricSearchTracker> 
 TrackerRecoGeometryESProducer::produce(const TrackerRecoGeometryRecord & iRecord){ 
 
@@ -43,7 +55,7 @@ TrackerRecoGeometryESProducer::produce(const TrackerRecoGeometryRecord & iRecord
   const TrackerTopology *tTopo=tTopoHand.product();
 
   GeometricSearchTrackerBuilder builder;
-  return std::unique_ptr<GeometricSearchTracker>(builder.build( tG->trackerDet(), &(*tG), tTopo ));
+  return std::unique_ptr<GeometricSearchTracker>(builder.build( tG->trackerDet(), &(*tG), tTopo, compatibleDetsLookup ));
 }
 
 
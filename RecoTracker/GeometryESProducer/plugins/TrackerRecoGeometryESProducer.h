@@ -3,6 +3,7 @@
 
 #include "FWCore/Framework/interface/ESProducer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ParameterSet/interface/ConfigurationDescriptions.h"
 #include "Geometry/Records/interface/TrackerDigiGeometryRecord.h"
 #include "RecoTracker/Record/interface/TrackerRecoGeometryRecord.h"
 #include "RecoTracker/TkDetLayers/interface/GeometricSearchTracker.h"
@@ -13,8 +14,10 @@ class  TrackerRecoGeometryESProducer: public edm::ESProducer{
   TrackerRecoGeometryESProducer(const edm::ParameterSet & p);
   ~TrackerRecoGeometryESProducer() override; 
   std::unique_ptr<GeometricSearchTracker> produce(const TrackerRecoGeometryRecord &);
+  static void fillDescriptions(edm::ConfigurationDescriptions & descriptions);
  private:
  std::string geoLabel;
+ bool compatibleDetsLookup;
 };
 
 
@@ -1,5 +1,7 @@
 import FWCore.ParameterSet.Config as cms
 
-TrackerRecoGeometryESProducer = cms.ESProducer("TrackerRecoGeometryESProducer")
-
-
+TrackerRecoGeometryESProducer = cms.ESProducer("TrackerRecoGeometryESProducer",
+    # precomputed lookup tables of the dets of the layers, to skip the
+    # compatibleDets() and grouped searches of a layer when no det is in reach
+    compatibleDetsLookup = cms.bool(False)
+)
@@ -0,0 +1,175 @@
+// system include files
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "RecoTracker/Record/interface/TrackerRecoGeometryRecord.h"
+#include "RecoTracker/TkDetLayers/interface/GeometricSearchTracker.h"
+#include "TrackingTools/DetLayers/interface/CompatibleDetsLookup.h"
+#include "TrackingTools/GeomPropagators/interface/AnalyticalPropagator.h"
+#include "TrackingTools/KalmanUpdators/interface/Chi2MeasurementEstimator.h"
+#include "TrackingTools/TrajectoryState/interface/TrajectoryStateOnSurface.h"
+#include "MagneticField/Engine/interface/MagneticField.h"
+#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
+#include "DataFormats/GeometrySurface/interface/Plane.h"
+
+/*
+ * Compares, layer by layer, the compatible dets given by the search of the
+ * tracker layers with those given when the search is skipped for the states
+ * for which a CompatibleDetsLookup of the layer finds no det in reach, and
+ * times both. Any difference, in the dets or in their order, is an error.
+ * The states leave vertices along the beam line on a grid of pt, eta, phi
+ * and charge; some of them are also propagated to each layer, to start
+ * from there as the states of the pattern recognition do.
+ */
+
+using namespace std;
+
+class CompatibleDetsLookupAnalyzer : public edm::one::EDAnalyzer<> {
+public:
+  CompatibleDetsLookupAnalyzer( const edm::ParameterSet& );
+  ~CompatibleDetsLookupAnalyzer();
+
+  void beginJob() override {}
+  void analyze(edm::Event const& iEvent, edm::EventSetup const&) override;
+  void endJob() override {}
+
+private:
+  vector<double> thePt;
+  vector<double> theVertexZ;
+  unsigned int theNEta, theNPhi;
+  double theEtaMax;
+  unsigned int theLayerStateStride;
+  double theMaxChi2, theNSigma;
+};
+
+CompatibleDetsLookupAnalyzer::CompatibleDetsLookupAnalyzer( const edm::ParameterSet& iConfig ) :
+  thePt(iConfig.getParameter<vector<double> >("pt")),
+  theVertexZ(iConfig.getParameter<vector<double> >("vertexZ")),
+  theNEta(iConfig.getParameter<unsigned int>("nEta")),
+  theNPhi(iConfig.getParameter<unsigned int>("nPhi")),
+  theEtaMax(iConfig.getParameter<double>("etaMax")),
+  theLayerStateStride(iConfig.getParameter<unsigned int>("layerStateStride")),
+  theMaxChi2(iConfig.getParameter<double>("maxChi2")),
+  theNSigma(iConfig.getParameter<double>("nSigma"))
+{}
+
+CompatibleDetsLookupAnalyzer::~CompatibleDetsLookupAnalyzer()
+{}
+
+void
+CompatibleDetsLookupAnalyzer::analyze( const edm::Event& iEvent, const edm::EventSetup& iSetup )
+{
+  typedef std::chrono::steady_clock Clock;
+
+  edm::ESHandle<GeometricSearchTracker> tracker;
+  iSetup.get<TrackerRecoGeometryRecord>().get( tracker );
+  edm::ESHandle<MagneticField> field;
+  iSetup.get<IdealMagneticFieldRecord>().get( field );
+
+  AnalyticalPropagator propagator(field.product(), alongMomentum);
+  Chi2MeasurementEstimator estimator(theMaxChi2, theNSigma);
+
+  // the states at the vertices, on a plane normal to their momentum
+  vector<TrajectoryStateOnSurface> states;
+  AlgebraicSymMatrix55 error;
+  for (auto z : theVertexZ)
+    for (auto pt : thePt)
+      for (unsigned int ieta = 0; ieta < theNEta; ++ieta)
+	for (unsigned int iphi = 0; iphi < theNPhi; ++iphi)
+	  for (int charge = -1; charge <= 1; charge += 2) {
+	    double eta = theNEta > 1 ? -theEtaMax + 2*theEtaMax*ieta/(theNEta-1) : 0.;
+	    double phi = -M_PI + (iphi + 0.5)*2*M_PI/theNPhi;
+	    GlobalVector p(pt*cos(phi), pt*sin(phi), pt*sinh(eta));
+	    GlobalPoint x(0,0,z);
+	    GlobalVector xx(p.y(), -p.x(), 0.);
+	    GlobalVector yy(p.cross(xx));
+	    Surface::RotationType rot(xx, yy);
+	    auto plane = Plane::build(x, rot);
+	    // errors of a track seeded in the pixels
+	    error(0,0) = 0.01*0.01/(pt*pt*cosh(eta)*cosh(eta));
+	    error(1,1) = error(2,2) = 1.e-3*1.e-3;
+	    error(3,3) = error(4,4) = 0.01*0.01;
+	    states.emplace_back(GlobalTrajectoryParameters(x, p, charge, field.product()),
+				CurvilinearTrajectoryError(error), *plane);
+	  }
+
+  // some of them on the surface of each layer
+  unsigned int nVertexStates = states.size();
+  for (auto layer : tracker->allLayers())
+    for (unsigned int i = 0; i < nVertexStates; i += std::max(1U, theLayerStateStride)) {
+      TrajectoryStateOnSurface onLayer = propagator.propagate(states[i], layer->surface());
+      if (onLayer.isValid()) states.push_back(onLayer);
+    }
+
+  unsigned long long nQueries = 0, nSkipped = 0, nDets = 0, nDifferent = 0;
+  double tSearch = 0, tLookup = 0;
+  vector<GeometricSearchDet::DetWithState> searched, lookedUp;
+  for (auto layer : tracker->allLayers()) {
+    CompatibleDetsLookup lookup(*layer);
+    unsigned long long layerSkipped = 0, layerDifferent = 0;
+    double layerSearch = 0, layerLookup = 0;
+    for (auto const & tsos : states) {
+      searched.clear(); lookedUp.clear();
+      auto s0 = Clock::now();
+      layer->GeometricSearchDet::compatibleDetsV(tsos, propagator, estimator, searched);
+      auto s1 = Clock::now();
+      bool search = lookup.mayHaveCompatibleDets(tsos, propagator, estimator);
+      if (search) layer->GeometricSearchDet::compatibleDetsV(tsos, propagator, estimator, lookedUp);
+      auto s2 = Clock::now();
+      layerSearch += std::chrono::duration<double>(s1 - s0).count();
+      layerLookup += std::chrono::duration<double>(s2 - s1).count();
+      if (!search) ++layerSkipped;
+      nDets += searched.size();
+
+      bool same = searched.size() == lookedUp.size();
+      for (unsigned int i = 0; same && i < searched.size(); ++i)
+	same = searched[i].first == lookedUp[i].first;
+      // the grouped searches are skipped too (LayerMeasurements)
+      if (same && !search)
+	for (auto const & group : layer->groupedCompatibleDets(tsos, propagator, estimator))
+	  same = same && group.empty();
+      if (same) continue;
+      ++layerDifferent;
+      edm::LogError("CompatibleDetsLookupAnalyzer") << "layer " << layer->seqNum()
+						    << ": " << searched.size() << " dets found by the layer and "
+						    << lookedUp.size() << " with the lookup for the state "
+						    << tsos.globalPosition() << " " << tsos.globalMomentum();
+    }
+    nQueries += states.size();
+    nSkipped += layerSkipped;
+    nDifferent += layerDifferent;
+    tSearch += layerSearch;
+    tLookup += layerLookup;
+    edm::LogInfo("CompatibleDetsLookupAnalyzer") << "layer " << layer->seqNum()
+						 << (layer->isBarrel() ? " barrel" : " forward")
+						 << ": " << layer->basicComponents().size() << " dets, "
+						 << layerSkipped << " of " << states.size() << " searches skipped, "
+						 << layerDifferent << " different; time per query: search "
+						 << 1.e9*layerSearch/states.size() << " ns, with the lookup "
+						 << 1.e9*layerLookup/states.size() << " ns";
+  }
+
+  edm::LogInfo("CompatibleDetsLookupAnalyzer") << states.size() << " states (" << nVertexStates << " from the vertices), "
+					       << nQueries << " queries, " << nDets << " compatible dets, "
+					       << nSkipped << " searches skipped, " << nDifferent << " different\n"
+					       << "time per query: search " << 1.e9*tSearch/nQueries
+					       << " ns, with the lookup " << 1.e9*tLookup/nQueries << " ns";
+  if (nDifferent > 0)
+    throw cms::Exception("CompatibleDetsLookupAnalyzer") << nDifferent << " queries give different dets with the lookup";
+}
+
+DEFINE_FWK_MODULE(CompatibleDetsLookupAnalyzer);
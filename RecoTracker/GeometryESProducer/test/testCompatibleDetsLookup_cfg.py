@@ -0,0 +1,32 @@
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process("CompatibleDetsLookupTest")
+
+process.maxEvents = cms.untracked.PSet(  input = cms.untracked.int32(1) )
+
+process.load('Configuration.StandardSequences.GeometryRecoDB_cff')
+process.load('Configuration.StandardSequences.MagneticField_cff')
+process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_cff')
+
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:run2_mc', '')
+
+process.load('FWCore.MessageLogger.MessageLogger_cfi')
+process.MessageLogger.categories.append('CompatibleDetsLookupAnalyzer')
+process.MessageLogger.cerr.INFO.limit = 0
+process.MessageLogger.cerr.CompatibleDetsLookupAnalyzer = cms.untracked.PSet( limit = cms.untracked.int32(-1) )
+
+process.source = cms.Source("EmptySource")
+
+process.CompatibleDetsLookupAnalyzer = cms.EDAnalyzer("CompatibleDetsLookupAnalyzer",
+                                                      pt = cms.vdouble(0.5, 1., 10.),
+                                                      vertexZ = cms.vdouble(-10., 0., 10.),
+                                                      nEta = cms.uint32(61),
+                                                      etaMax = cms.double(2.6),
+                                                      nPhi = cms.uint32(120),
+                                                      # one vertex state in layerStateStride is also propagated to each layer
+                                                      layerStateStride = cms.uint32(16),
+                                                      maxChi2 = cms.double(30.),
+                                                      nSigma = cms.double(3.)
+                                                      )
+process.p1 = cms.Path(process.CompatibleDetsLookupAnalyzer)
@@ -10,6 +10,9 @@ class TrackerTopology;
 
 /** GeometricSearchTrackerBuilder implementation
  *  
+ *  With compatibleDetsLookup, each layer is given a CompatibleDetsLookup
+ *  which skips its flat compatibleDets() search, and the grouped search
+ *  of LayerMeasurements::groupedMeasurements, when no det is in reach.
  */
 
 class GeometricSearchTrackerBuilder {
@@ -20,7 +23,8 @@ class GeometricSearchTrackerBuilder {
   
   GeometricSearchTracker* build(const GeometricDet* theGeometricTracker,
 				const TrackerGeometry* theGeomDetGeometry,
-				const TrackerTopology* tTopo) __attribute__ ((cold));
+				const TrackerTopology* tTopo,
+				bool compatibleDetsLookup = false) __attribute__ ((cold));
 };
 
 
@@ -10,6 +10,8 @@
 #include "TIDLayerBuilder.h"
 #include "TECLayerBuilder.h"
 
+#include "TrackingTools/DetLayers/interface/CompatibleDetsLookup.h"
+
 #include "Geometry/TrackerGeometryBuilder/interface/trackerHierarchy.h"
 
 #include "Geometry/CommonDetUnit/interface/GeomDet.h"
@@ -24,7 +26,8 @@ using namespace std;
 GeometricSearchTracker*
 GeometricSearchTrackerBuilder::build(const GeometricDet* theGeometricTracker,
 				     const TrackerGeometry* theGeomDetGeometry,
-				     const TrackerTopology* tTopo)
+				     const TrackerTopology* tTopo,
+				     bool compatibleDetsLookup)
 {
 
   PixelBarrelLayerBuilder aPixelBarrelLayerBuilder;
@@ -182,7 +185,15 @@ GeometricSearchTrackerBuilder::build(const GeometricDet* theGeometricTracker,
   }
 
 
-  return new GeometricSearchTracker(thePxlBarLayers,theTIBLayers,theTOBLayers,
-				    theNegPxlFwdLayers,theNegTIDLayers,theNegTECLayers,
-				    thePosPxlFwdLayers,thePosTIDLayers,thePosTECLayers, tTopo);
+  GeometricSearchTracker* tracker = new GeometricSearchTracker(thePxlBarLayers,theTIBLayers,theTOBLayers,
+							       theNegPxlFwdLayers,theNegTIDLayers,theNegTECLayers,
+							       thePosPxlFwdLayers,thePosTIDLayers,thePosTECLayers, tTopo);
+  if (compatibleDetsLookup) {
+    for (auto l : tracker->allLayers()) {
+      // same as for the sequential numbers set by GeometricSearchTracker
+      auto layer = const_cast<DetLayer*>(l);
+      layer->setCompatibleDetsLookup(std::make_unique<CompatibleDetsLookup>(*layer));
+    }
+  }
+  return tracker;
 }
@@ -42,6 +42,18 @@ public:
   HitDoublets doublets( const TrackingRegion& reg,
                         const edm::Event & ev,  const edm::EventSetup& es, const Layer& innerLayer, const Layer& outerLayer, LayerCacheType& layerCache);
   
+  /// Doublets of all the given layer pairs of one region, the pairs being
+  /// processed concurrently. result[i] holds the doublets of layerPairs[i],
+  /// identical to what the single-pair method gives whatever the scheduling.
+  /// The index vectors come from a per-pair arena owned by the generator,
+  /// which is refilled by recycle(); hence not reentrant.
+  void doublets( const TrackingRegion& reg,
+                 const edm::Event & ev, const edm::EventSetup& es, const std::vector<Layers>& layerPairs,
+                 LayerCacheType& layerCache, std::vector<HitDoublets>& result);
+  /// give the memory of consumed doublets back to the arena; doublets moved
+  /// out in the meantime return nothing, so copy those instead (compactCopy)
+  void recycle(std::vector<HitDoublets>& doublets);
+
   void hitPairs( const TrackingRegion& reg, OrderedHitPairs & prs,
                  const edm::Event & ev,  const edm::EventSetup& es, Layers layers);
   static void doublets(
@@ -60,10 +72,20 @@ public:
   Layer outerLayer(const Layers& layers) const { return layers[theOuterLayer]; }
 
 private:
+  static void fillDoublets(const TrackingRegion& region,
+			   const DetLayer & innerHitDetLayer,
+			   const DetLayer & outerHitDetLayer,
+			   const RecHitsSortedInPhi & innerHitsMap,
+			   const RecHitsSortedInPhi & outerHitsMap,
+			   const edm::EventSetup& iSetup,
+			   const unsigned int theMaxElement,
+			   HitDoublets & result);
+
   LayerCacheType *theLayerCache;
   const unsigned int theOuterLayer;
   const unsigned int theInnerLayer;
   const unsigned int theMaxElement;
+  std::vector<std::vector<HitDoublets::ADoublet> > theArena;
 };
 
 #endif
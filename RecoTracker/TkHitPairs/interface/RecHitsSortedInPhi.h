@@ -42,6 +42,10 @@ public:
   
   RecHitsSortedInPhi(const std::vector<Hit>& hits, GlobalPoint const & origin, DetLayer const * il);
 
+  // empty container whose coordinate arrays are filled by the caller,
+  // e.g. to replay stored doublets without the tracker geometry
+  explicit RecHitsSortedInPhi(bool barrel) : layer(nullptr), isBarrel(barrel) {}
+
   bool empty() const { return theHits.empty(); }
   std::size_t size() const { return theHits.size();}
 
@@ -139,6 +143,27 @@ public:
     layers{{&in,&out}}{}
   
   HitDoublets(HitDoublets && rh) : layers(std::move(rh.layers)), indeces(std::move(rh.indeces)){}
+
+  /// reuse the memory of an index vector given back by releaseStorage()
+  HitDoublets(  RecHitsSortedInPhi const & in,
+		RecHitsSortedInPhi const & out,
+		std::vector<ADoublet> && storage) :
+    layers{{&in,&out}}, indeces(std::move(storage)) { indeces.clear(); }
+
+  /// hand over the index memory for reuse, leaving this empty
+  std::vector<ADoublet> releaseStorage() {
+    std::vector<ADoublet> tmp;
+    tmp.swap(indeces);
+    tmp.clear();
+    return tmp;
+  }
+
+  /// copy whose index memory is exactly size(), leaving ours for reuse
+  HitDoublets compactCopy() const {
+    HitDoublets ret(*layers[inner],*layers[outer]);
+    ret.indeces.assign(indeces.begin(),indeces.end());
+    return ret;
+  }
   
   void reserve(std::size_t s) { indeces.reserve(s);}
   std::size_t size() const { return indeces.size();}
@@ -50,16 +50,44 @@ namespace {
 
     HitPairGeneratorFromLayerPair generator_;
     std::vector<unsigned> layerPairBegins_;
+
+    const bool parallelLayerPairs_;
+    const bool checkParallelLayerPairs_;
+    std::vector<HitDoublets> doublets_; // per layer pair of the current region
+
+    void checkDoublets(const TrackingRegion& region, const edm::Event& iEvent, const edm::EventSetup& iSetup,
+                       const std::vector<SeedingLayerSetsHits::SeedingLayerSet>& layerPairs, LayerHitMapCache& hitCache);
   };
   ImplBase::ImplBase(const edm::ParameterSet& iConfig):
     maxElement_(iConfig.getParameter<unsigned int>("maxElement")),
     generator_(0, 1, nullptr, maxElement_), // these indices are dummy, TODO: cleanup HitPairGeneratorFromLayerPair
-    layerPairBegins_(iConfig.getParameter<std::vector<unsigned> >("layerPairs"))
+    layerPairBegins_(iConfig.getParameter<std::vector<unsigned> >("layerPairs")),
+    parallelLayerPairs_(iConfig.getParameter<bool>("parallelLayerPairs")),
+    checkParallelLayerPairs_(iConfig.getParameter<bool>("checkParallelLayerPairs"))
   {
     if(layerPairBegins_.empty())
       throw cms::Exception("Configuration") << "HitPairEDProducer requires at least index for layer pairs (layerPairs parameter), none was given";
   }
 
+  // Compare the concurrently built doublets with the serial ones, pair by
+  // pair and doublet by doublet, so that any change in the output ordering
+  // is caught
+  void ImplBase::checkDoublets(const TrackingRegion& region, const edm::Event& iEvent, const edm::EventSetup& iSetup,
+                               const std::vector<SeedingLayerSetsHits::SeedingLayerSet>& layerPairs, LayerHitMapCache& hitCache) {
+    for(size_t i=0, size=layerPairs.size(); i<size; ++i) {
+      auto serial = generator_.doublets(region, iEvent, iSetup, layerPairs[i], hitCache);
+      const HitDoublets& parallel = doublets_[i];
+      bool same = serial.size() == parallel.size();
+      for(size_t j=0, n=serial.size(); same && j<n; ++j) {
+        same = serial.innerHitId(j) == parallel.innerHitId(j) && serial.outerHitId(j) == parallel.outerHitId(j);
+      }
+      if(!same) {
+        throw cms::Exception("LogicError") << "HitPairEDProducer: doublets built in parallel for layers " << layerPairs[i][0].index() << "," << layerPairs[i][1].index()
+                                           << " differ from the serial ones (" << parallel.size() << " vs. " << serial.size() << " doublets)";
+      }
+    }
+  }
+
   /////
   template <typename T_SeedingHitSets, typename T_IntermediateHitDoublets, typename T_RegionLayers>
   class Impl: public ImplBase {
@@ -97,6 +125,24 @@ namespace {
         auto hitCachePtr_filler_ihd = intermediateHitDoubletsProducer.beginRegion(&region, std::get<0>(hitCachePtr_filler_shs));
         auto hitCachePtr = std::get<0>(hitCachePtr_filler_ihd);
 
+        if(parallelLayerPairs_) {
+          const auto& layerPairs = regionLayers.layerPairs();
+          generator_.doublets(region, iEvent, iSetup, layerPairs, *hitCachePtr, doublets_);
+          if(checkParallelLayerPairs_)
+            checkDoublets(region, iEvent, iSetup, layerPairs, *hitCachePtr);
+          // filled in the order of the layer pairs, as in the serial case
+          for(size_t i=0, size=layerPairs.size(); i<size; ++i) {
+            auto& doublets = doublets_[i];
+            LogTrace("HitPairEDProducer") << " created " << doublets.size() << " doublets for layers " << layerPairs[i][0].index() << "," << layerPairs[i][1].index();
+            if(doublets.empty()) continue; // don't bother if no pairs from these layers
+            seedingHitSetsProducer.fill(std::get<1>(hitCachePtr_filler_shs), doublets);
+            // copied, so that the memory of doublets_ goes back to the generator
+            intermediateHitDoubletsProducer.fill(std::get<1>(hitCachePtr_filler_ihd), layerPairs[i], static_cast<const HitDoublets&>(doublets));
+          }
+          generator_.recycle(doublets_);
+          continue;
+        }
+
         for(SeedingLayerSetsHits::SeedingLayerSet layerSet: regionLayers.layerPairs()) {
           auto doublets = generator_.doublets(region, iEvent, iSetup, layerSet, *hitCachePtr);
           LogTrace("HitPairEDProducer") << " created " << doublets.size() << " doublets for layers " << layerSet[0].index() << "," << layerSet[1].index();
@@ -130,6 +176,7 @@ namespace {
 
     void fill(int, const HitDoublets&) {}
     void fill(int, const SeedingLayerSetsHits::SeedingLayerSet&, HitDoublets&&) {}
+    void fill(int, const SeedingLayerSetsHits::SeedingLayerSet&, const HitDoublets&) {}
 
     void put(edm::Event&) {}
     void putEmpty(edm::Event&) {}
@@ -204,6 +251,10 @@ namespace {
       filler.addDoublets(layerSet, std::move(doublets));
     }
 
+    void fill(IntermediateHitDoublets::RegionFiller& filler, const SeedingLayerSetsHits::SeedingLayerSet& layerSet, const HitDoublets& doublets) {
+      filler.addDoublets(layerSet, doublets.compactCopy());
+    }
+
     void put(edm::Event& iEvent) {
       intermediateHitDoublets_->shrink_to_fit();
       putEmpty(iEvent);
@@ -460,6 +511,8 @@ void HitPairEDProducer::fillDescriptions(edm::ConfigurationDescriptions& descrip
   desc.add<bool>("produceIntermediateHitDoublets", false);
   desc.add<unsigned int>("maxElement", 1000000);
   desc.add<std::vector<unsigned> >("layerPairs", std::vector<unsigned>{0})->setComment("Indices to the pairs of consecutive layers, i.e. 0 means (0,1), 1 (1,2) etc.");
+  desc.add<bool>("parallelLayerPairs", false)->setComment("Build the doublets of the layer pairs of a region concurrently (TBB tasks); output is identical to the serial one");
+  desc.add<bool>("checkParallelLayerPairs", false)->setComment("With parallelLayerPairs, rebuild the doublets serially and throw if they differ in any way (for validation only)");
 
   descriptions.add("hitPairEDProducerDefault", desc);
 }
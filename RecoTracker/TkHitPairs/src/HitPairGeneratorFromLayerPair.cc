@@ -13,6 +13,9 @@
 
 #include "FWCore/Framework/interface/Event.h"
 
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
 using namespace GeomDetEnumerators;
 using namespace std;
 
@@ -105,6 +108,63 @@ HitDoublets HitPairGeneratorFromLayerPair::doublets( const TrackingRegion& regio
 }
 
 void HitPairGeneratorFromLayerPair::doublets(const TrackingRegion& region,
+                                             const edm::Event & iEvent, const edm::EventSetup& iSetup,
+                                             const std::vector<Layers>& layerPairs,
+                                             LayerCacheType& layerCache, std::vector<HitDoublets>& result) {
+
+  const unsigned int nPairs = layerPairs.size();
+  result.clear();
+  result.reserve(nPairs);
+  if(theArena.size() < nPairs) theArena.resize(nPairs);
+
+  // the layer cache is not thread safe, fill it (in the same way as the
+  // single-pair method) before going parallel
+  for(unsigned int i=0; i!=nPairs; ++i) {
+    const RecHitsSortedInPhi & innerHitsMap = layerCache(innerLayer(layerPairs[i]), region, iSetup);
+    if (innerHitsMap.empty()) {
+      result.emplace_back(innerHitsMap,innerHitsMap,std::move(theArena[i]));
+      continue;
+    }
+    const RecHitsSortedInPhi& outerHitsMap = layerCache(outerLayer(layerPairs[i]), region, iSetup);
+    result.emplace_back(innerHitsMap,outerHitsMap,std::move(theArena[i]));
+  }
+
+  // isolated so that the waiting thread cannot pick up an unrelated task
+  // of the framework (e.g. another module on the same stream)
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(0U, nPairs, [&](unsigned int i) {
+        HitDoublets & res = result[i];
+        const RecHitsSortedInPhi & innerHitsMap = res.innerLayer();
+        const RecHitsSortedInPhi & outerHitsMap = res.outerLayer();
+        if (innerHitsMap.empty() || outerHitsMap.empty()) return;
+        res.reserve(std::max(innerHitsMap.size(),outerHitsMap.size()));
+        fillDoublets(region,
+		     *innerLayer(layerPairs[i]).detLayer(),*outerLayer(layerPairs[i]).detLayer(),
+		     innerHitsMap,outerHitsMap,iSetup,theMaxElement,res);
+      });
+  });
+}
+
+void HitPairGeneratorFromLayerPair::recycle(std::vector<HitDoublets>& doublets) {
+  if(theArena.size() < doublets.size()) theArena.resize(doublets.size());
+  for(std::size_t i=0; i!=doublets.size(); ++i)
+    theArena[i] = doublets[i].releaseStorage();
+  doublets.clear();
+}
+
+void HitPairGeneratorFromLayerPair::doublets(const TrackingRegion& region,
+						    const DetLayer & innerHitDetLayer,
+						    const DetLayer & outerHitDetLayer,
+						    const RecHitsSortedInPhi & innerHitsMap,
+						    const RecHitsSortedInPhi & outerHitsMap,
+						    const edm::EventSetup& iSetup,
+						    const unsigned int theMaxElement,
+						    HitDoublets & result){
+  fillDoublets(region,innerHitDetLayer,outerHitDetLayer,innerHitsMap,outerHitsMap,iSetup,theMaxElement,result);
+  result.shrink_to_fit();
+}
+
+void HitPairGeneratorFromLayerPair::fillDoublets(const TrackingRegion& region,
 						    const DetLayer & innerHitDetLayer,
 						    const DetLayer & outerHitDetLayer,
 						    const RecHitsSortedInPhi & innerHitsMap,
@@ -176,7 +236,6 @@ void HitPairGeneratorFromLayerPair::doublets(const TrackingRegion& region,
     delete checkRZ;
   }
   LogDebug("HitPairGeneratorFromLayerPair")<<" total number of pairs provided back: "<<result.size();
-  result.shrink_to_fit();
 
 }
 
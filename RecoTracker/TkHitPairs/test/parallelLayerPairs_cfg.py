@@ -0,0 +1,56 @@
+# Tracking reconstruction of RAW events with the doublets of all the
+# HitPairEDProducers built concurrently over the layer pairs of a region
+# (parallelLayerPairs) and checked against the serially built ones
+# (checkParallelLayerPairs), which throws on the first doublet that differs
+# in content or order. Run with several threads so that the layer pairs
+# really are processed concurrently.
+#
+# cmsRun parallelLayerPairs_cfg.py inputFiles=file:raw.root threads=4
+
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+from Configuration.StandardSequences.Eras import eras
+
+options = VarParsing.VarParsing('analysis')
+options.register('threads', 4, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "number of threads and streams")
+options.register('check', 1, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "0 to time the parallel doublets without the check")
+options.parseArguments()
+
+process = cms.Process('RECO', eras.Run2_2017)
+
+process.load('Configuration.StandardSequences.Services_cff')
+process.load('FWCore.MessageService.MessageLogger_cfi')
+process.load('Configuration.StandardSequences.GeometryRecoDB_cff')
+process.load('Configuration.StandardSequences.MagneticField_cff')
+process.load('Configuration.StandardSequences.RawToDigi_cff')
+process.load('Configuration.StandardSequences.Reconstruction_cff')
+process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_cff')
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:phase1_2017_realistic', '')
+
+process.source = cms.Source('PoolSource', fileNames = cms.untracked.vstring(options.inputFiles))
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.threads),
+    numberOfStreams = cms.untracked.uint32(options.threads),
+)
+
+# all the doublet producers of the iterations, both those giving the
+# doublets to the triplet/quadruplet producers and those giving hit pairs
+nProducers = 0
+for name, producer in process.producers_().items():
+    if producer.type_() == 'HitPairEDProducer':
+        producer.parallelLayerPairs = cms.bool(True)
+        producer.checkParallelLayerPairs = cms.bool(bool(options.check))
+        nProducers += 1
+if nProducers == 0:
+    raise RuntimeError('no HitPairEDProducer found in the configuration')
+
+process.Timing = cms.Service('Timing', summaryOnly = cms.untracked.bool(True))
+process.MessageLogger.cerr.FwkReport.reportEvery = 10
+
+process.raw2digi_step = cms.Path(process.RawToDigi)
+process.reconstruction_step = cms.Path(process.reconstruction_trackingOnly)
+process.schedule = cms.Schedule(process.raw2digi_step, process.reconstruction_step)
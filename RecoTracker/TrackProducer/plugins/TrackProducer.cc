@@ -26,6 +26,9 @@ TrackProducer::TrackProducer(const edm::ParameterSet& iConfig):
           consumes<MeasurementTrackerEvent>(iConfig.getParameter<edm::InputTag>( "MeasurementTrackerEvent") ));
   setAlias( iConfig.getParameter<std::string>( "@module_label" ) );
 
+  if ( iConfig.existsAs<bool>("stateArena") && iConfig.getParameter<bool>("stateArena") )
+    theArena = std::make_unique<TrackingArena>();
+
   if ( iConfig.exists("clusterRemovalInfo") ) {
         edm::InputTag tag = iConfig.getParameter<edm::InputTag>("clusterRemovalInfo");
         if (!(tag == edm::InputTag())) { setClusterRemovalInfo( tag ); }
@@ -82,6 +85,8 @@ void TrackProducer::produce(edm::Event& theEvent, const edm::EventSetup& setup)
   else{
     LogDebug("TrackProducer") << "run the algorithm" << "\n";
     try{  
+      // the fits take their states from the arena, if any
+      TrackingArena::Scope arenaScope(theArena.get());
       theAlgo.runWithCandidate(theG.product(), theMF.product(), *theTCCollection, 
 			       theFitter.product(), thePropagator.product(), theBuilder.product(), bs, algoResults);
     } catch (cms::Exception &e){ edm::LogError("TrackProducer") << "cms::Exception caught during theAlgo.runWithCandidate." << "\n" << e << "\n"; throw;}
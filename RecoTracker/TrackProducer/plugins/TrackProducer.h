@@ -12,6 +12,9 @@
 #include "RecoTracker/TrackProducer/interface/TrackProducerAlgorithm.h"
 
 #include "TrackingTools/TransientTrack/interface/TransientTrack.h"
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
+
+#include <memory>
 
 class TrackProducer : public KfTrackProducerBase, public edm::stream::EDProducer<> {
 public:
@@ -35,6 +38,8 @@ public:
 
 private:
   TrackProducerAlgorithm<reco::Track> theAlgo;
+  // arena of the trajectory states of the fits, if any
+  std::unique_ptr<TrackingArena> theArena;
 
 };
 
@@ -10,6 +10,8 @@ TrackProducer = cms.EDProducer("TrackProducer",
     useHitsSplitting = cms.bool(False),
     alias = cms.untracked.string('ctfWithMaterialTracks'),
     TrajectoryInEvent = cms.bool(False),
+    # take the trajectory states of the fits from an arena of the module
+    stateArena = cms.bool(False),
     TTRHBuilder = cms.string('WithAngleAndTemplate'),
     AlgorithmName = cms.string('undefAlgorithm'),
     Propagator = cms.string('RungeKuttaTrackerPropagator'),
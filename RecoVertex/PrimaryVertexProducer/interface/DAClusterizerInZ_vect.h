@@ -175,6 +175,19 @@ public:
   std::vector<TransientVertex>
   vertices(const std::vector<reco::TransientTrack> & tracks,
 	   const int verbosity = 0) const ;
+
+  // anneal the prototypes y with the tracks tks down to the stopping
+  // temperature, or with stopAtPurge down to the purging temperature
+  // before the purge, beta and rho0 being those reached
+  void anneal(track_t & tks, vertex_t & y, double & beta, double & rho0, bool stopAtPurge = false) const;
+
+  // the tracks assigned to the annealed prototypes
+  std::vector<TransientVertex>
+  assign(track_t & tks, vertex_t & y, const double beta, const double rho0) const;
+
+  // annealing in blocks of tracks in z, concurrently
+  std::vector<TransientVertex>
+  vertices_in_blocks(track_t & tks) const;
   
   track_t	fill(const std::vector<reco::TransientTrack> & tracks) const;
   
@@ -211,6 +224,10 @@ private:
   double zmerge_;
   double betapurge_;
 
+  bool runInBlocks_;
+  unsigned int blockSize_;
+  double overlapFraction_;
+
 };
 
 
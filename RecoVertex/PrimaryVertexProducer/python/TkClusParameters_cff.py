@@ -11,7 +11,10 @@ DA_vectParameters = cms.PSet(
         d0CutOff = cms.double(3.),        # downweight high IP tracks 
         dzCutOff = cms.double(3.),        # outlier rejection after freeze-out (T<Tmin)       
         zmerge = cms.double(1e-2),        # merge intermediat clusters separated by less than zmerge
-        uniquetrkweight = cms.double(0.8) # require at least two tracks with this weight at T=Tpurge
+        uniquetrkweight = cms.double(0.8), # require at least two tracks with this weight at T=Tpurge
+        runInBlocks = cms.bool(False),    # anneal concurrently in blocks of tracks in z
+        blockSize = cms.uint32(512),      # tracks per block
+        overlapFraction = cms.double(0.5) # overlap of the consecutive blocks
         )
 )
 
@@ -29,6 +32,9 @@ DA2D_vectParameters = cms.PSet(
         dtCutOff = cms.double(4.),        # outlier rejection after freeze-out (T<Tmin)
         zmerge = cms.double(1e-2),        # merge intermediat clusters separated by less than zmerge and tmerge
         tmerge = cms.double(1e-1),        # merge intermediat clusters separated by less than zmerge and tmerge
-        uniquetrkweight = cms.double(0.8) # require at least two tracks with this weight at T=Tpurge
+        uniquetrkweight = cms.double(0.8), # require at least two tracks with this weight at T=Tpurge
+        runInBlocks = cms.bool(False),    # anneal concurrently in blocks of tracks in z
+        blockSize = cms.uint32(512),      # tracks per block
+        overlapFraction = cms.double(0.5) # overlap of the consecutive blocks
         )
 )
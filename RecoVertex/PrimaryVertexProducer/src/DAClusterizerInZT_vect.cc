@@ -3,12 +3,15 @@
 #include "DataFormats/GeometryCommonDetAlgo/interface/Measurement1D.h"
 #include "RecoVertex/VertexPrimitives/interface/VertexException.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 #include <limits>
 #include <iomanip>
 #include "FWCore/Utilities/interface/isFinite.h"
 #include "vdt/vdtMath.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 
 using namespace std;
 //#define VI_DEBUG
@@ -44,6 +47,11 @@ DAClusterizerInZT_vect::DAClusterizerInZT_vect(const edm::ParameterSet& conf) {
   zmerge_ = conf.getParameter<double>("zmerge");
   tmerge_ = conf.getParameter<double>("tmerge");
 
+  // optional annealing in blocks of tracks in z
+  runInBlocks_ = conf.existsAs<bool>("runInBlocks") ? conf.getParameter<bool>("runInBlocks") : false;
+  blockSize_ = conf.existsAs<unsigned int>("blockSize") ? conf.getParameter<unsigned int>("blockSize") : 512;
+  overlapFraction_ = conf.existsAs<double>("overlapFraction") ? conf.getParameter<double>("overlapFraction") : 0.5;
+
 #ifdef VI_DEBUG
   if(verbose_){
     std::cout << "DAClusterizerinZT_vect: mintrkweight = " << mintrkweight_ << std::endl;
@@ -59,6 +67,9 @@ DAClusterizerInZT_vect::DAClusterizerInZT_vect(const edm::ParameterSet& conf) {
     std::cout << "DAClusterizerinZT_vect: d0CutOff = " << d0CutOff_ << std::endl;
     std::cout << "DAClusterizerinZT_vect: dzCutOff = " << dzCutOff_ << std::endl;
     std::cout << "DAClusterizerinZT_vect: dtCutoff = " << dtCutOff_ << std::endl;
+    std::cout << "DAClusterizerinZT_vect: runInBlocks = " << runInBlocks_ << std::endl;
+    std::cout << "DAClusterizerinZT_vect: blockSize = " << blockSize_ << std::endl;
+    std::cout << "DAClusterizerinZT_vect: overlapFraction = " << overlapFraction_ << std::endl;
   }
 #endif
 
@@ -85,6 +96,14 @@ DAClusterizerInZT_vect::DAClusterizerInZT_vect(const edm::ParameterSet& conf) {
     stopT = max(1., purgeT) ;
   }
   betastop_ = 1./stopT;
+
+  if ((blockSize_ == 0) || (overlapFraction_ < 0) || (overlapFraction_ >= 1)) {
+    edm::LogWarning("DAClusterizerinZT_vectorized") << "DAClusterizerInZT: invalid blockSize " << blockSize_
+						    << " or overlapFraction " << overlapFraction_
+						    << "  set to 512 and 0.5";
+    blockSize_ = 512;
+    overlapFraction_ = 0.5;
+  }
   
 }
 
@@ -816,13 +835,23 @@ DAClusterizerInZT_vect::vertices(const vector<reco::TransientTrack> & tracks, co
   track_t && tks = fill(tracks);
   tks.extractRaw();
   
-  unsigned int nt = tks.getSize();
-  double rho0 = 0.0; // start with no outlier rejection
-  
   vector<TransientVertex> clusters;
   if (tks.getSize() == 0) return clusters;
+
+  if (runInBlocks_ && tks.getSize() > blockSize_) return vertices_in_blocks(tks);
   
   vertex_t y; // the vertex prototypes
+  double beta, rho0;
+  anneal(tks, y, beta, rho0);
+  return assign(tks, y, beta, rho0);
+}
+
+
+void
+DAClusterizerInZT_vect::anneal(track_t & tks, vertex_t & y, double & beta, double & rho0, bool stopAtPurge) const {
+  
+  unsigned int nt = tks.getSize();
+  rho0 = 0.0; // start with no outlier rejection
   
   // initialize:single vertex at infinite temperature
   y.addItem( 0, 0, 1.0);
@@ -831,7 +860,7 @@ DAClusterizerInZT_vect::vertices(const vector<reco::TransientTrack> & tracks, co
   
   
   // estimate first critical temperature
-  double beta = beta0(betamax_, tks, y);
+  beta = beta0(betamax_, tks, y);
 #ifdef VI_DEBUG
   if ( verbose_) std::cout << "Beta0 is " << beta << std::endl;
 #endif
@@ -942,6 +971,8 @@ DAClusterizerInZT_vect::vertices(const vector<reco::TransientTrack> & tracks, co
   }
 
 
+  if (stopAtPurge) return;
+
   // eliminate insigificant vertices, this is more restrictive at higher T
   while (purge(y, tks, rho0, beta)) {
     niter = 0;
@@ -972,8 +1003,15 @@ DAClusterizerInZT_vect::vertices(const vector<reco::TransientTrack> & tracks, co
     dump(beta, y, tks, 2);
   }
 #endif
+}
 
 
+vector<TransientVertex>
+DAClusterizerInZT_vect::assign(track_t & tks, vertex_t & y, const double beta, const double rho0) const {
+
+  const unsigned int nt = tks.getSize();
+  vector<TransientVertex> clusters;
+
   // new, merge here and not in "clusterize"
   // final merging step
   double betadummy = 1;
@@ -1020,6 +1058,101 @@ DAClusterizerInZT_vect::vertices(const vector<reco::TransientTrack> & tracks, co
 
 }
 
+
+vector<TransientVertex>
+DAClusterizerInZT_vect::vertices_in_blocks(track_t & tks) const {
+  // the tracks ordered in z are cut in blocks of blockSize_ tracks,
+  // overlapping by overlapFraction_ of their size, the last block taking
+  // the remaining tracks; the blocks are annealed concurrently, each
+  // keeps its prototypes up to the middle of its overlaps with the next
+  // blocks. The blocks are annealed down to the purging temperature, then
+  // all the prototypes are brought to equilibrium with all the tracks, so
+  // that those split by the boundaries merge, purged and cooled down to
+  // the stopping temperature, as by anneal
+  const unsigned int nt = tks.getSize();
+
+  vector<unsigned int> iz(nt);
+  for (unsigned int i = 0; i < nt; i++) iz[i] = i;
+  std::sort(iz.begin(), iz.end(), [&tks](unsigned int a, unsigned int b){ return tks.z_[a] < tks.z_[b];});
+
+  const unsigned int step = std::max(1U, (unsigned int)(blockSize_ * (1. - overlapFraction_)));
+  unsigned int nb = 1;
+  while ((nb - 1) * step + blockSize_ < nt) nb++;
+  auto first = [step](unsigned int b) { return b * step; };
+  auto last = [this, step, nb, nt](unsigned int b) { return b + 1 < nb ? b * step + blockSize_ : nt; };
+
+  vector<track_t> btks(nb);
+  vector<vertex_t> by(nb);
+  vector<double> bbeta(nb), brho0(nb);
+  // isolated, so that the thread waiting for the blocks takes no
+  // unrelated task (e.g. another module) half way through them
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(0U, nb, [&](unsigned int b) {
+        for (unsigned int i = first(b); i < last(b); i++) {
+	  unsigned int j = iz[i];
+	  btks[b].addItem(tks.z_[j], tks.t_[j], tks.dz2_[j], tks.dt2_[j], tks.tt[j], tks.pi_[j]);
+        }
+        btks[b].extractRaw();
+        anneal(btks[b], by[b], bbeta[b], brho0[b], true);
+      });
+    });
+
+  vertex_t y;
+  double beta = 0;
+  double sumpk = 0;
+  for (unsigned int b = 0; b < nb; b++) {
+    double zmin = b == 0 ? -std::numeric_limits<double>::max()
+      : 0.5 * (tks.z_[iz[first(b)]] + tks.z_[iz[last(b - 1) - 1]]);
+    double zmax = b + 1 == nb ? std::numeric_limits<double>::max()
+      : 0.5 * (tks.z_[iz[first(b + 1)]] + tks.z_[iz[last(b) - 1]]);
+    for (unsigned int k = 0; k < by[b].getSize(); k++) {
+      if ((by[b].z_[k] < zmin) || (by[b].z_[k] >= zmax)) continue;
+      double pk = by[b].pk_[k] * (last(b) - first(b));
+      y.addItem(by[b].z_[k], by[b].t_[k], pk);
+      sumpk += pk;
+    }
+    beta = std::max(beta, bbeta[b]);
+  }
+
+  vector<TransientVertex> clusters;
+  if (y.getSize() == 0) return clusters;
+  for (unsigned int k = 0; k < y.getSize(); k++) y.pk_[k] /= sumpk;
+
+#ifdef VI_DEBUG
+  if (verbose_) {
+    std::cout << "DAClusterizerInZT_vect: " << y.getSize() << " prototypes from " << nb << " blocks" << std::endl;
+  }
+#endif
+
+  double rho0 = dzCutOff_ > 0 ? 1./nt : 0.;
+  int niter = 0;
+  while ((update(beta, tks, y, true, rho0) > 1.e-8) && (niter++ < maxIterations_)) {}
+  zorder(y);
+  while (merge(y, beta)) { update(beta, tks, y, true, rho0); }
+  while (purge(y, tks, rho0, beta)) {
+    niter = 0;
+    while ((update(beta, tks, y, true, rho0) > 1.e-6) && (niter++ < maxIterations_)) {
+      zorder(y);
+    }
+  }
+
+  while( beta < betastop_ ){
+    beta = min( beta/coolingFactor_, betastop_);
+    niter =0;
+    while ((update(beta, tks, y, true, rho0) > 1.e-8) && (niter++ < maxIterations_)) {}
+    zorder(y);
+  }
+
+#ifdef VI_DEBUG
+  if (verbose_) {
+    std::cout  << "Final result of the blocks, rho0=" << std::scientific << rho0 << endl;
+    dump(beta, y, tks, 2);
+  }
+#endif
+
+  return assign(tks, y, beta, rho0);
+}
+
 vector<vector<reco::TransientTrack> > DAClusterizerInZT_vect::clusterize(
 		const vector<reco::TransientTrack> & tracks) const {
   
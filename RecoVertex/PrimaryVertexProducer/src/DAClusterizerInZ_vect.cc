@@ -3,12 +3,15 @@
 #include "DataFormats/GeometryCommonDetAlgo/interface/Measurement1D.h"
 #include "RecoVertex/VertexPrimitives/interface/VertexException.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 #include <limits>
 #include <iomanip>
 #include "FWCore/Utilities/interface/isFinite.h"
 #include "vdt/vdtMath.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 
 using namespace std;
 
@@ -40,6 +43,11 @@ DAClusterizerInZ_vect::DAClusterizerInZ_vect(const edm::ParameterSet& conf) {
   uniquetrkweight_ = conf.getParameter<double>("uniquetrkweight");
   zmerge_ = conf.getParameter<double>("zmerge");
 
+  // optional annealing in blocks of tracks in z
+  runInBlocks_ = conf.existsAs<bool>("runInBlocks") ? conf.getParameter<bool>("runInBlocks") : false;
+  blockSize_ = conf.existsAs<unsigned int>("blockSize") ? conf.getParameter<unsigned int>("blockSize") : 512;
+  overlapFraction_ = conf.existsAs<double>("overlapFraction") ? conf.getParameter<double>("overlapFraction") : 0.5;
+
   if(verbose_){
     std::cout << "DAClusterizerinZ_vect: mintrkweight = " << mintrkweight_ << std::endl;
     std::cout << "DAClusterizerinZ_vect: uniquetrkweight = " << uniquetrkweight_ << std::endl;
@@ -51,6 +59,9 @@ DAClusterizerInZ_vect::DAClusterizerInZ_vect(const edm::ParameterSet& conf) {
     std::cout << "DAClusterizerinZ_vect: coolingFactor = " << coolingFactor_ << std::endl;
     std::cout << "DAClusterizerinZ_vect: d0CutOff = " << d0CutOff_ << std::endl;
     std::cout << "DAClusterizerinZ_vect: dzCutOff = " << dzCutOff_ << std::endl;
+    std::cout << "DAClusterizerinZ_vect: runInBlocks = " << runInBlocks_ << std::endl;
+    std::cout << "DAClusterizerinZ_vect: blockSize = " << blockSize_ << std::endl;
+    std::cout << "DAClusterizerinZ_vect: overlapFraction = " << overlapFraction_ << std::endl;
   }
 
 
@@ -76,6 +87,14 @@ DAClusterizerInZ_vect::DAClusterizerInZ_vect(const edm::ParameterSet& conf) {
     Tstop = max(1., Tpurge) ;
   }
   betastop_ = 1./Tstop;
+
+  if ((blockSize_ == 0) || (overlapFraction_ < 0) || (overlapFraction_ >= 1)) {
+    edm::LogWarning("DAClusterizerinZ_vectorized") << "DAClusterizerInZ: invalid blockSize " << blockSize_
+						   << " or overlapFraction " << overlapFraction_
+						   << "  set to 512 and 0.5";
+    blockSize_ = 512;
+    overlapFraction_ = 0.5;
+  }
   
 }
 
@@ -573,13 +592,23 @@ DAClusterizerInZ_vect::vertices(const vector<reco::TransientTrack> & tracks, con
   track_t && tks = fill(tracks);
   tks.ExtractRaw();
   
-  unsigned int nt = tks.GetSize();
-  double rho0 = 0.0; // start with no outlier rejection
-  
   vector<TransientVertex> clusters;
   if (tks.GetSize() == 0) return clusters;
+
+  if (runInBlocks_ && tks.GetSize() > blockSize_) return vertices_in_blocks(tks);
   
   vertex_t y; // the vertex prototypes
+  double beta, rho0;
+  anneal(tks, y, beta, rho0);
+  return assign(tks, y, beta, rho0);
+}
+
+
+void
+DAClusterizerInZ_vect::anneal(track_t & tks, vertex_t & y, double & beta, double & rho0, bool stopAtPurge) const {
+  
+  unsigned int nt = tks.GetSize();
+  rho0 = 0.0; // start with no outlier rejection
   
   // initialize:single vertex at infinite temperature
   y.AddItem( 0, 1.0);
@@ -588,7 +617,7 @@ DAClusterizerInZ_vect::vertices(const vector<reco::TransientTrack> & tracks, con
   
   
   // estimate first critical temperature
-  double beta = beta0(betamax_, tks, y);
+  beta = beta0(betamax_, tks, y);
   if ( verbose_) std::cout << "Beta0 is " << beta << std::endl;
   
   niter = 0;
@@ -677,6 +706,8 @@ DAClusterizerInZ_vect::vertices(const vector<reco::TransientTrack> & tracks, con
   }
 
 
+  if (stopAtPurge) return;
+
   // eliminate insigificant vertices, this is more restrictive at higher T
   while (purge(y, tks, rho0, beta)) {
     niter = 0;
@@ -701,6 +732,14 @@ DAClusterizerInZ_vect::vertices(const vector<reco::TransientTrack> & tracks, con
     std::cout  << "Final result, rho0=" << std::scientific << rho0 << endl;
     dump(beta, y, tks, 2);
   }
+}
+
+
+vector<TransientVertex>
+DAClusterizerInZ_vect::assign(track_t & tks, vertex_t & y, const double beta, const double rho0) const {
+
+  const unsigned int nt = tks.GetSize();
+  vector<TransientVertex> clusters;
 
   // select significant tracks and use a TransientVertex as a container
   GlobalError dummyError(0.01, 0, 0.01, 0., 0., 0.01);
@@ -743,6 +782,93 @@ DAClusterizerInZ_vect::vertices(const vector<reco::TransientTrack> & tracks, con
 
 }
 
+
+vector<TransientVertex>
+DAClusterizerInZ_vect::vertices_in_blocks(track_t & tks) const {
+  // the tracks ordered in z are cut in blocks of blockSize_ tracks,
+  // overlapping by overlapFraction_ of their size, the last block taking
+  // the remaining tracks; the blocks are annealed concurrently, each
+  // keeps its prototypes up to the middle of its overlaps with the next
+  // blocks. The blocks are annealed down to the purging temperature, then
+  // all the prototypes are brought to equilibrium with all the tracks, so
+  // that those split by the boundaries merge, purged and cooled down to
+  // the stopping temperature, as by anneal
+  const unsigned int nt = tks.GetSize();
+
+  vector<unsigned int> iz(nt);
+  for (unsigned int i = 0; i < nt; i++) iz[i] = i;
+  std::sort(iz.begin(), iz.end(), [&tks](unsigned int a, unsigned int b){ return tks._z[a] < tks._z[b];});
+
+  const unsigned int step = std::max(1U, (unsigned int)(blockSize_ * (1. - overlapFraction_)));
+  unsigned int nb = 1;
+  while ((nb - 1) * step + blockSize_ < nt) nb++;
+  auto first = [step](unsigned int b) { return b * step; };
+  auto last = [this, step, nb, nt](unsigned int b) { return b + 1 < nb ? b * step + blockSize_ : nt; };
+
+  vector<track_t> btks(nb);
+  vector<vertex_t> by(nb);
+  vector<double> bbeta(nb), brho0(nb);
+  // isolated, so that the thread waiting for the blocks takes no
+  // unrelated task (e.g. another module) half way through them
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(0U, nb, [&](unsigned int b) {
+        for (unsigned int i = first(b); i < last(b); i++) {
+	  unsigned int j = iz[i];
+	  btks[b].AddItem(tks._z[j], tks._dz2[j], tks.tt[j], tks._pi[j]);
+        }
+        btks[b].ExtractRaw();
+        anneal(btks[b], by[b], bbeta[b], brho0[b], true);
+      });
+    });
+
+  vertex_t y;
+  double beta = 0;
+  double sumpk = 0;
+  for (unsigned int b = 0; b < nb; b++) {
+    double zmin = b == 0 ? -std::numeric_limits<double>::max()
+      : 0.5 * (tks._z[iz[first(b)]] + tks._z[iz[last(b - 1) - 1]]);
+    double zmax = b + 1 == nb ? std::numeric_limits<double>::max()
+      : 0.5 * (tks._z[iz[first(b + 1)]] + tks._z[iz[last(b) - 1]]);
+    for (unsigned int k = 0; k < by[b].GetSize(); k++) {
+      if ((by[b]._z[k] < zmin) || (by[b]._z[k] >= zmax)) continue;
+      double pk = by[b]._pk[k] * (last(b) - first(b));
+      y.AddItem(by[b]._z[k], pk);
+      sumpk += pk;
+    }
+    beta = std::max(beta, bbeta[b]);
+  }
+
+  vector<TransientVertex> clusters;
+  if (y.GetSize() == 0) return clusters;
+  for (unsigned int k = 0; k < y.GetSize(); k++) y._pk[k] /= sumpk;
+
+  if (verbose_) {
+    std::cout << "DAClusterizerInZ_vect: " << y.GetSize() << " prototypes from " << nb << " blocks" << std::endl;
+  }
+
+  double rho0 = dzCutOff_ > 0 ? 1./nt : 0.;
+  int niter = 0;
+  while ((update(beta, tks, y, true, rho0) > 1.e-8) && (niter++ < maxIterations_)) {}
+  while (merge(y, beta)) { update(beta, tks, y, true, rho0); }
+  while (purge(y, tks, rho0, beta)) {
+    niter = 0;
+    while ((update(beta, tks, y, true, rho0) > 1.e-6) && (niter++ < maxIterations_)) {}
+  }
+
+  while( beta < betastop_ ){
+    beta = min( beta/coolingFactor_, betastop_);
+    niter =0;
+    while ((update(beta, tks, y, true, rho0) > 1.e-8) && (niter++ < maxIterations_)) {}
+  }
+
+  if (verbose_) {
+    std::cout  << "Final result of the blocks, rho0=" << std::scientific << rho0 << endl;
+    dump(beta, y, tks, 2);
+  }
+
+  return assign(tks, y, beta, rho0);
+}
+
 vector<vector<reco::TransientTrack> > DAClusterizerInZ_vect::clusterize(
 		const vector<reco::TransientTrack> & tracks) const {
   
@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Time per event of the primary vertex clustering of the whole event and
+# in concurrent blocks of tracks, for RECO files of increasing pileup, and
+# the speedup of the blocks.
+#
+# blockClusteringScan.sh [events] [threads] file:reco_pu50.root file:reco_pu140.root ...
+
+events=${1:-50}
+threads=${2:-1}
+shift 2
+
+config=${CMSSW_BASE}/src/RecoVertex/PrimaryVertexProducer/test/blockClustering_cfg.py
+[ -f $config ] || config=${CMSSW_RELEASE_BASE}/src/RecoVertex/PrimaryVertexProducer/test/blockClustering_cfg.py
+
+moduleTime() {
+  awk -v label=$2 '/Module Summary/ { m = 1 } m && $1 == "TimeReport" && $NF == label { print $2; exit }' $1
+}
+
+printf "%-40s %14s %14s %10s\n" input "event s/event" "blocks s/event" speedup
+for input in "$@"; do
+  log=blockClustering_$(basename $input .root).log
+  cmsRun $config inputFiles=$input maxEvents=$events threads=$threads > $log 2>&1 \
+    || { echo "blockClusteringScan: cmsRun failed, see $log"; exit 1; }
+  t=$(moduleTime $log offlinePrimaryVertices)
+  b=$(moduleTime $log offlinePrimaryVerticesInBlocks)
+  printf "%-40s %14.4f %14.4f %10.2f\n" $(basename $input) $t $b $(echo "$t / $b" | bc -l)
+done
@@ -0,0 +1,65 @@
+# Primary vertices of RECO events clustered by the DA of the whole event
+# (offlinePrimaryVertices) and by the DA in concurrent blocks of tracks in
+# z (offlinePrimaryVerticesInBlocks), from the same generalTracks, both
+# timed by the module summary of the framework. With validation=1 the two
+# collections are compared to the simulated vertices, efficiency and fake
+# rate, by PrimaryVertexAnalyzer4PUSlimmed, which needs the tracking truth
+# in the input (RECODEBUG or FEVTDEBUG).
+#
+# cmsRun blockClustering_cfg.py inputFiles=file:reco.root threads=4 blockSize=512 validation=1
+
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+from Configuration.StandardSequences.Eras import eras
+
+options = VarParsing.VarParsing('analysis')
+options.register('threads', 1, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "number of threads")
+options.register('blockSize', 512, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "tracks per block")
+options.register('overlapFraction', 0.5, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.float, "overlap of the consecutive blocks")
+options.register('validation', 0, VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int, "1 to compare the vertices to the simulated ones")
+options.parseArguments()
+
+process = cms.Process('PV', eras.Run2_2017)
+
+process.load('Configuration.StandardSequences.Services_cff')
+process.load('FWCore.MessageService.MessageLogger_cfi')
+process.load('Configuration.StandardSequences.GeometryRecoDB_cff')
+process.load('Configuration.StandardSequences.MagneticField_cff')
+process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_cff')
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:phase1_2017_realistic', '')
+process.load('TrackingTools.TransientTrack.TransientTrackBuilder_cfi')
+
+process.source = cms.Source('PoolSource', fileNames = cms.untracked.vstring(options.inputFiles))
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.threads),
+    numberOfStreams = cms.untracked.uint32(1),
+    wantSummary = cms.untracked.bool(True),
+)
+
+process.load('RecoVertex.PrimaryVertexProducer.OfflinePrimaryVertices_cfi')
+process.offlinePrimaryVerticesInBlocks = process.offlinePrimaryVertices.clone()
+process.offlinePrimaryVerticesInBlocks.TkClusParameters.TkDAClusParameters.runInBlocks = True
+process.offlinePrimaryVerticesInBlocks.TkClusParameters.TkDAClusParameters.blockSize = options.blockSize
+process.offlinePrimaryVerticesInBlocks.TkClusParameters.TkDAClusParameters.overlapFraction = options.overlapFraction
+process.MessageLogger.cerr.FwkReport.reportEvery = 10
+
+process.vertexing_step = cms.Path(process.offlinePrimaryVertices + process.offlinePrimaryVerticesInBlocks)
+process.schedule = cms.Schedule(process.vertexing_step)
+
+if options.validation:
+    process.load('DQMServices.Core.DQMStore_cfi')
+    process.load('DQMServices.Components.DQMFileSaver_cfi')
+    process.dqmSaver.workflow = '/PrimaryVertex/BlockClustering/VALIDATION'
+    process.load('Validation.RecoTrack.TrackValidation_cff')
+    process.load('Validation.RecoVertex.PrimaryVertexAnalyzer4PUSlimmed_cfi')
+    process.vertexAnalysis.vertexRecoCollections = cms.VInputTag('offlinePrimaryVertices',
+                                                                 'offlinePrimaryVerticesInBlocks')
+    process.validation_step = cms.Path(process.tracksValidationTruth + process.vertexAnalysis)
+    process.dqmsave_step = cms.EndPath(process.dqmSaver)
+    process.schedule.extend([process.validation_step, process.dqmsave_step])
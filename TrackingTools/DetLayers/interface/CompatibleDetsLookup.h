@@ -0,0 +1,60 @@
+#ifndef DetLayers_CompatibleDetsLookup_h
+#define DetLayers_CompatibleDetsLookup_h
+
+/** \class CompatibleDetsLookup
+ *  Precomputed lookup of the basic components of a layer, binned in phi
+ *  and in z (barrel) or r (forward), with the bounds of each det.
+ *  It tells whether any det of the layer can be compatible with a state:
+ *  the state is propagated once to the layer surface, and the window
+ *  where it can reach the layer, given by the maximal local displacement
+ *  of the estimator and by the thickness of the layer, is compared with
+ *  the bounds of the dets of the bins it covers. As the window contains
+ *  all the dets the layer may find, the search of the layer is needed
+ *  only when some det overlaps it, and gives the same dets in the same
+ *  order as without the lookup.
+ */
+
+#include "TrackingTools/DetLayers/interface/GeometricSearchDet.h"
+
+#include <utility>
+#include <vector>
+
+class DetLayer;
+
+class CompatibleDetsLookup {
+public:
+  CompatibleDetsLookup(const DetLayer& layer, unsigned int nPhiBins = 128, unsigned int nWBins = 32);
+
+  /// false if no det of the layer can be compatible with tsos; true if
+  /// some may be, or if the window can not be computed (state not
+  /// propagated to the layer, or too tangent to it)
+  bool mayHaveCompatibleDets(const TrajectoryStateOnSurface& tsos,
+			     const Propagator& prop,
+			     const MeasurementEstimator& est) const;
+
+private:
+  struct DetBounds {
+    const GeomDet* det;
+    float phi;        // phi of the center
+    float dPhi;       // half width in phi
+    float wMin, wMax; // range in z (barrel) or r (forward)
+  };
+
+  // range of the bins of w overlapping [wMin, wMax]
+  std::pair<int,int> wBins(float wMin, float wMax) const;
+  int phiBin(float phi) const;
+
+  const DetLayer& theLayer;
+  bool isBarrel;
+  std::vector<DetBounds> theDets;
+  // the range of the dets in r (barrel) or z (forward)
+  float theUMin, theUMax;
+
+  unsigned int theNPhi, theNW;
+  float theWMin, theWBin;
+  // the indices of the dets of each bin, bin b in [theBinStart[b], theBinStart[b+1])
+  std::vector<unsigned int> theBinStart;
+  std::vector<unsigned int> theBinDets;
+};
+
+#endif
@@ -16,8 +16,11 @@
 #include "TrackingTools/DetLayers/interface/NavigableLayer.h"
 #include "TrackingTools/DetLayers/interface/NavigationDirection.h"
 
+#include <memory>
 #include <vector>
 
+class CompatibleDetsLookup;
+
 class DetLayer : public GeometricSearchDet {  
  public:
 
@@ -28,6 +31,13 @@ class DetLayer : public GeometricSearchDet {
 
   ~DetLayer() override;
 
+  /// the compatible dets as searched by the layer; the search is skipped
+  /// if the lookup table of the layer, if any, finds no det in reach
+  void compatibleDetsV( const TrajectoryStateOnSurface& startingState,
+			const Propagator& prop, 
+			const MeasurementEstimator& est,
+			std::vector<DetWithState>& result) const override;
+
   // a detLayer can be either barrel or forward
   bool isBarrel() const { return iAmBarrel;}
   bool isForward() const { return !isBarrel();}
@@ -36,6 +46,10 @@ class DetLayer : public GeometricSearchDet {
   int seqNum() const { return theSeqNum;}
   void setSeqNum(int sq) { theSeqNum=sq;}
 
+  // precomputed lookup of the compatible dets, to be set once the layer is built
+  const CompatibleDetsLookup* compatibleDetsLookup() const { return theLookup.get();}
+  void setCompatibleDetsLookup(std::unique_ptr<const CompatibleDetsLookup> lookup);
+
   // Extension of the interface 
 
   /// The type of detector (PixelBarrel, PixelEndcap, TIB, TOB, TID, TEC, CSC, DT, RPCBarrel, RPCEndcap)
@@ -49,6 +63,7 @@ class DetLayer : public GeometricSearchDet {
  private:
   int theSeqNum;
   bool iAmBarrel;
+  std::unique_ptr<const CompatibleDetsLookup> theLookup;
 };
 
 #endif 
@@ -0,0 +1,180 @@
+#include "TrackingTools/DetLayers/interface/CompatibleDetsLookup.h"
+#include "TrackingTools/DetLayers/interface/DetLayer.h"
+#include "TrackingTools/DetLayers/interface/MeasurementEstimator.h"
+#include "TrackingTools/GeomPropagators/interface/Propagator.h"
+#include "TrackingTools/TrajectoryState/interface/TrajectoryStateOnSurface.h"
+#include "Geometry/CommonDetUnit/interface/GeomDet.h"
+#include "DataFormats/GeometrySurface/interface/TangentPlane.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  constexpr float pi = M_PI;
+  constexpr float twoPi = 2*M_PI;
+
+  inline float deltaPhi(float phi1, float phi2) {
+    float d = phi1 - phi2;
+    if (d > pi) d -= twoPi;
+    else if (d < -pi) d += twoPi;
+    return d;
+  }
+
+  // distance in the transverse plane of the z axis from the segment ab
+  inline float perpDistance(const GlobalPoint& a, const GlobalPoint& b) {
+    float dx = b.x() - a.x(), dy = b.y() - a.y();
+    float l2 = dx*dx + dy*dy;
+    float t = l2 > 0.f ? std::min(1.f, std::max(0.f, -(a.x()*dx + a.y()*dy) / l2)) : 0.f;
+    float x = a.x() + t*dx, y = a.y() + t*dy;
+    return std::sqrt(x*x + y*y);
+  }
+
+}
+
+CompatibleDetsLookup::CompatibleDetsLookup(const DetLayer& layer, unsigned int nPhiBins, unsigned int nWBins) :
+  theLayer(layer), isBarrel(layer.isBarrel()),
+  theUMin(std::numeric_limits<float>::max()), theUMax(-std::numeric_limits<float>::max()),
+  theNPhi(std::max(1U, nPhiBins)), theNW(std::max(1U, nWBins)), theWMin(0), theWBin(1) {
+
+  float wMin = std::numeric_limits<float>::max(), wMax = -std::numeric_limits<float>::max();
+  for (auto det : layer.basicComponents()) {
+    const Plane& plane = det->specificSurface();
+    const float hw = 0.5f*plane.bounds().width();
+    const float hl = 0.5f*plane.bounds().length();
+    const float ht = 0.5f*plane.bounds().thickness();
+
+    // the corners of the box of the det; the bounds of a det being
+    // convex, the ranges of phi, z and r over the det are those of its box
+    GlobalPoint corners[8];
+    for (unsigned int i = 0; i < 8; ++i)
+      corners[i] = plane.toGlobal(LocalPoint(i&1 ? hw : -hw, i&2 ? hl : -hl, i&4 ? ht : -ht));
+
+    DetBounds b;
+    b.det = det;
+    b.phi = plane.position().barePhi();
+    b.dPhi = 0;
+    float zMin = corners[0].z(), zMax = zMin;
+    float rMin = corners[0].perp(), rMax = rMin;
+    for (unsigned int i = 0; i < 8; ++i) {
+      b.dPhi = std::max(b.dPhi, std::abs(deltaPhi(corners[i].barePhi(), b.phi)));
+      zMin = std::min(zMin, corners[i].z());
+      zMax = std::max(zMax, corners[i].z());
+      rMax = std::max(rMax, corners[i].perp());
+      // the closest point to the axis may lie on an edge of the box
+      for (unsigned int j = 0; j < i; ++j) rMin = std::min(rMin, perpDistance(corners[i], corners[j]));
+    }
+
+    if (isBarrel) {
+      b.wMin = zMin; b.wMax = zMax;
+      theUMin = std::min(theUMin, rMin); theUMax = std::max(theUMax, rMax);
+    } else {
+      b.wMin = rMin; b.wMax = rMax;
+      theUMin = std::min(theUMin, zMin); theUMax = std::max(theUMax, zMax);
+    }
+    wMin = std::min(wMin, b.wMin);
+    wMax = std::max(wMax, b.wMax);
+    theDets.push_back(b);
+  }
+  if (theDets.empty()) return;
+
+  theWMin = wMin;
+  theWBin = std::max(wMax - wMin, 1.e-3f) / theNW;
+
+  // the dets of each bin, as compressed rows: count, then fill
+  theBinStart.assign(theNPhi*theNW + 1, 0);
+  auto forBins = [&](const DetBounds& b, auto && f) {
+    auto w = wBins(b.wMin, b.wMax);
+    int p0 = phiBin(b.phi - b.dPhi), np = phiBin(b.phi + b.dPhi) - p0;
+    if (np < 0) np += theNPhi;
+    if (b.dPhi >= pi) np = theNPhi - 1;
+    for (int ip = 0; ip <= np; ++ip) {
+      int p = (p0 + ip) % theNPhi;
+      for (int iw = w.first; iw <= w.second; ++iw) f(p*theNW + iw);
+    }
+  };
+  for (auto const & b : theDets) forBins(b, [&](unsigned int bin) { ++theBinStart[bin+1]; });
+  for (unsigned int bin = 0; bin < theNPhi*theNW; ++bin) theBinStart[bin+1] += theBinStart[bin];
+  theBinDets.resize(theBinStart.back());
+  std::vector<unsigned int> fill(theBinStart.begin(), theBinStart.end()-1);
+  for (unsigned int i = 0; i < theDets.size(); ++i)
+    forBins(theDets[i], [&](unsigned int bin) { theBinDets[fill[bin]++] = i; });
+}
+
+std::pair<int,int> CompatibleDetsLookup::wBins(float wMin, float wMax) const {
+  int b0 = std::floor((wMin - theWMin) / theWBin);
+  int b1 = std::floor((wMax - theWMin) / theWBin);
+  return std::make_pair(std::max(b0, 0), std::min(b1, int(theNW) - 1));
+}
+
+int CompatibleDetsLookup::phiBin(float phi) const {
+  int b = std::floor((phi + pi) * (theNPhi / twoPi));
+  b %= int(theNPhi);
+  return b < 0 ? b + theNPhi : b;
+}
+
+bool CompatibleDetsLookup::mayHaveCompatibleDets(const TrajectoryStateOnSurface& tsos,
+						 const Propagator& prop,
+						 const MeasurementEstimator& est) const {
+  if (theDets.empty()) return false;
+
+  TrajectoryStateOnSurface onLayer = prop.propagate(tsos, theLayer.surface());
+  if (!onLayer.isValid()) return true;
+
+  GlobalPoint pos = onLayer.globalPosition();
+  GlobalVector dir = onLayer.globalMomentum().unit();
+  const float r = pos.perp();
+  if (r < 1.e-3f) return true;
+  const float cosPhi = pos.x()/r, sinPhi = pos.y()/r;
+  const float dRho = std::abs(dir.x()*cosPhi + dir.y()*sinPhi);
+  const float dPhi = std::abs(dir.y()*cosPhi - dir.x()*sinPhi);
+  const float dZ = std::abs(dir.z());
+
+  // the path from the layer surface to the farthest det of the layer, and
+  // the bending of the track along it
+  const float dNormal = isBarrel ? dRho : dZ;
+  if (dNormal < 0.1f) return true;
+  const float u = isBarrel ? r : pos.z();
+  const float path = std::max(u - theUMin, theUMax - u) / dNormal;
+  const float bend = 0.5f*path*path*std::abs(onLayer.globalParameters().transverseCurvature());
+
+  // the displacement allowed by the estimator
+  auto disp = est.maximalLocalDisplacement(onLayer, *onLayer.surface().tangentPlane(pos));
+  const float m = std::max(std::abs(disp.x()), std::abs(disp.y()));
+
+  const float rPhiMargin = m + path*dPhi + bend;
+  float w, wMargin, rInner;
+  if (isBarrel) {
+    w = pos.z();
+    wMargin = m + path*dZ;
+    rInner = theUMin;
+  } else {
+    w = r;
+    wMargin = m + path*dRho + bend;
+    rInner = r - wMargin;
+  }
+  const float phiWindow = rInner > rPhiMargin ? rPhiMargin / rInner : pi;
+
+  auto wb = wBins(w - wMargin, w + wMargin);
+  if (wb.first > wb.second) return false;
+
+  const float phi = pos.barePhi();
+  int p0 = std::floor((phi - phiWindow + pi) * (theNPhi / twoPi));
+  int np = std::min(int(std::floor((phi + phiWindow + pi) * (theNPhi / twoPi))) - p0, int(theNPhi) - 1);
+  p0 %= int(theNPhi);
+  if (p0 < 0) p0 += theNPhi;
+
+  // a det in several bins is tested once per bin, which is cheaper than
+  // collecting the candidates of the window
+  for (int ip = 0; ip <= np; ++ip) {
+    unsigned int p = (p0 + ip) % theNPhi;
+    for (unsigned int k = theBinStart[p*theNW + wb.first]; k != theBinStart[p*theNW + wb.second + 1]; ++k) {
+      auto const & b = theDets[theBinDets[k]];
+      if (b.wMax < w - wMargin || b.wMin > w + wMargin) continue;
+      if (std::abs(deltaPhi(b.phi, phi)) > b.dPhi + phiWindow) continue;
+      return true;
+    }
+  }
+  return false;
+}
@@ -1,5 +1,17 @@
 #include "TrackingTools/DetLayers/interface/DetLayer.h"
+#include "TrackingTools/DetLayers/interface/CompatibleDetsLookup.h"
 
 DetLayer::~DetLayer() {}
 
+void DetLayer::setCompatibleDetsLookup(std::unique_ptr<const CompatibleDetsLookup> lookup) {
+  theLookup = std::move(lookup);
+}
+
+void DetLayer::compatibleDetsV( const TrajectoryStateOnSurface& startingState,
+				const Propagator& prop, 
+				const MeasurementEstimator& est,
+				std::vector<DetWithState>& result) const {
+  if (theLookup && !theLookup->mayHaveCompatibleDets(startingState, prop, est)) return;
+  GeometricSearchDet::compatibleDetsV(startingState, prop, est, result);
+}
 
@@ -0,0 +1,81 @@
+#ifndef _TRACKER_KFBATCHUPDATOR_H_
+#define _TRACKER_KFBATCHUPDATOR_H_
+
+/** \class KFBatchUpdator
+ * Kalman update, and chi2 of the measurement, of many (predicted state,
+ * hit) pairs at once. The pairs are added one by one, then updated in one
+ * call; the states and hits are stored as structures of arrays (one array
+ * per parameter or matrix element), so that the 5x5 algebra of the update
+ * runs in loops over the pairs which the compiler vectorises.
+ *
+ * The update is the one of KFUpdator, with the same Joseph form of the
+ * filtered covariance, computed element by element; the results agree
+ * with KFUpdator to the rounding of the operations.
+ *
+ * Hits of dimension 1 and 2 are batched, add() returns -1 for the others,
+ * which are to be updated with KFUpdator.
+ */
+
+#include "DataFormats/CLHEP/interface/AlgebraicObjects.h"
+#include "TrackingTools/TrajectoryState/interface/TrajectoryStateOnSurface.h"
+
+#include <array>
+#include <vector>
+
+class TrackingRecHit;
+
+class KFBatchUpdator {
+public:
+
+  /// add the update of tsos with hit, to be done by the next update();
+  /// returns the index of the pair, or -1 if the hit is not batched
+  int add(const TrajectoryStateOnSurface& tsos, const TrackingRecHit& hit);
+
+  /// update all the pairs added since the last clear()
+  void update();
+
+  /// the updated state of a pair, on the surface of its predicted state
+  /// tsos; invalid if the covariance of the residuals is not positive
+  TrajectoryStateOnSurface updatedState(int index, const TrajectoryStateOnSurface& tsos) const;
+
+  /// the chi2 of the hit of a pair with its predicted state
+  double chi2(int index) const;
+
+  void clear() { b1_.clear(); b2_.clear(); }
+  size_t size() const { return b1_.size() + b2_.size(); }
+
+private:
+
+  /// the pairs with hits of dimension D: the indices of the pairs give
+  /// the dimension in their lowest bit
+  template <unsigned int D>
+  struct Batch {
+    static constexpr unsigned int DD = D*(D+1)/2;
+
+    void add(const AlgebraicVector5& x, const AlgebraicSymMatrix55& C, const TrackingRecHit& hit);
+    void update();
+    void clear();
+    size_t size() const { return x[0].size(); }
+
+    // input: state and errors, hit and errors, state projected on the
+    // hit (H x, H C H^T and C H^T)
+    std::array<std::vector<double>, 5> x;
+    std::array<std::vector<double>, 15> c;
+    std::array<std::vector<double>, D> m;
+    std::array<std::vector<double>, DD> v;
+    std::array<std::vector<double>, D> hx;
+    std::array<std::vector<double>, DD> hch;
+    std::array<std::vector<double>, 5*D> ch;
+
+    // output
+    std::array<std::vector<double>, 5> xu;
+    std::array<std::vector<double>, 15> cu;
+    std::vector<double> chi2;
+    std::vector<char> ok;
+  };
+
+  Batch<1> b1_;
+  Batch<2> b2_;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "TrackingTools/KalmanUpdators/interface/KFBatchUpdator.h"
+#include "DataFormats/TrackingRecHit/interface/TrackingRecHit.h"
+#include "DataFormats/TrackingRecHit/interface/KfComponentsHolder.h"
+#include "DataFormats/Math/interface/ProjectMatrix.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+namespace {
+
+  // index of the element (a,b) of a symmetric matrix in packed storage
+  constexpr unsigned int sym(unsigned int a, unsigned int b) {
+    return a >= b ? a*(a+1)/2 + b : b*(b+1)/2 + a;
+  }
+
+  // inverse W of the covariance R of the residuals; the determinant is
+  // replaced by one if R is not positive, to keep the loops free of
+  // branches, and the pair is flagged
+  inline bool invert(const double (&R)[1], double (&W)[1]) {
+    bool ok = R[0] > 0.;
+    W[0] = 1./(ok ? R[0] : 1.);
+    return ok;
+  }
+
+  inline bool invert(const double (&R)[3], double (&W)[3]) {
+    double det = R[0]*R[2] - R[1]*R[1];
+    bool ok = (R[0] > 0.) & (det > 0.);
+    double idet = 1./(ok ? det : 1.);
+    W[0] =  R[2]*idet;
+    W[1] = -R[1]*idet;
+    W[2] =  R[0]*idet;
+    return ok;
+  }
+
+}
+
+template <unsigned int D>
+void KFBatchUpdator::Batch<D>::add(const AlgebraicVector5& x5, const AlgebraicSymMatrix55& C,
+                                   const TrackingRecHit& hit) {
+  typedef typename AlgebraicROOTObject<D,D>::SymMatrix SMatDD;
+  typedef typename AlgebraicROOTObject<D>::Vector VecD;
+  using ROOT::Math::SMatrixNoInit;
+
+  ProjectMatrix<double,5,D> pf;
+  VecD r, rMeas;
+  SMatDD V(SMatrixNoInit{}), VMeas(SMatrixNoInit{});
+
+  KfComponentsHolder holder;
+  holder.template setup<D>(&r, &V, &pf, &rMeas, &VMeas, x5, C);
+  hit.getKfComponents(holder);
+
+  for (unsigned int i = 0; i < 5; ++i) x[i].push_back(x5[i]);
+  for (unsigned int a = 0; a < 5; ++a)
+    for (unsigned int b = 0; b <= a; ++b) c[sym(a,b)].push_back(C(a,b));
+  for (unsigned int j = 0; j < D; ++j) {
+    m[j].push_back(r[j]);
+    hx[j].push_back(rMeas[j]);
+    for (unsigned int k = 0; k <= j; ++k) {
+      v[sym(j,k)].push_back(V(j,k));
+      hch[sym(j,k)].push_back(VMeas(j,k));
+    }
+    // C H^T, H having a single 1 per row
+    for (unsigned int i = 0; i < 5; ++i) ch[i*D+j].push_back(C(i,pf.index[j]));
+  }
+}
+
+template <unsigned int D>
+void KFBatchUpdator::Batch<D>::update() {
+  const size_t n = size();
+  for (auto& e : xu) e.resize(n);
+  for (auto& e : cu) e.resize(n);
+  chi2.resize(n);
+  ok.resize(n);
+
+  for (size_t p = 0; p < n; ++p) {
+    // residuals, their covariance and its inverse
+    double r[D], R[DD], W[DD];
+    for (unsigned int j = 0; j < D; ++j) r[j] = m[j][p] - hx[j][p];
+    for (unsigned int e = 0; e < DD; ++e) R[e] = v[e][p] + hch[e][p];
+    ok[p] = invert(R, W);
+
+    // gain K = C H^T W
+    double K[5*D];
+    for (unsigned int i = 0; i < 5; ++i)
+      for (unsigned int j = 0; j < D; ++j) {
+        double s = 0.;
+        for (unsigned int k = 0; k < D; ++k) s += ch[i*D+k][p] * W[sym(k,j)];
+        K[i*D+j] = s;
+      }
+
+    // filtered state
+    for (unsigned int i = 0; i < 5; ++i) {
+      double s = x[i][p];
+      for (unsigned int j = 0; j < D; ++j) s += K[i*D+j] * r[j];
+      xu[i][p] = s;
+    }
+
+    // filtered errors, (1-KH) C (1-KH)^T + K V K^T expanded:
+    // C - K (C H^T)^T - (C H^T) K^T + K R K^T
+    double KR[5*D];
+    for (unsigned int i = 0; i < 5; ++i)
+      for (unsigned int j = 0; j < D; ++j) {
+        double s = 0.;
+        for (unsigned int k = 0; k < D; ++k) s += K[i*D+k] * R[sym(k,j)];
+        KR[i*D+j] = s;
+      }
+    for (unsigned int a = 0; a < 5; ++a)
+      for (unsigned int b = 0; b <= a; ++b) {
+        double s = c[sym(a,b)][p];
+        for (unsigned int j = 0; j < D; ++j)
+          s += KR[a*D+j] * K[b*D+j] - K[a*D+j] * ch[b*D+j][p] - ch[a*D+j][p] * K[b*D+j];
+        cu[sym(a,b)][p] = s;
+      }
+
+    // chi2 of the hit, r^T W r
+    double s = 0.;
+    for (unsigned int j = 0; j < D; ++j)
+      for (unsigned int k = 0; k < D; ++k) s += r[j] * W[sym(j,k)] * r[k];
+    chi2[p] = s;
+  }
+}
+
+template <unsigned int D>
+void KFBatchUpdator::Batch<D>::clear() {
+  for (auto& e : x) e.clear();
+  for (auto& e : c) e.clear();
+  for (auto& e : m) e.clear();
+  for (auto& e : v) e.clear();
+  for (auto& e : hx) e.clear();
+  for (auto& e : hch) e.clear();
+  for (auto& e : ch) e.clear();
+}
+
+int KFBatchUpdator::add(const TrajectoryStateOnSurface& tsos, const TrackingRecHit& hit) {
+  auto && x = tsos.localParameters().vector();
+  auto && C = tsos.localError().matrix();
+  switch (hit.dimension()) {
+    case 1: b1_.add(x, C, hit); return 2*(b1_.size()-1);
+    case 2: b2_.add(x, C, hit); return 2*(b2_.size()-1) + 1;
+  }
+  return -1;
+}
+
+void KFBatchUpdator::update() {
+  b1_.update();
+  b2_.update();
+}
+
+namespace {
+  template <unsigned int D, typename B>
+  TrajectoryStateOnSurface state(const B& b, size_t p, const TrajectoryStateOnSurface& tsos) {
+    if (!b.ok[p]) {
+      typename AlgebraicROOTObject<D,D>::SymMatrix R;
+      for (unsigned int j = 0; j < D; ++j)
+        for (unsigned int k = 0; k <= j; ++k) R(j,k) = b.v[sym(j,k)][p] + b.hch[sym(j,k)][p];
+      edm::LogError("KFUpdator")<<" could not invert martix:\n"<< R;
+      return TrajectoryStateOnSurface();
+    }
+
+    AlgebraicVector5 fsv;
+    AlgebraicSymMatrix55 fse;
+    for (unsigned int i = 0; i < 5; ++i) fsv[i] = b.xu[i][p];
+    for (unsigned int a = 0; a < 5; ++a)
+      for (unsigned int c = 0; c <= a; ++c) fse(a,c) = b.cu[sym(a,c)][p];
+    return TrajectoryStateOnSurface( LocalTrajectoryParameters(fsv, tsos.localParameters().pzSign()),
+                                     LocalTrajectoryError(fse), tsos.surface(),
+                                     &(tsos.globalParameters().magneticField()), tsos.surfaceSide() );
+  }
+}
+
+TrajectoryStateOnSurface KFBatchUpdator::updatedState(int index, const TrajectoryStateOnSurface& tsos) const {
+  return (index & 1) ? state<2>(b2_, index >> 1, tsos) : state<1>(b1_, index >> 1, tsos);
+}
+
+double KFBatchUpdator::chi2(int index) const {
+  return (index & 1) ? b2_.chi2[index >> 1] : b1_.chi2[index >> 1];
+}
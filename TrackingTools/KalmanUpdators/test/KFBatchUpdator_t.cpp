@@ -0,0 +1,187 @@
+#include "TrackingTools/KalmanUpdators/interface/KFBatchUpdator.h"
+#include "TrackingTools/KalmanUpdators/interface/KFUpdator.h"
+#include "TrackingTools/KalmanUpdators/interface/Chi2MeasurementEstimator.h"
+
+#include "TrackingTools/TrajectoryState/interface/TrajectoryStateOnSurface.h"
+#include "DataFormats/GeometrySurface/interface/Surface.h"
+#include "DataFormats/GeometrySurface/interface/BoundPlane.h"
+#include <Geometry/CommonDetUnit/interface/GeomDet.h>
+
+#include "MagneticField/Engine/interface/MagneticField.h"
+
+#include "DataFormats/TrackerRecHit2D/interface/SiStripRecHit2D.h"
+#include "DataFormats/TrackerRecHit2D/interface/SiStripRecHit1D.h"
+#include "DataFormats/TrackerRecHit2D/interface/SiPixelRecHit.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/*
+ * Benchmark of KFBatchUpdator against KFUpdator and
+ * Chi2MeasurementEstimator, on pairs of predicted states and hits as the
+ * CKF finds them on a layer: states with correlated errors and pixel, 2D
+ * and 1D strip hits around them. The time per pair of the update and chi2
+ * is printed, hit by hit and in one batch, and the states and chi2 of the
+ * batch are checked to agree with those of KFUpdator and the estimator.
+ *
+ * Usage: KFBatchUpdator_t [number of pairs] [passes]
+ */
+
+class ConstMagneticField : public MagneticField {
+public:
+
+  virtual GlobalVector inTesla ( const GlobalPoint& ) const {
+    return GlobalVector(0,0,4);
+  }
+
+};
+
+// A fake Det class
+
+class MyDet : public GeomDet {
+ public:
+  MyDet(BoundPlane * bp, DetId id) :
+    GeomDet(bp){setDetId(id);}
+
+  virtual std::vector< const GeomDet*> components() const {
+    return std::vector< const GeomDet*>();
+  }
+
+  /// Which subdetector
+  virtual SubDetector subDetector() const {return GeomDetEnumerators::DT;}
+
+};
+
+namespace {
+
+  // a correlated, positive, error matrix of local parameters
+  AlgebraicSymMatrix55 covariance(unsigned int i) {
+    AlgebraicMatrix55 a;
+    for (unsigned int r = 0; r < 5; ++r)
+      for (unsigned int c = 0; c < 5; ++c)
+        a(r,c) = ((i*7 + r*5 + c*3) % 11 - 5) * 0.01 + (r == c ? 0.1 : 0.);
+    return ROOT::Math::SimilarityT(a, AlgebraicSymMatrix55(ROOT::Math::SMatrixIdentity()));
+  }
+
+  // relative difference of the states, the errors relative to their
+  // diagonal
+  double difference(const TrajectoryStateOnSurface& a, const TrajectoryStateOnSurface& b) {
+    if (a.isValid() != b.isValid()) return 1.;
+    if (!a.isValid()) return 0.;
+    double d = 0.;
+    auto && va = a.localParameters().vector();
+    auto && vb = b.localParameters().vector();
+    auto && ea = a.localError().matrix();
+    auto && eb = b.localError().matrix();
+    for (unsigned int i = 0; i < 5; ++i) {
+      d = std::max(d, std::abs(va[i] - vb[i]) / (std::abs(va[i]) + std::sqrt(ea(i,i))));
+      for (unsigned int j = 0; j <= i; ++j)
+        d = std::max(d, std::abs(ea(i,j) - eb(i,j)) / std::sqrt(ea(i,i)*ea(j,j)));
+    }
+    return d;
+  }
+
+  typedef std::chrono::steady_clock Clock;
+
+  double seconds(Clock::time_point s, Clock::time_point e) {
+    return std::chrono::duration<double>(e - s).count();
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  unsigned int nPairs = argc > 1 ? std::atoi(argv[1]) : 10000;
+  unsigned int nPasses = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  MagneticField * field = new ConstMagneticField;
+  GlobalPoint gp(0,0,0);
+  BoundPlane* plane = new BoundPlane( gp, Surface::RotationType());
+  GeomDet *  det =  new MyDet(plane,41);
+
+  std::vector<TrajectoryStateOnSurface> states;
+  std::vector<std::unique_ptr<TrackingRecHit>> hits;
+  OmniClusterRef cref;
+  SiPixelRecHit::ClusterRef pref;
+  for (unsigned int i = 0; i < nPairs; ++i) {
+    float u = (i % 101) * 0.01f - 0.5f;
+    float w = (i % 37) * 0.02f - 0.3f;
+    LocalTrajectoryParameters ltp(LocalPoint(u,w,0), LocalVector(0.3f+u,0.2f-w,1), 1);
+    states.emplace_back(ltp, LocalTrajectoryError(covariance(i)), *plane, field);
+
+    LocalPoint m(u + 0.01f*((i % 13) - 6.f), w - 0.01f*((i % 7) - 3.f), 0);
+    LocalError e(0.002f + 0.0001f*(i % 5), -0.0002f*(i % 3), 0.003f + 0.0001f*(i % 4));
+    switch (i % 3) {
+      case 0: hits.emplace_back(new SiPixelRecHit(m,e,1.,*det,pref)); break;
+      case 1: hits.emplace_back(new SiStripRecHit2D(m,e,*det,cref)); break;
+      case 2: hits.emplace_back(new SiStripRecHit1D(m,e,*det,cref)); break;
+    }
+  }
+
+  KFUpdator updator;
+  Chi2MeasurementEstimator estimator(30.);
+  KFBatchUpdator batch;
+
+  std::cout << "KFBatchUpdator_t: " << nPairs << " pairs, " << nPasses << " passes" << std::endl;
+
+  // hit by hit, as the CKF does
+  std::vector<TrajectoryStateOnSurface> updated(nPairs);
+  std::vector<double> chi2(nPairs);
+  auto s = Clock::now();
+  for (unsigned int pass = 0; pass < nPasses; ++pass)
+    for (unsigned int i = 0; i < nPairs; ++i) {
+      chi2[i] = estimator.estimate(states[i], *hits[i]).second;
+      updated[i] = updator.update(states[i], *hits[i]);
+    }
+  auto e = Clock::now();
+  double single = seconds(s, e) / nPasses / nPairs;
+
+  // in one batch, states created as the CKF does
+  std::vector<int> index(nPairs);
+  std::vector<TrajectoryStateOnSurface> batchUpdated(nPairs);
+  double add = 0., update = 0., create = 0.;
+  for (unsigned int pass = 0; pass < nPasses; ++pass) {
+    batch.clear();
+    auto s0 = Clock::now();
+    for (unsigned int i = 0; i < nPairs; ++i) index[i] = batch.add(states[i], *hits[i]);
+    auto s1 = Clock::now();
+    batch.update();
+    auto s2 = Clock::now();
+    for (unsigned int i = 0; i < nPairs; ++i) batchUpdated[i] = batch.updatedState(index[i], states[i]);
+    auto s3 = Clock::now();
+    add += seconds(s0, s1);
+    update += seconds(s1, s2);
+    create += seconds(s2, s3);
+  }
+  add /= nPasses * double(nPairs);
+  update /= nPasses * double(nPairs);
+  create /= nPasses * double(nPairs);
+
+  std::cout << std::fixed << std::setprecision(1)
+            << " KFUpdator + Chi2MeasurementEstimator " << std::setw(8) << single * 1e9 << " ns/pair\n"
+            << " KFBatchUpdator                       " << std::setw(8) << (add + update + create) * 1e9 << " ns/pair"
+            << " (add " << add * 1e9 << ", update " << update * 1e9 << ", states " << create * 1e9 << ")\n"
+            << " speedup " << std::setprecision(2) << single / (add + update + create) << std::endl;
+
+  double maxState = 0., maxChi2 = 0.;
+  for (unsigned int i = 0; i < nPairs; ++i) {
+    if (index[i] < 0) {
+      std::cout << "Error: hit " << i << " of dimension " << hits[i]->dimension() << " not batched" << std::endl;
+      return 1;
+    }
+    maxState = std::max(maxState, difference(updated[i], batchUpdated[i]));
+    maxChi2 = std::max(maxChi2, std::abs(chi2[i] - batch.chi2(index[i])) / std::max(chi2[i], 1.));
+  }
+  std::cout << " largest difference: states " << std::scientific << maxState << ", chi2 " << maxChi2 << std::endl;
+  if (maxState > 1e-9 || maxChi2 > 1e-9) {
+    std::cout << "Error: the batch differs from KFUpdator" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
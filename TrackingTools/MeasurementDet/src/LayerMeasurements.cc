@@ -11,6 +11,7 @@
 #include "TrackingTools/DetLayers/interface/GeometricSearchDet.h"
 #include "TrackingTools/DetLayers/interface/DetLayer.h"
 #include "TrackingTools/DetLayers/interface/DetGroup.h"
+#include "TrackingTools/DetLayers/interface/CompatibleDetsLookup.h"
 
 #include "TrackingTools/TransientTrackingRecHit/interface/InvalidTransientRecHit.h"
 
@@ -141,7 +142,12 @@ LayerMeasurements::groupedMeasurements( const DetLayer& layer,
 					const MeasurementEstimator& est) const {
   vector<TrajectoryMeasurementGroup> result;
   
-  vector<DetGroup> && groups = layer.groupedCompatibleDets( startingState, prop, est);
+  // as in DetLayer::compatibleDetsV, the lookup of the layer, if any,
+  // skips the search when no det can be reached
+  vector<DetGroup> groups;
+  auto lookup = layer.compatibleDetsLookup();
+  if (!lookup || lookup->mayHaveCompatibleDets( startingState, prop, est))
+    groups = layer.groupedCompatibleDets( startingState, prop, est);
   result.reserve(groups.size());
 
   tracking::TempMeasurements tmps;
@@ -330,6 +330,10 @@ public:
   /// It doesn't reverse the forward and backward predicted states within each trajectory measurement
   void reverse() ;
 
+  /// Copy the states of the trajectory measurements to the heap, for a
+  /// trajectory built in a TrackingArena that outlives its round.
+  void moveStatesToHeap();
+
   const boost::shared_ptr<const TrajectorySeed> & sharedSeed() const { return theSeed; }
   void setSharedSeed(const boost::shared_ptr<const TrajectorySeed> & seed) { theSeed=seed;}
 
@@ -199,6 +199,16 @@ public:
 
   // void setLayer( DetLayer const * il) const { theLayer=il;}
 
+  /// the measurement with its states copied to the heap, a state shared
+  /// by several of them copied once (see TrackingArena)
+  TrajectoryMeasurement heapCopy() const {
+    auto fwd = theFwdPredictedState.heapCopy();
+    auto bwd = theBwdPredictedState.sameState(theFwdPredictedState) ? fwd : theBwdPredictedState.heapCopy();
+    auto upd = theUpdatedState.sameState(theFwdPredictedState) ? fwd :
+      (theUpdatedState.sameState(theBwdPredictedState) ? bwd : theUpdatedState.heapCopy());
+    return TrajectoryMeasurement(fwd, bwd, upd, theRecHit, theEstimate, theLayer);
+  }
+
 private:
   TrajectoryStateOnSurface theFwdPredictedState;
   TrajectoryStateOnSurface theBwdPredictedState;
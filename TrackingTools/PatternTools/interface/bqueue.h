@@ -2,6 +2,7 @@
 #define CMSUTILS_BEUEUE_H
 #include <boost/intrusive_ptr.hpp>
 #include<cassert>
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
 
 /**  Backwards linked queue with "head sharing"
 
@@ -31,6 +32,8 @@
     to support c++11 begin,end and operator++ has been added with the same semantics of rbegin,rend and operator--
     Highly confusing, still the bqueue is a sort of reversed slist: provided the user knows should work....
 
+    The items are taken from the TrackingArena of the thread, if in scope of one.
+
 
 */
 namespace cmsutils {
@@ -48,7 +51,23 @@ namespace cmsutils {
     friend void intrusive_ptr_add_ref<T>(_bqueue_item<T> *it);
     friend void intrusive_ptr_release<T>(_bqueue_item<T> *it);
     void addRef() { ++refCount; }
-    void delRef() { if ((--refCount) == 0) delete this; }
+    void delRef() {
+      if ((--refCount) == 0) {
+        if (!inArena) delete this;
+        else { this->~_bqueue_item(); TrackingArena::deallocate(this); }
+      }
+    }
+    // from the TrackingArena of the thread, if in scope of one
+    template<typename... Args>
+    static _bqueue_item * make(Args && ...args) {
+      if (!TrackingArena::current()) return new _bqueue_item(std::forward<Args>(args)...);
+      void * p = TrackingArena::allocate(sizeof(_bqueue_item));
+      _bqueue_item * it;
+      try { it = new (p) _bqueue_item(std::forward<Args>(args)...); }
+      catch (...) { TrackingArena::deallocate(p); throw; }
+      it->inArena = true;
+      return it;
+    }
   private:
     _bqueue_item() : back(0), value(), refCount(0) { }
     _bqueue_item(boost::intrusive_ptr< _bqueue_item<T> > tail, const T &val) : back(tail), value(val), refCount(0) { }
@@ -62,6 +81,7 @@ namespace cmsutils {
     boost::intrusive_ptr< _bqueue_item<T> > back;
     T const value;
     unsigned int refCount;
+    bool inArena = false;
   };
   
   template<class T> inline void intrusive_ptr_add_ref(_bqueue_item<T> *it) { it->addRef(); }
@@ -131,20 +151,20 @@ namespace cmsutils {
     
     // copy
     void push_back(const T& val) {
-      m_tail = itemptr(new item(this->m_tail, val)); 
+      m_tail = itemptr(item::make(this->m_tail, val)); 
       if ((++m_size) == 1) { m_head = m_tail; };
     }
     
     //move 
     void push_back(T&& val) {
-      m_tail = itemptr(new item(this->m_tail, std::forward<T>(val))); 
+      m_tail = itemptr(item::make(this->m_tail, std::forward<T>(val))); 
       if ((++m_size) == 1) { m_head = m_tail; };
     }
     
     // emplace
     template<typename... Args>
     void emplace_back(Args && ...args){
-      m_tail = itemptr(new item(this->m_tail, std::forward<Args>(args)...)); 
+      m_tail = itemptr(item::make(this->m_tail, std::forward<Args>(args)...)); 
       if ((++m_size) == 1) { m_head = m_tail; };
     }
     
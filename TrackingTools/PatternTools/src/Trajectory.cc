@@ -268,3 +268,7 @@ void Trajectory::reverse() {
     // reverse the order of the hits
     std::reverse(theData.begin(), theData.end());
 }
+
+void Trajectory::moveStatesToHeap() {
+    for (auto & tm : theData) tm = tm.heapCopy();
+}
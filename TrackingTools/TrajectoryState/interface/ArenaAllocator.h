@@ -0,0 +1,159 @@
+#ifndef Tracker_ArenaAllocator_H
+#define Tracker_ArenaAllocator_H
+
+/** Arena of the trajectory states, and of the trajectory measurements of
+ *  the TempTrajectory's, built for one seed or one track fit.
+ *  While a TrackingArena::Scope is open on a thread, the states built by
+ *  TrajectoryStateOnSurface and the items of bqueue are cut from the
+ *  blocks of the arena by moving a pointer, instead of one malloc and one
+ *  free each.
+ *  Nothing freed is given back to the arena: a block is freed once the
+ *  arena has moved to the next block and the last object cut from it is
+ *  freed, so that a single object still alive keeps its whole block. The
+ *  work done in an arena is therefore cut in rounds (TrackingArena::Round)
+ *  at the end of which the objects kept are copied to the heap
+ *  (Trajectory::moveStatesToHeap) and the others are freed: the arena
+ *  then starts its block again. An object left in the arena still works,
+ *  its block is then given up and freed with its last object, by any
+ *  thread.
+ *  An arena is used by one thread at a time: one per stream, or per task.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+class TrackingArena {
+public:
+  explicit TrackingArena(std::size_t blockSize = 64*1024) :
+    theBlockSize(blockSize) {}
+  ~TrackingArena();
+
+  TrackingArena(TrackingArena const&) = delete;
+  TrackingArena& operator=(TrackingArena const&) = delete;
+
+  /// the arena of the thread while in scope; no arena if nullptr
+  class Scope {
+  public:
+    explicit Scope(TrackingArena* arena) : previous(current_()) { current_() = arena;}
+    ~Scope() { current_() = previous;}
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+  private:
+    TrackingArena* previous;
+  };
+
+  /// a round of work with the arena of the thread, if any, whose objects
+  /// are all freed, or copied to the heap, at its end; the arena then
+  /// reuses its block, or gives it up if some object is still alive
+  class Round {
+  public:
+    Round() : arena(current_()) {}
+    ~Round() { if (arena) arena->reset();}
+    Round(Round const&) = delete;
+    Round& operator=(Round const&) = delete;
+  private:
+    TrackingArena* arena;
+  };
+
+  static TrackingArena* current() { return current_();}
+
+  /// n bytes from the arena of the thread, or from the heap if none
+  static void* allocate(std::size_t n) {
+    TrackingArena* a = current_();
+    return a ? a->get(n) : heap(n);
+  }
+
+  /// free memory given by allocate(), from any thread
+  static void deallocate(void* p) noexcept {
+    if (!p) return;
+    Header* h = static_cast<Header*>(p) - 1;
+    if (h->block) h->block->release(1);
+    else ::operator delete(h);
+  }
+
+  /// start the current block again if all the objects cut from it are
+  /// freed, or else give it up to its objects
+  void reset() noexcept;
+
+  std::size_t blocks() const { return theBlocks;}
+  std::size_t allocations() const { return theAllocations;}
+
+private:
+
+  struct Block {
+    // the objects not yet freed, plus a large count held by the arena
+    // until it moves to the next block, so that it needs no atomic
+    // operation per allocation
+    std::atomic<std::size_t> live;
+    void release(std::size_t n) noexcept {
+      if (live.fetch_sub(n, std::memory_order_acq_rel) == n) ::operator delete(this);
+    }
+  };
+
+  // in front of each allocation, keeps it aligned as by operator new
+  struct alignas(16) Header {
+    Block* block;
+  };
+
+  static constexpr std::size_t kArenaCount = std::size_t(1) << 62;
+  static std::size_t aligned(std::size_t n) { return (n + 15) & ~std::size_t(15);}
+
+  static TrackingArena* & current_() {
+    static thread_local TrackingArena* local = nullptr;
+    return local;
+  }
+
+  static void* heap(std::size_t n) {
+    Header* h = static_cast<Header*>(::operator new(sizeof(Header) + n));
+    h->block = nullptr;
+    return h + 1;
+  }
+
+  void* get(std::size_t n) {
+    std::size_t size = sizeof(Header) + aligned(n);
+    if (std::size_t(theEnd - theNext) < size) newBlock(size);
+    Header* h = reinterpret_cast<Header*>(theNext);
+    h->block = theBlock;
+    theNext += size;
+    ++theCount;
+    ++theAllocations;
+    return h + 1;
+  }
+
+  void newBlock(std::size_t size);
+  void retire() noexcept;
+
+  std::size_t theBlockSize;
+  Block* theBlock = nullptr;
+  char* theNext = nullptr;
+  char* theEnd = nullptr;
+  std::size_t theCount = 0;  // allocations in theBlock
+
+  std::size_t theBlocks = 0;
+  std::size_t theAllocations = 0;
+};
+
+
+/// std allocator on TrackingArena, to be used with std::allocate_shared
+template <typename T>
+class arena_allocator {
+public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= 16, "arena_allocator aligns to 16 bytes only");
+
+  arena_allocator() = default;
+  template <class U>
+  arena_allocator(const arena_allocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) { return static_cast<T*>(TrackingArena::allocate(n*sizeof(T)));}
+  void deallocate(T* p, std::size_t) noexcept { TrackingArena::deallocate(p);}
+
+  template <class U>
+  bool operator==(const arena_allocator<U>&) const noexcept { return true;}
+  template <class U>
+  bool operator!=(const arena_allocator<U>&) const noexcept { return false;}
+};
+
+#endif
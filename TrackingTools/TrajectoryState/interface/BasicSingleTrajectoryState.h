@@ -15,6 +15,7 @@ public:
     BasicSingleTrajectoryState(Args && ...args) : BasicTrajectoryState(std::forward<Args>(args)...){/* assert(weight()>0);*/}
 
   pointer clone() const override {
+    if (TrackingArena::current()) return churn<BasicSingleTrajectoryState>(*this);
     return build<BasicSingleTrajectoryState>(*this);
   }
 
@@ -2,6 +2,7 @@
 #define BasicTrajectoryState_H
 
 #include "TrackingTools/TrajectoryState/interface/ProxyBase11.h"
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
 
 #include "TrackingTools/TrajectoryParametrization/interface/LocalTrajectoryParameters.h"
 #include "TrackingTools/TrajectoryParametrization/interface/LocalTrajectoryError.h"
@@ -84,8 +85,12 @@ public:
   template<typename T, typename... Args>
   static std::shared_ptr<BTSOS> build(Args && ...args){ return std::make_shared<T>(std::forward<Args>(args)...);}
 
+  // from the TrackingArena of the thread, if in scope of one
   template<typename T, typename... Args>
-  static std::shared_ptr<BTSOS> churn(Args && ...args){ return std::allocate_shared<T>(churn_allocator<T>(),std::forward<Args>(args)...);}
+  static std::shared_ptr<BTSOS> churn(Args && ...args){
+    if (TrackingArena::current()) return std::allocate_shared<T>(arena_allocator<T>(),std::forward<Args>(args)...);
+    return std::allocate_shared<T>(churn_allocator<T>(),std::forward<Args>(args)...);
+  }
 
 
 
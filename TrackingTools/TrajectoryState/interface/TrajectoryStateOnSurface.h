@@ -129,6 +129,19 @@ public:
     unsharedData().rescaleError(factor);
   }
 
+  /// a copy of the state from the heap, for a state from a TrackingArena
+  /// which has to outlive the round of the arena
+  TrajectoryStateOnSurface heapCopy() const {
+    if (!Base::isValid()) return TrajectoryStateOnSurface();
+    TrackingArena::Scope heap(nullptr);
+    return TrajectoryStateOnSurface(data().clone());
+  }
+
+  /// whether rh is a copy of this state (sharing its data)
+  bool sameState(TrajectoryStateOnSurface const & rh) const {
+    return Base::isValid() && rh.Base::isValid() && &data() == &rh.data();
+  }
+
   using	Components = BasicTrajectoryState::Components;
   Components const & components() const {
     return data().components();
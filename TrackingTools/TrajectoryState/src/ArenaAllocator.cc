@@ -0,0 +1,42 @@
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
+
+#include <algorithm>
+
+constexpr std::size_t TrackingArena::kArenaCount;
+
+TrackingArena::~TrackingArena() {
+  retire();
+}
+
+void TrackingArena::retire() noexcept {
+  if (!theBlock) return;
+  // drop the count of the arena: the block is freed now if all its
+  // objects are, or else by the last of them
+  theBlock->release(kArenaCount - theCount);
+  theBlock = nullptr;
+  theNext = theEnd = nullptr;
+  theCount = 0;
+}
+
+void TrackingArena::reset() noexcept {
+  if (!theBlock) return;
+  // the count is down by one per object freed
+  std::size_t allFreed = kArenaCount - theCount;
+  if (theBlock->live.compare_exchange_strong(allFreed, kArenaCount, std::memory_order_acq_rel)) {
+    theNext = reinterpret_cast<char*>(theBlock) + aligned(sizeof(Block));
+    theCount = 0;
+  }
+  else retire();
+}
+
+void TrackingArena::newBlock(std::size_t size) {
+  retire();
+  std::size_t head = aligned(sizeof(Block));
+  std::size_t bytes = std::max(theBlockSize, head + size);
+  char* raw = static_cast<char*>(::operator new(bytes));
+  theBlock = new (raw) Block;
+  theBlock->live.store(kArenaCount, std::memory_order_relaxed);
+  theNext = raw + head;
+  theEnd = raw + bytes;
+  ++theBlocks;
+}
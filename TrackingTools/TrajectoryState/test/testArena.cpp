@@ -0,0 +1,123 @@
+#include "TrackingTools/TrajectoryState/interface/TrajectoryStateOnSurface.h"
+#include "TrackingTools/TrajectoryState/interface/ArenaAllocator.h"
+#include "DataFormats/GeometrySurface/interface/Surface.h"
+#include "DataFormats/GeometrySurface/interface/BoundPlane.h"
+#include "MagneticField/Engine/interface/MagneticField.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Trajectory states built as by the track building: for each seed a window
+ * of live states is churned, and the states of the trajectories found
+ * for it are kept to the end of the event. The time per state and the
+ * peak virtual and resident size are printed for the states from the heap,
+ * from a TrackingArena over the whole event and from a TrackingArena reset
+ * after each seed, the kept states being copied to the heap first as
+ * CkfTrackCandidateMakerBase does. The kept states are checked after the
+ * arena is gone, from another thread. The peak sizes are those of the
+ * process: run one mode at a time.
+ *
+ * Usage: testArena [heap|arena|round] [events] [seeds] [states per seed]
+ */
+
+class ConstMagneticField : public MagneticField {
+public:
+
+  virtual GlobalVector inTesla ( const GlobalPoint& ) const {
+    return GlobalVector(0,0,4);
+  }
+
+};
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  const unsigned int window = 40;
+  const unsigned int keptPerSeed = 15;
+
+  // in MB, from /proc/self/status
+  long vmStatus(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+      if (line.compare(0, std::strlen(key), key) == 0) return std::atol(line.c_str() + std::strlen(key)) / 1024;
+    return 0;
+  }
+
+  void seed(unsigned int nStates, bool round, const BoundPlane& plane, const MagneticField* field,
+	    std::vector<TrajectoryStateOnSurface>& kept) {
+    std::unique_ptr<TrackingArena::Round> arenaRound(round ? new TrackingArena::Round : nullptr);
+    std::vector<TrajectoryStateOnSurface> live(window);
+    std::vector<TrajectoryStateOnSurface> found;
+    LocalTrajectoryError lerr(1.,1.,0.1,0.1,0.1);
+    for (unsigned int i = 0; i < nStates; ++i) {
+      LocalTrajectoryParameters ltp(LocalPoint(0.001f*(i%1000),0,0), LocalVector(1,1,1), 1);
+      live[i % window] = TrajectoryStateOnSurface(ltp, lerr, plane, field);
+      if (i % (nStates / keptPerSeed) == 0 && found.size() < keptPerSeed) found.push_back(live[i % window]);
+    }
+    for (auto const& tsos : found) kept.push_back(round ? tsos.heapCopy() : tsos);
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  std::string mode = argc > 1 ? argv[1] : "round";
+  unsigned int nEvents = argc > 2 ? std::atoi(argv[2]) : 20;
+  unsigned int nSeeds = argc > 3 ? std::atoi(argv[3]) : 4000;
+  unsigned int perSeed = argc > 4 ? std::atoi(argv[4]) : 400;
+  if (mode != "heap" && mode != "arena" && mode != "round") {
+    std::cout << "Usage: testArena [heap|arena|round] [events] [seeds] [states per seed]" << std::endl;
+    return 1;
+  }
+
+  MagneticField * field = new ConstMagneticField;
+  GlobalPoint gp(0,0,0);
+  BoundPlane* plane = new BoundPlane( gp, Surface::RotationType());
+
+  std::vector<TrajectoryStateOnSurface> kept;
+  TrackingArena theArena;
+  auto s = Clock::now();
+  for (unsigned int e = 0; e < nEvents; ++e) {
+    kept.clear();
+    TrackingArena::Scope scope(mode == "heap" ? nullptr : &theArena);
+    for (unsigned int j = 0; j < nSeeds; ++j)
+      seed(perSeed, mode == "round", *plane, field, kept);
+  }
+  double perState = std::chrono::duration<double>(Clock::now() - s).count() / (double(nEvents) * nSeeds * perSeed);
+
+  if (mode != "heap" && theArena.allocations() != size_t(nEvents) * nSeeds * perSeed) {
+    std::cout << "Error: " << theArena.allocations() << " states from the arena, "
+	      << size_t(nEvents) * nSeeds * perSeed << " built" << std::endl;
+    return 1;
+  }
+
+  std::cout << "testArena " << mode << ": " << nEvents << " events, " << nSeeds << " seeds, "
+	    << perSeed << " states per seed, " << window << " live\n"
+	    << " " << perState * 1e9 << " ns/state, " << theArena.blocks() << " blocks\n"
+	    << " VmPeak " << vmStatus("VmPeak:") << " MB, VmHWM " << vmStatus("VmHWM:") << " MB" << std::endl;
+
+  // the states kept outlive the arena, and are freed by another thread
+  bool ok = kept.size() == size_t(nSeeds) * keptPerSeed;
+  std::thread t([&]() {
+      for (unsigned int i = 0; ok && i < kept.size(); ++i)
+	ok = kept[i].isValid() && kept[i].localPosition().x() < 1.f;
+      kept.clear();
+    });
+  t.join();
+  if (!ok) {
+    std::cout << "Error: the states kept are not those built" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}